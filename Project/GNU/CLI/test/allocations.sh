@@ -0,0 +1,48 @@
+#!/usr/bin/env bash
+
+script_path="${PWD}/test"
+. ${script_path}/helpers.sh
+
+test="allocations"
+
+# test disabled on macOS due to this bug: https://bugs.kde.org/show_bug.cgi?id=349128
+if [[ "${OSTYPE}" == "darwin"* ]] || [ -n "${WSL}" ] ; then
+    exit 77
+fi
+
+type -p valgrind >/dev/null 2>&1 || fatal "${test}" "valgrind command not found"
+
+# count of heap allocations during the check of the container, frames are not decoded but reversibility data of each frame is read
+count_allocs() {
+    valgrind --log-file="${1}.valgrind" rawcooked -n -threads 1 --check-level container "${1}.mkv" >/dev/null 2>&1
+    sed -n 's/.*total heap usage: \([0-9,]*\) allocs.*/\1/p' "${1}.valgrind" | tr -d ','
+}
+
+pushd "${files_path}" >/dev/null 2>&1
+    for frames in 10 50 ; do
+        file="allocations${frames}"
+        mkdir "${file}"
+        ffmpeg -nostdin -f lavfi -i testsrc=size=16x16 -frames:v ${frames} "${file}/%04d.dpx" >/dev/null 2>&1 || fatal "internal" "ffmpeg command failed"
+        run_rawcooked --encode "${file}"
+        check_success "encoding failed" "encoding succeeded" || fatal "${test}" "encoding failed"
+    done
+
+    file="allocations"
+    allocs10="$(count_allocs allocations10)"
+    allocs50="$(count_allocs allocations50)"
+    if [ -z "${allocs10}" ] || [ -z "${allocs50}" ] ; then
+        fatal "${test}" "heap usage not found in valgrind output"
+    fi
+
+    # reversibility data of a frame is read without allocation, without hashes in the reversibility data only the frame indexes grow (geometrically)
+    if [ "$((allocs50 - allocs10))" -ge "16" ] ; then
+        echo "NOK: ${test}, ${allocs10} allocations with 10 frames and ${allocs50} allocations with 50 frames" >&${fd}
+        status=1
+    else
+        echo "OK: ${test}, no allocation per frame for reversibility data" >&${fd}
+    fi
+
+    clean
+popd >/dev/null 2>&1
+
+exit ${status}
@@ -0,0 +1,118 @@
+/*  Copyright (c) MediaArea.net SARL & AV Preservation by reto.ch.
+ *
+ *  Use of this source code is governed by a BSD-style license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+/* Client of the C API for api.sh
+ * Usage: api file.mkv directory
+ * Decodes all frames of the video tracks from the last one to the first one
+ * (random access) into directory/<track>_<frame>.raw, checks that the
+ * callback and the copy provide the same content and checks error cases.
+ */
+
+#include "Lib/API/RAWcooked_API.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct
+{
+    uint8_t*    Data;
+    size_t      Size;
+} planes;
+
+static void Planes_Callback(void* Opaque, const rawcooked_plane* Planes, size_t Planes_Count)
+{
+    planes* Content = (planes*)Opaque;
+    size_t i;
+    Content->Size = 0;
+    for (i = 0; i < Planes_Count; i++)
+    {
+        Content->Data = (uint8_t*)realloc(Content->Data, Content->Size + Planes[i].Size);
+        memcpy(Content->Data + Content->Size, Planes[i].Data, Planes[i].Size);
+        Content->Size += Planes[i].Size;
+    }
+}
+
+static int Error(const char* Message, rawcooked_file* File)
+{
+    fprintf(stderr, "Error: %s%s%s\n", Message, File ? ", " : "", File ? rawcooked_error(File) : "");
+    return 1;
+}
+
+int main(int argc, char* argv[])
+{
+    rawcooked_file* File;
+    planes Content = { NULL, 0 };
+    size_t Track, Track_Count;
+    int Result = 0;
+
+    if (argc != 3)
+        return Error("usage: api file.mkv directory", NULL);
+
+    if (rawcooked_open("nonexistent.mkv", &File) != RAWCOOKED_ERROR_OPEN)
+        return Error("opening a missing file did not fail", NULL);
+    if (rawcooked_open(argv[1], &File))
+        return Error("can not open the file", NULL);
+
+    Track_Count = rawcooked_track_count(File);
+    if (!Track_Count)
+        Result = Error("no track", File);
+    for (Track = 0; Track < Track_Count && !Result; Track++)
+    {
+        rawcooked_track_info Info;
+        uint64_t Frame;
+        if (rawcooked_track_info_get(File, Track, &Info))
+        {
+            Result = Error("can not get track info", File);
+            break;
+        }
+        printf("track %u: %s, %ux%u, %llu frames\n", (unsigned)Track, Info.CodecID, Info.Width, Info.Height, (unsigned long long)Info.FrameCount);
+        if (Info.Kind != RAWCOOKED_TRACK_VIDEO)
+            continue;
+
+        for (Frame = Info.FrameCount; Frame-- && !Result;)
+        {
+            size_t Size = 0;
+            uint8_t* Buffer;
+            char FileName[4096];
+            FILE* Output;
+
+            if (rawcooked_decode_frame_to(File, Track, Frame, NULL, 0, &Size) != RAWCOOKED_ERROR_BUFFER || !Size)
+            {
+                Result = Error("size query did not provide the size", File);
+                break;
+            }
+            Buffer = (uint8_t*)malloc(Size);
+            if (rawcooked_decode_frame_to(File, Track, Frame, Buffer, Size, &Size))
+                Result = Error("can not decode the frame", File);
+            else if (rawcooked_decode_frame(File, Track, Frame, Planes_Callback, &Content))
+                Result = Error("can not decode the frame with a callback", File);
+            else if (Content.Size != Size || memcmp(Content.Data, Buffer, Size))
+                Result = Error("callback and copy are not same", NULL);
+            else
+            {
+                snprintf(FileName, sizeof(FileName), "%s/%u_%llu.raw", argv[2], (unsigned)Track, (unsigned long long)Frame);
+                Output = fopen(FileName, "wb");
+                if (!Output || fwrite(Buffer, 1, Size, Output) != Size)
+                    Result = Error("can not write the frame", NULL);
+                if (Output)
+                    fclose(Output);
+            }
+            free(Buffer);
+        }
+
+        if (!Result && rawcooked_decode_frame_to(File, Track, Info.FrameCount, NULL, 0, NULL) != RAWCOOKED_ERROR_ARGUMENT)
+            Result = Error("decoding a frame after the last one did not fail", NULL);
+    }
+
+    if (!Result && rawcooked_decode_frame(File, Track_Count, 0, Planes_Callback, &Content) != RAWCOOKED_ERROR_ARGUMENT)
+        Result = Error("decoding a missing track did not fail", NULL);
+    if (!Result && !*rawcooked_error(File))
+        Result = Error("no message for the last error", NULL);
+
+    free(Content.Data);
+    rawcooked_close(File);
+    return Result;
+}
@@ -0,0 +1,63 @@
+#!/usr/bin/env bash
+
+script_path="${PWD}/test"
+. ${script_path}/helpers.sh
+
+test="api"
+
+library_path="${PWD}/.libs"
+cc="${CC:-cc}"
+
+# C API client needs a C compiler and the library
+if ! command -v ${cc} >/dev/null 2>&1 ; then
+    echo "SKIP: ${test}, no C compiler" >&${fd}
+    exit 77
+fi
+if [ ! -e "${PWD}/librawcooked.la" ] ; then
+    fatal "internal" "librawcooked.la is missing, run make"
+fi
+
+pushd "${files_path}" >/dev/null 2>&1
+    ${cc} -I"${script_path}/../../../../Source" -o api "${script_path}/api.c" -L"${library_path}" -lrawcooked -Wl,-rpath,"${library_path}" >/dev/null 2>&1 || fatal "internal" "api client compilation failed"
+
+    for pix_fmt in rgb24 rgb48le gray16le ; do
+        file="api_${pix_fmt}"
+        mkdir -p "${file}" "${file}.raw"
+        ffmpeg -nostdin -f lavfi -i testsrc=size=64x48 -t 1 -pix_fmt ${pix_fmt} "${file}/%04d.dpx" >/dev/null 2>&1 || fatal "internal" "ffmpeg command failed"
+
+        run_rawcooked "${file}"
+        check_success "encoding failed" "encoding succeeded" || fatal "internal" "rawcooked command failed"
+
+        # reference from FFmpeg
+        ffmpeg -nostdin -i "${file}.mkv" -f framemd5 "${file}.framemd5" >/dev/null 2>&1 || fatal "internal" "ffmpeg command failed"
+
+        cmd_stderr="$(./api "${file}.mkv" "${file}.raw" 2>&1 >/dev/null)"
+        cmd_status="${?}"
+        check_success "decoding with the C API failed" "decoding with the C API succeeded" || continue
+
+        # size and hash of each frame
+        frame=0
+        frames_status=0
+        while IFS=, read -r index dts pts duration size hash ; do
+            raw="${file}.raw/0_${frame}.raw"
+            if [ "$(${fsize} "${raw}" 2>/dev/null)" != "$(echo ${size})" ] || [ "$(${md5cmd} "${raw}" | cut -d' ' -f1)" != "$(echo ${hash})" ] ; then
+                frames_status=1
+            fi
+            frame=$((frame + 1))
+        done < <(grep -v '^#' "${file}.framemd5")
+        if [ "${frame}" -ne "25" ] || [ "$(ls "${file}.raw" | wc -l)" -ne "25" ] ; then
+            frames_status=1
+        fi
+
+        if [ "${frames_status}" -ne "0" ] ; then
+            echo "NOK: ${test}/${file}, frames decoded with the C API are not same as FFmpeg ones" >&${fd}
+            status=1
+        else
+            echo "OK: ${test}/${file}, frames decoded with the C API are same as FFmpeg ones" >&${fd}
+        fi
+    done
+
+    clean
+popd >/dev/null 2>&1
+
+exit ${status}
@@ -0,0 +1,85 @@
+#!/usr/bin/env bash
+
+script_path="${PWD}/test"
+. ${script_path}/helpers.sh
+
+test="checklevel"
+
+# local helper functions
+swap_byte() {
+    local pos="${1}"
+    local file="${2}"
+    local buffer="$(xxd -u -p -l 1 -s ${pos} ${file})" || return 1
+    buffer="$(printf %02x $((0x${buffer}^255)))" || return 1
+    echo ${buffer} | xxd -r -p -l 1 -s ${pos} - ${file} || return 1
+}
+
+find_first() {
+    local pattern="${1}" file="${2}" size="$(${fsize} ${2})" chunk_size=256 pos=0
+    while ((pos < size)) ; do
+        local chunk="$(xxd -u -p -c ${chunk_size} -l ${chunk_size} -s ${pos} ${file})"
+        local prefix="${chunk%%${pattern}*}"
+        if ((${#prefix} < ${#chunk})) ; then
+            echo "$((pos + ${#prefix} / 2))"
+            return 0
+        fi
+        ((pos += chunk_size - ${#pattern} / 2 + 1))
+    done
+    return 1
+}
+
+pushd "${files_path}" >/dev/null 2>&1
+    file=checklevel1
+    mkdir -p "${file}"
+    ffmpeg -nostdin -f lavfi -i testsrc=size=16x16 -t 1 "${file}/%04d.dpx" >/dev/null 2>&1 || fatal "internal" "ffmpeg command failed"
+
+    run_rawcooked --hash "${file}"
+    check_success "encoding failed" "encoding succeeded" || fatal "internal" "rawcooked command failed"
+
+    # valid file
+    for level in container decode sample ; do
+        run_rawcooked --check-level ${level} "${file}.mkv"
+        check_success "check failed with ${level} level on valid file" "check succeeded with ${level} level on valid file" && echo "OK: ${test}/${file}, ${level} level on valid file" >&${fd}
+    done
+
+    run_rawcooked --check-level invalid "${file}.mkv"
+    check_failure "invalid check level rejected" "invalid check level accepted"
+
+    # 1 byte changed in the slice content of the first frame, after the first cluster header
+    cp -f "${file}.mkv" "${file}.orig.mkv" || fatal "internal" "cp command failed"
+    cluster="$(find_first "1F43B675" "${file}.mkv")" || fatal "internal" "cluster not found"
+    swap_byte $((cluster + 64)) "${file}.mkv" || fatal "internal" "unable to modify file"
+    ! cmp -s "${file}.mkv" "${file}.orig.mkv" || fatal "internal" "file not modified"
+
+    for level in container decode sample ; do
+        run_rawcooked --check-level ${level} "${file}.mkv"
+        if check_failure "check failed with ${level} level on corrupted slice" "check succeeded with ${level} level on corrupted slice" ; then
+            if [ "${level}" != "decode" ] && ! contains "checksum of compressed frame is wrong" "${cmd_stderr}" ; then
+                echo "NOK: ${test}/${file}, ${level} level, invalid error message, ${cmd_stderr}" >&${fd}
+                status=1
+            else
+                echo "OK: ${test}/${file}, ${level} level on corrupted slice" >&${fd}
+            fi
+        fi
+    done
+
+    # without slice CRC, container level decodes the frames for checking them
+    file=checklevel2
+    mkdir -p "${file}"
+    ffmpeg -nostdin -f lavfi -i testsrc=size=16x16 -t 1 "${file}/%04d.dpx" >/dev/null 2>&1 || fatal "internal" "ffmpeg command failed"
+
+    run_rawcooked --hash -slicecrc 0 "${file}"
+    check_success "encoding without slice CRC failed" "encoding without slice CRC succeeded" || fatal "internal" "rawcooked command failed"
+
+    run_rawcooked --check-level container "${file}.mkv"
+    check_success "check failed with container level on valid file without slice CRC" "check succeeded with container level on valid file without slice CRC" && echo "OK: ${test}/${file}, container level on valid file without slice CRC" >&${fd}
+
+    cluster="$(find_first "1F43B675" "${file}.mkv")" || fatal "internal" "cluster not found"
+    swap_byte $((cluster + 64)) "${file}.mkv" || fatal "internal" "unable to modify file"
+    run_rawcooked --check-level container "${file}.mkv"
+    check_failure "check failed with container level on corrupted slice without slice CRC" "check succeeded with container level on corrupted slice without slice CRC" && echo "OK: ${test}/${file}, container level on corrupted slice without slice CRC" >&${fd}
+
+    clean
+popd >/dev/null 2>&1
+
+exit ${status}
@@ -0,0 +1,64 @@
+#!/usr/bin/env bash
+
+script_path="${PWD}/test"
+. ${script_path}/helpers.sh
+
+test="containerhash"
+
+sha256cmd=
+if type -p sha256sum ; then
+    sha256cmd="sha256sum"
+elif type -p shasum ; then
+    sha256cmd="shasum -a 256"
+fi >/dev/null 2>&1
+
+pushd "${files_path}" >/dev/null 2>&1
+    file=containerhash1
+    mkdir -p "${file}"
+    ffmpeg -nostdin -f lavfi -i testsrc=size=16x16 -t 1 "${file}/%04d.dpx" >/dev/null 2>&1 || fatal "internal" "ffmpeg command failed"
+
+    run_rawcooked "${file}"
+    check_success "encoding failed" "encoding succeeded" || fatal "internal" "rawcooked command failed"
+
+    # digest computed during the check
+    md5="$(${md5cmd} "${file}.mkv" | cut -d' ' -f1)"
+    run_rawcooked --check --container-hash md5 "${file}.mkv"
+    if check_success "check with container hash failed" "check with container hash succeeded" ; then
+        if contains "MD5 of ${file}.mkv is ${md5}" "${cmd_stdout}" ; then
+            echo "OK: ${test}/${file}, MD5 of container" >&${fd}
+        else
+            echo "NOK: ${test}/${file}, MD5 of container is not ${md5}, ${cmd_stdout}" >&${fd}
+            status=1
+        fi
+    fi
+
+    # digest compared with a sidecar file
+    ${md5cmd} "${file}.mkv" | sed 's/ .*//' | sed "s|$|  ${file}.mkv|" > "${file}.mkv.md5"
+    run_rawcooked --check --container-hash-file "${file}.mkv.md5" "${file}.mkv"
+    check_success "check with MD5 sidecar failed" "check with MD5 sidecar succeeded" && echo "OK: ${test}/${file}, MD5 sidecar matches" >&${fd}
+
+    if [ -n "${sha256cmd}" ] ; then
+        ${sha256cmd} "${file}.mkv" > "${file}.mkv.sha256"
+        run_rawcooked --check --container-hash-file "${file}.mkv.sha256" "${file}.mkv"
+        check_success "check with SHA-256 sidecar failed" "check with SHA-256 sidecar succeeded" && echo "OK: ${test}/${file}, SHA-256 sidecar matches" >&${fd}
+    fi
+
+    # mismatch
+    echo "00000000000000000000000000000000  ${file}.mkv" > "${file}.mkv.md5"
+    run_rawcooked --check --container-hash-file "${file}.mkv.md5" "${file}.mkv"
+    if check_failure "check with wrong MD5 sidecar failed" "check with wrong MD5 sidecar succeeded" ; then
+        if contains "does not match" "${cmd_stderr}" ; then
+            echo "OK: ${test}/${file}, MD5 sidecar mismatch" >&${fd}
+        else
+            echo "NOK: ${test}/${file}, invalid error message, ${cmd_stderr}" >&${fd}
+            status=1
+        fi
+    fi
+
+    run_rawcooked --check --container-hash invalid "${file}.mkv"
+    check_failure "invalid container hash rejected" "invalid container hash accepted"
+
+    clean
+popd >/dev/null 2>&1
+
+exit ${status}
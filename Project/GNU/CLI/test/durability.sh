@@ -0,0 +1,38 @@
+#!/usr/bin/env bash
+
+script_path="${PWD}/test"
+. ${script_path}/helpers.sh
+
+test="durability"
+
+pushd "${files_path}" >/dev/null 2>&1
+    file=durability1
+    mkdir -p "${file}"
+    ffmpeg -nostdin -f lavfi -i testsrc=size=16x16 -r 1 -t 4 "${file}/%04d.dpx" >/dev/null 2>&1 || fatal "internal" "ffmpeg command failed"
+
+    run_rawcooked "${file}"
+    check_success "encoding failed" "encoding succeeded" || fatal "internal" "rawcooked command failed"
+
+    for durability in none batch file ; do
+        run_rawcooked --durability ${durability} "${file}.mkv"
+        if check_success "decoding failed with ${durability} durability" "decoding succeeded with ${durability} durability" ; then
+            check_directories "${file}" "${file}.mkv.RAWcooked" -n && echo "OK: ${test}/${file}, decoding with ${durability} durability" >&${fd}
+        fi
+
+        # last file of the batch is reported as durable
+        if [ "${durability}" == "batch" ] && ! contains "files are durable up to ${file}.mkv.RAWcooked/${file}/0004.dpx" "${cmd_stdout}" ; then
+            echo "NOK: ${test}/${file}, last durable file not reported, ${cmd_stdout}" >&${fd}
+            status=1
+        fi
+
+        rm -fr "${file}.mkv.RAWcooked"
+    done
+
+    run_rawcooked --durability invalid "${file}.mkv"
+    check_failure "invalid durability value rejected" "invalid durability value accepted"
+    rm -fr "${file}.mkv.RAWcooked"
+
+    clean
+popd >/dev/null 2>&1
+
+exit ${status}
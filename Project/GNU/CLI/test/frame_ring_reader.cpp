@@ -0,0 +1,78 @@
+/*  Copyright (c) MediaArea.net SARL & AV Preservation by reto.ch.
+ *
+ *  Use of this source code is governed by a BSD-style license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+/* Consumer of the frame ring for framering.sh
+ * Usage: frame_ring_reader name directory [count [delay]]
+ * Waits for the frame ring name, writes the planes of each frame into
+ * directory/<input>_<frame>.raw and checks that frames are in sequence.
+ * Stops after count frames if count is not 0 (the producer is told that the
+ * reader is closed), waits delay milliseconds after each frame before
+ * releasing it (the producer has to wait for free slots).
+ */
+
+#include "Lib/Utils/FrameRing/FrameRing.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+using namespace std;
+
+static int Error(const char* Message)
+{
+    fprintf(stderr, "Error: %s\n", Message);
+    return 1;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 3 || argc > 5)
+        return Error("usage: frame_ring_reader name directory [count [delay]]");
+    auto Count = argc > 3 ? strtoull(argv[3], nullptr, 10) : 0;
+    auto Delay = argc > 4 ? strtoul(argv[4], nullptr, 10) : 0;
+
+    // The producer creates the frame ring after having parsed the first frames
+    frame_ring_reader Reader;
+    for (int i = 0; Reader.Open(argv[1]); i++)
+    {
+        if (i == 200)
+            return Error("can not open the frame ring");
+        this_thread::sleep_for(chrono::milliseconds(50));
+    }
+
+    uint64_t Frames = 0;
+    while (!Count || Frames < Count)
+    {
+        auto Slot = Reader.Next();
+        if (!Slot)
+            break;
+        if (Slot->Sequence != Frames)
+            return Error("frames are not in sequence");
+
+        char FileName[4096];
+        snprintf(FileName, sizeof(FileName), "%s/%u_%llu.raw", argv[2], (unsigned)Slot->Input, (unsigned long long)Slot->Frame);
+        auto Output = fopen(FileName, "wb");
+        if (!Output)
+            return Error("can not create the frame file");
+        for (uint32_t i = 0; i < Slot->Planes_Count; i++)
+            if (fwrite(Reader.Data(Slot, i), 1, (size_t)Slot->Planes[i].Size, Output) != Slot->Planes[i].Size)
+            {
+                fclose(Output);
+                return Error("can not write the frame file");
+            }
+        fclose(Output);
+
+        if (Delay)
+            this_thread::sleep_for(chrono::milliseconds(Delay));
+        Reader.Release();
+        Frames++;
+    }
+
+    printf("%llu frames\n", (unsigned long long)Frames);
+    if (Reader.HasError())
+        return Error("producer reported an error");
+    Reader.Close();
+    return 0;
+}
@@ -0,0 +1,59 @@
+#!/usr/bin/env bash
+
+script_path="${PWD}/test"
+. ${script_path}/helpers.sh
+
+test="framemd5"
+
+# local helper functions
+check_framemd5() {
+    local framemd5="${1}"
+    local message="${2}"
+
+    if [ ! -s "${framemd5}" ] ; then
+        echo "NOK: ${test}/${file}, ${message}, ${framemd5} is missing" >&${fd}
+        status=1
+        return 1
+    fi
+
+    # size and hash of each frame, time base may be expressed differently
+    if ! diff -q <(grep -v '^#' "${file}.ref.framemd5" | cut -d, -f5,6) <(grep -v '^#' "${framemd5}" | cut -d, -f5,6) >/dev/null 2>&1 ; then
+        echo "NOK: ${test}/${file}, ${message}, framemd5 is not same as FFmpeg one" >&${fd}
+        status=1
+        return 1
+    fi
+
+    echo "OK: ${test}/${file}, ${message}" >&${fd}
+}
+
+pushd "${files_path}" >/dev/null 2>&1
+    # 8-bit, more than 8-bit, gray and 10-bit samples have each their own packing in the FFmpeg layout
+    for pix_fmt in rgb24 rgb48le gray16le gbrp10le ; do
+        file="framemd5_${pix_fmt}"
+        mkdir -p "${file}"
+        ffmpeg -nostdin -f lavfi -i testsrc=size=16x16 -t 1 -pix_fmt ${pix_fmt} "${file}/%04d.dpx" >/dev/null 2>&1 || fatal "internal" "ffmpeg command failed"
+
+        # framemd5 computed during the check after encoding
+        run_rawcooked --check --framemd5 "${file}"
+        check_success "encoding with framemd5 failed" "encoding with framemd5 succeeded" || fatal "internal" "rawcooked command failed"
+
+        # reference from FFmpeg
+        ffmpeg -nostdin -i "${file}.mkv" -f framemd5 "${file}.ref.framemd5" >/dev/null 2>&1 || fatal "internal" "ffmpeg command failed"
+        [ "$(grep -v '^#' "${file}.ref.framemd5" | wc -l)" -eq "25" ] || fatal "internal" "unexpected count of frames in FFmpeg framemd5"
+
+        check_framemd5 "${file}.framemd5" "framemd5 during encoding"
+
+        # framemd5 from the Matroska file
+        run_rawcooked --framemd5 "${file}.mkv"
+        check_success "decoding with framemd5 failed" "decoding with framemd5 succeeded" && check_framemd5 "${file}.mkv.framemd5" "framemd5 from Matroska file"
+        rm -fr "${file}.mkv.RAWcooked"
+
+        run_rawcooked --framemd5 --framemd5-name "${file}.custom.framemd5" "${file}.mkv"
+        check_success "decoding with framemd5 name failed" "decoding with framemd5 name succeeded" && check_framemd5 "${file}.custom.framemd5" "framemd5 from Matroska file with custom name"
+        rm -fr "${file}.mkv.RAWcooked"
+    done
+
+    clean
+popd >/dev/null 2>&1
+
+exit ${status}
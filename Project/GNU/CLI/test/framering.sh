@@ -0,0 +1,129 @@
+#!/usr/bin/env bash
+
+script_path="${PWD}/test"
+. ${script_path}/helpers.sh
+
+test="framering"
+
+cxx="${CXX:-c++}"
+source_path="${script_path}/../../../../Source"
+
+# local helper functions
+start_producer() {
+    local name="${1}" slots="${2}"
+    shift 2
+    rawcooked -threads 1 --frame-ring "${name}" --frame-ring-slots ${slots} "${@}" >producer.out 2>producer.err & producer=${!}
+}
+
+wait_producer() {
+    (sleep ${timeout} ; kill -KILL ${producer}) >/dev/null 2>&1 & local watcher=${!}
+    wait ${producer}
+    producer_status="${?}"
+    pkill -P ${watcher} >/dev/null 2>&1
+    kill ${watcher} >/dev/null 2>&1
+    producer_stderr="$(<producer.err)"
+}
+
+is_removed() {
+    [ ! -d /dev/shm ] || [ ! -e "/dev/shm/${1}" ]
+}
+
+# size and hash of each frame against FFmpeg ones
+check_frames() {
+    local file="${1}" directory="${2}" frame=0
+    while IFS=, read -r index dts pts duration size hash ; do
+        local raw="${directory}/0_${frame}.raw"
+        if [ "$(${fsize} "${raw}" 2>/dev/null)" != "$(echo ${size})" ] || [ "$(${md5cmd} "${raw}" | cut -d' ' -f1)" != "$(echo ${hash})" ] ; then
+            return 1
+        fi
+        frame=$((frame + 1))
+    done < <(grep -v '^#' "${file}.framemd5")
+    [ "${frame}" -eq "25" ] && [ "$(ls "${directory}" | wc -l)" -eq "25" ]
+}
+
+# C++ consumer needs a C++ compiler
+if ! command -v ${cxx} >/dev/null 2>&1 ; then
+    echo "SKIP: ${test}, no C++ compiler" >&${fd}
+    exit 77
+fi
+
+pushd "${files_path}" >/dev/null 2>&1
+    ${cxx} -std=c++11 -pthread -I"${source_path}" -o frame_ring_reader "${script_path}/frame_ring_reader.cpp" "${source_path}/Lib/Utils/FrameRing/FrameRing.cpp" >/dev/null 2>&1 \
+    || ${cxx} -std=c++11 -pthread -I"${source_path}" -o frame_ring_reader "${script_path}/frame_ring_reader.cpp" "${source_path}/Lib/Utils/FrameRing/FrameRing.cpp" -lrt >/dev/null 2>&1 \
+    || fatal "internal" "frame ring reader compilation failed"
+
+    file=framering
+    name="rawcooked_framering_${$}"
+    mkdir -p "${file}"
+    ffmpeg -nostdin -f lavfi -i testsrc=size=64x48 -t 1 "${file}/%04d.dpx" >/dev/null 2>&1 || fatal "internal" "ffmpeg command failed"
+    run_rawcooked "${file}"
+    check_success "encoding failed" "encoding succeeded" || fatal "internal" "rawcooked command failed"
+    ffmpeg -nostdin -i "${file}.mkv" -f framemd5 "${file}.framemd5" >/dev/null 2>&1 || fatal "internal" "ffmpeg command failed"
+
+    # all frames, the reader is slower than the producer with 1 or 2 slots
+    for slots in 8 2 1 ; do
+        directory="${file}_${slots}.raw"
+        mkdir -p "${directory}"
+        start_producer "${name}" ${slots} "${file}.mkv"
+        reader_stdout="$(./frame_ring_reader "${name}" "${directory}" 0 $((slots > 2 ? 0 : 20)) 2>/dev/null)"
+        reader_status="${?}"
+        wait_producer
+        if [ "${producer_status}" -ne "0" ] || [ "${reader_status}" -ne "0" ] || [ "${reader_stdout}" != "25 frames" ] ; then
+            echo "NOK: ${test}/${file}, ${slots} slots, reading failed, ${reader_stdout} ${producer_stderr}" >&${fd}
+            status=1
+        elif ! check_frames "${file}" "${directory}" ; then
+            echo "NOK: ${test}/${file}, ${slots} slots, frames from the frame ring are not same as FFmpeg ones" >&${fd}
+            status=1
+        elif ! is_removed "${name}" ; then
+            echo "NOK: ${test}/${file}, ${slots} slots, shared memory is not removed" >&${fd}
+            status=1
+        else
+            echo "OK: ${test}/${file}, ${slots} slots, frames from the frame ring are same as FFmpeg ones" >&${fd}
+        fi
+    done
+
+    # reader closes after 5 frames
+    directory="${file}_close.raw"
+    mkdir -p "${directory}"
+    start_producer "${name}" 2 "${file}.mkv"
+    reader_stdout="$(./frame_ring_reader "${name}" "${directory}" 5 2>/dev/null)"
+    wait_producer
+    if [ "${producer_status}" -ne "0" ] || [ "${reader_stdout}" != "5 frames" ] || ! contains "stopped by the reader" "${producer_stderr}" || ! is_removed "${name}" ; then
+        echo "NOK: ${test}/${file}, producer did not stop after the reader closed, ${reader_stdout} ${producer_stderr}" >&${fd}
+        status=1
+    else
+        echo "OK: ${test}/${file}, producer stops after the reader closed" >&${fd}
+    fi
+
+    # reader is killed while the producer waits for a free slot
+    directory="${file}_kill.raw"
+    mkdir -p "${directory}"
+    start_producer "${name}" 1 "${file}.mkv"
+    ./frame_ring_reader "${name}" "${directory}" 0 200 >/dev/null 2>&1 & reader=${!}
+    sleep 1
+    kill -KILL ${reader} >/dev/null 2>&1
+    wait ${reader} >/dev/null 2>&1
+    wait_producer
+    if [ "${producer_status}" -ne "0" ] || ! contains "stopped by the reader" "${producer_stderr}" || ! is_removed "${name}" ; then
+        echo "NOK: ${test}/${file}, producer did not stop after the reader was killed, ${producer_stderr}" >&${fd}
+        status=1
+    else
+        echo "OK: ${test}/${file}, producer stops after the reader was killed" >&${fd}
+    fi
+
+    # producer is terminated while it waits for a reader
+    start_producer "${name}" 1 "${file}.mkv"
+    sleep 1
+    kill -TERM ${producer} >/dev/null 2>&1
+    wait_producer
+    if [ "${producer_status}" -eq "0" ] || [ "${producer_status}" -gt "128" ] || ! is_removed "${name}" ; then
+        echo "NOK: ${test}/${file}, producer did not stop cleanly on SIGTERM, ${producer_stderr}" >&${fd}
+        status=1
+    else
+        echo "OK: ${test}/${file}, producer stops cleanly on SIGTERM" >&${fd}
+    fi
+
+    clean
+popd >/dev/null 2>&1
+
+exit ${status}
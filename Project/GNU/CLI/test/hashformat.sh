@@ -0,0 +1,58 @@
+#!/usr/bin/env bash
+
+script_path="${PWD}/test"
+. ${script_path}/helpers.sh
+
+test="hashformat"
+
+pushd "${files_path}" >/dev/null 2>&1
+    for hash_format in xxh3 blake3 sha256 ; do
+        # hash list in MD5, a format which is not the one of the reversibility data
+        file="hashformat_${hash_format}"
+        mkdir -p "${file}"
+        ffmpeg -nostdin -f lavfi -i testsrc=size=16x16 -t 0.4 "${file}/%04d.dpx" >/dev/null 2>&1 || fatal "internal" "ffmpeg command failed"
+        pushd "${file}" >/dev/null 2>&1
+            ${md5cmd} *.dpx > "${file}.md5"
+        popd >/dev/null 2>&1
+
+        run_rawcooked --hash --hash-format ${hash_format} "${file}"
+        check_success "encoding failed" "encoding succeeded" || continue
+
+        run_rawcooked --check "${file}.mkv"
+        check_success "check failed" "check succeeded" && echo "OK: ${test}/${file}, check with ${hash_format} hashes and MD5 hash list" >&${fd}
+
+        run_rawcooked "${file}.mkv"
+        if check_success "decoding failed" "decoding succeeded" ; then
+            check_directories "${file}" "${file}.mkv.RAWcooked" && echo "OK: ${test}/${file}, decoding with ${hash_format} hashes and MD5 hash list" >&${fd}
+        fi
+
+        # the hash list is attached, a modified hash list is detected
+        content="$(grep -abo "$(head -c 32 "${file}/${file}.md5")" "${file}.mkv" | head -1 | cut -d: -f1)"
+        if [ -n "${content}" ] ; then
+            [ "$(head -c 1 "${file}/${file}.md5")" != "0" ] && digit=0 || digit=1
+            printf "${digit}" | dd of="${file}.mkv" bs=1 seek=${content} conv=notrunc >/dev/null 2>&1
+            run_rawcooked --check "${file}.mkv"
+            check_failure "check failed with a modified hash list" "check succeeded with a modified hash list" && echo "OK: ${test}/${file}, modified hash list with ${hash_format} hashes" >&${fd}
+        fi
+    done
+
+    # big frames, BLAKE3 subtrees are hashed by several threads
+    file=hashformat_blake3_threads
+    mkdir -p "${file}"
+    ffmpeg -nostdin -f lavfi -i testsrc=size=640x480 -t 0.2 -pix_fmt rgb48le "${file}/%04d.dpx" >/dev/null 2>&1 || fatal "internal" "ffmpeg command failed"
+
+    run_rawcooked -threads 4 --hash --hash-format blake3 "${file}"
+    if check_success "encoding failed" "encoding succeeded" ; then
+        run_rawcooked -threads 4 "${file}.mkv"
+        if check_success "decoding failed" "decoding succeeded" ; then
+            check_directories "${file}" "${file}.mkv.RAWcooked" && echo "OK: ${test}/${file}, BLAKE3 hashes of big files" >&${fd}
+        fi
+    fi
+
+    run_rawcooked --hash --hash-format invalid "${file}"
+    check_failure "invalid hash format rejected" "invalid hash format accepted"
+
+    clean
+popd >/dev/null 2>&1
+
+exit ${status}
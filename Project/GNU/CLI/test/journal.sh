@@ -0,0 +1,80 @@
+#!/usr/bin/env bash
+
+script_path="${PWD}/test"
+. ${script_path}/helpers.sh
+
+test="journal"
+
+pushd "${files_path}" >/dev/null 2>&1
+    file=journal1
+    mkdir -p "${file}"
+    ffmpeg -nostdin -f lavfi -i testsrc=size=16x16 -r 1 -t 4 "${file}/%04d.dpx" >/dev/null 2>&1 || fatal "internal" "ffmpeg command failed"
+
+    run_rawcooked "${file}"
+    check_success "encoding failed" "encoding succeeded" || fatal "internal" "rawcooked command failed"
+
+    # no journal without --resume
+    mkdir -p "${file}.mkv.RAWcooked/${file}/0003.dpx"
+    run_rawcooked "${file}.mkv"
+    check_failure "decoding failed" "decoding succeeded despite an output file which can not be created"
+    if [ -e "${file}.mkv.RAWcooked.rawcooked_journal" ] ; then
+        echo "NOK: ${test}/${file}, journal is created without --resume" >&${fd}
+        status=1
+    fi
+    rm -fr "${file}.mkv.RAWcooked"
+
+    # interrupted decoding, an output file can not be created
+    mkdir -p "${file}.mkv.RAWcooked/${file}/0003.dpx"
+    run_rawcooked --resume "${file}.mkv"
+    check_failure "decoding failed" "decoding succeeded despite an output file which can not be created"
+    if [ ! -s "${file}.mkv.RAWcooked.rawcooked_journal" ] ; then
+        echo "NOK: ${test}/${file}, journal is missing after an interrupted decoding" >&${fd}
+        status=1
+    fi
+    for f in 0001 0002 0004 ; do
+        if ! grep -q " ${file}/${f}.dpx$" "${file}.mkv.RAWcooked.rawcooked_journal" ; then
+            echo "NOK: ${test}/${file}, ${f}.dpx is missing in the journal" >&${fd}
+            status=1
+        fi
+    done
+    if grep -q " ${file}/0003.dpx$" "${file}.mkv.RAWcooked.rawcooked_journal" ; then
+        echo "NOK: ${test}/${file}, 0003.dpx is in the journal but was not written" >&${fd}
+        status=1
+    fi
+
+    # resumed decoding, only the missing file is decoded
+    rmdir "${file}.mkv.RAWcooked/${file}/0003.dpx"
+    run_rawcooked --resume "${file}.mkv"
+    if check_success "resumed decoding failed" "resumed decoding succeeded" ; then
+        if ! contains "3 files already decoded were not decoded again" "${cmd_stdout}" ; then
+            echo "NOK: ${test}/${file}, complete files were decoded again, ${cmd_stdout}" >&${fd}
+            status=1
+        fi
+        check_directories "${file}" "${file}.mkv.RAWcooked" -n && echo "OK: ${test}/${file}, decoding resumed" >&${fd}
+    fi
+    if [ -e "${file}.mkv.RAWcooked.rawcooked_journal" ] ; then
+        echo "NOK: ${test}/${file}, journal is not removed after a complete decoding" >&${fd}
+        status=1
+    fi
+
+    # journal of a complete file which changed since is not trusted, also with the same size
+    for change in size content ; do
+        rm -fr "${file}.mkv.RAWcooked"
+        mkdir -p "${file}.mkv.RAWcooked/${file}/0003.dpx"
+        run_rawcooked --resume "${file}.mkv"
+        rmdir "${file}.mkv.RAWcooked/${file}/0003.dpx"
+        if [ "${change}" = "size" ] ; then
+            echo 1 >> "${file}.mkv.RAWcooked/${file}/0002.dpx"
+        else
+            printf 'X' | dd of="${file}.mkv.RAWcooked/${file}/0002.dpx" bs=1 seek=2100 conv=notrunc >/dev/null 2>&1
+        fi
+        run_rawcooked -y --resume "${file}.mkv"
+        if check_success "resumed decoding of a file modified in ${change} failed" "resumed decoding of a file modified in ${change} succeeded" ; then
+            check_directories "${file}" "${file}.mkv.RAWcooked" -n && echo "OK: ${test}/${file}, file modified in ${change} decoded again" >&${fd}
+        fi
+    done
+
+    clean
+popd >/dev/null 2>&1
+
+exit ${status}
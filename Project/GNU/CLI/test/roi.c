@@ -0,0 +1,153 @@
+/*  Copyright (c) MediaArea.net SARL & AV Preservation by reto.ch.
+ *
+ *  Use of this source code is governed by a BSD-style license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+/* Client of the region of interest API for roi.sh
+ * Usage: roi file.mkv X Y Width Height Decimation
+ * Decodes all frames of the first track with the region and compares them
+ * with the same region taken from the whole frames, with the copy and with
+ * the callback.
+ */
+
+#include "Lib/API/RAWcooked_API.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct
+{
+    uint8_t*    Data;
+    size_t      Size;
+} planes;
+
+typedef struct
+{
+    planes      Content;
+    uint32_t    X;
+    uint32_t    Y;
+    uint32_t    Width;
+    uint32_t    Height;
+    uint32_t    Decimation;
+    uint32_t    Frame_Width;
+    uint32_t    Frame_Height;
+} reference;
+
+static void Append(planes* Content, const uint8_t* Data, size_t Size)
+{
+    Content->Data = (uint8_t*)realloc(Content->Data, Content->Size + Size);
+    memcpy(Content->Data + Content->Size, Data, Size);
+    Content->Size += Size;
+}
+
+/* Region taken from the whole frame, pixel per pixel */
+static void Reference_Callback(void* Opaque, const rawcooked_plane* Planes, size_t Planes_Count)
+{
+    reference* Ref = (reference*)Opaque;
+    size_t i;
+    Ref->Content.Size = 0;
+    for (i = 0; i < Planes_Count; i++)
+    {
+        const rawcooked_plane* Plane = &Planes[i];
+        size_t Sub_X = (Ref->Frame_Width + Plane->Width - 1) / Plane->Width;
+        size_t Sub_Y = (Ref->Frame_Height + Plane->Height - 1) / Plane->Height;
+        size_t X_Begin = Ref->X / Sub_X;
+        size_t Y_Begin = Ref->Y / Sub_Y;
+        size_t X_End = (Ref->X + Ref->Width + Sub_X - 1) / Sub_X;
+        size_t Y_End = (Ref->Y + Ref->Height + Sub_Y - 1) / Sub_Y;
+        size_t x, y;
+        if (X_End > Plane->Width)
+            X_End = Plane->Width;
+        if (Y_End > Plane->Height)
+            Y_End = Plane->Height;
+        for (y = Y_Begin; y < Y_End; y += Ref->Decimation)
+            for (x = X_Begin; x < X_End; x += Ref->Decimation)
+                Append(&Ref->Content, Plane->Data + y * Plane->BytesPerLine + x * Plane->BytesPerBlock, Plane->BytesPerBlock);
+    }
+}
+
+/* Lines of the provided planes, without what is after the region */
+static void Region_Callback(void* Opaque, const rawcooked_plane* Planes, size_t Planes_Count)
+{
+    planes* Content = (planes*)Opaque;
+    size_t i, y;
+    Content->Size = 0;
+    for (i = 0; i < Planes_Count; i++)
+        for (y = 0; y < Planes[i].Height; y++)
+            Append(Content, Planes[i].Data + y * Planes[i].BytesPerLine, Planes[i].Width * Planes[i].BytesPerBlock);
+}
+
+static int Error(const char* Message, rawcooked_file* File)
+{
+    fprintf(stderr, "Error: %s%s%s\n", Message, File ? ", " : "", File ? rawcooked_error(File) : "");
+    return 1;
+}
+
+int main(int argc, char* argv[])
+{
+    rawcooked_file* Whole;
+    rawcooked_file* Region;
+    rawcooked_track_info Info;
+    reference Ref;
+    planes Content = { NULL, 0 };
+    uint8_t* Buffer = NULL;
+    uint64_t Frame;
+    int Result = 0;
+
+    if (argc != 7)
+        return Error("usage: roi file.mkv X Y Width Height Decimation", NULL);
+    if (rawcooked_open(argv[1], &Whole) || rawcooked_open(argv[1], &Region))
+        return Error("can not open the file", NULL);
+    if (rawcooked_track_info_get(Whole, 0, &Info))
+        return Error("can not get track info", Whole);
+
+    memset(&Ref, 0, sizeof(Ref));
+    Ref.X = (uint32_t)atoi(argv[2]);
+    Ref.Y = (uint32_t)atoi(argv[3]);
+    Ref.Width = (uint32_t)atoi(argv[4]);
+    Ref.Height = (uint32_t)atoi(argv[5]);
+    Ref.Decimation = (uint32_t)atoi(argv[6]);
+    Ref.Frame_Width = Info.Width;
+    Ref.Frame_Height = Info.Height;
+    if (rawcooked_set_region(Region, 0, Ref.X, Ref.Y, Ref.Width, Ref.Height, Ref.Decimation))
+    {
+        /* Error message is checked by the caller */
+        printf("%s\n", rawcooked_error(Region));
+        return 2;
+    }
+    if (!Ref.Width || !Ref.Height)
+    {
+        Ref.X = Ref.Y = 0;
+        Ref.Width = Info.Width;
+        Ref.Height = Info.Height;
+    }
+    if (!Ref.Decimation)
+        Ref.Decimation = 1;
+
+    for (Frame = 0; Frame < Info.FrameCount && !Result; Frame++)
+    {
+        size_t Size = 0;
+        if (rawcooked_decode_frame(Whole, 0, Frame, Reference_Callback, &Ref))
+            Result = Error("can not decode the whole frame", Whole);
+        else if (rawcooked_decode_frame_to(Region, 0, Frame, NULL, 0, &Size) != RAWCOOKED_ERROR_BUFFER)
+            Result = Error("size query did not provide the size", Region);
+        else if (!(Buffer = (uint8_t*)realloc(Buffer, Size)) || rawcooked_decode_frame_to(Region, 0, Frame, Buffer, Size, &Size))
+            Result = Error("can not decode the region", Region);
+        else if (Size != Ref.Content.Size || memcmp(Buffer, Ref.Content.Data, Size))
+            Result = Error("copy of the region is not same as the region of the whole frame", NULL);
+        else if (rawcooked_decode_frame(Region, 0, Frame, Region_Callback, &Content))
+            Result = Error("can not decode the region with a callback", Region);
+        else if (Content.Size != Ref.Content.Size || memcmp(Content.Data, Ref.Content.Data, Content.Size))
+            Result = Error("callback of the region is not same as the region of the whole frame", NULL);
+    }
+    if (!Result)
+        printf("%llu frames, %u bytes per frame\n", (unsigned long long)Info.FrameCount, (unsigned)Ref.Content.Size);
+
+    free(Buffer);
+    free(Content.Data);
+    free(Ref.Content.Data);
+    rawcooked_close(Whole);
+    rawcooked_close(Region);
+    return Result;
+}
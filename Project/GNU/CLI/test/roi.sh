@@ -0,0 +1,51 @@
+#!/usr/bin/env bash
+
+script_path="${PWD}/test"
+. ${script_path}/helpers.sh
+
+test="roi"
+
+library_path="${PWD}/.libs"
+cc="${CC:-cc}"
+
+# C API client needs a C compiler and the library
+if ! command -v ${cc} >/dev/null 2>&1 ; then
+    echo "SKIP: ${test}, no C compiler" >&${fd}
+    exit 77
+fi
+if [ ! -e "${PWD}/librawcooked.la" ] ; then
+    fatal "internal" "librawcooked.la is missing, run make"
+fi
+
+pushd "${files_path}" >/dev/null 2>&1
+    ${cc} -I"${script_path}/../../../../Source" -o roi "${script_path}/roi.c" -L"${library_path}" -lrawcooked -Wl,-rpath,"${library_path}" >/dev/null 2>&1 || fatal "internal" "roi client compilation failed"
+
+    for pix_fmt in rgb24 rgb48le gray16le ; do
+        file="roi_${pix_fmt}"
+        mkdir -p "${file}"
+        ffmpeg -nostdin -f lavfi -i testsrc=size=128x96 -t 0.4 -pix_fmt ${pix_fmt} "${file}/%04d.dpx" >/dev/null 2>&1 || fatal "internal" "ffmpeg command failed"
+
+        run_rawcooked "${file}"
+        check_success "encoding failed" "encoding succeeded" || fatal "internal" "rawcooked command failed"
+
+        # X Y Width Height Decimation: whole frame, region, region at the bottom right corner, decimation, region crossing slices with decimation
+        for region in "0 0 0 0 0" "10 7 33 21 1" "96 72 32 24 1" "0 0 0 0 2" "5 3 100 80 3" ; do
+            cmd_stderr="$(./roi "${file}.mkv" ${region} 2>&1 >/dev/null)"
+            cmd_status="${?}"
+            if check_success "region ${region} failed" "region ${region} succeeded" ; then
+                echo "OK: ${test}/${file}, region ${region} is same as in the whole frame" >&${fd}
+            fi
+        done
+
+        # region out of the frame
+        cmd_stdout="$(./roi "${file}.mkv" 100 0 64 10 1 2>/dev/null)"
+        if [ "${?}" -ne "2" ] || ! contains "region is out of the frame" "${cmd_stdout}" ; then
+            echo "NOK: ${test}/${file}, region out of the frame is accepted" >&${fd}
+            status=1
+        fi
+    done
+
+    clean
+popd >/dev/null 2>&1
+
+exit ${status}
@@ -0,0 +1,156 @@
+#!/usr/bin/env bash
+
+script_path="${PWD}/test"
+. ${script_path}/helpers.sh
+
+test="serve"
+
+# local helper functions
+swap_byte() {
+    local pos="${1}"
+    local file="${2}"
+    local buffer="$(xxd -u -p -l 1 -s ${pos} ${file})" || return 1
+    buffer="$(printf %02x $((0x${buffer}^255)))" || return 1
+    echo ${buffer} | xxd -r -p -l 1 -s ${pos} - ${file} || return 1
+}
+
+find_first() {
+    local pattern="${1}" file="${2}" size="$(${fsize} ${2})" chunk_size=256 pos=0
+    while ((pos < size)) ; do
+        local chunk="$(xxd -u -p -c ${chunk_size} -l ${chunk_size} -s ${pos} ${file})"
+        local prefix="${chunk%%${pattern}*}"
+        if ((${#prefix} < ${#chunk})) ; then
+            echo "$((pos + ${#prefix} / 2))"
+            return 0
+        fi
+        ((pos += chunk_size - ${#pattern} / 2 + 1))
+    done
+    return 1
+}
+
+# sends the JSON lines of stdin on one connection, prints "id event [details]" per received event
+# until the end of all jobs
+client_script="$(cat <<'EOF'
+import json, socket, sys
+jobs = sys.stdin.read().splitlines()
+client = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+client.settimeout(60)
+client.connect(sys.argv[1])
+client.sendall(''.join(job + '\n' for job in jobs).encode())
+ends = 0
+pending = b''
+while ends < len(jobs):
+    data = client.recv(4096)
+    if not data:
+        break
+    pending += data
+    while b'\n' in pending:
+        line, pending = pending.split(b'\n', 1)
+        event = json.loads(line)
+        details = ''
+        if event['event'] == 'progress':
+            if 'percent' in event:
+                details = 'percent'
+            elif 'total' in event:
+                details = '%d/%d' % (event['done'], event['total'])
+            else:
+                details = '%d' % event['done']
+        elif event['event'] == 'end':
+            details = event['status'] + ' ' + event.get('message', '')
+            ends += 1
+        elif event['event'] == 'log':
+            details = event['text']
+        print(event['id'], event['event'], details)
+EOF
+)"
+
+run_client() {
+    python3 -c "${client_script}" "${1}"
+}
+
+if ! command -v python3 >/dev/null 2>&1 ; then
+    echo "SKIP: ${test}, python3 is missing" >&${fd}
+    exit 77
+fi
+
+pushd "${files_path}" >/dev/null 2>&1
+    file=serve1
+    socket="${files_path}/serve.sock"
+    mkdir -p "${file}"
+    ffmpeg -nostdin -f lavfi -i testsrc=size=16x16 -t 1 "${file}/%04d.dpx" >/dev/null 2>&1 || fatal "internal" "ffmpeg command failed"
+
+    rawcooked -threads 2 --serve-jobs 1 --serve "${socket}" >/dev/null 2>&1 & server=${!}
+    for i in $(seq 50) ; do
+        [ -S "${socket}" ] && break
+        sleep 0.1
+    done
+    if [ ! -S "${socket}" ] || ! kill -0 ${server} >/dev/null 2>&1 ; then
+        kill ${server} >/dev/null 2>&1
+        fatal "internal" "server is not listening"
+    fi
+
+    # jobs of a connection are run one after the other
+    events="$(run_client "${socket}" 2>&1 <<EOF
+{"id": "encode", "type": "encode", "args": ["-y", "--hash", "${file}"]}
+{"id": "check", "type": "check", "input": "${file}.mkv"}
+{"id": "frames", "type": "decode-frames", "input": "${file}.mkv"}
+{"id": 4, "type": "unknown"}
+not a JSON object
+EOF
+)"
+    for expected in "encode end ok" "check progress percent" "check end ok" "frames progress 25/25" "frames end ok" "4 end error job type unknown is unknown" "None end error request is not a JSON object" ; do
+        if contains "^${expected}" "${events}" ; then
+            echo "OK: ${test}/${file}, ${expected}" >&${fd}
+        else
+            echo "NOK: ${test}/${file}, ${expected} is missing, ${events}" >&${fd}
+            status=1
+        fi
+    done
+    if contains "^check log Time=" "${events}" ; then
+        echo "NOK: ${test}/${file}, progress of the child is sent as log, ${events}" >&${fd}
+        status=1
+    fi
+
+    # jobs of 2 connections, child jobs wait for a free place
+    run_client "${socket}" >serve_client1.txt 2>&1 <<<"{\"id\": \"check1\", \"type\": \"check\", \"input\": \"${file}.mkv\"}" & client1=${!}
+    run_client "${socket}" >serve_client2.txt 2>&1 <<<"{\"id\": \"check2\", \"type\": \"check\", \"input\": \"${file}.mkv\"}" & client2=${!}
+    wait ${client1} ${client2}
+    events="$(cat serve_client1.txt serve_client2.txt)"
+    for expected in "check1 end ok" "check2 end ok" ; do
+        if contains "^${expected}" "${events}" ; then
+            echo "OK: ${test}/${file}, 2 connections, ${expected}" >&${fd}
+        else
+            echo "NOK: ${test}/${file}, 2 connections, ${expected} is missing, ${events}" >&${fd}
+            status=1
+        fi
+    done
+
+    # 1 byte changed in the slice content of the first frame, both checks fail
+    cluster="$(find_first "1F43B675" "${file}.mkv")" || { kill ${server} ; fatal "internal" "cluster not found" ; }
+    swap_byte $((cluster + 64)) "${file}.mkv" || { kill ${server} ; fatal "internal" "unable to modify file" ; }
+    events="$(run_client "${socket}" 2>&1 <<EOF
+{"id": "check", "type": "check", "input": "${file}.mkv"}
+{"id": "frames", "type": "decode-frames", "input": "${file}.mkv"}
+EOF
+)"
+    for expected in "check end error" "frames end error" ; do
+        if contains "^${expected}" "${events}" ; then
+            echo "OK: ${test}/${file}, corrupted file, ${expected}" >&${fd}
+        else
+            echo "NOK: ${test}/${file}, corrupted file, ${expected} is missing, ${events}" >&${fd}
+            status=1
+        fi
+    done
+
+    # server stops on SIGTERM and removes its socket
+    kill -TERM ${server}
+    wait ${server}
+    if [ "${?}" -ne "0" ] || [ -e "${socket}" ] ; then
+        echo "NOK: ${test}/${file}, server did not stop cleanly" >&${fd}
+        status=1
+    fi
+
+    clean
+popd >/dev/null 2>&1
+
+exit ${status}
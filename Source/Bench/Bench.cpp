@@ -0,0 +1,614 @@
+/*  Copyright (c) MediaArea.net SARL & AV Preservation by reto.ch.
+ *
+ *  Use of this source code is governed by a BSD-style license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//---------------------------------------------------------------------------
+#include "Bench/Corpus.h"
+#include "Bench/Cpu.h"
+#include "Bench/Kernels.h"
+#include "Lib/Compressed/Matroska/Matroska.h"
+#include "Lib/Compressed/RAWcooked/RAWcooked.h"
+#include "Lib/Uncompressed/DPX/DPX.h"
+#include "Lib/Uncompressed/TIFF/TIFF.h"
+#include "Lib/Uncompressed/EXR/EXR.h"
+#include "Lib/Utils/FileIO/FileIO.h"
+#include "Lib/Utils/Stats/Stats.h"
+#include "Lib/ThirdParty/thread-pool/include/ThreadPool.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <thread>
+using namespace std;
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+#if defined(_WIN32) || defined(_WINDOWS)
+    static const char* NullDevice = "NUL";
+#else
+    static const char* NullDevice = "/dev/null";
+#endif
+
+//***************************************************************************
+// Config
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+struct resolution
+{
+    uint32_t                    Width;
+    uint32_t                    Height;
+
+    string                      ToString() const { return to_string(Width) + 'x' + to_string(Height); }
+};
+
+//---------------------------------------------------------------------------
+struct config
+{
+    vector<resolution>          Resolutions;
+    resolution                  Fixture_Resolution = { 1920, 1080 };
+    uint32_t                    Frames = 8;
+    unsigned                    Threads = 0;
+    bool                        Kernels = false;
+    uint32_t                    Warmup = 3;
+    uint32_t                    Repetitions = 15;
+    string                      Filter;
+    string                      FixturesDirectoryName;
+    string                      RAWcookedName = "rawcooked";
+    string                      OutputFileName;
+};
+
+//---------------------------------------------------------------------------
+// Flavors of the FFV1 fixtures, encoded with each used coder and each slice count
+static const corpus::flavor_info Fixture_Flavors[] =
+{
+    { Parser_DPX, (uint8_t)dpx::flavor::Raw_RGB_10_FilledA_BE },
+    { Parser_DPX, (uint8_t)dpx::flavor::Raw_RGB_16_BE },
+    { Parser_DPX, (uint8_t)dpx::flavor::Raw_Y_16_LE },
+    { Parser_DPX, (uint8_t)dpx::flavor::Raw_Y_8 },
+    { Parser_TIFF, (uint8_t)tiff::flavor::Raw_RGB_8_U },
+};
+static const int Fixture_Coders[] = { 0, 1 }; // Golomb-Rice, range coder
+
+//---------------------------------------------------------------------------
+// FFmpeg forces the range coder above 8 bits, Golomb-Rice fixtures would be range coder ones
+static bool Fixture_IsCoderUsed(const corpus::flavor_info& Flavor, int Coder)
+{
+    return Coder || corpus::BitDepth(Flavor) <= 8;
+}
+static const int Fixture_Slices[] = { 4, 9, 16, 24, 36, 64 };
+
+//***************************************************************************
+// Results
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+struct result
+{
+    string                      Name;
+    string                      Format;
+    resolution                  Resolution;
+    int                         Coder = -1;
+    int                         Slices = -1;
+    uint64_t                    Frames = 0;
+    uint64_t                    Bytes = 0;
+    uint64_t                    Duration = 0; // In nanoseconds
+    uint64_t                    Cycles = 0; // Time stamp counter ticks, 0 if not available
+};
+
+//---------------------------------------------------------------------------
+static string Json_String(const string& Value)
+{
+    string Result("\"");
+    for (auto Char : Value)
+    {
+        if (Char == '\"' || Char == '\\')
+            Result += '\\';
+        Result += Char;
+    }
+    Result += '\"';
+    return Result;
+}
+
+//---------------------------------------------------------------------------
+static void Json(ostream& Out, const config& Config, const vector<result>& Results, const vector<kernel_result>& Kernels, const vector<string>& Errors)
+{
+    Out << fixed << setprecision(3);
+    Out << "{\n";
+    Out << "  \"cpu\": { \"architecture\": " << Json_String(cpu::Architecture())
+        << ", \"name\": " << Json_String(cpu::Name())
+        << ", \"features\": [";
+    auto Features = cpu::Features();
+    for (size_t i = 0; i < Features.size(); i++)
+        Out << (i ? ", " : "") << Json_String(Features[i]);
+    Out << "], \"compiler\": " << Json_String(cpu::Compiler()) << " },\n";
+    Out << "  \"threads\": " << Config.Threads << ",\n";
+    Out << "  \"benchmarks\": [";
+    for (size_t i = 0; i < Results.size(); i++)
+    {
+        const auto& Result = Results[i];
+        auto Seconds = (double)Result.Duration / 1000000000;
+        auto Pixels = (double)Result.Frames * Result.Resolution.Width * Result.Resolution.Height;
+        Out << (i ? ",\n" : "\n");
+        Out << "    { \"name\": " << Json_String(Result.Name)
+            << ", \"format\": " << Json_String(Result.Format)
+            << ", \"resolution\": " << Json_String(Result.Resolution.ToString());
+        if (Result.Coder >= 0)
+            Out << ", \"coder\": " << Result.Coder;
+        if (Result.Slices >= 0)
+            Out << ", \"slices\": " << Result.Slices;
+        Out << ", \"frames\": " << Result.Frames
+            << ", \"bytes\": " << Result.Bytes
+            << ", \"seconds\": " << Seconds
+            << ", \"mb_per_s\": " << (Seconds ? Result.Bytes / Seconds / 1000000 : 0)
+            << ", \"frames_per_s\": " << (Seconds ? Result.Frames / Seconds : 0)
+            << ", \"cycles_per_pixel\": ";
+        if (Result.Cycles && Pixels)
+            Out << Result.Cycles / Pixels;
+        else
+            Out << "null";
+        Out << " }";
+    }
+    Out << "\n  ],\n";
+    Out << "  \"kernels\": [";
+    for (size_t i = 0; i < Kernels.size(); i++)
+    {
+        const auto& Kernel = Kernels[i];
+        Out << (i ? ",\n" : "\n");
+        Out << "    { \"name\": " << Json_String(Kernel.Name)
+            << ", \"variant\": " << Json_String(Kernel.Variant)
+            << ", \"resolution\": ";
+        if (Kernel.Width && Kernel.Height)
+            Out << Json_String(to_string(Kernel.Width) + 'x' + to_string(Kernel.Height));
+        else
+            Out << "null";
+        Out << ", \"unit\": " << Json_String(Kernel.Unit)
+            << ", \"items\": " << Kernel.Items
+            << ", \"bytes\": " << Kernel.Bytes
+            << ", \"repetitions\": " << Kernel.Repetitions
+            << ", \"median_ns\": " << Kernel.Median
+            << ", \"min_ns\": " << Kernel.Min
+            << ", \"mean_ns\": " << Kernel.Mean
+            << ", \"stddev_ns\": " << Kernel.StdDev
+            << ", \"ns_per_item\": " << (Kernel.Items ? Kernel.Median / Kernel.Items : 0)
+            << ", \"mb_per_s\": " << (Kernel.Median ? Kernel.Bytes * 1000 / Kernel.Median : 0)
+            << ", \"cycles_per_item\": ";
+        if (Kernel.Cycles && Kernel.Items)
+            Out << Kernel.Cycles / Kernel.Items;
+        else
+            Out << "null";
+        Out << " }";
+    }
+    Out << (Kernels.empty() ? "],\n" : "\n  ],\n");
+    Out << "  \"errors\": [";
+    for (size_t i = 0; i < Errors.size(); i++)
+        Out << (i ? ",\n" : "\n") << "    " << Json_String(Errors[i]);
+    Out << (Errors.empty() ? "]\n" : "\n  ]\n");
+    Out << "}\n";
+}
+
+//***************************************************************************
+// Benchmarks
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+static bool IsFiltered(const config& Config, const result& Result)
+{
+    if (Config.Filter.empty())
+        return false;
+    auto Name = Result.Name + ' ' + Result.Format + ' ' + Result.Resolution.ToString();
+    if (Result.Coder >= 0)
+        Name += " coder" + to_string(Result.Coder);
+    if (Result.Slices >= 0)
+        Name += " slices" + to_string(Result.Slices);
+    return Name.find(Config.Filter) == string::npos;
+}
+
+//---------------------------------------------------------------------------
+static input_base_uncompressed* New_Parser(parser Parser, errors* Errors)
+{
+    switch (Parser)
+    {
+        case Parser_TIFF: return new tiff(Errors);
+        case Parser_EXR: return new exr(Errors);
+        default: return new dpx(Errors);
+    }
+}
+
+//---------------------------------------------------------------------------
+static user_mode Ask_Callback(user_mode*, const string&, const string&, bool, bool*, condition_variable*)
+{
+    return AlwaysYes;
+}
+
+//---------------------------------------------------------------------------
+// Parsing of input frames and creation of reversibility data, as during encoding
+static void Analysis(const config& Config, vector<result>& Results, vector<string>& Errors_List)
+{
+    for (const auto& Flavor : corpus::Flavors())
+        for (const auto& Resolution : Config.Resolutions)
+        {
+            result Result;
+            Result.Name = "analysis";
+            Result.Format = corpus::Flavor_String(Flavor);
+            Result.Resolution = Resolution;
+            if (IsFiltered(Config, Result))
+                continue;
+
+            buffer Frame;
+            corpus::Generate(Frame, Flavor, Resolution.Width, Resolution.Height, 0);
+
+            errors Errors;
+            user_mode Mode = AlwaysYes;
+            rawcooked RAWcooked;
+            RAWcooked.FileName = NullDevice;
+            RAWcooked.Mode = &Mode;
+            RAWcooked.Ask_Callback = Ask_Callback;
+            RAWcooked.Errors = &Errors;
+            RAWcooked.OutputFileName = string("00000000.") + corpus::Extension(Flavor.Parser);
+            unique_ptr<input_base_uncompressed> Parser(New_Parser(Flavor.Parser, &Errors));
+            Parser->Actions.set(Action_Encode);
+            Parser->Actions.set(Action_Coherency);
+            Parser->Actions.set(Action_CheckPadding);
+            Parser->FileName = &RAWcooked.OutputFileName;
+            Parser->RAWcooked = &RAWcooked;
+
+            // Warm-up, and check that the synthetic frame is supported
+            Parser->Parse(Frame);
+            if (!Parser->IsSupported() || Errors.HasErrors())
+            {
+                Errors_List.push_back(Result.Name + ' ' + Result.Format + ' ' + Resolution.ToString() + ": " + (Errors.HasErrors() ? Errors.ErrorMessage() : string("not supported")));
+                continue;
+            }
+
+            auto Cycles_Begin = cpu::Cycles();
+            auto Begin = stats::Now();
+            for (uint32_t i = 0; i < Config.Frames; i++)
+                Parser->Parse(Frame);
+            Result.Duration = stats::Now() - Begin;
+            Result.Cycles = cpu::Cycles() - Cycles_Begin;
+            Result.Frames = Config.Frames;
+            Result.Bytes = (uint64_t)Frame.Size() * Config.Frames;
+            Results.push_back(move(Result));
+        }
+}
+
+//---------------------------------------------------------------------------
+static string Fixture_Name(const corpus::flavor_info& Flavor, const resolution& Resolution)
+{
+    auto Name = corpus::Flavor_String(Flavor);
+    for (auto& Char : Name)
+        if (Char == '/')
+            Char = '_';
+    return Name + '_' + Resolution.ToString();
+}
+
+//---------------------------------------------------------------------------
+// Creation of the FFV1 file with rawcooked if it is not already present
+static bool Fixture_Create(const config& Config, const corpus::flavor_info& Flavor, int Coder, int Slices, const string& FileName, vector<string>& Errors)
+{
+    filemap File;
+    if (!File.Open_ReadMode(FileName))
+        return false;
+
+    auto SourceName = Config.FixturesDirectoryName + Fixture_Name(Flavor, Config.Fixture_Resolution);
+    filemap Source;
+    if (Source.Open_ReadMode(SourceName + PathSeparator + "00000000." + corpus::Extension(Flavor.Parser)))
+    {
+        if (corpus::Write(SourceName + PathSeparator, Flavor, Config.Fixture_Resolution.Width, Config.Fixture_Resolution.Height, Config.Frames))
+        {
+            Errors.push_back("can not write " + SourceName);
+            return true;
+        }
+    }
+    Source.Close();
+
+    auto Command = '\"' + Config.RAWcookedName + "\" -y --no-check-padding -coder " + to_string(Coder) + " -slices " + to_string(Slices) + " -o \"" + FileName + "\" \"" + SourceName + "\" >" + NullDevice + " 2>&1";
+    if (system(Command.c_str()) || File.Open_ReadMode(FileName))
+    {
+        Errors.push_back("can not create " + FileName + " with " + Config.RAWcookedName);
+        return true;
+    }
+    return false;
+}
+
+//---------------------------------------------------------------------------
+// Decoding of FFV1 fixtures, without writing the output files
+static void Decode(const config& Config, vector<result>& Results, vector<string>& Errors_List)
+{
+    if (Config.FixturesDirectoryName.empty())
+        return;
+
+    ThreadPool* Pool = nullptr;
+    if (Config.Threads > 1)
+    {
+        Pool = new ThreadPool(Config.Threads);
+        Pool->init();
+    }
+
+    for (const auto& Flavor : Fixture_Flavors)
+        for (auto Coder : Fixture_Coders)
+            for (auto Slices : Fixture_Slices)
+            {
+                if (!Fixture_IsCoderUsed(Flavor, Coder))
+                    continue;
+
+                result Result;
+                Result.Name = "decode";
+                Result.Format = corpus::Flavor_String(Flavor);
+                Result.Resolution = Config.Fixture_Resolution;
+                Result.Coder = Coder;
+                Result.Slices = Slices;
+                if (IsFiltered(Config, Result))
+                    continue;
+
+                auto FileName = Config.FixturesDirectoryName + Fixture_Name(Flavor, Config.Fixture_Resolution) + "_coder" + to_string(Coder) + "_slices" + to_string(Slices) + ".mkv";
+                if (Fixture_Create(Config, Flavor, Coder, Slices, FileName, Errors_List))
+                    continue;
+
+                filemap File;
+                if (File.Open_ReadMode(FileName))
+                {
+                    Errors_List.push_back("can not open " + FileName);
+                    continue;
+                }
+
+                errors Errors;
+                user_mode Mode = AlwaysNo;
+                matroska M(string(), &Mode, Ask_Callback, Pool, &Errors);
+                M.Quiet = true;
+                M.NoOutputCheck = true;
+                M.Actions.set(Action_Check);
+                M.FileName = &FileName;
+
+                auto Cycles_Begin = cpu::Cycles();
+                auto Begin = stats::Now();
+                M.Parse(File);
+                Result.Duration = stats::Now() - Begin;
+                Result.Cycles = cpu::Cycles() - Cycles_Begin;
+                if (Errors.HasErrors())
+                {
+                    Errors_List.push_back(Result.Name + ' ' + FileName + ": " + Errors.ErrorMessage());
+                    continue;
+                }
+
+                buffer Frame;
+                corpus::Generate(Frame, Flavor, Config.Fixture_Resolution.Width, Config.Fixture_Resolution.Height, 0);
+                Result.Frames = Config.Frames;
+                Result.Bytes = (uint64_t)Frame.Size() * Config.Frames;
+                Results.push_back(move(Result));
+            }
+
+    delete Pool;
+}
+
+//---------------------------------------------------------------------------
+// Hot kernels on their own, for each resolution
+static void Kernels(const config& Config, vector<kernel_result>& Results, vector<string>& Errors)
+{
+    for (size_t i = 0; i < Config.Resolutions.size(); i++)
+    {
+        kernels::config Kernels_Config;
+        Kernels_Config.Width = Config.Resolutions[i].Width;
+        Kernels_Config.Height = Config.Resolutions[i].Height;
+        Kernels_Config.Warmup = Config.Warmup;
+        Kernels_Config.Repetitions = Config.Repetitions;
+        Kernels_Config.Filter = Config.Filter;
+        Kernels_Config.Resolution_Independent = !i;
+        kernels(Kernels_Config, Results, Errors).Run();
+    }
+}
+
+//***************************************************************************
+// Command line
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+static int Help(const char* Name)
+{
+    cout <<
+        "Usage: " << Name << " [options]\n"
+        "\n"
+        "Runs benchmarks on deterministic synthetic content and prints the results in JSON:\n"
+        "- analysis: parsing of DPX, TIFF and EXR frames of each flavor and resolution,\n"
+        "  with creation of reversibility data, as during encoding\n"
+        "- decode: decoding of FFV1 fixtures of some flavors, with many slice counts,\n"
+        "  with the range coder and with Golomb-Rice for 8-bit flavors (FFmpeg forces\n"
+        "  the range coder above 8 bits), without writing the output files\n"
+        "- kernels (with --kernels only): each hot kernel (range coder, Golomb-Rice,\n"
+        "  slice lines, output transforms, CRC-32, MD5, mask merge, reversibility data\n"
+        "  compression and decompression) on its own, with statistics on repetitions\n"
+        "\n"
+        "Options:\n"
+        "       --kernels\n"
+        "              Run the kernel benchmarks instead of the analysis and decode ones.\n"
+        "       --warmup value\n"
+        "              Count of runs of a kernel before the measure (default: 3).\n"
+        "       --repetitions value\n"
+        "              Count of measured runs of a kernel (default: 15).\n"
+        "       --frames value\n"
+        "              Count of frames per benchmark (default: 8).\n"
+        "       --resolutions value\n"
+        "              Comma separated list of WxH resolutions of analysis and kernel\n"
+        "              benchmarks (default: 720x486,1920x1080,4096x2160 for analysis,\n"
+        "              1920x1080 for kernels).\n"
+        "       --filter value\n"
+        "              Run only the benchmarks with value in their name, format or\n"
+        "              variant, resolution, coder (e.g. coder0) or slices (e.g. slices16).\n"
+        "       --fixtures value\n"
+        "              Directory of FFV1 fixtures, missing fixtures are created there\n"
+        "              with rawcooked, decode benchmarks are run only if it is set.\n"
+        "       --fixture-resolution value\n"
+        "              Resolution of FFV1 fixtures (default: 1920x1080).\n"
+        "       --rawcooked value\n"
+        "              rawcooked binary used for creating fixtures (default: rawcooked).\n"
+        "       --threads value\n"
+        "              Count of decoding threads (default: count of CPU threads).\n"
+        "       --output value\n"
+        "              Write the results to the file value instead of the standard output.\n";
+    return 0;
+}
+
+//---------------------------------------------------------------------------
+static bool Resolution_Parse(const char* Value, resolution& Resolution)
+{
+    char* End;
+    auto Width = strtoul(Value, &End, 10);
+    if (End == Value || *End != 'x')
+        return true;
+    Value = End + 1;
+    auto Height = strtoul(Value, &End, 10);
+    if (End == Value || (*End && *End != ','))
+        return true;
+    if (!Width || !Height || Width > 65536 || Height > 65536)
+        return true;
+    Resolution.Width = (uint32_t)Width;
+    Resolution.Height = (uint32_t)Height;
+    return false;
+}
+
+//---------------------------------------------------------------------------
+static int Error(const char* Option)
+{
+    cerr << "Error: missing or invalid value for " << Option << ".\n";
+    return 1;
+}
+
+//---------------------------------------------------------------------------
+int main(int argc, const char* argv[])
+{
+    config Config;
+    for (int i = 1; i < argc; i++)
+    {
+        const char* Value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (!strcmp(argv[i], "--help") || !strcmp(argv[i], "-h"))
+            return Help(argv[0]);
+        else if (!strcmp(argv[i], "--kernels"))
+            Config.Kernels = true;
+        else if (!strcmp(argv[i], "--warmup"))
+        {
+            if (!Value || (!atoi(Value) && strcmp(Value, "0")))
+                return Error(argv[i]);
+            Config.Warmup = (uint32_t)atoi(Value);
+            i++;
+        }
+        else if (!strcmp(argv[i], "--repetitions"))
+        {
+            if (!Value || atoi(Value) <= 0)
+                return Error(argv[i]);
+            Config.Repetitions = (uint32_t)atoi(Value);
+            i++;
+        }
+        else if (!strcmp(argv[i], "--frames"))
+        {
+            if (!Value || !atoi(Value))
+                return Error(argv[i]);
+            Config.Frames = (uint32_t)atoi(Value);
+            i++;
+        }
+        else if (!strcmp(argv[i], "--resolutions"))
+        {
+            if (!Value)
+                return Error(argv[i]);
+            for (const char* Item = Value; Item; Item = strchr(Item, ','), Item = Item ? Item + 1 : nullptr)
+            {
+                resolution Resolution;
+                if (Resolution_Parse(Item, Resolution))
+                    return Error(argv[i]);
+                Config.Resolutions.push_back(Resolution);
+            }
+            i++;
+        }
+        else if (!strcmp(argv[i], "--filter"))
+        {
+            if (!Value)
+                return Error(argv[i]);
+            Config.Filter = Value;
+            i++;
+        }
+        else if (!strcmp(argv[i], "--fixtures"))
+        {
+            if (!Value || !*Value)
+                return Error(argv[i]);
+            Config.FixturesDirectoryName = Value;
+            if (Config.FixturesDirectoryName.find_last_of("/\\") != Config.FixturesDirectoryName.size() - 1)
+                Config.FixturesDirectoryName += PathSeparator;
+            i++;
+        }
+        else if (!strcmp(argv[i], "--fixture-resolution"))
+        {
+            if (!Value || Resolution_Parse(Value, Config.Fixture_Resolution))
+                return Error(argv[i]);
+            i++;
+        }
+        else if (!strcmp(argv[i], "--rawcooked"))
+        {
+            if (!Value || !*Value)
+                return Error(argv[i]);
+            Config.RAWcookedName = Value;
+            i++;
+        }
+        else if (!strcmp(argv[i], "--threads"))
+        {
+            if (!Value || !atoi(Value))
+                return Error(argv[i]);
+            Config.Threads = (unsigned)atoi(Value);
+            i++;
+        }
+        else if (!strcmp(argv[i], "--output"))
+        {
+            if (!Value || !*Value)
+                return Error(argv[i]);
+            Config.OutputFileName = Value;
+            i++;
+        }
+        else
+        {
+            cerr << "Error: unknown option " << argv[i] << ".\n";
+            return 1;
+        }
+    }
+    if (Config.Resolutions.empty())
+    {
+        if (Config.Kernels)
+            Config.Resolutions = { { 1920, 1080 } };
+        else
+            Config.Resolutions = { { 720, 486 }, { 1920, 1080 }, { 4096, 2160 } };
+    }
+    if (!Config.Threads)
+        Config.Threads = thread::hardware_concurrency();
+    if (!Config.Threads)
+        Config.Threads = 1;
+
+    vector<result> Results;
+    vector<kernel_result> Kernels_Results;
+    vector<string> Errors;
+    if (Config.Kernels)
+        Kernels(Config, Kernels_Results, Errors);
+    else
+    {
+        Analysis(Config, Results, Errors);
+        Decode(Config, Results, Errors);
+    }
+
+    if (Config.OutputFileName.empty())
+        Json(cout, Config, Results, Kernels_Results, Errors);
+    else
+    {
+        ofstream Out(Config.OutputFileName);
+        Json(Out, Config, Results, Kernels_Results, Errors);
+        if (!Out)
+        {
+            cerr << "Error: can not write " << Config.OutputFileName << ".\n";
+            return 1;
+        }
+    }
+
+    return Errors.empty() ? 0 : 1;
+}
@@ -0,0 +1,542 @@
+/*  Copyright (c) MediaArea.net SARL & AV Preservation by reto.ch.
+ *
+ *  Use of this source code is governed by a BSD-style license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//---------------------------------------------------------------------------
+#include "Bench/Corpus.h"
+#include "Lib/Uncompressed/DPX/DPX.h"
+#include "Lib/Uncompressed/TIFF/TIFF.h"
+#include "Lib/Uncompressed/EXR/EXR.h"
+#include "Lib/Utils/FileIO/FileIO.h"
+#include <cstring>
+#include <cstdio>
+//---------------------------------------------------------------------------
+
+//***************************************************************************
+// Flavors
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+// How samples are stored
+enum class packing : uint8_t
+{
+    Byte,                       // 1 sample per byte
+    Word,                       // 1 sample per 16-bit word
+    Word_MSB,                   // 1 sample per 16-bit word, padding in the low bits
+    Filled_A,                   // 3 samples per 32-bit word, padding in the low bits
+    Packed,                     // Samples packed in 32-bit words, from the low bits
+    Half,                       // 1 half float per 16-bit word, planar per line
+};
+
+struct image_info
+{
+    uint8_t                     Components;
+    uint8_t                     BitDepth;
+    packing                     Packing;
+    bool                        IsBigEndian;
+};
+
+//---------------------------------------------------------------------------
+// Same order as dpx::flavor
+static const image_info DPX_Info[] =
+{
+    { 3,  8, packing::Byte    , false },
+    { 3, 10, packing::Filled_A, false },
+    { 3, 10, packing::Filled_A, true  },
+    { 3, 12, packing::Packed  , true  },
+    { 3, 12, packing::Word_MSB, false },
+    { 3, 12, packing::Word_MSB, true  },
+    { 3, 16, packing::Word    , false },
+    { 3, 16, packing::Word    , true  },
+    { 4,  8, packing::Byte    , false },
+    { 4, 10, packing::Filled_A, false },
+    { 4, 10, packing::Filled_A, true  },
+    { 4, 12, packing::Packed  , true  },
+    { 4, 12, packing::Word_MSB, false },
+    { 4, 12, packing::Word_MSB, true  },
+    { 4, 16, packing::Word    , false },
+    { 4, 16, packing::Word    , true  },
+    { 1,  8, packing::Byte    , false },
+    { 1, 16, packing::Word    , false },
+    { 1, 16, packing::Word    , true  },
+};
+static_assert(dpx::flavor_Max == sizeof(DPX_Info) / sizeof(image_info), IncoherencyMessage);
+
+//---------------------------------------------------------------------------
+// Same order as tiff::flavor
+static const image_info TIFF_Info[] =
+{
+    { 3,  8, packing::Byte    , false },
+    { 3, 16, packing::Word    , false },
+    { 3, 16, packing::Word    , true  },
+    { 4,  8, packing::Byte    , false },
+    { 4, 16, packing::Word    , false },
+    { 1,  8, packing::Byte    , true  },
+    { 1, 16, packing::Word    , false },
+    { 1, 16, packing::Word    , true  },
+};
+static_assert(tiff::flavor_Max == sizeof(TIFF_Info) / sizeof(image_info), IncoherencyMessage);
+
+//---------------------------------------------------------------------------
+// Same order as exr::flavor
+static const image_info EXR_Info[] =
+{
+    { 3, 16, packing::Half    , false },
+};
+static_assert(exr::flavor_Max == sizeof(EXR_Info) / sizeof(image_info), IncoherencyMessage);
+
+//---------------------------------------------------------------------------
+static const image_info& Info_Get(const corpus::flavor_info& Info)
+{
+    switch (Info.Parser)
+    {
+        case Parser_TIFF: return TIFF_Info[Info.Flavor];
+        case Parser_EXR: return EXR_Info[Info.Flavor];
+        default: return DPX_Info[Info.Flavor];
+    }
+}
+
+//---------------------------------------------------------------------------
+vector<corpus::flavor_info> corpus::Flavors()
+{
+    vector<flavor_info> List;
+    for (uint8_t i = 0; i < dpx::flavor_Max; i++)
+        List.push_back({ Parser_DPX, i });
+    for (uint8_t i = 0; i < tiff::flavor_Max; i++)
+        List.push_back({ Parser_TIFF, i });
+    for (uint8_t i = 0; i < exr::flavor_Max; i++)
+        List.push_back({ Parser_EXR, i });
+    return List;
+}
+
+//---------------------------------------------------------------------------
+string corpus::Flavor_String(const flavor_info& Info)
+{
+    switch (Info.Parser)
+    {
+        case Parser_TIFF: return TIFF_Flavor_String(Info.Flavor);
+        case Parser_EXR: return EXR_Flavor_String(Info.Flavor);
+        default: return DPX_Flavor_String(Info.Flavor);
+    }
+}
+
+//---------------------------------------------------------------------------
+const char* corpus::Extension(parser Parser)
+{
+    switch (Parser)
+    {
+        case Parser_TIFF: return "tiff";
+        case Parser_EXR: return "exr";
+        default: return "dpx";
+    }
+}
+
+//---------------------------------------------------------------------------
+uint8_t corpus::Components(const flavor_info& Info)
+{
+    return Info_Get(Info).Components;
+}
+
+//---------------------------------------------------------------------------
+uint8_t corpus::BitDepth(const flavor_info& Info)
+{
+    return Info_Get(Info).BitDepth;
+}
+
+//***************************************************************************
+// Content
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+class writer
+{
+public:
+    writer(uint8_t* Data_Source, bool IsBigEndian_Source) : Data(Data_Source), IsBigEndian(IsBigEndian_Source) {}
+
+    void X1(uint8_t Value) { *Data++ = Value; }
+    void X2(uint16_t Value)
+    {
+        if (IsBigEndian)
+        {
+            X1((uint8_t)(Value >> 8));
+            X1((uint8_t)Value);
+        }
+        else
+        {
+            X1((uint8_t)Value);
+            X1((uint8_t)(Value >> 8));
+        }
+    }
+    void X4(uint32_t Value)
+    {
+        if (IsBigEndian)
+        {
+            X2((uint16_t)(Value >> 16));
+            X2((uint16_t)Value);
+        }
+        else
+        {
+            X2((uint16_t)Value);
+            X2((uint16_t)(Value >> 16));
+        }
+    }
+    void X8(uint64_t Value)
+    {
+        if (IsBigEndian)
+        {
+            X4((uint32_t)(Value >> 32));
+            X4((uint32_t)Value);
+        }
+        else
+        {
+            X4((uint32_t)Value);
+            X4((uint32_t)(Value >> 32));
+        }
+    }
+    void String(const char* Value) { auto Size = strlen(Value) + 1; memcpy(Data, Value, Size); Data += Size; }
+
+    uint8_t*                    Data;
+    bool                        IsBigEndian;
+};
+
+//---------------------------------------------------------------------------
+// Component values of a line, 0 to (1 << BitDepth) - 1
+static void Line_Samples(vector<uint16_t>& Samples, const image_info& Info, uint32_t Width, uint32_t Height, uint32_t Y, uint32_t FrameNumber)
+{
+    uint32_t Max = (1 << Info.BitDepth) - 1;
+    if (Info.Packing == packing::Half)
+        Max = 0x3BFF; // Half floats from 0 to 1 (excluded), bit patterns increase with the value
+    uint64_t Range = ((uint64_t)Width + Height) * 4;
+    uint32_t Noise_Mask = Max >> 6;
+    uint32_t Noise = (Y + 1) * 0x9E3779B9 ^ (FrameNumber + 1) * 0x85EBCA6B;
+    Samples.resize((size_t)Width * Info.Components);
+    auto Sample = Samples.data();
+    for (uint32_t X = 0; X < Width; X++)
+        for (uint8_t c = 0; c < Info.Components; c++)
+        {
+            // Diagonal gradient, different per component, moving with the frame number
+            uint64_t Position = ((uint64_t)X * (c + 1) + (uint64_t)Y * (4 - c) + (uint64_t)FrameNumber * 16) % Range;
+            uint32_t Value = (uint32_t)(Position * Max / Range);
+
+            // Sensor like noise (xorshift)
+            Noise ^= Noise << 13;
+            Noise ^= Noise >> 17;
+            Noise ^= Noise << 5;
+            Value += Noise & Noise_Mask;
+            if (Value > Max)
+                Value = Max;
+
+            *Sample++ = (uint16_t)Value;
+        }
+}
+
+//---------------------------------------------------------------------------
+static uint8_t* Line_Write(uint8_t* Data, const vector<uint16_t>& Samples, const image_info& Info, uint32_t Width)
+{
+    writer W(Data, Info.IsBigEndian);
+    switch (Info.Packing)
+    {
+        case packing::Byte:
+            for (auto Sample : Samples)
+                W.X1((uint8_t)Sample);
+            break;
+        case packing::Word:
+            for (auto Sample : Samples)
+                W.X2(Sample);
+            break;
+        case packing::Word_MSB:
+            for (auto Sample : Samples)
+                W.X2((uint16_t)(Sample << (16 - Info.BitDepth)));
+            break;
+        case packing::Filled_A:
+            for (size_t i = 0; i < Samples.size(); i += 3)
+            {
+                uint32_t Word = Samples[i] << 22;
+                if (i + 1 < Samples.size())
+                    Word |= Samples[i + 1] << 12;
+                if (i + 2 < Samples.size())
+                    Word |= Samples[i + 2] << 2;
+                W.X4(Word);
+            }
+            break;
+        case packing::Packed:
+        {
+            uint64_t Bits = 0;
+            uint8_t Bits_Count = 0;
+            for (auto Sample : Samples)
+            {
+                Bits |= (uint64_t)Sample << Bits_Count;
+                Bits_Count += Info.BitDepth;
+                if (Bits_Count >= 32)
+                {
+                    W.X4((uint32_t)Bits);
+                    Bits >>= 32;
+                    Bits_Count -= 32;
+                }
+            }
+            if (Bits_Count)
+                W.X4((uint32_t)Bits);
+            break;
+        }
+        case packing::Half:
+            // Planar per line, channels in alphabetical order (B, G, R)
+            for (uint8_t c = Info.Components; c; c--)
+                for (uint32_t X = 0; X < Width; X++)
+                    W.X2(Samples[(size_t)X * Info.Components + c - 1]);
+            break;
+    }
+    return W.Data;
+}
+
+//---------------------------------------------------------------------------
+static size_t Line_Size(const image_info& Info, uint32_t Width)
+{
+    size_t Samples = (size_t)Width * Info.Components;
+    switch (Info.Packing)
+    {
+        case packing::Byte: return Samples;
+        case packing::Filled_A: return (Samples + 2) / 3 * 4;
+        case packing::Packed: return (Samples * Info.BitDepth + 31) / 32 * 4;
+        default: return Samples * 2;
+    }
+}
+
+//***************************************************************************
+// Headers
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+static size_t DPX_Header(uint8_t* Data, const image_info& Info, uint32_t Width, uint32_t Height, size_t FileSize)
+{
+    const size_t Header_Size = 2048;
+    if (!Data)
+        return Header_Size;
+
+    memset(Data, 0, Header_Size);
+    writer W(Data, Info.IsBigEndian);
+    W.X4(0x53445058); // SDPX, written in the file endianness
+    W.X4(Header_Size); // Offset to image data
+    W.String("V2.0");
+    W.Data = Data + 16;
+    W.X4((uint32_t)FileSize);
+    W.X4(1); // Ditto key, new frame
+    W.X4(1664); // Generic section header length
+    W.X4(384); // Industry specific header length
+    W.X4(0); // User defined header length
+    W.Data = Data + 660;
+    W.X4((uint32_t)-1); // Encryption key, not encrypted
+    W.Data = Data + 768;
+    W.X2(0); // Orientation
+    W.X2(1); // Number of image elements
+    W.X4(Width);
+    W.X4(Height);
+    W.X4(0); // Data sign, unsigned
+    W.Data = Data + 800;
+    W.X1(Info.Components == 1 ? 6 : (Info.Components == 3 ? 50 : 51)); // Descriptor
+    W.X1(2); // Transfer characteristic, linear
+    W.X1(2); // Colorimetric specification, linear
+    W.X1(Info.BitDepth);
+    W.X2(Info.Packing == packing::Filled_A || Info.Packing == packing::Word_MSB ? 1 : 0); // Packing, method A or packed
+    W.X2(0); // Encoding, not encoded
+    W.X4(Header_Size); // Offset to data
+    W.X4(0); // End-of-line padding
+    W.X4(0); // End-of-image padding
+    W.Data = Data + 1724;
+    W.X4(0x41C00000); // Frame rate of original (24.0)
+    W.Data = Data + 1940;
+    W.X4(0x41C00000); // Temporal sampling rate (24.0)
+    return Header_Size;
+}
+
+//---------------------------------------------------------------------------
+static size_t TIFF_Header(uint8_t* Data, const image_info& Info, uint32_t Width, uint32_t Height, size_t ImageSize)
+{
+    uint16_t Entries_Count = Info.Components == 4 ? 11 : 10;
+    size_t IFD_End = 8 + 2 + 12 * Entries_Count + 4;
+    size_t BitsPerSample_Offset = IFD_End;
+    size_t Header_Size = IFD_End + (Info.Components > 2 ? 2 * Info.Components : 0);
+    if (!Data)
+        return Header_Size;
+
+    writer W(Data, Info.IsBigEndian);
+    W.X2(Info.IsBigEndian ? 0x4D4D : 0x4949);
+    W.X2(42);
+    W.X4(8); // First IFD offset
+    W.X2(Entries_Count);
+    auto Entry = [&](uint16_t Tag, uint16_t Type, uint32_t Count, uint32_t Value)
+    {
+        W.X2(Tag);
+        W.X2(Type);
+        W.X4(Count);
+        if (Type == 3 && Count == 1)
+        {
+            W.X2((uint16_t)Value); // Left justified
+            W.X2(0);
+        }
+        else
+            W.X4(Value);
+    };
+    Entry(256, 4, 1, Width); // ImageWidth
+    Entry(257, 4, 1, Height); // ImageLength
+    if (Info.Components > 2)
+        Entry(258, 3, Info.Components, (uint32_t)BitsPerSample_Offset); // BitsPerSample
+    else
+        Entry(258, 3, 1, Info.BitDepth);
+    Entry(259, 3, 1, 1); // Compression, none
+    Entry(262, 3, 1, Info.Components == 1 ? 1 : 2); // PhotometricInterpretation
+    Entry(273, 4, 1, (uint32_t)Header_Size); // StripOffsets
+    Entry(277, 3, 1, Info.Components); // SamplesPerPixel
+    Entry(278, 4, 1, Height); // RowsPerStrip
+    Entry(279, 4, 1, (uint32_t)ImageSize); // StripByteCounts
+    Entry(284, 3, 1, 1); // PlanarConfiguration, chunky
+    if (Info.Components == 4)
+        Entry(338, 3, 1, 2); // ExtraSamples, unassociated alpha
+    W.X4(0); // Next IFD offset
+    if (Info.Components > 2)
+        for (uint8_t c = 0; c < Info.Components; c++)
+            W.X2(Info.BitDepth);
+    return Header_Size;
+}
+
+//---------------------------------------------------------------------------
+static size_t EXR_Header(uint8_t* Data, const image_info& Info, uint32_t Width, uint32_t Height)
+{
+    static const char* Channels = "BGR";
+    size_t Header_Size = 8
+        + 9 + 7 + 4 + 3 * 18 + 1                // channels
+        + 12 + 12 + 4 + 1                       // compression
+        + 11 + 6 + 4 + 16                       // dataWindow
+        + 14 + 6 + 4 + 16                       // displayWindow
+        + 10 + 10 + 4 + 1                       // lineOrder
+        + 17 + 6 + 4 + 4                        // pixelAspectRatio
+        + 19 + 4 + 4 + 8                        // screenWindowCenter
+        + 18 + 6 + 4 + 4                        // screenWindowWidth
+        + 1                                     // End of header
+        + 8 * (size_t)Height;                   // Offset table
+    if (!Data)
+        return Header_Size;
+
+    writer W(Data, false);
+    W.X4(0x01312F76); // Magic number
+    W.X4(2); // Version 2, single part scan lines
+    auto Attribute = [&](const char* Name, const char* Type, uint32_t Size)
+    {
+        W.String(Name);
+        W.String(Type);
+        W.X4(Size);
+    };
+    Attribute("channels", "chlist", 3 * 18 + 1);
+    for (uint8_t c = 0; c < Info.Components; c++)
+    {
+        W.X1(Channels[c]);
+        W.X1(0);
+        W.X4(1); // HALF
+        W.X4(0); // pLinear + reserved
+        W.X4(1); // xSampling
+        W.X4(1); // ySampling
+    }
+    W.X1(0);
+    Attribute("compression", "compression", 1);
+    W.X1(0); // No compression
+    Attribute("dataWindow", "box2i", 16);
+    W.X4(0); W.X4(0); W.X4(Width - 1); W.X4(Height - 1);
+    Attribute("displayWindow", "box2i", 16);
+    W.X4(0); W.X4(0); W.X4(Width - 1); W.X4(Height - 1);
+    Attribute("lineOrder", "lineOrder", 1);
+    W.X1(0); // Increasing Y
+    Attribute("pixelAspectRatio", "float", 4);
+    W.X4(0x3F800000); // 1.0
+    Attribute("screenWindowCenter", "v2f", 8);
+    W.X8(0);
+    Attribute("screenWindowWidth", "float", 4);
+    W.X4(0x3F800000); // 1.0
+    W.X1(0);
+
+    // Offset table
+    auto Line_Offset = (uint64_t)Header_Size;
+    auto LineBlock_Size = 8 + Line_Size(Info, Width);
+    for (uint32_t Y = 0; Y < Height; Y++)
+    {
+        W.X8(Line_Offset);
+        Line_Offset += LineBlock_Size;
+    }
+    return Header_Size;
+}
+
+//***************************************************************************
+// Generate
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+size_t corpus::ImageOffset(const flavor_info& Flavor, uint32_t Width, uint32_t Height)
+{
+    const auto& Info = Info_Get(Flavor);
+    switch (Flavor.Parser)
+    {
+        case Parser_TIFF: return TIFF_Header(nullptr, Info, Width, Height, 0);
+        case Parser_EXR: return EXR_Header(nullptr, Info, Width, Height);
+        default: return DPX_Header(nullptr, Info, Width, Height, 0);
+    }
+}
+
+//---------------------------------------------------------------------------
+void corpus::Samples(vector<uint16_t>& Output, const flavor_info& Flavor, uint32_t Width, uint32_t Height, uint32_t Y, uint32_t FrameNumber)
+{
+    Line_Samples(Output, Info_Get(Flavor), Width, Height, Y, FrameNumber);
+}
+
+//---------------------------------------------------------------------------
+void corpus::Generate(buffer& Output, const flavor_info& Flavor, uint32_t Width, uint32_t Height, uint32_t FrameNumber)
+{
+    const auto& Info = Info_Get(Flavor);
+    auto LineSize = Line_Size(Info, Width);
+    auto IsEXR = Flavor.Parser == Parser_EXR;
+    auto ImageSize = (LineSize + (IsEXR ? 8 : 0)) * Height;
+    auto HeaderSize = ImageOffset(Flavor, Width, Height);
+    auto FileSize = HeaderSize + ImageSize;
+    if (Output.Size() != FileSize)
+        Output.Create(FileSize);
+
+    switch (Flavor.Parser)
+    {
+        case Parser_TIFF: TIFF_Header(Output.Data(), Info, Width, Height, ImageSize); break;
+        case Parser_EXR: EXR_Header(Output.Data(), Info, Width, Height); break;
+        default: DPX_Header(Output.Data(), Info, Width, Height, FileSize);
+    }
+
+    vector<uint16_t> Samples;
+    auto Data = Output.Data() + HeaderSize;
+    for (uint32_t Y = 0; Y < Height; Y++)
+    {
+        if (IsEXR)
+        {
+            writer W(Data, false);
+            W.X4(Y);
+            W.X4((uint32_t)LineSize);
+            Data = W.Data;
+        }
+        Line_Samples(Samples, Info, Width, Height, Y, FrameNumber);
+        Data = Line_Write(Data, Samples, Info, Width);
+    }
+}
+
+//---------------------------------------------------------------------------
+bool corpus::Write(const string& DirectoryName, const flavor_info& Flavor, uint32_t Width, uint32_t Height, uint32_t FrameCount)
+{
+    buffer Frame;
+    for (uint32_t i = 0; i < FrameCount; i++)
+    {
+        Generate(Frame, Flavor, Width, Height, i);
+
+        char FileName[32];
+        snprintf(FileName, sizeof(FileName), "%08u.%s", i, Extension(Flavor.Parser));
+        file File;
+        if (File.Open_WriteMode(DirectoryName, FileName)
+         || File.Write(Frame)
+         || File.Close())
+            return true;
+    }
+    return false;
+}
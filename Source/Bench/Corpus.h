@@ -0,0 +1,48 @@
+/*  Copyright (c) MediaArea.net SARL & AV Preservation by reto.ch.
+ *
+ *  Use of this source code is governed by a BSD-style license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//---------------------------------------------------------------------------
+#ifndef CorpusH
+#define CorpusH
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+#include "Lib/Config.h"
+#include "Lib/Utils/Buffer/Buffer.h"
+#include "Lib/Utils/Errors/Errors.h"
+#include <vector>
+using namespace std;
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+// Deterministic synthetic frames in each supported image flavor
+// Content is smooth gradients moving with the frame number plus low level noise,
+// so it is compressible like real scans, and is the same on all platforms
+class corpus
+{
+public:
+    struct flavor_info
+    {
+        parser                  Parser;
+        uint8_t                 Flavor;
+    };
+
+    // Info
+    static vector<flavor_info>  Flavors(); // All supported image flavors
+    static string               Flavor_String(const flavor_info& Info);
+    static const char*          Extension(parser Parser);
+    static uint8_t              Components(const flavor_info& Info);
+    static uint8_t              BitDepth(const flavor_info& Info);
+    static size_t               ImageOffset(const flavor_info& Info, uint32_t Width, uint32_t Height); // Offset of the first line in generated frames
+
+    // Actions
+    static void                 Generate(buffer& Output, const flavor_info& Info, uint32_t Width, uint32_t Height, uint32_t FrameNumber);
+    static void                 Samples(vector<uint16_t>& Output, const flavor_info& Info, uint32_t Width, uint32_t Height, uint32_t Y, uint32_t FrameNumber); // Component values of line Y, interleaved in storage order
+    static bool                 Write(const string& DirectoryName, const flavor_info& Info, uint32_t Width, uint32_t Height, uint32_t FrameCount); // Returns true on error
+};
+
+//---------------------------------------------------------------------------
+#endif
@@ -0,0 +1,217 @@
+/*  Copyright (c) MediaArea.net SARL & AV Preservation by reto.ch.
+ *
+ *  Use of this source code is governed by a BSD-style license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//---------------------------------------------------------------------------
+#include "Bench/Cpu.h"
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    #ifdef _MSC_VER
+        #include <intrin.h>
+    #else
+        #include <cpuid.h>
+        #include <x86intrin.h>
+    #endif
+    #define BENCH_X86
+#endif
+#include <cstring>
+using namespace std;
+//---------------------------------------------------------------------------
+
+//***************************************************************************
+// x86
+//***************************************************************************
+
+#ifdef BENCH_X86
+//---------------------------------------------------------------------------
+static void CPUID(uint32_t Leaf, uint32_t SubLeaf, uint32_t Registers[4])
+{
+    #ifdef _MSC_VER
+        int Temp[4];
+        __cpuidex(Temp, (int)Leaf, (int)SubLeaf);
+        for (int i = 0; i < 4; i++)
+            Registers[i] = (uint32_t)Temp[i];
+    #else
+        __cpuid_count(Leaf, SubLeaf, Registers[0], Registers[1], Registers[2], Registers[3]);
+    #endif
+}
+
+//---------------------------------------------------------------------------
+// Register states saved by the OS on context switches
+static uint64_t XGETBV()
+{
+    #ifdef _MSC_VER
+        return _xgetbv(0);
+    #else
+        uint32_t Low, High;
+        __asm__ volatile("xgetbv" : "=a"(Low), "=d"(High) : "c"(0));
+        return ((uint64_t)High << 32) | Low;
+    #endif
+}
+#endif //BENCH_X86
+
+//***************************************************************************
+// Info
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+string cpu::Architecture()
+{
+    #if defined(__x86_64__) || defined(_M_X64)
+        return "x86_64";
+    #elif defined(__i386__) || defined(_M_IX86)
+        return "x86";
+    #elif defined(__aarch64__) || defined(_M_ARM64)
+        return "arm64";
+    #elif defined(__arm__) || defined(_M_ARM)
+        return "arm";
+    #elif defined(__powerpc64__)
+        return "ppc64";
+    #else
+        return "unknown";
+    #endif
+}
+
+//---------------------------------------------------------------------------
+string cpu::Name()
+{
+    #ifdef BENCH_X86
+        uint32_t Registers[4];
+        CPUID(0x80000000, 0, Registers);
+        if (Registers[0] < 0x80000004)
+            return string();
+
+        char Brand[49];
+        for (uint32_t i = 0; i < 3; i++)
+        {
+            CPUID(0x80000002 + i, 0, Registers);
+            memcpy(Brand + i * 16, Registers, 16);
+        }
+        Brand[48] = '\0';
+
+        string Result(Brand);
+        auto Begin = Result.find_first_not_of(' ');
+        if (Begin == string::npos)
+            return string();
+        return Result.substr(Begin, Result.find_last_not_of(' ') + 1 - Begin);
+    #else
+        return string();
+    #endif
+}
+
+//---------------------------------------------------------------------------
+vector<string> cpu::Features()
+{
+    vector<string> Result;
+
+    #ifdef BENCH_X86
+        uint32_t Registers[4];
+        CPUID(0, 0, Registers);
+        auto MaxLeaf = Registers[0];
+        if (!MaxLeaf)
+            return Result;
+
+        CPUID(1, 0, Registers);
+        auto Leaf1_ECX = Registers[2];
+        auto Leaf1_EDX = Registers[3];
+        uint32_t Leaf7_EBX = 0;
+        if (MaxLeaf >= 7)
+        {
+            CPUID(7, 0, Registers);
+            Leaf7_EBX = Registers[1];
+        }
+
+        // AVX registers are usable only if the OS saves them
+        uint64_t XCR0 = (Leaf1_ECX & (1 << 27)) ? XGETBV() : 0; // OSXSAVE
+        auto OS_AVX = (XCR0 & 0x06) == 0x06;
+        auto OS_AVX512 = (XCR0 & 0xE6) == 0xE6;
+
+        struct feature
+        {
+            const char*         Name;
+            uint32_t            Register;
+            uint32_t            Bit;
+            int                 OS; // 0 = none, 1 = AVX, 2 = AVX-512
+        };
+        const feature List[] =
+        {
+            { "sse2",      Leaf1_EDX, 26, 0 },
+            { "sse3",      Leaf1_ECX,  0, 0 },
+            { "ssse3",     Leaf1_ECX,  9, 0 },
+            { "sse4.1",    Leaf1_ECX, 19, 0 },
+            { "sse4.2",    Leaf1_ECX, 20, 0 },
+            { "popcnt",    Leaf1_ECX, 23, 0 },
+            { "pclmulqdq", Leaf1_ECX,  1, 0 },
+            { "aes",       Leaf1_ECX, 25, 0 },
+            { "avx",       Leaf1_ECX, 28, 1 },
+            { "fma",       Leaf1_ECX, 12, 1 },
+            { "bmi1",      Leaf7_EBX,  3, 0 },
+            { "avx2",      Leaf7_EBX,  5, 1 },
+            { "bmi2",      Leaf7_EBX,  8, 0 },
+            { "sha",       Leaf7_EBX, 29, 0 },
+            { "avx512f",   Leaf7_EBX, 16, 2 },
+            { "avx512bw",  Leaf7_EBX, 30, 2 },
+            { "avx512vl",  Leaf7_EBX, 31, 2 },
+        };
+        for (const auto& Feature : List)
+        {
+            if (!(Feature.Register & ((uint32_t)1 << Feature.Bit)))
+                continue;
+            if ((Feature.OS == 1 && !OS_AVX) || (Feature.OS == 2 && !OS_AVX512))
+                continue;
+            Result.push_back(Feature.Name);
+        }
+    #else
+        // Known at compile time only
+        #if defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+            Result.push_back("neon");
+        #endif
+        #ifdef __ARM_FEATURE_CRC32
+            Result.push_back("crc32");
+        #endif
+        #ifdef __ARM_FEATURE_CRYPTO
+            Result.push_back("crypto");
+        #endif
+    #endif
+
+    return Result;
+}
+
+//---------------------------------------------------------------------------
+string cpu::Compiler()
+{
+    #if defined(__clang__)
+        return string("clang ") + __clang_version__;
+    #elif defined(__GNUC__)
+        return "gcc " + to_string(__GNUC__) + '.' + to_string(__GNUC_MINOR__) + '.' + to_string(__GNUC_PATCHLEVEL__);
+    #elif defined(_MSC_VER)
+        return "msvc " + to_string(_MSC_FULL_VER);
+    #else
+        return "unknown";
+    #endif
+}
+
+//***************************************************************************
+// Time stamp counter
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+bool cpu::HasCycles()
+{
+    #ifdef BENCH_X86
+        return true;
+    #else
+        return false;
+    #endif
+}
+
+//---------------------------------------------------------------------------
+uint64_t cpu::Cycles()
+{
+    #ifdef BENCH_X86
+        return __rdtsc();
+    #else
+        return 0;
+    #endif
+}
@@ -0,0 +1,37 @@
+/*  Copyright (c) MediaArea.net SARL & AV Preservation by reto.ch.
+ *
+ *  Use of this source code is governed by a BSD-style license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//---------------------------------------------------------------------------
+#ifndef CpuH
+#define CpuH
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+#include "Lib/Config.h"
+#include <string>
+#include <vector>
+using namespace std;
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+// Labels of the CPU running the benchmarks, so results of different machines
+// or builds are not compared blindly
+class cpu
+{
+public:
+    // Info
+    static string               Architecture();
+    static string               Name(); // Brand string, empty if not available
+    static vector<string>       Features(); // Instruction set extensions usable by the program
+    static string               Compiler();
+
+    // Time stamp counter, 0 if not available
+    static bool                 HasCycles();
+    static uint64_t             Cycles();
+};
+
+//---------------------------------------------------------------------------
+#endif
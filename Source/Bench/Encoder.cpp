@@ -0,0 +1,543 @@
+/*  Copyright (c) MediaArea.net SARL & AV Preservation by reto.ch.
+ *
+ *  Use of this source code is governed by a BSD-style license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//---------------------------------------------------------------------------
+#include "Bench/Encoder.h"
+#include "Lib/CoDec/FFV1/FFV1_Parameters.h"
+#include <algorithm>
+using namespace std;
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+extern const state_transitions_struct default_state_transitions;
+//---------------------------------------------------------------------------
+
+//***************************************************************************
+// Range coder
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+rangecoder_writer::rangecoder_writer()
+{
+    one_state = default_state_transitions;
+    zero_state.States[0] = 0;
+    for (size_t i = 1; i < state_transitions_struct_size; i++)
+        zero_state.States[i] = -one_state.States[state_transitions_struct_size - i];
+}
+
+//---------------------------------------------------------------------------
+void rangecoder_writer::Renorm()
+{
+    // Carry propagation to the bytes already written
+    if (Low >= 0x10000)
+    {
+        for (auto Byte = Output.rbegin(); Byte != Output.rend(); Byte++)
+            if (++*Byte)
+                break;
+        Low -= 0x10000;
+    }
+
+    Output.push_back((uint8_t)(Low >> 8));
+    Low = (Low & 0xFF) << 8;
+    Range <<= 8;
+}
+
+//---------------------------------------------------------------------------
+void rangecoder_writer::b(uint8_t& State, bool Value)
+{
+    uint32_t Range1 = (Range * State) >> 8;
+    if (Value)
+    {
+        Low += Range - Range1;
+        Range = Range1;
+        State = one_state.States[State];
+    }
+    else
+    {
+        Range -= Range1;
+        State = zero_state.States[State];
+    }
+
+    while (Range < 0x100)
+        Renorm();
+}
+
+//---------------------------------------------------------------------------
+void rangecoder_writer::u(states_struct& States, uint32_t Value)
+{
+    if (!Value)
+    {
+        b(States.States[0], true);
+        return;
+    }
+    b(States.States[0], false);
+
+    int e = 0;
+    while (Value >> (e + 1))
+        e++;
+    for (int i = 0; i < e; i++)
+        b(States.States[1 + min(i, 9)], true); // 1..10
+    b(States.States[1 + min(e, 9)], false);
+    for (int i = e - 1; i >= 0; i--)
+        b(States.States[22 + min(i, 9)], (Value >> i) & 1); // 22..31
+}
+
+//---------------------------------------------------------------------------
+void rangecoder_writer::s(states_struct& States, int32_t Value)
+{
+    if (!Value)
+    {
+        b(States.States[0], true);
+        return;
+    }
+    b(States.States[0], false);
+
+    uint32_t a = Value < 0 ? -(uint32_t)Value : (uint32_t)Value;
+    int e = 0;
+    while (a >> (e + 1))
+        e++;
+    for (int i = 0; i < e; i++)
+        b(States.States[1 + min(i, 9)], true); // 1..10
+    b(States.States[1 + min(e, 9)], false);
+    for (int i = e - 1; i >= 0; i--)
+        b(States.States[22 + min(i, 9)], (a >> i) & 1); // 22..31
+    b(States.States[11 + min(e, 10)], Value < 0); // 11..21
+}
+
+//---------------------------------------------------------------------------
+void rangecoder_writer::Terminate()
+{
+    Range = 0xFF;
+    Low += 0xFF;
+    Renorm();
+    Range = 0xFF;
+    Renorm();
+    Output.pop_back(); // Not needed by the decoder, like FFmpeg which keeps it outstanding
+}
+
+//***************************************************************************
+// Golomb-Rice
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+void bit_writer::Put(uint32_t Value, uint8_t Bits)
+{
+    if (!Bits)
+        return;
+    Pending = (Pending << Bits) | (Value & (((uint64_t)1 << Bits) - 1));
+    Pending_Count += Bits;
+    while (Pending_Count >= 8)
+    {
+        Pending_Count -= 8;
+        Output.push_back((uint8_t)(Pending >> Pending_Count));
+    }
+}
+
+//---------------------------------------------------------------------------
+void bit_writer::Flush()
+{
+    if (Pending_Count)
+        Put(0, 8 - Pending_Count);
+}
+
+//---------------------------------------------------------------------------
+void golombrice_writer::Update()
+{
+    if (ContextCount == 128)
+    {
+        ContextCount  >>= 1;
+        Sum_Absolute  >>= 1;
+        Sum_Corrected >>= 1;
+    }
+    ContextCount++;
+
+    if (Sum_Corrected <= -ContextCount)
+    {
+        if (Corrected > -128)
+            Corrected--;
+
+        Sum_Corrected += ContextCount;
+        if (Sum_Corrected <= -ContextCount)
+            Sum_Corrected = 1 - ContextCount;
+    }
+    else if (Sum_Corrected > 0)
+    {
+        if (Corrected < 127)
+            Corrected++;
+
+        if (Sum_Corrected > ContextCount)
+            Sum_Corrected = 0;
+        else
+            Sum_Corrected -= ContextCount;
+    }
+}
+
+//---------------------------------------------------------------------------
+void golombrice_writer::Put(bit_writer& BW, int32_t Value, uint32_t bits_max)
+{
+    uint8_t k = 0;
+    while ((ContextCount << k) < Sum_Absolute)
+        k++;
+
+    // The decoder adds the bias then keeps the low bits_max bits
+    int32_t Half = 1 << (bits_max - 1);
+    int32_t Code = ((Value - Corrected + Half) & ((Half << 1) - 1)) - Half;
+    int32_t M = 2 * Sum_Corrected + ContextCount;
+    int32_t Code_Written = Code ^ (M >> 31);
+
+    Sum_Corrected += Code;
+    Sum_Absolute += Code >= 0 ? Code : -Code;
+    Update();
+
+    uint32_t v = ((uint32_t)Code_Written << 1) ^ (uint32_t)(Code_Written >> 31); // Signed to unsigned
+    uint32_t q = v >> k;
+    if (q < 12)
+    {
+        BW.Put(0, (uint8_t)q);
+        BW.Put(1, 1);
+        BW.Put(v, k);
+    }
+    else
+    {
+        BW.Put(0, 12); // ESC (Escape)
+        BW.Put(v - 11, (uint8_t)bits_max);
+    }
+}
+
+//***************************************************************************
+// Encoder
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+// Coming from FFv1 spec.
+static const uint8_t GR_log2_run[41] = {
+    0 , 0, 0, 0, 1, 1, 1, 1,
+    2 , 2, 2, 2, 3, 3, 3, 3,
+    4 , 4, 5, 5, 6, 6, 7, 7,
+    8 , 9,10,11,12,13,14,15,
+    16,17,18,19,20,21,22,23,
+    24,
+};
+
+//---------------------------------------------------------------------------
+// Quantization runs of the context tables, like FFmpeg default for 8-bit content
+static const uint8_t Quant_Runs[] = { 1, 1, 3, 7, 36, 80 };
+
+//---------------------------------------------------------------------------
+static inline int32_t get_median_number(int32_t one, int32_t two, int32_t three)
+{
+    return max(min(one, two), min(max(one, two), three));
+}
+
+//---------------------------------------------------------------------------
+static inline pixel_t predict(pixel_t *current, pixel_t *current_top, bool is_overflow_16bit)
+{
+    pixel_t LeftTop, Top, Left;
+    if (is_overflow_16bit)
+    {
+        LeftTop = (int16_t)current_top[-1];
+        Top = (int16_t)current_top[0];
+        Left = (int16_t)current[-1];
+    }
+    else
+    {
+        LeftTop = current_top[-1];
+        Top = current_top[0];
+        Left = current[-1];
+    }
+
+    return get_median_number(Left, Left + Top - LeftTop, Top);
+}
+
+//---------------------------------------------------------------------------
+static inline pixel_t get_context(pixel_t quant_table[MAX_CONTEXT_INPUTS][MAX_QUANT_TABLE_SIZE], pixel_t *src, pixel_t *last, bool Is5)
+{
+    const int LT = last[-1];
+    const int T = last[0];
+    const int RT = last[1];
+    const int L = src[-1];
+    pixel_t Context = quant_table[0][(L - LT) & 0xFF]
+        + quant_table[1][(LT - T) & 0xFF]
+        + quant_table[2][(T - RT) & 0xFF];
+    if (Is5)
+    {
+        const int TT = src[0];
+        const int LL = src[-2];
+        Context += quant_table[3][(LL - L) & 0xFF]
+            + quant_table[4][(TT - T) & 0xFF];
+    }
+    return Context;
+}
+
+//---------------------------------------------------------------------------
+static void Header(rangecoder_writer& RC, uint32_t Coder, bool IsRGB, uint8_t Bits, bool Alpha)
+{
+    uint8_t KeyFrame = states_default;
+    RC.b(KeyFrame, true);
+
+    states_struct States(states_default);
+    RC.u(States, 1); // version
+    RC.u(States, Coder); // coder_type
+    RC.u(States, IsRGB ? 1 : 0); // colorspace_type
+    RC.u(States, Bits); // bits_per_raw_sample
+    RC.b(States, IsRGB); // chroma_planes
+    RC.u(States, 0); // log2_h_chroma_subsample
+    RC.u(States, 0); // log2_v_chroma_subsample
+    RC.b(States, Alpha); // alpha_plane
+
+    // 1 quant table set, 3 context inputs
+    for (size_t i = 0; i < MAX_CONTEXT_INPUTS; i++)
+    {
+        states_struct Table_States(states_default);
+        if (i < 3)
+        {
+            for (auto Run : Quant_Runs)
+                RC.u(Table_States, Run - 1);
+        }
+        else
+            RC.u(Table_States, MAX_QUANT_TABLE_SIZE / 2 - 1);
+    }
+}
+
+//---------------------------------------------------------------------------
+class line_writer
+{
+public:
+    line_writer(parameters& P_, uint32_t Coder_, uint32_t w_, rangecoder_writer& RC_, bit_writer& BW_) :
+        P(P_),
+        Coder(Coder_),
+        w(w_),
+        RC(RC_),
+        BW(BW_)
+    {
+        auto Contexts_Count = P.QuantTableSets[0].Contexts_Count;
+        for (size_t i = 0; i < P.quant_table_set_index_count; i++)
+        {
+            if (Coder)
+                RC_Contexts[i].resize(Contexts_Count, states_struct(states_default));
+            else
+                GR_Contexts[i].resize(Contexts_Count);
+        }
+    }
+
+    void                        Plane_Init() { run_index = 0; }
+    void                        Line(size_t quant_table_set_index, pixel_t* sample[2], const pixel_t* Target);
+
+private:
+    void                        Sample_Delta(size_t quant_table_set_index, int32_t Context, int32_t Delta);
+    void                        Line_End();
+
+    parameters&                 P;
+    uint32_t                    Coder;
+    uint32_t                    w;
+    rangecoder_writer&          RC;
+    bit_writer&                 BW;
+    vector<states_struct>       RC_Contexts[MAX_QUANT_TABLE_SET_INDEXES];
+    vector<golombrice_writer>   GR_Contexts[MAX_QUANT_TABLE_SET_INDEXES];
+    uint32_t                    run_index = 0;
+    uint32_t                    run_mode = 0;
+    uint32_t                    run_count = 0;
+};
+
+//---------------------------------------------------------------------------
+void line_writer::Line(size_t quant_table_set_index, pixel_t* sample[2], const pixel_t* Target)
+{
+    auto& QuantTables = P.QuantTableSets[0].QuantTables;
+    bool Is5 = QuantTables[3][127] ? true : false;
+    pixel_t Half = (P.bits_mask + 1) >> 1;
+    pixel_t* s0c = sample[0];
+    pixel_t* s1c = sample[1];
+
+    for (uint32_t x = 0; x < w; x++)
+    {
+        pixel_t Context = get_context(QuantTables, s1c, s0c, Is5);
+        int32_t Delta = Target[x] - predict(s1c, s0c, P.IsOverflow16bit);
+        if (Context < 0)
+        {
+            Context = -Context;
+            Delta = -Delta;
+        }
+        Delta = ((Delta + Half) & P.bits_mask) - Half; // The decoder keeps only the low bits
+        Sample_Delta(quant_table_set_index, Context, Delta);
+        *s1c = Target[x];
+
+        s0c++;
+        s1c++;
+    }
+
+    if (!Coder)
+        Line_End();
+}
+
+//---------------------------------------------------------------------------
+void line_writer::Sample_Delta(size_t quant_table_set_index, int32_t Context, int32_t Delta)
+{
+    if (Coder)
+    {
+        RC.s(RC_Contexts[quant_table_set_index][Context], Delta);
+        return;
+    }
+
+    // Run mode
+    if (!Context)
+        run_mode = 1;
+    if (run_mode)
+    {
+        if (!Delta)
+        {
+            run_count++;
+            return;
+        }
+        while (run_count >= ((uint32_t)1 << GR_log2_run[run_index]))
+        {
+            run_count -= (uint32_t)1 << GR_log2_run[run_index];
+            run_index++;
+            BW.Put(1, 1);
+        }
+        BW.Put(run_count, 1 + GR_log2_run[run_index]);
+        if (run_index)
+            run_index--;
+        run_count = 0;
+        run_mode = 0;
+        if (Delta > 0)
+            Delta--;
+    }
+
+    GR_Contexts[quant_table_set_index][Context].Put(BW, Delta, P.bits_max);
+}
+
+//---------------------------------------------------------------------------
+void line_writer::Line_End()
+{
+    if (run_mode)
+    {
+        while (run_count >= ((uint32_t)1 << GR_log2_run[run_index]))
+        {
+            run_count -= (uint32_t)1 << GR_log2_run[run_index];
+            run_index++;
+            BW.Put(1, 1);
+        }
+        if (run_count)
+            BW.Put(1, 1); // Run until the end of the line
+    }
+    run_mode = 0;
+    run_count = 0;
+}
+
+//---------------------------------------------------------------------------
+bool ffv1_encoder::IsSupported(const corpus::flavor_info& Info)
+{
+    return Info.Parser == Parser_DPX || Info.Parser == Parser_TIFF;
+}
+
+//---------------------------------------------------------------------------
+void ffv1_encoder::Planes(vector<pixel_t>& Output, const corpus::flavor_info& Info, uint32_t Width, uint32_t Height, uint32_t Y, uint32_t FrameNumber)
+{
+    auto Components = corpus::Components(Info);
+    auto Bits = corpus::BitDepth(Info);
+    auto IsRGB = Components >= 3;
+    auto Alpha = Components == 4;
+    vector<uint16_t> Samples;
+    corpus::Samples(Samples, Info, Width, Height, Y, FrameNumber);
+    Output.resize((size_t)Width * (IsRGB ? Components : 1));
+
+    pixel_t Offset = ((pixel_t)1) << Bits;
+    auto Swap_GB = Bits > 8 && Bits < 16; // Exception indicated in specs, g and b are inverted
+    for (uint32_t x = 0; x < Width; x++)
+    {
+        const auto Sample = Samples.data() + (size_t)x * Components;
+        if (!IsRGB)
+        {
+            Output[x] = Sample[0];
+            continue;
+        }
+
+        // JPEG2000-RCT
+        pixel_t r = Sample[0];
+        pixel_t g = Sample[Swap_GB ? 2 : 1];
+        pixel_t b = Sample[Swap_GB ? 1 : 2];
+        b -= g;
+        r -= g;
+        g += (b + r) >> 2;
+        Output[x] = g;
+        Output[Width + x] = b + Offset;
+        Output[2 * Width + x] = r + Offset;
+        if (Alpha)
+            Output[3 * Width + x] = Sample[3];
+    }
+}
+
+//---------------------------------------------------------------------------
+bool ffv1_encoder::Frame(buffer& Output, const corpus::flavor_info& Info, uint32_t Width, uint32_t Height, uint32_t FrameNumber, uint32_t Coder)
+{
+    if (!IsSupported(Info) || Coder > 1 || !Width || !Height)
+        return true;
+    auto Components = corpus::Components(Info);
+    auto Bits = corpus::BitDepth(Info);
+    auto IsRGB = Components >= 3;
+    auto Alpha = Components == 4;
+
+    // Parameters as seen by the decoder
+    parameters P;
+    {
+        rangecoder_writer Header_RC;
+        Header(Header_RC, Coder, IsRGB, Bits, Alpha);
+        Header_RC.Terminate();
+        rangecoder E(Header_RC.Output.data(), Header_RC.Output.size(), default_state_transitions);
+        uint8_t KeyFrame = states_default;
+        E.b(KeyFrame);
+        if (P.Parse(E, false))
+            return true;
+    }
+
+    rangecoder_writer RC;
+    bit_writer BW;
+    Header(RC, Coder, IsRGB, Bits, Alpha);
+    if (!Coder)
+    {
+        uint8_t State = states_end;
+        RC.b(State, false);
+        RC.Terminate();
+    }
+
+    // Content
+    line_writer Writer(P, Coder, Width, RC, BW);
+    auto Plane_Count = P.plane_count;
+    vector<pixel_t> SamplesBuffer(2 * Plane_Count * ((size_t)Width + 3));
+    vector<pixel_t> Targets;
+    pixel_t* sample[4][2];
+    for (size_t c = 0; c < Plane_Count; c++)
+    {
+        sample[c][0] = SamplesBuffer.data() + 2 * c * (Width + 3) + 2;
+        sample[c][1] = sample[c][0] + Width + 3;
+    }
+    Writer.Plane_Init();
+    for (uint32_t y = 0; y < Height; y++)
+    {
+        Planes(Targets, Info, Width, Height, y, FrameNumber);
+        for (size_t c = 0; c < Plane_Count; c++)
+        {
+            swap(sample[c][0], sample[c][1]);
+            sample[c][1][-1] = sample[c][0][0];
+            sample[c][0][Width] = sample[c][0][Width - 1];
+            Writer.Line(IsRGB ? ((c + 1) >> 1) : 0, sample[c], Targets.data() + c * Width);
+        }
+    }
+
+    if (Coder)
+    {
+        uint8_t State = states_end;
+        RC.b(State, false);
+        RC.Terminate();
+    }
+    BW.Flush();
+
+    Output.Create(RC.Output.size() + BW.Output.size());
+    memcpy(Output.Data(), RC.Output.data(), RC.Output.size());
+    if (!BW.Output.empty())
+        memcpy(Output.Data() + RC.Output.size(), BW.Output.data(), BW.Output.size());
+    return false;
+}
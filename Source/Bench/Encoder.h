@@ -0,0 +1,95 @@
+/*  Copyright (c) MediaArea.net SARL & AV Preservation by reto.ch.
+ *
+ *  Use of this source code is governed by a BSD-style license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//---------------------------------------------------------------------------
+#ifndef EncoderH
+#define EncoderH
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+#include "Bench/Corpus.h"
+#include "Lib/CoDec/FFV1/FFV1_RangeCoder.h"
+#include <vector>
+using namespace std;
+//---------------------------------------------------------------------------
+
+//***************************************************************************
+// Writers, mirrors of the readers of the decoder
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+// Range coder, output is readable by rangecoder
+class rangecoder_writer
+{
+public:
+    rangecoder_writer();
+
+    // Run
+    void                        b(uint8_t& State, bool Value);
+    void                        b(states_struct& States, bool Value) { b(States.States[0], Value); }
+    void                        u(states_struct& States, uint32_t Value);
+    void                        s(states_struct& States, int32_t Value);
+    void                        Terminate();
+
+    vector<uint8_t>             Output;
+
+private:
+    void                        Renorm();
+
+    uint32_t                    Low = 0;
+    uint32_t                    Range = 0xFF00;
+    state_transitions_struct    zero_state;
+    state_transitions_struct    one_state;
+};
+
+//---------------------------------------------------------------------------
+// MSB first, output is readable by BitStream
+class bit_writer
+{
+public:
+    void                        Put(uint32_t Value, uint8_t Bits);
+    void                        Flush();
+
+    vector<uint8_t>             Output;
+
+private:
+    uint64_t                    Pending = 0;
+    uint8_t                     Pending_Count = 0;
+};
+
+//---------------------------------------------------------------------------
+// Golomb-Rice adaptive context, output is readable by coder_golombrice
+class golombrice_writer
+{
+public:
+    void                        Put(bit_writer& BW, int32_t Value, uint32_t bits_max); // Value is in the signed bits_max range
+
+private:
+    void                        Update();
+
+    int32_t                     ContextCount = 1;
+    int32_t                     Sum_Absolute = 4;
+    int32_t                     Sum_Corrected = 0;
+    int32_t                     Corrected = 0;
+};
+
+//***************************************************************************
+// Encoder
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+// Lossless FFV1 version 1 intra frames of the synthetic corpus, 1 slice
+// Only what is needed for realistic bitstreams in benchmarks, without external tools
+class ffv1_encoder
+{
+public:
+    static bool                 IsSupported(const corpus::flavor_info& Info);
+    static void                 Planes(vector<pixel_t>& Output, const corpus::flavor_info& Info, uint32_t Width, uint32_t Height, uint32_t Y, uint32_t FrameNumber); // Samples of line Y as coded, 1 plane after the other
+    static bool                 Frame(buffer& Output, const corpus::flavor_info& Info, uint32_t Width, uint32_t Height, uint32_t FrameNumber, uint32_t Coder); // Coder is 0 for Golomb-Rice, 1 for range coder, returns true on error
+};
+
+//---------------------------------------------------------------------------
+#endif
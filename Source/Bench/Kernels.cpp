@@ -0,0 +1,665 @@
+/*  Copyright (c) MediaArea.net SARL & AV Preservation by reto.ch.
+ *
+ *  Use of this source code is governed by a BSD-style license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//---------------------------------------------------------------------------
+#include "Bench/Kernels.h"
+#include "Bench/Corpus.h"
+#include "Bench/Cpu.h"
+#include "Bench/Encoder.h"
+#include "Lib/CoDec/FFV1/FFV1_Parameters.h"
+#include "Lib/CoDec/FFV1/FFV1_Slice.h"
+#include "Lib/CoDec/FFV1/Coder/FFV1_Coder_GolombRice.h"
+#include "Lib/Compressed/RAWcooked/RAWcooked.h"
+#include "Lib/Compressed/RAWcooked/Reversibility.h"
+#include "Lib/Transform/Transform.h"
+#include "Lib/Uncompressed/DPX/DPX.h"
+#include "Lib/Uncompressed/TIFF/TIFF.h"
+#include "Lib/Utils/CRC32/ZenCRC32.h"
+#include "Lib/Utils/RawFrame/RawFrame.h"
+#include "Lib/Utils/Stats/Stats.h"
+#include "zlib.h"
+extern "C"
+{
+#include "md5.h"
+}
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+using namespace std;
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+extern const state_transitions_struct default_state_transitions;
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+#if defined(_WIN32) || defined(_WINDOWS)
+    static const char* NullDevice = "NUL";
+#else
+    static const char* NullDevice = "/dev/null";
+#endif
+
+//---------------------------------------------------------------------------
+// Flavors of the inputs of kernels which are not run on all flavors
+static const corpus::flavor_info Flavor_Main = { Parser_DPX, (uint8_t)dpx::flavor::Raw_RGB_10_FilledA_BE };
+static const corpus::flavor_info Slice_Flavors[] =
+{
+    { Parser_DPX, (uint8_t)dpx::flavor::Raw_RGB_10_FilledA_BE },
+    { Parser_DPX, (uint8_t)dpx::flavor::Raw_RGB_16_BE },
+    { Parser_DPX, (uint8_t)dpx::flavor::Raw_Y_16_LE },
+    { Parser_TIFF, (uint8_t)tiff::flavor::Raw_RGB_8_U },
+};
+static const size_t Symbols_Contexts_Count = 16;
+static const size_t Headers_Count = 256;
+static const size_t Transform_Lines = 16; // Input lines are reused, as the slice decoder keeps them in cache
+
+//***************************************************************************
+// Harness
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+kernels::kernels(const config& Config_, vector<kernel_result>& Results_, vector<string>& Errors_) :
+    Config(Config_),
+    Results(Results_),
+    Errors(Errors_)
+{
+}
+
+//---------------------------------------------------------------------------
+void kernels::Run()
+{
+    RangeCoder();
+    GolombRice();
+    Slice();
+    Transform();
+    CRC32();
+    MD5();
+    MergeIn();
+    if (Config.Resolution_Independent)
+    {
+        Assign();
+        Reversibility();
+    }
+}
+
+//---------------------------------------------------------------------------
+static string Label(const kernel_result& Result)
+{
+    auto Name = Result.Name + ' ' + Result.Variant;
+    if (Result.Width && Result.Height)
+        Name += ' ' + to_string(Result.Width) + 'x' + to_string(Result.Height);
+    return Name;
+}
+
+//---------------------------------------------------------------------------
+bool kernels::IsFiltered(const kernel_result& Result) const
+{
+    if (Config.Filter.empty())
+        return false;
+    return Label(Result).find(Config.Filter) == string::npos;
+}
+
+//---------------------------------------------------------------------------
+void kernels::Error(const kernel_result& Result, const string& Message)
+{
+    Errors.push_back(Label(Result) + ": " + Message);
+}
+
+//---------------------------------------------------------------------------
+// Function returns a value depending on all the output of the kernel
+template<typename function>
+void kernels::Measure(kernel_result& Result, function Function)
+{
+    for (uint32_t i = 0; i < Config.Warmup; i++)
+        Sink = Sink + Function();
+
+    vector<uint64_t> Durations;
+    vector<uint64_t> Ticks;
+    for (uint32_t i = 0; i < Config.Repetitions; i++)
+    {
+        auto Cycles_Begin = cpu::Cycles();
+        auto Begin = stats::Now();
+        Sink = Sink + Function();
+        Durations.push_back(stats::Now() - Begin);
+        Ticks.push_back(cpu::Cycles() - Cycles_Begin);
+    }
+
+    // Statistics
+    sort(Durations.begin(), Durations.end());
+    sort(Ticks.begin(), Ticks.end());
+    auto Count = Durations.size();
+    auto Middle = Count / 2;
+    double Sum = 0;
+    for (auto Duration : Durations)
+        Sum += Duration;
+    Result.Repetitions = (uint32_t)Count;
+    Result.Min = (double)Durations[0];
+    Result.Median = (Count & 1) ? (double)Durations[Middle] : ((double)Durations[Middle - 1] + Durations[Middle]) / 2;
+    Result.Mean = Sum / Count;
+    double Variance = 0;
+    for (auto Duration : Durations)
+        Variance += (Duration - Result.Mean) * (Duration - Result.Mean);
+    Result.StdDev = Count > 1 ? sqrt(Variance / (Count - 1)) : 0;
+    if (cpu::HasCycles())
+        Result.Cycles = (Count & 1) ? (double)Ticks[Middle] : ((double)Ticks[Middle - 1] + Ticks[Middle]) / 2;
+
+    Results.push_back(Result);
+}
+
+//***************************************************************************
+// Inputs
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+// Median prediction residuals of the first plane, with a context from the local gradient
+void kernels::Symbols_Init()
+{
+    if (!Symbols.empty())
+        return;
+
+    auto Width = Config.Width;
+    auto Height = Config.Height;
+    Symbols.reserve((size_t)Width * Height);
+    Symbols_Contexts.reserve((size_t)Width * Height);
+    vector<pixel_t> Previous(Width);
+    vector<pixel_t> Current;
+    for (uint32_t y = 0; y < Height; y++)
+    {
+        ffv1_encoder::Planes(Current, Flavor_Main, Width, Height, y, 0);
+        for (uint32_t x = 0; x < Width; x++)
+        {
+            int32_t T = Previous[x];
+            int32_t LT = x ? Previous[x - 1] : T;
+            int32_t L = x ? Current[x - 1] : T;
+            int32_t Predicted = max(min(L, T), min(max(L, T), L + T - LT));
+            Symbols.push_back(Current[x] - Predicted);
+
+            uint32_t Gradient = abs(L - LT) + abs(LT - T);
+            uint8_t Context = 0;
+            while (Gradient && Context < Symbols_Contexts_Count - 1)
+            {
+                Gradient >>= 1;
+                Context++;
+            }
+            Symbols_Contexts.push_back(Context);
+        }
+        Previous.assign(Current.begin(), Current.begin() + Width);
+    }
+}
+
+//---------------------------------------------------------------------------
+// Only the file name differs, like in most scanned sequences
+void kernels::Headers_Init()
+{
+    if (!Headers.empty())
+        return;
+
+    buffer Frame;
+    corpus::Generate(Frame, Flavor_Main, 16, 16, 0);
+    auto Header_Size = corpus::ImageOffset(Flavor_Main, 16, 16);
+    for (size_t i = 0; i < Headers_Count; i++)
+    {
+        vector<uint8_t> Header(Frame.Data(), Frame.Data() + Header_Size);
+        char FileName[16];
+        auto FileName_Size = snprintf(FileName, sizeof(FileName), "%08u.dpx", (unsigned)i);
+        memcpy(Header.data() + 36, FileName, FileName_Size); // DPX image file name field
+        Headers.push_back(move(Header));
+    }
+}
+
+//***************************************************************************
+// Kernels
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+void kernels::RangeCoder()
+{
+    kernel_result Result;
+    Result.Name = "rangecoder::s";
+    Result.Variant = corpus::Flavor_String(Flavor_Main) + " residuals";
+    Result.Width = Config.Width;
+    Result.Height = Config.Height;
+    Result.Unit = "symbol";
+    if (IsFiltered(Result))
+        return;
+    Symbols_Init();
+
+    rangecoder_writer Writer;
+    vector<states_struct> States(Symbols_Contexts_Count, states_struct(states_default));
+    for (size_t i = 0; i < Symbols.size(); i++)
+        Writer.s(States[Symbols_Contexts[i]], Symbols[i]);
+    Writer.Terminate();
+
+    const auto Data = Writer.Output.data();
+    const auto Size = Writer.Output.size();
+    rangecoder E;
+    E.AssignStateTransitions(default_state_transitions);
+    auto Decode = [&](int32_t* Output) -> uint64_t
+    {
+        E.AssignBuffer(Data, Size);
+        States.assign(Symbols_Contexts_Count, states_struct(states_default));
+        uint64_t Sum = 0;
+        for (size_t i = 0; i < Symbols.size(); i++)
+        {
+            auto Value = E.s(States[Symbols_Contexts[i]]);
+            if (Output)
+                Output[i] = Value;
+            Sum += (uint32_t)Value;
+        }
+        return Sum;
+    };
+
+    vector<int32_t> Decoded(Symbols.size());
+    Decode(Decoded.data());
+    if (Decoded != Symbols)
+    {
+        Error(Result, "decoded symbols differ");
+        return;
+    }
+
+    Result.Items = Symbols.size();
+    Result.Bytes = Size;
+    Measure(Result, [&]() { return Decode(nullptr); });
+}
+
+//---------------------------------------------------------------------------
+// GR_Decode is private, it is reached through Sample_Delta with non-zero contexts (no run mode)
+void kernels::GolombRice()
+{
+    kernel_result Result;
+    Result.Name = "GR_Decode";
+    Result.Variant = corpus::Flavor_String(Flavor_Main) + " residuals, via coder_golombrice::Sample_Delta";
+    Result.Width = Config.Width;
+    Result.Height = Config.Height;
+    Result.Unit = "symbol";
+    if (IsFiltered(Result))
+        return;
+    Symbols_Init();
+
+    const uint32_t bits_max = corpus::BitDepth(Flavor_Main) + 1;
+    bit_writer BW;
+    vector<golombrice_writer> Writers(Symbols_Contexts_Count + 1);
+    for (size_t i = 0; i < Symbols.size(); i++)
+        Writers[Symbols_Contexts[i] + 1].Put(BW, Symbols[i], bits_max);
+    BW.Flush();
+
+    const auto Data = BW.Output.data();
+    const auto Size = BW.Output.size();
+    quant_table_sets_struct QuantTableSets;
+    QuantTableSets[0].Contexts_Count = Symbols_Contexts_Count + 1;
+    quant_table_set_indexes_struct Indexes;
+    Indexes[0].Index = 0;
+    coder_golombrice Coder(QuantTableSets, 1, Config.Width, bits_max);
+    auto Decode = [&](int32_t* Output) -> uint64_t
+    {
+        Coder.GOP_Init(Indexes);
+        Coder.Frame_Init(Data, Size);
+        Coder.Plane_Init();
+        Coder.Line_Init(0);
+        uint64_t Sum = 0;
+        for (size_t i = 0; i < Symbols.size(); i++)
+        {
+            auto Value = Coder.Sample_Delta(Symbols_Contexts[i] + 1);
+            if (Output)
+                Output[i] = Value;
+            Sum += (uint32_t)Value;
+        }
+        return Sum;
+    };
+
+    vector<int32_t> Decoded(Symbols.size());
+    Decode(Decoded.data());
+    if (Decoded != Symbols)
+    {
+        Error(Result, "decoded symbols differ");
+        return;
+    }
+
+    Result.Items = Symbols.size();
+    Result.Bytes = Size;
+    Measure(Result, [&]() { return Decode(nullptr); });
+}
+
+//---------------------------------------------------------------------------
+// slice::Line is private, it is reached through slice::Parse of 1-slice frames, output transform included
+void kernels::Slice()
+{
+    for (const auto& Flavor : Slice_Flavors)
+        for (uint32_t Coder = 0; Coder < 2; Coder++)
+        {
+            kernel_result Result;
+            Result.Name = "slice::Line";
+            Result.Variant = corpus::Flavor_String(Flavor) + " coder" + to_string(Coder) + ", via slice::Parse";
+            Result.Width = Config.Width;
+            Result.Height = Config.Height;
+            Result.Unit = "pixel";
+            if (IsFiltered(Result))
+                continue;
+
+            buffer Frame;
+            if (ffv1_encoder::Frame(Frame, Flavor, Config.Width, Config.Height, 0, Coder))
+            {
+                Error(Result, "can not encode the frame");
+                continue;
+            }
+
+            parameters P;
+            P.width = Config.Width;
+            P.height = Config.Height;
+            raw_frame RawFrame;
+            RawFrame.Flavor = Flavor.Parser == Parser_TIFF ? raw_frame::flavor::TIFF : raw_frame::flavor::DPX;
+            RawFrame.Flavor_Private = Flavor.Flavor;
+            slice Slice(&P);
+            auto Decode = [&]() -> uint64_t
+            {
+                Slice.Init(Frame.Data(), Frame.Size(), true, true, &RawFrame);
+                if (Slice.Parse() || P.error_message)
+                    return 0;
+                const auto& Image = RawFrame.Plane(0)->Buffer();
+                return Image.Data()[Image.Size() - 1];
+            };
+
+            // Decoded image must be the image of the uncompressed frame
+            Decode();
+            if (P.error_message)
+            {
+                Error(Result, P.error_message);
+                continue;
+            }
+            buffer Source;
+            corpus::Generate(Source, Flavor, Config.Width, Config.Height, 0);
+            auto Offset = corpus::ImageOffset(Flavor, Config.Width, Config.Height);
+            const auto& Image = RawFrame.Plane(0)->Buffer();
+            if (RawFrame.Planes().size() != 1 || Offset + Image.Size() > Source.Size() || memcmp(Source.Data() + Offset, Image.Data(), Image.Size()))
+            {
+                Error(Result, "decoded image differs");
+                continue;
+            }
+
+            Result.Items = (uint64_t)Config.Width * Config.Height;
+            Result.Bytes = Image.Size();
+            Measure(Result, Decode);
+        }
+}
+
+//---------------------------------------------------------------------------
+void kernels::Transform()
+{
+    for (const auto& Flavor : corpus::Flavors())
+    {
+        auto IsRGB = corpus::Components(Flavor) >= 3;
+        kernel_result Result;
+        Result.Name = IsRGB ? "transform_jpeg2000rct::From" : "transform_passthrough::From";
+        Result.Variant = corpus::Flavor_String(Flavor);
+        Result.Width = Config.Width;
+        Result.Height = Config.Height;
+        Result.Unit = "pixel";
+        if (IsFiltered(Result))
+            continue;
+
+        raw_frame RawFrame;
+        switch (Flavor.Parser)
+        {
+            case Parser_TIFF: RawFrame.Flavor = raw_frame::flavor::TIFF; break;
+            case Parser_EXR: RawFrame.Flavor = raw_frame::flavor::EXR; break;
+            default: RawFrame.Flavor = raw_frame::flavor::DPX;
+        }
+        RawFrame.Flavor_Private = Flavor.Flavor;
+        auto Bits = corpus::BitDepth(Flavor);
+        auto Alpha = corpus::Components(Flavor) == 4;
+        RawFrame.Create(IsRGB ? 1 : 0, Config.Width, Config.Height, Bits, IsRGB, Alpha, 1, 1);
+        if (RawFrame.Planes().empty())
+        {
+            Error(Result, "no raw frame");
+            continue;
+        }
+        auto PixelsPerBlock = RawFrame.Plane(0)->PixelsPerBlock();
+        if (Config.Width % PixelsPerBlock)
+        {
+            Error(Result, "width is not a multiple of " + to_string(PixelsPerBlock));
+            continue;
+        }
+
+        // Lines as decoded by the slice decoder
+        vector<vector<pixel_t>> Lines(Transform_Lines);
+        for (uint32_t y = 0; y < Transform_Lines; y++)
+            ffv1_encoder::Planes(Lines[y], Flavor, Config.Width, Config.Height, y % Config.Height, 0);
+        auto Run = [&]() -> uint64_t
+        {
+            unique_ptr<transform_base> Transform(Transform_Init(&RawFrame, IsRGB ? pix_style::RGBA : pix_style::YUVA, Bits, 0, 0, Config.Width, Config.Height));
+            for (uint32_t y = 0; y < Config.Height; y++)
+            {
+                auto Line = Lines[y % Transform_Lines].data();
+                if (IsRGB)
+                    Transform->From(Line, Line + Config.Width, Line + 2 * Config.Width, Alpha ? (Line + 3 * Config.Width) : nullptr);
+                else
+                    Transform->From(Line);
+            }
+            const auto& Image = RawFrame.Plane(0)->Buffer();
+            return Image.Data()[Image.Size() - 1];
+        };
+
+        Result.Items = (uint64_t)Config.Width * Config.Height;
+        Result.Bytes = RawFrame.Plane(0)->Buffer().Size();
+        Measure(Result, Run);
+    }
+}
+
+//---------------------------------------------------------------------------
+void kernels::CRC32()
+{
+    kernel_result Result;
+    Result.Name = "ZenCRC32";
+    Result.Variant = corpus::Flavor_String(Flavor_Main) + " frame";
+    Result.Width = Config.Width;
+    Result.Height = Config.Height;
+    if (IsFiltered(Result))
+        return;
+
+    buffer Frame;
+    corpus::Generate(Frame, Flavor_Main, Config.Width, Config.Height, 0);
+    Result.Items = Frame.Size();
+    Result.Bytes = Frame.Size();
+    Measure(Result, [&]() -> uint64_t { return ZenCRC32(Frame.Data(), Frame.Size()); });
+}
+
+//---------------------------------------------------------------------------
+void kernels::MD5()
+{
+    kernel_result Result;
+    Result.Name = "MD5_Update";
+    Result.Variant = corpus::Flavor_String(Flavor_Main) + " frame";
+    Result.Width = Config.Width;
+    Result.Height = Config.Height;
+    if (IsFiltered(Result))
+        return;
+
+    buffer Frame;
+    corpus::Generate(Frame, Flavor_Main, Config.Width, Config.Height, 0);
+    Result.Items = Frame.Size();
+    Result.Bytes = Frame.Size();
+    Measure(Result, [&]() -> uint64_t
+    {
+        MD5_CTX Context;
+        MD5_Init(&Context);
+        MD5_Update(&Context, Frame.Data(), (unsigned long)Frame.Size());
+        unsigned char Digest[16];
+        MD5_Final(Digest, &Context);
+        return Digest[0];
+    });
+}
+
+//---------------------------------------------------------------------------
+void kernels::MergeIn()
+{
+    kernel_result Result;
+    Result.Name = "raw_frame::MergeIn";
+    Result.Variant = corpus::Flavor_String(Flavor_Main) + " plane";
+    Result.Width = Config.Width;
+    Result.Height = Config.Height;
+    if (IsFiltered(Result))
+        return;
+
+    raw_frame RawFrame;
+    RawFrame.Flavor = raw_frame::flavor::DPX;
+    RawFrame.Flavor_Private = Flavor_Main.Flavor;
+    RawFrame.Create(1, Config.Width, Config.Height, corpus::BitDepth(Flavor_Main), true, false, 1, 1);
+    if (RawFrame.Planes().size() != 1)
+    {
+        Error(Result, "no raw frame");
+        return;
+    }
+    const auto& Image = RawFrame.Plane(0)->Buffer();
+    buffer Frame;
+    corpus::Generate(Frame, Flavor_Main, Config.Width, Config.Height, 0);
+    auto Offset = corpus::ImageOffset(Flavor_Main, Config.Width, Config.Height);
+    if (Offset + Image.Size() > Frame.Size())
+    {
+        Error(Result, "frame is too small");
+        return;
+    }
+    RawFrame.SetIn(buffer_or_view(Frame.Data() + Offset, Image.Size()));
+
+    Result.Items = Image.Size();
+    Result.Bytes = Image.Size();
+    Measure(Result, [&]() -> uint64_t
+    {
+        RawFrame.MergeIn();
+        return Image.Data()[Image.Size() - 1];
+    });
+}
+
+//---------------------------------------------------------------------------
+static user_mode Ask_Callback(user_mode*, const string&, const string&, bool, bool*, condition_variable*)
+{
+    return AlwaysYes;
+}
+
+//---------------------------------------------------------------------------
+// compressed_buffer is private, it is reached through rawcooked::Parse, so reversibility data is written to the null device
+void kernels::Assign()
+{
+    kernel_result Result;
+    Result.Name = "compressed_buffer::Assign";
+    Result.Variant = corpus::Flavor_String(Flavor_Main) + " headers, via rawcooked::Parse";
+    Result.Unit = "frame";
+    if (IsFiltered(Result))
+        return;
+    Headers_Init();
+
+    errors Errors_Lib;
+    user_mode Mode = AlwaysYes;
+    rawcooked RAWcooked;
+    RAWcooked.FileName = NullDevice;
+    RAWcooked.Mode = &Mode;
+    RAWcooked.Ask_Callback = Ask_Callback;
+    RAWcooked.Errors = &Errors_Lib;
+    vector<string> FileNames;
+    for (size_t i = 0; i < Headers.size(); i++)
+        FileNames.push_back(string((const char*)Headers[i].data() + 36, 12));
+
+    Result.Items = Headers.size();
+    for (const auto& Header : Headers)
+        Result.Bytes += Header.size();
+    Measure(Result, [&]() -> uint64_t
+    {
+        for (size_t i = 0; i < Headers.size(); i++)
+        {
+            RAWcooked.OutputFileName = FileNames[i];
+            RAWcooked.BeforeData = Headers[i].data();
+            RAWcooked.BeforeData_Size = Headers[i].size();
+            RAWcooked.Parse();
+        }
+        return Headers.size();
+    });
+    if (Errors_Lib.HasErrors())
+        Error(Result, Errors_Lib.ErrorMessage());
+}
+
+//---------------------------------------------------------------------------
+// Size in EBML style, then zlib content
+static void Compressed_Append(vector<uint8_t>& Output, const uint8_t* Data, size_t Size, bool Compress)
+{
+    vector<uint8_t> Compressed;
+    uint64_t UncompressedSize = 0;
+    if (Compress)
+    {
+        auto Compressed_Size = compressBound((uLong)Size);
+        Compressed.resize(Compressed_Size);
+        if (compress2(Compressed.data(), &Compressed_Size, Data, (uLong)Size, 1) == Z_OK && Compressed_Size < Size)
+        {
+            Compressed.resize(Compressed_Size);
+            UncompressedSize = Size;
+        }
+    }
+    if (!UncompressedSize)
+        Compressed.assign(Data, Data + Size);
+
+    size_t Length = 1;
+    while (Length < 8 && UncompressedSize >= ((uint64_t)1 << (7 * Length)) - 1)
+        Length++;
+    Output.push_back((uint8_t)((0x80 >> (Length - 1)) | (UncompressedSize >> (8 * (Length - 1)))));
+    for (size_t i = Length - 1; i; i--)
+        Output.push_back((uint8_t)(UncompressedSize >> (8 * (i - 1))));
+    Output.insert(Output.end(), Compressed.begin(), Compressed.end());
+}
+
+//---------------------------------------------------------------------------
+void kernels::Reversibility()
+{
+    kernel_result Result;
+    Result.Name = "reversibility::data::Data";
+    Result.Variant = corpus::Flavor_String(Flavor_Main) + " headers, via reversibility::View";
+    Result.Unit = "frame";
+    if (IsFiltered(Result))
+        return;
+    Headers_Init();
+
+    // Reversibility data as stored by rawcooked, first header is the mask
+    const auto& Mask = Headers[0];
+    vector<uint8_t> Mask_Data;
+    Compressed_Append(Mask_Data, Mask.data(), Mask.size(), false);
+    reversibility R;
+    R.SetDataMask(reversibility::element::BeforeData, buffer_view(Mask_Data.data(), Mask_Data.size()));
+    vector<uint8_t> Base;
+    vector<uint8_t> Masked;
+    for (const auto& Header : Headers)
+    {
+        Masked.resize(Header.size());
+        for (size_t i = 0; i < Header.size(); i++)
+            Masked[i] = Header[i] - Mask[i];
+        auto Offset = Base.size();
+        Compressed_Append(Base, Masked.data(), Masked.size(), true);
+        R.NewFrame();
+        R.SetData(reversibility::element::BeforeData, Offset, Base.size() - Offset, true);
+    }
+
+    auto Decode = [&](bool Check) -> uint64_t
+    {
+        uint64_t Sum = 0;
+        R.StartParsing(Base.data());
+        for (size_t i = 0; i < Headers.size(); i++)
+        {
+            auto Content = R.View(reversibility::element::BeforeData);
+            if (Check && (Content.Size() != Headers[i].size() || memcmp(Content.Data(), Headers[i].data(), Content.Size())))
+                return (uint64_t)-1;
+            Sum += Content.Size();
+            R.NextFrame();
+        }
+        return Sum;
+    };
+    if (Decode(true) == (uint64_t)-1)
+    {
+        Error(Result, "decoded headers differ");
+        return;
+    }
+
+    Result.Items = Headers.size();
+    for (const auto& Header : Headers)
+        Result.Bytes += Header.size();
+    Measure(Result, [&]() { return Decode(false); });
+}
@@ -0,0 +1,88 @@
+/*  Copyright (c) MediaArea.net SARL & AV Preservation by reto.ch.
+ *
+ *  Use of this source code is governed by a BSD-style license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//---------------------------------------------------------------------------
+#ifndef KernelsH
+#define KernelsH
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+#include "Lib/Config.h"
+#include <string>
+#include <vector>
+using namespace std;
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+struct kernel_result
+{
+    string                      Name;
+    string                      Variant;
+    uint32_t                    Width = 0;
+    uint32_t                    Height = 0;
+    const char*                 Unit = "byte"; // What Items counts
+    uint64_t                    Items = 0; // Per repetition
+    uint64_t                    Bytes = 0; // Per repetition
+    uint32_t                    Repetitions = 0;
+    double                      Median = 0; // Durations of a repetition in nanoseconds
+    double                      Min = 0;
+    double                      Mean = 0;
+    double                      StdDev = 0;
+    double                      Cycles = 0; // Median of time stamp counter ticks of a repetition, 0 if not available
+};
+
+//---------------------------------------------------------------------------
+// Each hot kernel measured on its own, with inputs from the synthetic corpus
+class kernels
+{
+public:
+    struct config
+    {
+        uint32_t                Width = 1920;
+        uint32_t                Height = 1080;
+        uint32_t                Warmup = 3;
+        uint32_t                Repetitions = 15;
+        string                  Filter;
+        bool                    Resolution_Independent = true; // Also the kernels whose input does not depend on the resolution
+    };
+
+    kernels(const config& Config, vector<kernel_result>& Results, vector<string>& Errors);
+
+    void                        Run();
+
+private:
+    // Harness
+    bool                        IsFiltered(const kernel_result& Result) const;
+    void                        Error(const kernel_result& Result, const string& Message);
+    template<typename function>
+    void                        Measure(kernel_result& Result, function Function);
+
+    // Kernels
+    void                        RangeCoder();
+    void                        GolombRice();
+    void                        Slice();
+    void                        Transform();
+    void                        CRC32();
+    void                        MD5();
+    void                        MergeIn();
+    void                        Assign();
+    void                        Reversibility();
+
+    // Inputs
+    void                        Symbols_Init();
+    void                        Headers_Init();
+
+    const config&               Config;
+    vector<kernel_result>&      Results;
+    vector<string>&             Errors;
+    vector<int32_t>             Symbols; // Prediction residuals of a plane
+    vector<uint8_t>             Symbols_Contexts;
+    vector<vector<uint8_t>>     Headers; // DPX headers of consecutive frames
+    volatile uint64_t           Sink = 0; // Results of the kernels, so they are not optimized out
+};
+
+//---------------------------------------------------------------------------
+#endif
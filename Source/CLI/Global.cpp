@@ -7,7 +7,10 @@
 //---------------------------------------------------------------------------
 #include "CLI/Global.h"
 #include "CLI/Help.h"
+#include "Lib/Utils/Hash/Hash.h"
+#include "Lib/Utils/Stats/Stats.h"
 #include <iostream>
+#include <cstdlib>
 #include <cstring>
 #include <iomanip>
 #include <thread>
@@ -80,6 +83,138 @@ int global::SetDisplayCommand()
     return 0;
 }
 
+//---------------------------------------------------------------------------
+int global::SetDurability(const char* Value)
+{
+    if (strcmp(Value, "none") == 0)
+        Durability = durability::None;
+    else if (strcmp(Value, "batch") == 0)
+        Durability = durability::Batch;
+    else if (strcmp(Value, "file") == 0)
+        Durability = durability::File;
+    else
+    {
+        cerr << "Error: durability must be none, batch or file.\n";
+        return 1;
+    }
+    return 0;
+}
+
+//---------------------------------------------------------------------------
+int global::SetMaxMemory(const char* Value)
+{
+    char* End;
+    auto Size = strtoull(Value, &End, 10);
+    int Shift = 0;
+    switch (*End)
+    {
+        case 'K': case 'k': Shift = 10; End++; break;
+        case 'M': case 'm': Shift = 20; End++; break;
+        case 'G': case 'g': Shift = 30; End++; break;
+        default:;
+    }
+    if (End == Value || *End || !Size || Size > ((size_t)-1 >> Shift))
+    {
+        cerr << "Error: max memory must be a positive count of bytes, with an optional K, M or G suffix.\n";
+        return 1;
+    }
+    MaxMemory = (size_t)Size << Shift;
+    return 0;
+}
+
+//---------------------------------------------------------------------------
+int global::SetStats(const char* Value)
+{
+    if (!*Value)
+    {
+        cerr << "Error: stats file name must not be empty.\n";
+        return 1;
+    }
+    StatsFileName = Value;
+    return 0;
+}
+
+//---------------------------------------------------------------------------
+int global::SetTrace(const char* Value)
+{
+    if (!*Value)
+    {
+        cerr << "Error: trace file name must not be empty.\n";
+        return 1;
+    }
+    TraceFileName = Value;
+    return 0;
+}
+
+//---------------------------------------------------------------------------
+int global::SetAnalyzeFFV1(const char* Value)
+{
+    if (!*Value)
+    {
+        cerr << "Error: FFV1 analysis file name must not be empty.\n";
+        return 1;
+    }
+    AnalyzeFFV1FileName = Value;
+    size_t Value_Size = AnalyzeFFV1FileName.size();
+    if (Value_Size > 4 && (Value[Value_Size - 4] == '.') && (Value[Value_Size - 3] | 0x20) == 'c' && (Value[Value_Size - 2] | 0x20) == 's' && (Value[Value_Size - 1] | 0x20) == 'v')
+        AnalyzeFFV1 = analysis_format::CSV;
+    else
+        AnalyzeFFV1 = analysis_format::JSON;
+    return 0;
+}
+
+//---------------------------------------------------------------------------
+int global::SetFrameRing(const char* Value)
+{
+    if (!*Value || strchr(Value + 1, '/'))
+    {
+        cerr << "Error: frame ring name must not be empty and must not contain '/' after its first character.\n";
+        return 1;
+    }
+    FrameRingName = Value;
+    return 0;
+}
+
+//---------------------------------------------------------------------------
+int global::SetFrameRingSlots(const char* Value)
+{
+    char* End;
+    auto Count = strtoul(Value, &End, 10);
+    if (End == Value || *End || !Count || Count > 0xFFFF)
+    {
+        cerr << "Error: frame ring slot count must be between 1 and 65535.\n";
+        return 1;
+    }
+    FrameRingSlots = Count;
+    return 0;
+}
+
+//---------------------------------------------------------------------------
+int global::SetServe(const char* Value)
+{
+    if (!*Value)
+    {
+        cerr << "Error: job server socket name must not be empty.\n";
+        return 1;
+    }
+    ServeSocketName = Value;
+    return 0;
+}
+
+//---------------------------------------------------------------------------
+int global::SetServeJobs(const char* Value)
+{
+    char* End;
+    auto Count = strtoul(Value, &End, 10);
+    if (End == Value || *End || !Count || Count > 0xFFFF)
+    {
+        cerr << "Error: job server child job count must be between 1 and 65535.\n";
+        return 1;
+    }
+    ServeJobs = Count;
+    return 0;
+}
+
 //---------------------------------------------------------------------------
 int global::SetAcceptFiles()
 {
@@ -127,6 +262,23 @@ int global::SetCheck(const char* Value, int& i)
     return 0;
 }
 
+//---------------------------------------------------------------------------
+int global::SetCheckLevel(const char* Value)
+{
+    if (strcmp(Value, "container") == 0)
+        CheckLevel = check_level::Container;
+    else if (strcmp(Value, "decode") == 0)
+        CheckLevel = check_level::Decode;
+    else if (strcmp(Value, "sample") == 0)
+        CheckLevel = check_level::Sample;
+    else
+    {
+        cerr << "Error: check level must be container, decode or sample.\n";
+        return 1;
+    }
+    return SetCheck(true);
+}
+
 //---------------------------------------------------------------------------
 int global::SetCheckPadding(bool Value)
 {
@@ -209,6 +361,25 @@ int global::SetFrameMd5FileName(const char* FileName)
     return 0;
 }
 
+//---------------------------------------------------------------------------
+int global::SetContainerHash(const char* Value)
+{
+    ContainerHash = hash_base::FromOptionName(Value);
+    if (ContainerHash == hash_format::None)
+    {
+        cerr << "Error: container hash must be md5, sha256, xxh3 or blake3.\n";
+        return 1;
+    }
+    return 0;
+}
+
+//---------------------------------------------------------------------------
+int global::SetContainerHashFileName(const char* FileName)
+{
+    ContainerHashFileName = FileName;
+    return 0;
+}
+
 //---------------------------------------------------------------------------
 int global::SetHash(bool Value)
 {
@@ -216,6 +387,18 @@ int global::SetHash(bool Value)
     return 0;
 }
 
+//---------------------------------------------------------------------------
+int global::SetHashFormat(const char* Value)
+{
+    HashFormat = hash_base::FromOptionName(Value);
+    if (HashFormat == hash_format::None)
+    {
+        cerr << "Error: hash format must be md5, sha256, xxh3 or blake3.\n";
+        return 1;
+    }
+    return 0;
+}
+
 //---------------------------------------------------------------------------
 int global::SetAll(bool Value)
 {
@@ -453,7 +636,6 @@ int global::ManageCommandLine(const char* argv[], int argc)
     Actions.set(Action_Encode);
     Actions.set(Action_Decode);
     Actions.set(Action_Coherency);
-    Hashes = hashes(&Errors);
     ProgressIndicator_Thread = NULL;
 
     for (int i = 1; i < argc; i++)
@@ -514,6 +696,15 @@ int global::ManageCommandLine(const char* argv[], int argc)
                     return Value;
             }
         }
+        else if (strcmp(argv[i], "--check-level") == 0)
+        {
+            if (i + 1 == argc)
+                return Error_Missing(argv[i]);
+            int Value = SetCheckLevel(argv[++i]);
+            License.Feature(feature::GeneralOptions);
+            if (Value)
+                return Value;
+        }
         else if (strcmp(argv[i], "--check-padding") == 0)
         {
             int Value = SetCheckPadding(true);
@@ -545,6 +736,86 @@ int global::ManageCommandLine(const char* argv[], int argc)
                 return Value;
             License.Feature(feature::GeneralOptions);
         }
+        else if (strcmp(argv[i], "--durability") == 0)
+        {
+            if (i + 1 == argc)
+                return Error_Missing(argv[i]);
+            int Value = SetDurability(argv[++i]);
+            if (Value)
+                return Value;
+        }
+        else if (strcmp(argv[i], "--resume") == 0)
+        {
+            Resume = true;
+        }
+        else if (strcmp(argv[i], "--max-memory") == 0)
+        {
+            if (i + 1 == argc)
+                return Error_Missing(argv[i]);
+            int Value = SetMaxMemory(argv[++i]);
+            if (Value)
+                return Value;
+        }
+        else if (strcmp(argv[i], "--huge-pages") == 0)
+        {
+            HugePages = true;
+        }
+        else if (strcmp(argv[i], "--stats") == 0)
+        {
+            if (i + 1 == argc)
+                return Error_Missing(argv[i]);
+            int Value = SetStats(argv[++i]);
+            if (Value)
+                return Value;
+        }
+        else if (strcmp(argv[i], "--trace") == 0)
+        {
+            if (i + 1 == argc)
+                return Error_Missing(argv[i]);
+            int Value = SetTrace(argv[++i]);
+            if (Value)
+                return Value;
+        }
+        else if (strcmp(argv[i], "--analyze-ffv1") == 0)
+        {
+            if (i + 1 == argc)
+                return Error_Missing(argv[i]);
+            int Value = SetAnalyzeFFV1(argv[++i]);
+            if (Value)
+                return Value;
+        }
+        else if (strcmp(argv[i], "--frame-ring") == 0)
+        {
+            if (i + 1 == argc)
+                return Error_Missing(argv[i]);
+            int Value = SetFrameRing(argv[++i]);
+            if (Value)
+                return Value;
+        }
+        else if (strcmp(argv[i], "--frame-ring-slots") == 0)
+        {
+            if (i + 1 == argc)
+                return Error_Missing(argv[i]);
+            int Value = SetFrameRingSlots(argv[++i]);
+            if (Value)
+                return Value;
+        }
+        else if (strcmp(argv[i], "--serve") == 0)
+        {
+            if (i + 1 == argc)
+                return Error_Missing(argv[i]);
+            int Value = SetServe(argv[++i]);
+            if (Value)
+                return Value;
+        }
+        else if (strcmp(argv[i], "--serve-jobs") == 0)
+        {
+            if (i + 1 == argc)
+                return Error_Missing(argv[i]);
+            int Value = SetServeJobs(argv[++i]);
+            if (Value)
+                return Value;
+        }
         else if (strcmp(argv[i], "--decode") == 0)
         {
             int Value = SetDecode(true);
@@ -571,12 +842,36 @@ int global::ManageCommandLine(const char* argv[], int argc)
             if (Value)
                 return Value;
         }
+        else if (strcmp(argv[i], "--container-hash") == 0)
+        {
+            if (i + 1 == argc)
+                return Error_Missing(argv[i]);
+            int Value = SetContainerHash(argv[++i]);
+            if (Value)
+                return Value;
+        }
+        else if (strcmp(argv[i], "--container-hash-file") == 0)
+        {
+            if (i + 1 == argc)
+                return Error_Missing(argv[i]);
+            int Value = SetContainerHashFileName(argv[++i]);
+            if (Value)
+                return Value;
+        }
         else if (strcmp(argv[i], "--hash") == 0)
         {
             int Value = SetHash(true);
             if (Value)
                 return Value;
         }
+        else if (strcmp(argv[i], "--hash-format") == 0)
+        {
+            if (i + 1 == argc)
+                return Error_Missing(argv[i]);
+            int Value = SetHashFormat(argv[++i]);
+            if (Value)
+                return Value;
+        }
         else if (strcmp(argv[i], "--file") == 0)
         {
             int Value = SetAcceptFiles();
@@ -832,6 +1127,7 @@ void global::ProgressIndicator_Show()
     steady_clock::time_point Clock_Init = steady_clock::now();
     steady_clock::time_point Clock_Previous = Clock_Init;
     uint64_t FileCount_Previous = 0;
+    stats::values Stats_Previous;
 
     // Show progress indicator at a specific frequency
     const chrono::seconds Frequency = chrono::seconds(1);
@@ -879,6 +1175,14 @@ void global::ProgressIndicator_Show()
                 cerr << setprecision(0) << FileRate;
                 cerr << " files/s";
             }
+            if (stats::IsEnabled())
+            {
+                auto Stats_Current = stats::Values();
+                auto Bottleneck = stats::Bottleneck(Stats_Current, Stats_Previous);
+                if (Bottleneck != (stage)stage_Max)
+                    cerr << ", bottleneck: " << stats::Name(Bottleneck);
+                Stats_Previous = Stats_Current;
+            }
             cerr << "    "; // Clean up in case there is less content outputed than the previous time
 
             ProgressIndicator_Value = ProgressIndicator_New;
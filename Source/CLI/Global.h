@@ -12,6 +12,7 @@
 //---------------------------------------------------------------------------
 #include "CLI/Config.h"
 #include "Lib/Config.h"
+#include "Lib/CoDec/FFV1/FFV1_Analysis.h"
 #include "Lib/Uncompressed/HashSum/HashSum.h"
 #include "Lib/License/License.h"
 #include <map>
@@ -33,6 +34,7 @@ public:
     string                      rawcooked_reversibility_FileName;
     string                      OutputFileName;
     string                      FrameMd5FileName;
+    string                      ContainerHashFileName;
     string                      BinName;
     string                      LicenseKey;
     uint64_t                    SubLicenseId;
@@ -47,13 +49,28 @@ public:
     bool                        OutputFileName_IsProvided;
     bool                        Quiet;
     bitset<Action_Max>          Actions;
+    durability                  Durability = durability::None;
+    bool                        Resume = false; // Journal of complete output files is kept, for resuming an interrupted decoding
+    size_t                      MaxMemory = 0; // Budget for buffers of decoded frames, 0 means default
+    bool                        HugePages = false;
+    string                      StatsFileName; // Per stage performance report in JSON, empty means no report
+    string                      TraceFileName; // Timeline of tasks in Chrome trace format, empty means no trace
+    analysis_format             AnalyzeFFV1 = analysis_format::None; // Per slice statistics of FFV1 streams
+    string                      AnalyzeFFV1FileName; // Output of the FFV1 statistics, format from its extension
+    string                      FrameRingName; // Shared memory receiving the decoded frames instead of files, empty means files
+    size_t                      FrameRingSlots = 8;
+    string                      ServeSocketName; // Local socket receiving jobs, empty means no job server
+    size_t                      ServeJobs = 0; // Count of child jobs running at the same time, 0 means a quarter of the threads
+    check_level                 CheckLevel = check_level::Decode;
+    hash_format                 ContainerHash = hash_format::None;
+    hash_format                 HashFormat = hash_format::MD5; // Format of hashes of files stored in reversibility data
 
     // Intermediate info
     size_t                      Path_Pos_Global;
     vector<string>              Inputs;
     license                     License;
     user_mode                   Mode = Ask;
-    hashes                      Hashes;
+    hashes                      Hashes{ &Errors };
     errors                      Errors;
     ask_callback                Ask_Callback = nullptr;
 
@@ -83,9 +100,19 @@ private:
     int SetSubLicenseId(uint64_t Id);
     int SetSubLicenseDur(uint64_t Dur);
     int SetDisplayCommand();
+    int SetDurability(const char* Value);
+    int SetMaxMemory(const char* Value);
+    int SetStats(const char* Value);
+    int SetTrace(const char* Value);
+    int SetAnalyzeFFV1(const char* Value);
+    int SetFrameRing(const char* Value);
+    int SetFrameRingSlots(const char* Value);
+    int SetServe(const char* Value);
+    int SetServeJobs(const char* Value);
     int SetAcceptFiles();
     int SetCheck(bool Value);
     int SetCheck(const char* Value, int& i);
+    int SetCheckLevel(const char* Value);
     int SetQuickCheck();
     int SetCheckPadding(bool Value);
     int SetQuickCheckPadding();
@@ -97,7 +124,10 @@ private:
     int SetInfo(bool Value);
     int SetFrameMd5(bool Value);
     int SetFrameMd5FileName(const char* FileName);
+    int SetContainerHash(const char* Value);
+    int SetContainerHashFileName(const char* FileName);
     int SetHash(bool Value);
+    int SetHashFormat(const char* Value);
     int SetAll(bool Value);
 
     // Progress indicator
@@ -122,6 +122,81 @@ ReturnValue Help(const char* Name)
         "              Do not show information related to RAWcooked.\n"
         "              External encoder or decoder may need an additional option.\n"
         "\n"
+        "       --durability value\n"
+        "              Set when decoded files are flushed to stable storage to value:\n"
+        "              none (left to the operating system), batch (group commit of\n"
+        "              several files in the background, the last durable file is\n"
+        "              displayed at the end), file (each file is flushed before being\n"
+        "              closed, slower).\n"
+        "              The default value is none, but batch is used with --resume.\n"
+        "\n"
+        "       --resume\n"
+        "              During decoding, keep the list of complete output files which\n"
+        "              are on stable storage in ${Output}.rawcooked_journal next to\n"
+        "              the output directory. If decoding is interrupted, the next run\n"
+        "              with --resume on the same input does not decode again the\n"
+        "              files which are listed and not modified since (same size and\n"
+        "              modification time). Their content is not read, so they are not\n"
+        "              checked. The journal is removed when decoding ends without\n"
+        "              error.\n"
+        "\n"
+        "       --max-memory value\n"
+        "              Set the memory budget of decoded frames waiting for being written\n"
+        "              and of recycled frame buffers to value, in bytes or with a K, M\n"
+        "              or G suffix. When the budget is reached, decoding waits for\n"
+        "              pending writes.\n"
+        "              The default value is 384M.\n"
+        "\n"
+        "       --huge-pages\n"
+        "              Use transparent huge pages for big frame buffers (Linux only).\n"
+        "\n"
+        "       --stats value\n"
+        "              Write a JSON report of bytes, frames, busy time and wait time\n"
+        "              per processing stage and of live and peak memory per use\n"
+        "              to the file value after processing, and show the current\n"
+        "              bottleneck stage in the progress indicator.\n"
+        "\n"
+        "       --trace value\n"
+        "              Write a timeline of slice decoding, frame writing, hashing\n"
+        "              and remapping tasks per thread to the file value, in Chrome\n"
+        "              trace format (readable by Perfetto or chrome://tracing).\n"
+        "\n"
+        "       --analyze-ffv1 value\n"
+        "              Write statistics of the decoded FFV1 slices to the file value\n"
+        "              during processing, in csv format if value ends with .csv else\n"
+        "              in json format: position, coder, bytes, range coder bytes,\n"
+        "              bits per pixel and decode time per slice, bytes, count of used\n"
+        "              contexts and Golomb-Rice runs per plane. json adds histograms\n"
+        "              of contexts and of run lengths per stream and plane. Slices\n"
+        "              are in decoding order.\n"
+        "\n"
+        "       --frame-ring value\n"
+        "              Publish the decoded frames of the first video track of the\n"
+        "              input Matroska files in the POSIX shared memory named value\n"
+        "              instead of writing files, for another process reading them\n"
+        "              without copy. Slots are sized for the biggest frames of the\n"
+        "              inputs, decoding waits when all slots are used by the reader.\n"
+        "              Publishing stops if the reader process ends, the shared\n"
+        "              memory is removed on SIGINT or SIGTERM.\n"
+        "              See Source/Lib/Utils/FrameRing/FrameRing.h for the protocol.\n"
+        "\n"
+        "       --frame-ring-slots value\n"
+        "              Set the count of frames in the frame ring to value.\n"
+        "              The default value is 8.\n"
+        "\n"
+        "       --serve value\n"
+        "              Run as a job server listening on the local socket named\n"
+        "              value instead of processing inputs. Jobs (check, encode,\n"
+        "              decode, run in a child process each, and decode-frames, run\n"
+        "              in the server) and their progress and results are JSON lines.\n"
+        "              See Source/CLI/Server.h for the protocol.\n"
+        "\n"
+        "       --serve-jobs value\n"
+        "              Set the count of child jobs of the job server running at the\n"
+        "              same time to value, other ones wait. The threads are split\n"
+        "              between them (-threads of each child).\n"
+        "              The default value is a quarter of the threads, at least 1.\n"
+        "\n"
         "       -y     Automatic yes to prompts.\n"
         "              Assume yes in answer to all prompts, and run non-interactively.\n"
         "\n"
@@ -143,6 +218,17 @@ ReturnValue Help(const char* Name)
         "              as the original content.\n"
         "              Disables decoding.\n"
         "\n"
+        "       --check-level value\n"
+        "              Set how much of the compressed content is decoded by --check\n"
+        "              to value: container (structure and checksums of compressed\n"
+        "              frames, no decoding), decode (all frames are decoded),\n"
+        "              sample (structure and checksums, 1 frame randomly chosen in\n"
+        "              each group of 100 frames is decoded).\n"
+        "              Tracks without checksums of compressed frames (FFV1 without\n"
+        "              slice CRC, FLAC, PCM) are fully decoded with container.\n"
+        "              Implies --check.\n"
+        "              The default value is decode.\n"
+        "\n"
         "       --quick-check\n"
         "              Run quick coherency checks of the encoded file. Allows user to\n"
         "              check that the file seems healthy without the additional time\n"
@@ -227,6 +313,14 @@ ReturnValue Help(const char* Name)
         "              Any issues raised by this check is considered a decoding error.\n"
         "              This permits a reversibility check without the original files.\n"
         "\n"
+        "       --hash-format value\n"
+        "              Set the algorithm of the hashes computed by --hash to value:\n"
+        "              md5 (default, compatible with all versions), xxh3 (XXH3-128,\n"
+        "              fastest), blake3 (BLAKE3, multi-threaded for big files) or\n"
+        "              sha256 (SHA-256, CPU instructions are used if available).\n"
+        "              The algorithm is stored in the reversibility metadata and\n"
+        "              used by --decode and --check.\n"
+        "\n"
         "       --no-hash\n"
         "              Do not compute or test the hash of the file (see above).\n"
         "              This is default, but may change in the future.\n"
@@ -234,6 +328,9 @@ ReturnValue Help(const char* Name)
         "       --framemd5\n"
         "              Compute the framemd5 of input frames and store it to a sidecar\n"
         "              file.\n"
+        "              If the input is a Matroska file or if the check after encoding\n"
+        "              is requested, the framemd5 is computed by RAWcooked from the\n"
+        "              decoded frames of the first FFV1 track.\n"
         "              See FFmpeg framemd5 documentation for more information.\n"
         "\n"
         "       --framemd5-name value\n"
@@ -244,6 +341,16 @@ ReturnValue Help(const char* Name)
         "              Do not compute the framemd5 of input frames. (see above).\n"
         "              Is default.\n"
         "\n"
+        "       --container-hash value\n"
+        "              Compute the hash of the whole Matroska file while it is parsed\n"
+        "              for decoding or checking, with the algorithm value: md5,\n"
+        "              sha256, xxh3 or blake3.\n"
+        "\n"
+        "       --container-hash-file value\n"
+        "              Compare the hash of the whole Matroska file (see above) with\n"
+        "              the one in the sidecar file value (e.g. from md5sum).\n"
+        "              Algorithm is deduced from the sidecar file if not provided.\n"
+        "\n"
         "       --accept-gaps\n"
         "              Use if there are missing files within the sequence numbering.\n"
         "              RAWcooked creates a concatenated list of all files ensuring the\n"
@@ -8,6 +8,7 @@
 #include "CLI/Global.h"
 #include "CLI/Input.h"
 #include "CLI/Output.h"
+#include "CLI/Server.h"
 #include "Lib/Compressed/Matroska/Matroska.h"
 #include "Lib/Uncompressed/DPX/DPX.h"
 #include "Lib/Uncompressed/TIFF/TIFF.h"
@@ -16,15 +17,28 @@
 #include "Lib/Uncompressed/AIFF/AIFF.h"
 #include "Lib/CoDec/FFV1/FFV1_Frame.h"
 #include "Lib/Utils/RawFrame/RawFrame.h"
+#include "Lib/Utils/Buffer/BufferPool.h"
+#include "Lib/Utils/Buffer/Memory.h"
+#include "Lib/Utils/FileIO/AsyncWriter.h"
+#include "Lib/Utils/FileIO/Durability.h"
+#include "Lib/Utils/FileIO/Journal.h"
+#include "Lib/Utils/Hash/StreamHash.h"
+#include "Lib/CoDec/FFV1/FFV1_Analysis.h"
+#include "Lib/Utils/Stats/Stats.h"
+#include "Lib/Utils/Stats/Trace.h"
 #include "Lib/Compressed/RAWcooked/RAWcooked.h"
+#include "Lib/Utils/FrameRing/FramePublisher.h"
 #include "Lib/ThirdParty/alphanum/alphanum.hpp"
 #include "Lib/ThirdParty/thread-pool/include/ThreadPool.h"
 #include <map>
 #include <sstream>
+#include <fstream>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <algorithm>
+#include <csignal>
 #include <thread>
 using namespace std;
 //---------------------------------------------------------------------------
@@ -34,12 +48,35 @@ global Global;
 input Input;
 output Output;
 rawcooked RAWcooked;
+ThreadPool* Hash_Pool = nullptr; // Threads for hashes of uncompressed files with a parallel mode
 //---------------------------------------------------------------------------
 
+//---------------------------------------------------------------------------
+// Count of threads from the command line, nullptr if only 1 thread
+ThreadPool* ThreadPool_New()
+{
+    unsigned threads;
+    auto OutputOptions_Threads = Global.OutputOptions.find("threads");
+    if (OutputOptions_Threads != Global.OutputOptions.end())
+        threads = stoul(OutputOptions_Threads->second);
+    else
+        threads = 0;
+    if (!threads)
+        threads = thread::hardware_concurrency();
+    if (threads <= 1)
+        return nullptr;
+    auto Pool = new ThreadPool(threads);
+    Pool->init();
+    return Pool;
+}
+
 //---------------------------------------------------------------------------
 // Ask user about overwriting files
 user_mode Ask_Callback(user_mode* Mode, const string& FileName, const string& ExtraText, bool Always, bool* ProgressIndicator_IsPaused, condition_variable* ProgressIndicator_IsEnd)
 {
+    static mutex Ask_Mutex; // Tracks may ask at the same time
+    lock_guard<mutex> Lock(Ask_Mutex);
+
     if (Mode && *Mode != Ask)
         return *Mode;
 
@@ -82,6 +119,7 @@ struct parse_info
     string FileList;
     string Flavor;
     string Slices;
+    string CheckedName; // Name of the file if Name is not set, e.g. output file during the check after encoding
     input_info InputInfo;
     bool   IsDetected;
     bool   Problem;
@@ -104,10 +142,20 @@ bool parse_info::ParseFile_Input(input_base& SingleFile, bool OverrideCheckPaddi
         SingleFile.Actions.set(Action_CheckPadding);
     SingleFile.Hashes = &Global.Hashes;
     SingleFile.FileName = &RAWcooked.OutputFileName;
+    SingleFile.HashFormat = Global.HashFormat;
+    SingleFile.HashPool = Hash_Pool;
     SingleFile.InputInfo = &InputInfo;
 
     // Parse
-    SingleFile.Parse(FileMap);
+    if (SingleFile.ParserCode == Parser_Matroska)
+        SingleFile.Parse(FileMap); // Performance is counted per Matroska element
+    else
+    {
+        stats_scope Stats(stage::Input);
+        SingleFile.Parse(FileMap);
+        if (SingleFile.IsDetected())
+            Stats.Add(FileMap.Size(), 1);
+    }
     Global.ProgressIndicator_Increment();
 
     // Management
@@ -391,26 +439,63 @@ int ParseFile_Compressed(parse_info& ParseInfo)
     if (!ParseInfo.IsDetected)
     {
         // Threads
-        unsigned threads;
-        auto OutputOptions_Threads = Global.OutputOptions.find("threads");
-        if (OutputOptions_Threads != Global.OutputOptions.end())
-            threads = stoul(OutputOptions_Threads->second);
-        else
-            threads = 0;
-        if (!threads)
-            threads = thread::hardware_concurrency();
-        ThreadPool* Thread_Pool;
-        if (threads > 1)
+        ThreadPool* Thread_Pool = ThreadPool_New();
+
+        // Journal of complete output files, next to the output directory, for resuming an interrupted decoding
+        journal* Journal = nullptr;
+        if (Global.Resume && Global.Actions[Action_Decode] && ParseInfo.Name && OutputDirectoryName.size() > 1)
         {
-            Thread_Pool = new ThreadPool(threads);
-            Thread_Pool->init();
+            Journal = new journal(OutputDirectoryName.substr(0, OutputDirectoryName.size() - 1) + ".rawcooked_journal", OutputDirectoryName, *ParseInfo.Name, ParseInfo.FileMap.Size());
+            if (Journal->Open())
+            {
+                delete Journal; // Decoding is not resumable
+                Journal = nullptr;
+            }
         }
-        else
-            Thread_Pool = nullptr;
+
+        // Files are listed in the journal only once durable, so at least group commits are needed
+        durable_writes* Durable = nullptr;
+        if ((Global.Durability != durability::None || Journal) && Global.Actions[Action_Decode])
+        {
+            Durable = new durable_writes(Global.Durability != durability::None ? Global.Durability : durability::Batch);
+            Durable->SetJournal(Journal);
+        }
+
+        // Hash of the whole container, computed during the same pass
+        const string& ContainerName = ParseInfo.Name ? *ParseInfo.Name : ParseInfo.CheckedName;
+        auto ContainerHash_Format = Global.ContainerHash;
+        string ContainerHash_Sidecar;
+        bool ContainerHash_SidecarIsFound = false;
+        if (!Global.ContainerHashFileName.empty())
+        {
+            ContainerHash_SidecarIsFound = stream_hash::FromSidecar(Global.ContainerHashFileName, ContainerName, ContainerHash_Sidecar);
+            if (ContainerHash_Format == hash_format::None)
+                ContainerHash_Format = ContainerHash_Sidecar.size() == 64 ? hash_format::SHA256 : hash_format::MD5; // Format from the sidecar file
+        }
+        stream_hash* ContainerHash = nullptr;
+        if (ContainerHash_Format != hash_format::None)
+            ContainerHash = new stream_hash(ContainerHash_Format);
 
         matroska* M = new matroska(OutputDirectoryName, &Global.Mode, Ask_Callback, Thread_Pool, &Global.Errors);
         M->Quiet = Global.Quiet;
         M->NoOutputCheck = NoOutputCheck;
+        M->Durable = Durable;
+        M->Journal = Journal;
+        M->CheckLevel = Global.CheckLevel;
+        M->ContainerHash = ContainerHash;
+        buffer_pool* Buffers = nullptr;
+        if (Thread_Pool)
+        {
+            // Write-behind of whole files, with a memory budget shared with recycled frame buffers
+            Buffers = new buffer_pool(Global.MaxMemory, Global.HugePages);
+            M->Writer = new async_writer(Buffers);
+        }
+        if (Global.Actions[Action_FrameMd5])
+        {
+            M->FrameMd5FileName = Global.FrameMd5FileName;
+            if (M->FrameMd5FileName.empty() && ParseInfo.Name)
+                M->FrameMd5FileName = *ParseInfo.Name + ".framemd5";
+        }
         if (ParseInfo.ParseFile_Input(*M))
         {
             ReturnValue = 1;
@@ -440,9 +525,58 @@ int ParseFile_Compressed(parse_info& ParseInfo)
                 }
                 cout << endl;
             }
+
+            if (ContainerHash)
+            {
+                auto Hash = ContainerHash->Final();
+                if (!Global.Quiet)
+                    cout << "\nInfo: " << hash_base::Name(ContainerHash->Format()) << " of " << ContainerName << " is " << Hash << '.' << endl;
+                if (!Global.ContainerHashFileName.empty())
+                {
+                    if (!ContainerHash_SidecarIsFound)
+                    {
+                        cerr << "\nError: no hash of " << ContainerName << " found in " << Global.ContainerHashFileName << '.' << endl;
+                        ReturnValue = 1;
+                    }
+                    else if (ContainerHash_Sidecar != Hash)
+                    {
+                        cerr << "\nError: " << hash_base::Name(ContainerHash->Format()) << " of " << ContainerName << " does not match the one in " << Global.ContainerHashFileName << " (" << ContainerHash_Sidecar << ")." << endl;
+                        ReturnValue = 1;
+                    }
+                    else if (!Global.Quiet)
+                        cout << "\nInfo: " << hash_base::Name(ContainerHash->Format()) << " of " << ContainerName << " matches the one in " << Global.ContainerHashFileName << '.' << endl;
+                }
+            }
+        }
+        if (M->FrameMd5_IsError)
+        {
+            cerr << "\nError: can not write " << M->FrameMd5FileName << '.' << endl;
+            ReturnValue = 1;
         }
+        if (M->Complete_Count && !Global.Quiet)
+            cout << "\nInfo: " << M->Complete_Count << " files already decoded were not decoded again." << endl;
         delete M;
+        delete Buffers;
+        delete ContainerHash;
         delete Thread_Pool;
+
+        if (Durable)
+        {
+            if (Durable->HasErrors())
+                cerr << "\nError: some files could not be flushed to stable storage." << endl;
+            else if (Global.Durability == durability::Batch && !Global.Quiet && !Durable->LastDurable().empty())
+                cout << "\nInfo: files are durable up to " << Durable->LastDurable() << '.' << endl;
+            if (Durable->HasErrors())
+                ReturnValue = 1;
+            delete Durable;
+        }
+
+        if (Journal)
+        {
+            if ((!ReturnValue && !Global.Errors.HasErrors()) || Journal->IsEmpty())
+                Journal->Remove(); // All is OK or nothing to resume
+            delete Journal;
+        }
     }
 
     // End
@@ -499,6 +633,50 @@ int ParseFile(size_t Files_Pos)
     return 0;
 }
 
+//---------------------------------------------------------------------------
+// Frame ring, decoded frames are published in shared memory instead of being written to files
+volatile sig_atomic_t FrameRing_Stop = 0;
+void FrameRing_Signal_Handler(int)
+{
+    FrameRing_Stop = 1;
+}
+
+int PublishFrames()
+{
+    // Threads
+    size_t Threads = 0;
+    auto OutputOptions_Threads = Global.OutputOptions.find("threads");
+    if (OutputOptions_Threads != Global.OutputOptions.end())
+        Threads = stoul(OutputOptions_Threads->second);
+    if (!Threads)
+        Threads = thread::hardware_concurrency();
+
+    frame_publisher Publisher;
+    Publisher.Name = Global.FrameRingName;
+    Publisher.Slot_Count = Global.FrameRingSlots;
+    Publisher.Threads = Threads;
+    Publisher.Stop = &FrameRing_Stop;
+
+    // Signals, the shared memory is removed before exiting
+    #if !defined(_WIN32) && !defined(_WINDOWS)
+        struct sigaction Action;
+        memset(&Action, 0, sizeof(Action));
+        Action.sa_handler = FrameRing_Signal_Handler;
+        sigaction(SIGINT, &Action, nullptr);
+        sigaction(SIGTERM, &Action, nullptr);
+    #endif
+
+    int Value = 0;
+    if (Publisher.Run(Input.Files))
+    {
+        cerr << "Error: " << Publisher.ErrorMessage() << ".\n";
+        Value = 1;
+    }
+    if (!Global.Quiet)
+        cerr << Publisher.Published() << " frames published in " << Global.FrameRingName << (Publisher.IsClosed() ? ", stopped by the reader.\n" : ".\n");
+    return Value;
+}
+
 //---------------------------------------------------------------------------
 int main(int argc, const char* argv[])
 {
@@ -508,6 +686,32 @@ int main(int argc, const char* argv[])
     // Manage command line
     if (int Value = Global.ManageCommandLine(argv, argc))
         return Value;
+    if (!Global.StatsFileName.empty())
+    {
+        // Check now that the report can be written, not after processing
+        ofstream Stats_File(Global.StatsFileName, ios_base::out | ios_base::trunc);
+        if (!Stats_File.is_open())
+        {
+            cerr << "Error: can not create " << Global.StatsFileName << ".\n";
+            return 1;
+        }
+        stats::Enable();
+        memory::Enable();
+    }
+    if (!Global.AnalyzeFFV1FileName.empty() && ffv1_analysis::Enable(Global.AnalyzeFFV1, Global.AnalyzeFFV1FileName))
+    {
+        cerr << "Error: can not create " << Global.AnalyzeFFV1FileName << ".\n";
+        return 1;
+    }
+    if (!Global.TraceFileName.empty() && trace::Enable(Global.TraceFileName))
+    {
+        cerr << "Error: can not create " << Global.TraceFileName << ".\n";
+        return 1;
+    }
+
+    // Job server
+    if (!Global.ServeSocketName.empty())
+        return Serve(Global, argv[0]);
 
     // Analyze input
     if (int Value = Input.AnalyzeInputs(Global))
@@ -515,8 +719,14 @@ int main(int argc, const char* argv[])
     sort(Input.Files.begin(), Input.Files.end(),
         [](const string& l, const string& r) {return doj::alphanum_comp(l, r) < 0; });
 
+    // Frame ring
+    if (!Global.FrameRingName.empty())
+        return PublishFrames();
+
     // Parse files
     RAWcooked.FileName = Global.rawcooked_reversibility_FileName;
+    if (Global.Actions[Action_Hash] && Global.HashFormat == hash_format::BLAKE3)
+        Hash_Pool = ThreadPool_New(); // Same threads for all files
     int Value = 0;
     for (size_t i = 0; i < Input.Files.size(); i++)
     {
@@ -525,6 +735,12 @@ int main(int argc, const char* argv[])
             break;
     }
     RAWcooked.Close();
+    if (Hash_Pool)
+    {
+        Hash_Pool->shutdown();
+        delete Hash_Pool;
+        Hash_Pool = nullptr;
+    }
 
     // Coherency checks
     if (Global.Actions[Action_Coherency])
@@ -605,6 +821,7 @@ int main(int argc, const char* argv[])
         {
             // Configure for a 2nd pass
             ParseInfo.Name = NULL;
+            ParseInfo.CheckedName = Global.OutputFileName;
             Global.OutputFileName = Global.Inputs[0];
             if (!Global.Actions[Action_Hash]) // If hashes are present in the file, output is checked by using hashes
                 Global.OutputFileName_IsProvided = true;
@@ -639,5 +856,31 @@ int main(int argc, const char* argv[])
             Value = 1;
     }
 
+    // Performance report
+    if (!Global.StatsFileName.empty())
+    {
+        ofstream Stats_File(Global.StatsFileName, ios_base::out | ios_base::trunc);
+        if (Stats_File.is_open())
+            stats::Json(Stats_File);
+        if (!Stats_File.is_open() || !Stats_File.good())
+        {
+            cerr << "Error: can not write " << Global.StatsFileName << ".\n";
+            if (!Value)
+                Value = 1;
+        }
+    }
+    if (ffv1_analysis::IsEnabled() && ffv1_analysis::End())
+    {
+        cerr << "Error: can not write " << Global.AnalyzeFFV1FileName << ".\n";
+        if (!Value)
+            Value = 1;
+    }
+    if (trace::Write())
+    {
+        cerr << "Error: can not write " << Global.TraceFileName << ".\n";
+        if (!Value)
+            Value = 1;
+    }
+
     return Value;
 }
@@ -323,9 +323,12 @@ int output::FFmpeg_Command(const char* FileName, global& Global)
                 Global.FrameMd5FileName.pop_back();
             Global.FrameMd5FileName += ".framemd5";
         }
-        Command += " -f framemd5 \"";
-        Command += Global.FrameMd5FileName;
-        Command += '\"';
+        if (!Global.Actions[Action_Check]) // Else computed by the check pass, from the decoded frames
+        {
+            Command += " -f framemd5 \"";
+            Command += Global.FrameMd5FileName;
+            Command += '\"';
+        }
     }
 
     // Info
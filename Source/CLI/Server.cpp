@@ -0,0 +1,888 @@
+/*  Copyright (c) MediaArea.net SARL & AV Preservation by reto.ch.
+ *
+ *  Use of this source code is governed by a BSD-style license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//---------------------------------------------------------------------------
+#include "CLI/Server.h"
+#include "Lib/API/RAWcooked_API.h"
+#include "Lib/ThirdParty/thread-pool/include/ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <vector>
+#if !defined(_WIN32) && !defined(_WINDOWS)
+#include <csignal>
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <spawn.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+extern char** environ;
+#endif
+using namespace std;
+//---------------------------------------------------------------------------
+
+#if defined(_WIN32) || defined(_WINDOWS)
+
+//---------------------------------------------------------------------------
+int Serve(global& /*Global*/, const char* /*BinName*/)
+{
+    cerr << "Error: job server is not supported on this platform.\n";
+    return 1;
+}
+
+#else
+
+//---------------------------------------------------------------------------
+namespace
+{
+    volatile sig_atomic_t       Signal_Stop = 0;
+    void Signal_Handler(int)
+    {
+        Signal_Stop = 1;
+    }
+
+    const int                   Poll_Timeout = 200; // In ms, for seeing the stop request
+    const auto                  Progress_Interval = chrono::milliseconds(250);
+
+    void CloseOnExec(int Fd)
+    {
+        fcntl(Fd, F_SETFD, fcntl(Fd, F_GETFD) | FD_CLOEXEC);
+    }
+
+    //***********************************************************************
+    // JSON
+    //***********************************************************************
+
+    //-----------------------------------------------------------------------
+    string Json_String(const string& Value)
+    {
+        string Result(1, '"');
+        for (auto c : Value)
+        {
+            switch (c)
+            {
+                case '"'  : Result += "\\\""; break;
+                case '\\' : Result += "\\\\"; break;
+                case '\n' : Result += "\\n"; break;
+                case '\r' : Result += "\\r"; break;
+                case '\t' : Result += "\\t"; break;
+                default:
+                    if ((unsigned char)c < 0x20)
+                    {
+                        char Temp[7];
+                        snprintf(Temp, sizeof(Temp), "\\u%04x", (unsigned)c);
+                        Result += Temp;
+                    }
+                    else
+                        Result += c;
+            }
+        }
+        Result += '"';
+        return Result;
+    }
+
+    //-----------------------------------------------------------------------
+    struct request
+    {
+        string                  ID; // JSON value, string or number
+        string                  Type;
+        string                  Input;
+        vector<string>          Args;
+    };
+
+    //-----------------------------------------------------------------------
+    // Object with string or array of strings values, other values are skipped
+    // Returns true on error
+    class request_parser
+    {
+    public:
+        request_parser(const string& Text_Source) :
+            Text(Text_Source)
+        {}
+
+        bool                    Parse(request& Request);
+
+    private:
+        const string&           Text;
+        size_t                  Pos = 0;
+
+        void                    Spaces();
+        bool                    Expect(char c);
+        bool                    String(string& Value);
+        bool                    Strings(vector<string>& Values);
+        bool                    Skip(size_t Depth = 0);
+    };
+
+    //-----------------------------------------------------------------------
+    void request_parser::Spaces()
+    {
+        while (Pos < Text.size() && (Text[Pos] == ' ' || Text[Pos] == '\t' || Text[Pos] == '\r' || Text[Pos] == '\n'))
+            Pos++;
+    }
+
+    //-----------------------------------------------------------------------
+    bool request_parser::Expect(char c)
+    {
+        Spaces();
+        if (Pos >= Text.size() || Text[Pos] != c)
+            return true;
+        Pos++;
+        return false;
+    }
+
+    //-----------------------------------------------------------------------
+    bool request_parser::String(string& Value)
+    {
+        if (Expect('"'))
+            return true;
+        Value.clear();
+        while (Pos < Text.size())
+        {
+            auto c = Text[Pos++];
+            if (c == '"')
+                return false;
+            if (c != '\\')
+            {
+                Value += c;
+                continue;
+            }
+            if (Pos >= Text.size())
+                return true;
+            switch (c = Text[Pos++])
+            {
+                case 'b' : Value += '\b'; break;
+                case 'f' : Value += '\f'; break;
+                case 'n' : Value += '\n'; break;
+                case 'r' : Value += '\r'; break;
+                case 't' : Value += '\t'; break;
+                case 'u' :
+                {
+                    auto Hex = [&](uint32_t& Code) {
+                        if (Text.size() - Pos < 4)
+                            return true;
+                        Code = 0;
+                        for (int i = 0; i < 4; i++)
+                        {
+                            auto h = Text[Pos++];
+                            Code <<= 4;
+                            if (h >= '0' && h <= '9') Code |= h - '0';
+                            else if (h >= 'a' && h <= 'f') Code |= h - 'a' + 10;
+                            else if (h >= 'A' && h <= 'F') Code |= h - 'A' + 10;
+                            else return true;
+                        }
+                        return false;
+                    };
+                    uint32_t Code;
+                    if (Hex(Code))
+                        return true;
+                    if (Code >= 0xD800 && Code < 0xDC00)
+                    {
+                        // Surrogate pair
+                        uint32_t Low;
+                        if (Text.compare(Pos, 2, "\\u") || (Pos += 2, Hex(Low)) || Low < 0xDC00 || Low >= 0xE000)
+                            return true;
+                        Code = 0x10000 + ((Code - 0xD800) << 10) + (Low - 0xDC00);
+                    }
+                    // UTF-8
+                    if (Code < 0x80)
+                        Value += (char)Code;
+                    else if (Code < 0x800)
+                    {
+                        Value += (char)(0xC0 | (Code >> 6));
+                        Value += (char)(0x80 | (Code & 0x3F));
+                    }
+                    else if (Code < 0x10000)
+                    {
+                        Value += (char)(0xE0 | (Code >> 12));
+                        Value += (char)(0x80 | ((Code >> 6) & 0x3F));
+                        Value += (char)(0x80 | (Code & 0x3F));
+                    }
+                    else
+                    {
+                        Value += (char)(0xF0 | (Code >> 18));
+                        Value += (char)(0x80 | ((Code >> 12) & 0x3F));
+                        Value += (char)(0x80 | ((Code >> 6) & 0x3F));
+                        Value += (char)(0x80 | (Code & 0x3F));
+                    }
+                    break;
+                }
+                default  : Value += c; // '"', '\\' and '/'
+            }
+        }
+        return true;
+    }
+
+    //-----------------------------------------------------------------------
+    bool request_parser::Strings(vector<string>& Values)
+    {
+        if (Expect('['))
+            return true;
+        Values.clear();
+        Spaces();
+        if (Pos < Text.size() && Text[Pos] == ']')
+        {
+            Pos++;
+            return false;
+        }
+        for (;;)
+        {
+            Values.emplace_back();
+            if (String(Values.back()))
+                return true;
+            Spaces();
+            if (Pos >= Text.size())
+                return true;
+            auto c = Text[Pos++];
+            if (c == ']')
+                return false;
+            if (c != ',')
+                return true;
+        }
+    }
+
+    //-----------------------------------------------------------------------
+    bool request_parser::Skip(size_t Depth)
+    {
+        if (Depth > 32)
+            return true;
+        Spaces();
+        if (Pos >= Text.size())
+            return true;
+        string Temp;
+        switch (Text[Pos])
+        {
+            case '"':
+                return String(Temp);
+            case '[':
+            case '{':
+            {
+                auto IsObject = Text[Pos++] == '{';
+                auto End = IsObject ? '}' : ']';
+                Spaces();
+                if (Pos < Text.size() && Text[Pos] == End)
+                {
+                    Pos++;
+                    return false;
+                }
+                for (;;)
+                {
+                    if (IsObject && (String(Temp) || Expect(':')))
+                        return true;
+                    if (Skip(Depth + 1))
+                        return true;
+                    Spaces();
+                    if (Pos >= Text.size())
+                        return true;
+                    auto c = Text[Pos++];
+                    if (c == End)
+                        return false;
+                    if (c != ',')
+                        return true;
+                }
+            }
+            default:
+            {
+                // Number, true, false, null
+                auto Begin = Pos;
+                while (Pos < Text.size() && (isalnum((unsigned char)Text[Pos]) || Text[Pos] == '-' || Text[Pos] == '+' || Text[Pos] == '.'))
+                    Pos++;
+                return Pos == Begin;
+            }
+        }
+    }
+
+    //-----------------------------------------------------------------------
+    bool request_parser::Parse(request& Request)
+    {
+        if (Expect('{'))
+            return true;
+        Spaces();
+        if (Pos < Text.size() && Text[Pos] == '}')
+        {
+            Pos++;
+            return false;
+        }
+        for (;;)
+        {
+            string Key;
+            if (String(Key) || Expect(':'))
+                return true;
+            Spaces();
+            if (Key == "id")
+            {
+                // Sent back as is
+                auto Begin = Pos;
+                if (Skip())
+                    return true;
+                Request.ID = Text.substr(Begin, Pos - Begin);
+            }
+            else if (Key == "type")
+            {
+                if (String(Request.Type))
+                    return true;
+            }
+            else if (Key == "input")
+            {
+                if (String(Request.Input))
+                    return true;
+            }
+            else if (Key == "args")
+            {
+                if (Strings(Request.Args))
+                    return true;
+            }
+            else if (Skip())
+                return true;
+            Spaces();
+            if (Pos >= Text.size())
+                return true;
+            auto c = Text[Pos++];
+            if (c == '}')
+            {
+                Spaces();
+                return Pos != Text.size();
+            }
+            if (c != ',')
+                return true;
+        }
+    }
+
+    //-----------------------------------------------------------------------
+    // Progress line of a child, "Time=00:01:02 (12.5%)..." from rawcooked or
+    // "frame=  120 ..." from FFmpeg, returns the content of the progress
+    // event or an empty string if it is not a progress line
+    string Progress_Event(const string& Text)
+    {
+        if (!Text.compare(0, 5, "Time="))
+        {
+            auto Begin = Text.find(" (");
+            auto End = Text.find("%)", Begin);
+            if (Begin == string::npos || End == string::npos)
+                return string();
+            Begin += 2;
+            if (End == Begin || !isdigit((unsigned char)Text[Begin]) || Text.find_first_not_of("0123456789.", Begin) < End)
+                return string();
+            return "\"progress\", \"percent\": " + Text.substr(Begin, End - Begin);
+        }
+        if (!Text.compare(0, 6, "frame="))
+        {
+            auto Begin = Text.find_first_not_of(' ', 6);
+            if (Begin == string::npos || !isdigit((unsigned char)Text[Begin]))
+                return string();
+            auto End = Text.find_first_not_of("0123456789", Begin);
+            return "\"progress\", \"done\": " + Text.substr(Begin, End == string::npos ? string::npos : (End - Begin));
+        }
+        return string();
+    }
+
+    //***********************************************************************
+    // Server
+    //***********************************************************************
+
+    //-----------------------------------------------------------------------
+    struct connection
+    {
+        int                     Fd;
+        thread                  Thread;
+        string                  Pending; // Received content not yet used
+        atomic<bool>            IsFinished{ false };
+        bool                    IsClosed = false;
+    };
+
+    //-----------------------------------------------------------------------
+    class server
+    {
+    public:
+        server(ThreadPool* Pool_Source, const string& BinName_Source, size_t Children_Max_Source, size_t Child_Threads_Source) :
+            Pool(Pool_Source),
+            BinName(BinName_Source),
+            Children_Max(Children_Max_Source),
+            Child_Threads(Child_Threads_Source)
+        {}
+
+        int                     Run(const string& SocketName, bool Quiet);
+
+    private:
+        ThreadPool*             Pool;
+        string                  BinName;
+        atomic<bool>            IsStopping{ false };
+        mutex                   Spawn_Mutex; // File descriptors must be close on exec before a child is created
+
+        // Children
+        size_t                  Children_Max;
+        size_t                  Child_Threads; // -threads of a child if the job does not provide it
+        size_t                  Children = 0;
+        mutex                   Children_Mutex;
+        condition_variable      Children_Free;
+
+        // Connection
+        void                    Connection(connection& C);
+        bool                    Receive(connection& C, int Timeout); // Returns true if the connection is closed
+        void                    Send(connection& C, const request& Request, const string& Event);
+
+        // Jobs, return the exit code
+        void                    Job(connection& C, const string& Line);
+        int                     Job_DecodeFrames(connection& C, const request& Request, string& ErrorMessage);
+        int                     Job_Command(connection& C, const request& Request, string& ErrorMessage);
+        int                     Job_Child(connection& C, const request& Request, string& ErrorMessage);
+    };
+
+    //-----------------------------------------------------------------------
+    int server::Run(const string& SocketName, bool Quiet)
+    {
+        sockaddr_un Address;
+        memset(&Address, 0, sizeof(Address));
+        Address.sun_family = AF_UNIX;
+        if (SocketName.size() >= sizeof(Address.sun_path))
+        {
+            cerr << "Error: socket name " << SocketName << " is too long.\n";
+            return 1;
+        }
+        memcpy(Address.sun_path, SocketName.c_str(), SocketName.size());
+
+        auto Listen = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (Listen == -1)
+        {
+            cerr << "Error: can not create a socket (" << strerror(errno) << ").\n";
+            return 1;
+        }
+        CloseOnExec(Listen);
+        if (bind(Listen, (sockaddr*)&Address, sizeof(Address)))
+        {
+            // A socket file from a stopped server is replaced, not one of a running server
+            auto Probe = socket(AF_UNIX, SOCK_STREAM, 0);
+            struct stat Stat;
+            auto IsStale = errno == EADDRINUSE && !stat(SocketName.c_str(), &Stat) && S_ISSOCK(Stat.st_mode) && connect(Probe, (sockaddr*)&Address, sizeof(Address)) && errno == ECONNREFUSED;
+            close(Probe);
+            if (!IsStale || unlink(SocketName.c_str()) || bind(Listen, (sockaddr*)&Address, sizeof(Address)))
+            {
+                cerr << "Error: can not listen on " << SocketName << " (" << strerror(errno) << ").\n";
+                close(Listen);
+                return 1;
+            }
+        }
+        if (listen(Listen, 64))
+        {
+            cerr << "Error: can not listen on " << SocketName << " (" << strerror(errno) << ").\n";
+            close(Listen);
+            unlink(SocketName.c_str());
+            return 1;
+        }
+
+        // Signals
+        struct sigaction Action;
+        memset(&Action, 0, sizeof(Action));
+        Action.sa_handler = Signal_Handler;
+        sigaction(SIGINT, &Action, nullptr);
+        sigaction(SIGTERM, &Action, nullptr);
+        signal(SIGPIPE, SIG_IGN); // Disconnected clients are errors of send()
+
+        if (!Quiet)
+            cerr << "Listening on " << SocketName << ".\n";
+
+        list<connection> Connections;
+        while (!Signal_Stop)
+        {
+            // Finished connections
+            for (auto C = Connections.begin(); C != Connections.end();)
+            {
+                if (C->IsFinished)
+                {
+                    C->Thread.join();
+                    C = Connections.erase(C);
+                }
+                else
+                    C++;
+            }
+
+            pollfd Poll = { Listen, POLLIN, 0 };
+            if (poll(&Poll, 1, Poll_Timeout) <= 0)
+                continue;
+            int Fd;
+            {
+                lock_guard<mutex> Lock(Spawn_Mutex);
+                Fd = accept(Listen, nullptr, nullptr);
+                if (Fd != -1)
+                    CloseOnExec(Fd);
+            }
+            if (Fd == -1)
+                continue;
+            Connections.emplace_back();
+            auto& C = Connections.back();
+            C.Fd = Fd;
+            C.Thread = thread(&server::Connection, this, ref(C));
+        }
+
+        // Stop
+        close(Listen);
+        unlink(SocketName.c_str());
+        IsStopping = true;
+        for (auto& C : Connections)
+            C.Thread.join();
+        if (!Quiet)
+            cerr << "Stopped.\n";
+        return 0;
+    }
+
+    //-----------------------------------------------------------------------
+    void server::Connection(connection& C)
+    {
+        while (!IsStopping && !C.IsClosed)
+        {
+            auto Line_End = C.Pending.find('\n');
+            if (Line_End == string::npos)
+            {
+                if (Receive(C, Poll_Timeout))
+                    break;
+                continue;
+            }
+            auto Line = C.Pending.substr(0, Line_End);
+            C.Pending.erase(0, Line_End + 1);
+            if (Line.find_first_not_of(" \t\r") != string::npos)
+                Job(C, Line);
+        }
+        close(C.Fd);
+        C.IsFinished = true;
+    }
+
+    //-----------------------------------------------------------------------
+    bool server::Receive(connection& C, int Timeout)
+    {
+        if (C.IsClosed)
+            return true;
+        pollfd Poll = { C.Fd, POLLIN, 0 };
+        if (poll(&Poll, 1, Timeout) <= 0)
+            return false;
+        char Buffer[4096];
+        auto Size = recv(C.Fd, Buffer, sizeof(Buffer), 0);
+        if (Size <= 0)
+        {
+            if (Size == 0 || (errno != EINTR && errno != EAGAIN))
+                C.IsClosed = true;
+            return C.IsClosed;
+        }
+        C.Pending.append(Buffer, (size_t)Size);
+        return false;
+    }
+
+    //-----------------------------------------------------------------------
+    void server::Send(connection& C, const request& Request, const string& Event)
+    {
+        if (C.IsClosed)
+            return;
+        string Line = "{\"id\": " + (Request.ID.empty() ? string("null") : Request.ID) + ", \"event\": " + Event + "}\n";
+        size_t Offset = 0;
+        while (Offset < Line.size())
+        {
+            auto Size = send(C.Fd, Line.data() + Offset, Line.size() - Offset, 0);
+            if (Size < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                C.IsClosed = true;
+                return;
+            }
+            Offset += (size_t)Size;
+        }
+    }
+
+    //-----------------------------------------------------------------------
+    void server::Job(connection& C, const string& Line)
+    {
+        request Request;
+        string ErrorMessage;
+        int ExitCode;
+        if (request_parser(Line).Parse(Request))
+        {
+            ExitCode = 1;
+            ErrorMessage = "request is not a JSON object";
+        }
+        else
+        {
+            Send(C, Request, "\"start\"");
+            if (Request.Type == "decode-frames")
+                ExitCode = Job_DecodeFrames(C, Request, ErrorMessage);
+            else if (Request.Type == "check" || Request.Type == "encode" || Request.Type == "decode" || Request.Type == "command")
+                ExitCode = Job_Command(C, Request, ErrorMessage);
+            else
+            {
+                ExitCode = 1;
+                ErrorMessage = Request.Type.empty() ? "job type is missing" : ("job type " + Request.Type + " is unknown");
+            }
+        }
+
+        if (ExitCode)
+        {
+            string Event("\"end\", \"status\": \"error\", \"exit_code\": " + to_string(ExitCode));
+            if (!ErrorMessage.empty())
+                Event += ", \"message\": " + Json_String(ErrorMessage);
+            Send(C, Request, Event);
+        }
+        else
+            Send(C, Request, "\"end\", \"status\": \"ok\"");
+    }
+
+    //-----------------------------------------------------------------------
+    void Frame_Ignore(void*, const rawcooked_plane*, size_t)
+    {
+    }
+
+    //-----------------------------------------------------------------------
+    int server::Job_DecodeFrames(connection& C, const request& Request, string& ErrorMessage)
+    {
+        if (Request.Input.empty())
+        {
+            ErrorMessage = "input is missing";
+            return 1;
+        }
+        rawcooked_file* File;
+        if (auto Result = rawcooked_open(Request.Input.c_str(), &File))
+        {
+            ErrorMessage = Request.Input + (Result == RAWCOOKED_ERROR_OPEN ? " can not be opened" : " is not a supported Matroska file");
+            return 1;
+        }
+        if (Pool)
+            rawcooked_set_pool(File, Pool);
+
+        // Frames of tracks with a supported codec
+        auto Tracks_Count = rawcooked_track_count(File);
+        vector<uint64_t> FrameCounts(Tracks_Count);
+        uint64_t Total = 0;
+        for (size_t i = 0; i < Tracks_Count; i++)
+        {
+            rawcooked_track_info Info;
+            if (!rawcooked_track_info_get(File, i, &Info) && Info.Kind != RAWCOOKED_TRACK_UNKNOWN)
+                FrameCounts[i] = Info.FrameCount;
+            Total += FrameCounts[i];
+        }
+
+        // Frames are decoded one after the other, slices of a frame are in the shared pool
+        int ExitCode = 0;
+        uint64_t Done = 0;
+        auto Progress_Next = chrono::steady_clock::now();
+        for (size_t i = 0; i < Tracks_Count && !ExitCode; i++)
+            for (uint64_t Frame = 0; Frame < FrameCounts[i]; Frame++)
+            {
+                if (IsStopping || Receive(C, 0))
+                {
+                    ErrorMessage = "stopped";
+                    ExitCode = 1;
+                    break;
+                }
+                if (rawcooked_decode_frame(File, i, Frame, Frame_Ignore, nullptr))
+                {
+                    ErrorMessage = "track " + to_string(i) + ", " + rawcooked_error(File);
+                    ExitCode = 1;
+                    break;
+                }
+                Done++;
+                auto Now = chrono::steady_clock::now();
+                if (Now >= Progress_Next || Done == Total)
+                {
+                    Send(C, Request, "\"progress\", \"done\": " + to_string(Done) + ", \"total\": " + to_string(Total));
+                    Progress_Next = Now + Progress_Interval;
+                }
+            }
+
+        rawcooked_close(File);
+        return ExitCode;
+    }
+
+    //-----------------------------------------------------------------------
+    // At most Children_Max children at the same time, the job waits for a free place
+    int server::Job_Command(connection& C, const request& Request, string& ErrorMessage)
+    {
+        for (;;)
+        {
+            {
+                unique_lock<mutex> Lock(Children_Mutex);
+                if (Children < Children_Max)
+                {
+                    Children++;
+                    break;
+                }
+                Children_Free.wait_for(Lock, chrono::milliseconds(Poll_Timeout));
+            }
+            if (IsStopping || Receive(C, 0))
+            {
+                ErrorMessage = "stopped";
+                return 1;
+            }
+        }
+
+        auto ExitCode = Job_Child(C, Request, ErrorMessage);
+
+        {
+            lock_guard<mutex> Lock(Children_Mutex);
+            Children--;
+        }
+        Children_Free.notify_one();
+        return ExitCode;
+    }
+
+    //-----------------------------------------------------------------------
+    int server::Job_Child(connection& C, const request& Request, string& ErrorMessage)
+    {
+        vector<string> Args;
+        Args.push_back(BinName);
+        if (Request.Type != "command")
+            Args.push_back("--" + Request.Type);
+        if (find(Request.Args.begin(), Request.Args.end(), "-threads") == Request.Args.end())
+        {
+            Args.push_back("-threads");
+            Args.push_back(to_string(Child_Threads));
+        }
+        Args.insert(Args.end(), Request.Args.begin(), Request.Args.end());
+        if (!Request.Input.empty())
+            Args.push_back(Request.Input);
+        vector<char*> Argv;
+        for (auto& Arg : Args)
+            Argv.push_back(&Arg[0]);
+        Argv.push_back(nullptr);
+
+        // Child with output in a pipe and no input, so prompts get no as answer
+        int Pipe[2];
+        pid_t Child;
+        int Result;
+        {
+            lock_guard<mutex> Lock(Spawn_Mutex);
+            if (pipe(Pipe))
+            {
+                ErrorMessage = string("can not create a pipe (") + strerror(errno) + ')';
+                return 1;
+            }
+            CloseOnExec(Pipe[0]);
+            CloseOnExec(Pipe[1]);
+            posix_spawn_file_actions_t Actions;
+            posix_spawn_file_actions_init(&Actions);
+            posix_spawn_file_actions_addopen(&Actions, 0, "/dev/null", O_RDONLY, 0);
+            posix_spawn_file_actions_adddup2(&Actions, Pipe[1], 1);
+            posix_spawn_file_actions_adddup2(&Actions, Pipe[1], 2);
+            Result = posix_spawn(&Child, BinName.c_str(), &Actions, nullptr, Argv.data(), environ);
+            posix_spawn_file_actions_destroy(&Actions);
+            close(Pipe[1]);
+        }
+        if (Result)
+        {
+            close(Pipe[0]);
+            ErrorMessage = "can not run " + BinName + " (" + strerror(Result) + ')';
+            return 1;
+        }
+
+        // Output of the child, line by line (progress lines end with '\r' and are sent as progress events)
+        string Output;
+        auto Output_Send = [&](size_t End) {
+            auto Text = Output.substr(0, End);
+            auto Text_End = Text.find_last_not_of(" \t");
+            if (Text_End != string::npos)
+            {
+                Text.resize(Text_End + 1);
+                auto Progress = Progress_Event(Text);
+                Send(C, Request, Progress.empty() ? ("\"log\", \"text\": " + Json_String(Text)) : Progress);
+            }
+            Output.erase(0, End + 1);
+        };
+        bool IsKilled = false;
+        for (;;)
+        {
+            if (!IsKilled && (IsStopping || C.IsClosed))
+            {
+                kill(Child, SIGTERM);
+                IsKilled = true;
+            }
+            pollfd Polls[2] = { { Pipe[0], POLLIN, 0 }, { C.Fd, POLLIN, 0 } };
+            if (poll(Polls, C.IsClosed ? 1 : 2, Poll_Timeout) <= 0)
+                continue;
+            if (Polls[1].revents && !C.IsClosed)
+                Receive(C, 0);
+            if (!Polls[0].revents)
+                continue;
+            char Buffer[4096];
+            auto Size = read(Pipe[0], Buffer, sizeof(Buffer));
+            if (Size < 0 && errno == EINTR)
+                continue;
+            if (Size <= 0)
+                break;
+            Output.append(Buffer, (size_t)Size);
+            size_t End;
+            while ((End = Output.find_first_of("\r\n")) != string::npos)
+                Output_Send(End);
+        }
+        if (!Output.empty())
+            Output_Send(Output.size());
+        close(Pipe[0]);
+
+        int Status;
+        while (waitpid(Child, &Status, 0) == -1 && errno == EINTR);
+        if (IsKilled)
+        {
+            ErrorMessage = "stopped";
+            return 1;
+        }
+        if (WIFEXITED(Status))
+            return WEXITSTATUS(Status);
+        ErrorMessage = "terminated by signal " + to_string(WTERMSIG(Status));
+        return 1;
+    }
+
+    //-----------------------------------------------------------------------
+    // Path of this program, for running it again
+    string Self(const char* BinName)
+    {
+        #if defined(__linux__)
+            char Path[4096];
+            auto Size = readlink("/proc/self/exe", Path, sizeof(Path) - 1);
+            if (Size > 0)
+                return string(Path, (size_t)Size);
+        #endif
+        return BinName;
+    }
+}
+
+//---------------------------------------------------------------------------
+int Serve(global& Global, const char* BinName)
+{
+    // Threads
+    size_t Threads = 0;
+    auto OutputOptions_Threads = Global.OutputOptions.find("threads");
+    if (OutputOptions_Threads != Global.OutputOptions.end())
+        Threads = stoul(OutputOptions_Threads->second);
+    if (!Threads)
+        Threads = thread::hardware_concurrency();
+    ThreadPool* Pool = nullptr;
+    if (Threads > 1)
+    {
+        Pool = new ThreadPool(Threads);
+        Pool->init();
+    }
+
+    // Child jobs share the threads
+    auto Children_Max = Global.ServeJobs ? Global.ServeJobs : max(Threads / 4, (size_t)1);
+    auto Child_Threads = max(Threads / Children_Max, (size_t)1);
+
+    auto Value = server(Pool, Self(BinName), Children_Max, Child_Threads).Run(Global.ServeSocketName, Global.Quiet);
+
+    if (Pool)
+    {
+        Pool->shutdown();
+        delete Pool;
+    }
+    return Value;
+}
+
+#endif
@@ -0,0 +1,53 @@
+/*  Copyright (c) MediaArea.net SARL & AV Preservation by reto.ch.
+ *
+ *  Use of this source code is governed by a BSD-style license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//---------------------------------------------------------------------------
+#ifndef ServerH
+#define ServerH
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+#include "CLI/Config.h"
+#include "CLI/Global.h"
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+// Job server on a local (Unix domain) socket, a single entry point per node
+// for queuing reels and following their progress
+//
+// Protocol, one JSON object per line in both directions:
+// - a client sends jobs, jobs of a connection are run one after the other,
+//   connections are run in parallel
+//   {"id": "reel1", "type": "check", "input": "/path/reel1.mkv"}
+//   {"id": "reel2", "type": "encode", "args": ["/path/reel2/", "-o", "/path/reel2.mkv"]}
+// - "check", "encode", "decode" and "command" run rawcooked in a child
+//   process per job, with --check, --encode or --decode for the first ones,
+//   then -threads with the part of the threads of a child if "args" does not
+//   have it, then "args", then "input" if present; at most --serve-jobs
+//   children run at the same time, other jobs wait; the output of the child
+//   is sent back, prompts are answered with no
+// - "decode-frames" decodes all frames of all tracks of "input" in the
+//   server (slice checksums and decoding errors only, not the comparison with
+//   the hashes of the original files, use "check" for that); slices of these
+//   jobs share one thread pool, a plain FIFO queue, and each job has at most
+//   one frame in the pool so jobs get turns
+// - the server sends events with the id of the job:
+//   {"id": "reel1", "event": "start"}
+//   {"id": "reel1", "event": "progress", "done": 120, "total": 2400}
+//   {"id": "reel2", "event": "progress", "percent": 12.5}
+//   {"id": "reel2", "event": "log", "text": "..."}
+// - progress of "decode-frames" is in frames with the total, progress lines
+//   of a child are sent as progress events in percent (rawcooked) or as
+//   count of frames without total (FFmpeg), other lines as log events
+//   {"id": "reel1", "event": "end", "status": "ok"}
+//   {"id": "reel2", "event": "end", "status": "error", "exit_code": 1, "message": "..."}
+// A job stops when its client disconnects, the server stops on SIGINT or
+// SIGTERM after stopping the running jobs.
+
+//---------------------------------------------------------------------------
+int Serve(global& Global, const char* BinName);
+
+#endif
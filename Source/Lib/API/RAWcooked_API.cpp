@@ -0,0 +1,709 @@
+/*  Copyright (c) MediaArea.net SARL & AV Preservation by reto.ch.
+ *
+ *  Use of this source code is governed by a BSD-style license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//---------------------------------------------------------------------------
+#include "Lib/API/RAWcooked_API.h"
+#include "Lib/CoDec/Wrapper.h"
+#include "Lib/Compressed/RAWcooked/Track.h"
+#include "Lib/Utils/FileIO/FileIO.h"
+#include "Lib/Utils/RawFrame/RawFrame.h"
+#ifdef __GNUC__
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wreorder"
+#endif
+#include "ThreadPool.h"
+#ifdef __GNUC__
+#pragma GCC diagnostic pop
+#endif
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+using namespace std;
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+namespace
+{
+    // Matroska element IDs, without the length marker as in the Matroska parser
+    enum : uint64_t
+    {
+        ID_EBML                 = 0xA45DFA3,
+        ID_Segment              = 0x8538067,
+        ID_Cluster              = 0xF43B675,
+        ID_BlockGroup           = 0x20,
+        ID_Block                = 0x21,
+        ID_ReferenceBlock       = 0x7B,
+        ID_SimpleBlock          = 0x23,
+        ID_Tracks               = 0x654AE6B,
+        ID_TrackEntry           = 0x2E,
+        ID_TrackNumber          = 0x57,
+        ID_CodecID              = 0x6,
+        ID_CodecPrivate         = 0x23A2,
+        ID_DefaultDuration      = 0x3E383,
+        ID_Video                = 0x60,
+        ID_PixelWidth           = 0x30,
+        ID_PixelHeight          = 0x3A,
+        ID_Audio                = 0x61,
+        ID_SamplingFrequency    = 0x35,
+        ID_Channels             = 0x1F,
+        ID_BitDepth             = 0x2264,
+    };
+
+    struct frame_entry
+    {
+        size_t                  Offset; // Of the frame content in the file, after the block header
+        size_t                  Size;
+        bool                    IsKeyFrame;
+    };
+
+    struct track
+    {
+        // From the container
+        uint64_t                Number = 0;
+        string                  CodecID;
+        const uint8_t*          CodecPrivate = nullptr;
+        size_t                  CodecPrivate_Size = 0;
+        uint64_t                FrameDuration = 0;
+        uint32_t                Width = 0;
+        uint32_t                Height = 0;
+        uint32_t                Channels = 0;
+        uint32_t                BitDepth = 0;
+        double                  SampleRate = 0;
+        vector<frame_entry>     Frames;
+        bool                    HasLacing = false;
+
+        // Decoding
+        base_wrapper*           Wrapper = nullptr;
+        raw_frame*              RawFrame = nullptr;
+        uint64_t                Frame_Next = 0; // Frame after the last decoded one, sequential decoding does not need the previous key frame
+
+        // Region of interest and proxy
+        uint32_t                Region_X = 0;
+        uint32_t                Region_Y = 0;
+        uint32_t                Region_W = 0; // 0 for the whole frame
+        uint32_t                Region_H = 0;
+        uint32_t                Decimation = 1;
+        vector<uint8_t>         Proxy; // Compact planes provided to the callback
+    };
+
+    // Part of a decoded plane
+    struct plane_view
+    {
+        const uint8_t*          Data;
+        size_t                  BytesPerLine;
+        size_t                  Width;
+        size_t                  Height;
+        size_t                  BytesPerBlock;
+    };
+
+    // Variable length integer, the length marker is removed
+    // Returns true on error
+    bool Get_EB(const uint8_t* Data, size_t End, size_t& Offset, uint64_t& Value)
+    {
+        if (Offset >= End || !Data[Offset])
+            return true;
+        Value = Data[Offset];
+        size_t s = 0;
+        while (!(Value & (((uint64_t)1) << (7 - s))))
+            s++;
+        if (End - Offset < 1 + s)
+            return true;
+        Value ^= (((uint64_t)1) << (7 - s));
+        uint64_t UnknownValue = (((uint64_t)1) << ((s + 1) * 7)) - 1;
+        while (s)
+        {
+            Offset++;
+            s--;
+            Value = (Value << 8) | Data[Offset];
+        }
+        Offset++;
+        if (Value == UnknownValue)
+            Value = (uint64_t)-1; // Unknown size
+        return false;
+    }
+
+    uint64_t Get_UInt(const uint8_t* Data, size_t Size)
+    {
+        uint64_t Value = 0;
+        for (size_t i = 0; i < Size; i++)
+            Value = (Value << 8) | Data[i];
+        return Value;
+    }
+
+    double Get_Float(const uint8_t* Data, size_t Size)
+    {
+        auto Value = Get_UInt(Data, Size);
+        if (Size == 4)
+        {
+            float Result;
+            auto Value32 = (uint32_t)Value;
+            memcpy(&Result, &Value32, 4);
+            return Result;
+        }
+        if (Size == 8)
+        {
+            double Result;
+            memcpy(&Result, &Value, 8);
+            return Result;
+        }
+        return 0;
+    }
+
+    bool IsMaster(uint64_t Parent, uint64_t ID)
+    {
+        switch (Parent)
+        {
+            case 0: return ID == ID_Segment;
+            case ID_Segment: return ID == ID_Tracks || ID == ID_Cluster;
+            case ID_Tracks: return ID == ID_TrackEntry;
+            case ID_TrackEntry: return ID == ID_Video || ID == ID_Audio;
+            case ID_Cluster: return ID == ID_BlockGroup;
+            default: return false;
+        }
+    }
+}
+
+//---------------------------------------------------------------------------
+struct rawcooked_file
+{
+    filemap                     FileMap;
+    vector<track>               Tracks;
+    ThreadPool*                 Pool = nullptr;
+    size_t                      Pool_Threads = 0;
+    bool                        Pool_IsShared = false; // Pool belongs to the caller
+    string                      ErrorMessage;
+
+    ~rawcooked_file()
+    {
+        for (auto& Track : Tracks)
+        {
+            delete Track.Wrapper; // Before the pool, wrappers may use it
+            delete Track.RawFrame;
+        }
+        if (Pool && !Pool_IsShared)
+        {
+            Pool->shutdown();
+            delete Pool;
+        }
+    }
+
+    // Helpers
+    int                         Error(rawcooked_status Status, const string& Message);
+    int                         Parse();
+    track*                      Parse_Block(size_t Offset, size_t End, bool IsSimpleBlock); // Track of the block, nullptr if not indexed
+    int                         Decode(size_t Track, uint64_t Frame, const raw_frame*& RawFrame, uint8_t& BitDepth);
+    int                         Init(track& Track);
+};
+
+//***************************************************************************
+// Helpers
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+int rawcooked_file::Error(rawcooked_status Status, const string& Message)
+{
+    ErrorMessage = Message;
+    return Status;
+}
+
+//---------------------------------------------------------------------------
+// Index of the tracks and of the frames, the content is not copied
+// matroska::ParseBuffer() is not used: it is a single pass which decodes each
+// block when it meets it, with the reversibility data, file writers, hashes and
+// progress indicator of the command line, and it keeps no position of the
+// blocks so it can not seek to a frame. Only the elements needed for random
+// access (tracks, codec private data, clusters and blocks) are read here.
+int rawcooked_file::Parse()
+{
+    struct level
+    {
+        uint64_t                ID;
+        size_t                  End;
+    };
+    auto Data = FileMap.Data();
+    auto Size = FileMap.Size();
+    vector<level> Levels;
+    Levels.push_back({ 0, Size });
+    track* BlockGroup_Track = nullptr; // Track of the last block of a block group, for its key frame flag
+
+    size_t Offset = 0;
+    uint64_t ID;
+    if (Get_EB(Data, Size, Offset, ID) || ID != ID_EBML)
+        return Error(RAWCOOKED_ERROR_FORMAT, "not a Matroska file");
+    Offset = 0;
+
+    while (Offset < Size)
+    {
+        while (Levels.size() > 1 && Offset >= Levels.back().End)
+            Levels.pop_back();
+
+        uint64_t Element_Size;
+        if (Get_EB(Data, Size, Offset, ID) || Get_EB(Data, Size, Offset, Element_Size))
+            break; // Truncated or junk at the end, frames found until here are kept
+        if (ID == ID_Cluster && Levels.back().ID == ID_Cluster)
+            Levels.pop_back(); // Previous cluster has an unknown size
+        auto Parent_End = Levels.back().End;
+        auto End = Element_Size <= Parent_End - Offset ? (Offset + Element_Size) : Parent_End;
+
+        auto Parent = Levels.back().ID;
+        if (IsMaster(Parent, ID))
+        {
+            Levels.push_back({ ID, End });
+            if (ID == ID_TrackEntry)
+            {
+                Tracks.emplace_back();
+                Tracks.back().Number = Tracks.size(); // Position if there is no track number, as the Matroska parser does
+            }
+            if (ID == ID_BlockGroup)
+                BlockGroup_Track = nullptr;
+            continue;
+        }
+
+        auto Element = Data + Offset;
+        auto Element_Size2 = End - Offset;
+        switch (Parent)
+        {
+            case ID_TrackEntry:
+                switch (ID)
+                {
+                    case ID_TrackNumber: Tracks.back().Number = Get_UInt(Element, Element_Size2); break;
+                    case ID_CodecID: Tracks.back().CodecID.assign((const char*)Element, strnlen((const char*)Element, Element_Size2)); break;
+                    case ID_CodecPrivate: Tracks.back().CodecPrivate = Element; Tracks.back().CodecPrivate_Size = Element_Size2; break;
+                    case ID_DefaultDuration: Tracks.back().FrameDuration = Get_UInt(Element, Element_Size2); break;
+                }
+                break;
+            case ID_Video:
+                switch (ID)
+                {
+                    case ID_PixelWidth: Tracks.back().Width = (uint32_t)Get_UInt(Element, Element_Size2); break;
+                    case ID_PixelHeight: Tracks.back().Height = (uint32_t)Get_UInt(Element, Element_Size2); break;
+                }
+                break;
+            case ID_Audio:
+                switch (ID)
+                {
+                    case ID_SamplingFrequency: Tracks.back().SampleRate = Get_Float(Element, Element_Size2); break;
+                    case ID_Channels: Tracks.back().Channels = (uint32_t)Get_UInt(Element, Element_Size2); break;
+                    case ID_BitDepth: Tracks.back().BitDepth = (uint32_t)Get_UInt(Element, Element_Size2); break;
+                }
+                break;
+            case ID_Cluster:
+                if (ID == ID_SimpleBlock)
+                    Parse_Block(Offset, End, true);
+                break;
+            case ID_BlockGroup:
+                if (ID == ID_Block)
+                    BlockGroup_Track = Parse_Block(Offset, End, false);
+                else if (ID == ID_ReferenceBlock && BlockGroup_Track)
+                    BlockGroup_Track->Frames.back().IsKeyFrame = false;
+                break;
+        }
+        Offset = End;
+    }
+
+    if (Tracks.empty())
+        return Error(RAWCOOKED_ERROR_FORMAT, "no track");
+    return 0;
+}
+
+//---------------------------------------------------------------------------
+track* rawcooked_file::Parse_Block(size_t Offset, size_t End, bool IsSimpleBlock)
+{
+    auto Data = FileMap.Data();
+    uint64_t Number;
+    if (Get_EB(Data, End, Offset, Number) || End - Offset < 3)
+        return nullptr; // Problem
+    auto Flags = Data[Offset + 2];
+    Offset += 3; // Timestamp and flags
+
+    for (auto& Track : Tracks)
+        if (Track.Number == Number)
+        {
+            if (Flags & 0x06)
+                Track.HasLacing = true; // Several frames in the block, not indexed
+            Track.Frames.push_back({ Offset, End - Offset, IsSimpleBlock ? ((Flags & 0x80) != 0) : true }); // Key frame flag of a block group is from the absence of reference
+            return &Track;
+        }
+    return nullptr;
+}
+
+//---------------------------------------------------------------------------
+int rawcooked_file::Init(track& Track)
+{
+    auto Format = Format_FromCodecID(Track.CodecID.c_str());
+    auto Kind = FormatKind(Format);
+    if (Kind == format_kind::unknown)
+        return Error(RAWCOOKED_ERROR_CODEC, "codec " + Track.CodecID + " is not supported");
+    if (Track.HasLacing)
+        return Error(RAWCOOKED_ERROR_CODEC, "laced blocks are not supported");
+
+    if (Pool_Threads > 1 && !Pool)
+    {
+        Pool = new ThreadPool(Pool_Threads);
+        Pool->init();
+    }
+    Track.Wrapper = CreateWrapper(Format, Pool);
+    if (!Track.Wrapper)
+        return Error(RAWCOOKED_ERROR_CODEC, "codec " + Track.CodecID + " is not supported");
+    Track.RawFrame = new raw_frame;
+    Track.Wrapper->RawFrame = Track.RawFrame;
+
+    switch (Kind)
+    {
+        case format_kind::video:
+        {
+            auto Wrapper = (video_wrapper*)Track.Wrapper;
+            Track.RawFrame->Flavor = raw_frame::flavor::FFmpeg;
+            Wrapper->SetWidth(Track.Width);
+            Wrapper->SetHeight(Track.Height);
+            Wrapper->SetRegion(Track.Region_X, Track.Region_Y, Track.Region_W, Track.Region_H);
+            break;
+        }
+        case format_kind::audio:
+        {
+            auto Wrapper = (audio_wrapper*)Track.Wrapper;
+            Wrapper->SetEndianness(endianness::LE);
+            break;
+        }
+        case format_kind::unknown:;
+    }
+
+    if (Track.CodecPrivate_Size)
+    {
+        Track.Wrapper->OutOfBand(Track.CodecPrivate, Track.CodecPrivate_Size);
+        if (auto Message = Track.Wrapper->ErrorMessage())
+            return Error(RAWCOOKED_ERROR_DECODE, Message);
+    }
+    if (Kind == format_kind::audio && Track.BitDepth)
+        ((audio_wrapper*)Track.Wrapper)->SetOutputBitDepth((uint8_t)Track.BitDepth); // After the out of band data, which has the bit depth of the codec
+
+    return 0;
+}
+
+//---------------------------------------------------------------------------
+int rawcooked_file::Decode(size_t Track_Pos, uint64_t Frame, const raw_frame*& RawFrame, uint8_t& BitDepth)
+{
+    if (Track_Pos >= Tracks.size())
+        return Error(RAWCOOKED_ERROR_ARGUMENT, "track " + to_string(Track_Pos) + " does not exist");
+    auto& Track = Tracks[Track_Pos];
+    if (Frame >= Track.Frames.size())
+        return Error(RAWCOOKED_ERROR_ARGUMENT, "frame " + to_string(Frame) + " does not exist");
+    if (!Track.Wrapper)
+    {
+        if (auto Result = Init(Track))
+        {
+            delete Track.Wrapper;
+            Track.Wrapper = nullptr;
+            delete Track.RawFrame;
+            Track.RawFrame = nullptr;
+            return Result;
+        }
+    }
+
+    // Previous key frame, if needed
+    auto First = Frame;
+    if (!Track.Wrapper->IsIntraOnly() && Frame != Track.Frame_Next)
+    {
+        while (First && !Track.Frames[First].IsKeyFrame)
+            First--;
+        if (First < Track.Frame_Next && Track.Frame_Next < Frame)
+            First = Track.Frame_Next; // No key frame since the last decoded frame, continuing
+    }
+
+    auto Data = FileMap.Data();
+    for (auto i = First; i <= Frame; i++)
+    {
+        const auto& Entry = Track.Frames[i];
+        Track.Wrapper->Process(Data + Entry.Offset, Entry.Size);
+        if (auto Message = Track.Wrapper->ErrorMessage())
+        {
+            Track.Frame_Next = 0;
+            return Error(RAWCOOKED_ERROR_DECODE, "frame " + to_string(i) + ": " + Message);
+        }
+    }
+    Track.Wrapper->Wait();
+    Track.Frame_Next = Frame + 1;
+
+    RawFrame = Track.RawFrame;
+    BitDepth = FormatKind(Format_FromCodecID(Track.CodecID.c_str())) == format_kind::audio ? ((audio_wrapper*)Track.Wrapper)->OutputBitDepth() : 0;
+    ErrorMessage.clear();
+    return 0;
+}
+
+//---------------------------------------------------------------------------
+// Parts of the decoded planes in the region of interest of the track
+static void Views_Get(const track& Track, const raw_frame* RawFrame, const rawcooked_track_info& Info, uint8_t BitDepth, vector<plane_view>& Views)
+{
+    Views.clear();
+    const auto& Planes_Source = RawFrame->Planes();
+    if (Planes_Source.empty())
+    {
+        // Audio, no region
+        const auto& Buffer = RawFrame->Buffer();
+        size_t BytesPerBlock = BitDepth && Info.Channels ? ((size_t)BitDepth / 8 * Info.Channels) : 1;
+        Views.push_back({ Buffer.Data(), Buffer.Size(), Buffer.Size() / BytesPerBlock, 1, BytesPerBlock });
+        return;
+    }
+    const auto Frame_Width = Planes_Source[0]->Width_;
+    const auto Frame_Height = Planes_Source[0]->Height_;
+    for (const auto Plane : Planes_Source)
+    {
+        if (!Plane)
+            continue;
+        plane_view View{ Plane->Buffer().Data(), Plane->AllBytesPerLine(), Plane->Width_, Plane->Height_, Plane->BytesPerBlock() };
+        if (Track.Region_W && Track.Region_H && View.Width && View.Height)
+        {
+            // Region is in pixels of the frame, chroma planes may be subsampled
+            auto Divisor_X = (Frame_Width + View.Width - 1) / View.Width;
+            auto Divisor_Y = (Frame_Height + View.Height - 1) / View.Height;
+            auto X = Track.Region_X / Divisor_X;
+            auto Y = Track.Region_Y / Divisor_Y;
+            auto X_End = min((Track.Region_X + Track.Region_W + Divisor_X - 1) / Divisor_X, View.Width);
+            auto Y_End = min((Track.Region_Y + Track.Region_H + Divisor_Y - 1) / Divisor_Y, View.Height);
+            View.Data += Y * View.BytesPerLine + X * View.BytesPerBlock;
+            View.Width = X_End - X;
+            View.Height = Y_End - Y;
+        }
+        Views.push_back(View);
+    }
+}
+
+//---------------------------------------------------------------------------
+// Size of a view copied with no padding, 1 pixel out of Decimation in each direction
+static size_t Compact_Size(const plane_view& View, size_t Decimation)
+{
+    return (View.Width + Decimation - 1) / Decimation * View.BytesPerBlock * ((View.Height + Decimation - 1) / Decimation);
+}
+
+//---------------------------------------------------------------------------
+static rawcooked_plane Compact_Copy(const plane_view& View, size_t Decimation, uint8_t* Buffer)
+{
+    auto Width = (View.Width + Decimation - 1) / Decimation;
+    auto Height = (View.Height + Decimation - 1) / Decimation;
+    auto BytesPerLine = Width * View.BytesPerBlock;
+    auto Output = Buffer;
+    for (size_t y = 0; y < View.Height; y += Decimation)
+    {
+        auto Input = View.Data + y * View.BytesPerLine;
+        if (Decimation == 1)
+            memcpy(Output, Input, BytesPerLine);
+        else
+        {
+            auto Input_Step = Decimation * View.BytesPerBlock;
+            for (size_t x = 0; x < Width; x++)
+                memcpy(Output + x * View.BytesPerBlock, Input + x * Input_Step, View.BytesPerBlock);
+        }
+        Output += BytesPerLine;
+    }
+    return { Buffer, BytesPerLine * Height, Width, Height, BytesPerLine, View.BytesPerBlock, 1 };
+}
+
+//***************************************************************************
+// API
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+int rawcooked_open(const char* FileName, rawcooked_file** File)
+{
+    if (!File)
+        return RAWCOOKED_ERROR_ARGUMENT;
+    *File = nullptr;
+    if (!FileName)
+        return RAWCOOKED_ERROR_ARGUMENT;
+
+    auto NewFile = new rawcooked_file;
+    if (NewFile->FileMap.Open_ReadMode(FileName))
+    {
+        delete NewFile;
+        return RAWCOOKED_ERROR_OPEN;
+    }
+    if (auto Result = NewFile->Parse())
+    {
+        delete NewFile;
+        return Result;
+    }
+
+    *File = NewFile;
+    return 0;
+}
+
+//---------------------------------------------------------------------------
+void rawcooked_close(rawcooked_file* File)
+{
+    delete File;
+}
+
+//---------------------------------------------------------------------------
+const char* rawcooked_error(const rawcooked_file* File)
+{
+    if (!File)
+        return "";
+    return File->ErrorMessage.c_str();
+}
+
+//---------------------------------------------------------------------------
+int rawcooked_set_threads(rawcooked_file* File, size_t Count)
+{
+    if (!File)
+        return RAWCOOKED_ERROR_ARGUMENT;
+    for (const auto& Track : File->Tracks)
+        if (Track.Wrapper)
+            return File->Error(RAWCOOKED_ERROR_ARGUMENT, "threads must be set before the first decoded frame");
+    File->Pool_Threads = Count;
+    return 0;
+}
+
+//---------------------------------------------------------------------------
+int rawcooked_set_pool(rawcooked_file* File, ThreadPool* Pool)
+{
+    if (!File)
+        return RAWCOOKED_ERROR_ARGUMENT;
+    for (const auto& Track : File->Tracks)
+        if (Track.Wrapper)
+            return File->Error(RAWCOOKED_ERROR_ARGUMENT, "pool must be set before the first decoded frame");
+    File->Pool = Pool;
+    File->Pool_IsShared = Pool != nullptr;
+    return 0;
+}
+
+//---------------------------------------------------------------------------
+int rawcooked_set_region(rawcooked_file* File, size_t Track, uint32_t X, uint32_t Y, uint32_t Width, uint32_t Height, uint32_t Decimation)
+{
+    if (!File)
+        return RAWCOOKED_ERROR_ARGUMENT;
+    if (Track >= File->Tracks.size())
+        return File->Error(RAWCOOKED_ERROR_ARGUMENT, "track " + to_string(Track) + " does not exist");
+    auto& Destination = File->Tracks[Track];
+    if (FormatKind(Format_FromCodecID(Destination.CodecID.c_str())) != format_kind::video)
+        return File->Error(RAWCOOKED_ERROR_ARGUMENT, "region is for video tracks only");
+    if (!Width || !Height)
+        X = Y = Width = Height = 0;
+    else if ((uint64_t)X + Width > Destination.Width || (uint64_t)Y + Height > Destination.Height)
+        return File->Error(RAWCOOKED_ERROR_ARGUMENT, "region is out of the frame");
+
+    Destination.Region_X = X;
+    Destination.Region_Y = Y;
+    Destination.Region_W = Width;
+    Destination.Region_H = Height;
+    Destination.Decimation = Decimation ? Decimation : 1;
+    if (Destination.Wrapper)
+        ((video_wrapper*)Destination.Wrapper)->SetRegion(X, Y, Width, Height);
+    return 0;
+}
+
+//---------------------------------------------------------------------------
+size_t rawcooked_track_count(const rawcooked_file* File)
+{
+    if (!File)
+        return 0;
+    return File->Tracks.size();
+}
+
+//---------------------------------------------------------------------------
+int rawcooked_track_info_get(rawcooked_file* File, size_t Track, rawcooked_track_info* Info)
+{
+    if (!File || !Info)
+        return RAWCOOKED_ERROR_ARGUMENT;
+    if (Track >= File->Tracks.size())
+        return File->Error(RAWCOOKED_ERROR_ARGUMENT, "track " + to_string(Track) + " does not exist");
+    const auto& Source = File->Tracks[Track];
+
+    switch (FormatKind(Format_FromCodecID(Source.CodecID.c_str())))
+    {
+        case format_kind::video: Info->Kind = RAWCOOKED_TRACK_VIDEO; break;
+        case format_kind::audio: Info->Kind = RAWCOOKED_TRACK_AUDIO; break;
+        default: Info->Kind = RAWCOOKED_TRACK_UNKNOWN;
+    }
+    Info->CodecID = Source.CodecID.c_str();
+    Info->FrameCount = Source.Frames.size();
+    Info->FrameDuration = Source.FrameDuration;
+    Info->Width = Source.Width;
+    Info->Height = Source.Height;
+    Info->ColorSpace = Source.RawFrame && Info->Kind == RAWCOOKED_TRACK_VIDEO ? (int32_t)Source.RawFrame->ColorSpace : -1;
+    Info->Channels = Source.Channels;
+    Info->BitDepth = Source.BitDepth;
+    if (!Info->BitDepth && Source.Wrapper)
+    {
+        if (Info->Kind == RAWCOOKED_TRACK_AUDIO)
+            Info->BitDepth = ((audio_wrapper*)Source.Wrapper)->OutputBitDepth();
+        else if (Info->Kind == RAWCOOKED_TRACK_VIDEO)
+            Info->BitDepth = (uint32_t)Source.RawFrame->BitsPerSample;
+    }
+    Info->SampleRate = Source.SampleRate;
+    return 0;
+}
+
+//---------------------------------------------------------------------------
+int rawcooked_decode_frame(rawcooked_file* File, size_t Track, uint64_t Frame, rawcooked_planes_callback Callback, void* Opaque)
+{
+    if (!File || !Callback)
+        return RAWCOOKED_ERROR_ARGUMENT;
+    const raw_frame* RawFrame;
+    uint8_t BitDepth;
+    if (auto Result = File->Decode(Track, Frame, RawFrame, BitDepth))
+        return Result;
+
+    rawcooked_track_info Info;
+    rawcooked_track_info_get(File, Track, &Info);
+    auto& Source = File->Tracks[Track];
+    vector<plane_view> Views;
+    Views_Get(Source, RawFrame, Info, BitDepth, Views);
+    vector<rawcooked_plane> Planes;
+    if (Source.Decimation > 1)
+    {
+        // Proxy, compact copy
+        size_t Total = 0;
+        for (const auto& View : Views)
+            Total += Compact_Size(View, Source.Decimation);
+        Source.Proxy.resize(Total);
+        auto Buffer = Source.Proxy.data();
+        for (const auto& View : Views)
+        {
+            Planes.push_back(Compact_Copy(View, Source.Decimation, Buffer));
+            Buffer += Planes.back().Size;
+        }
+    }
+    else
+    {
+        // No copy, lines of a region are in the decoded frame
+        for (const auto& View : Views)
+        {
+            auto Size = View.Height ? ((View.Height - 1) * View.BytesPerLine + View.Width * View.BytesPerBlock) : 0;
+            Planes.push_back({ View.Data, Size, View.Width, View.Height, View.BytesPerLine, View.BytesPerBlock, 1 });
+        }
+    }
+    Callback(Opaque, Planes.data(), Planes.size());
+    return 0;
+}
+
+//---------------------------------------------------------------------------
+int rawcooked_decode_frame_to(rawcooked_file* File, size_t Track, uint64_t Frame, uint8_t* Buffer, size_t Buffer_Size, size_t* Size)
+{
+    if (!File)
+        return RAWCOOKED_ERROR_ARGUMENT;
+    const raw_frame* RawFrame;
+    uint8_t BitDepth;
+    if (auto Result = File->Decode(Track, Frame, RawFrame, BitDepth))
+        return Result;
+
+    rawcooked_track_info Info;
+    rawcooked_track_info_get(File, Track, &Info);
+    const auto& Source = File->Tracks[Track];
+    vector<plane_view> Views;
+    Views_Get(Source, RawFrame, Info, BitDepth, Views);
+    size_t Total = 0;
+    for (const auto& View : Views)
+        Total += Compact_Size(View, Source.Decimation);
+    if (Size)
+        *Size = Total;
+    if (!Buffer || Buffer_Size < Total)
+        return File->Error(RAWCOOKED_ERROR_BUFFER, "buffer is too small, " + to_string(Total) + " bytes are needed");
+
+    for (const auto& View : Views)
+        Buffer += Compact_Copy(View, Source.Decimation, Buffer).Size;
+    return 0;
+}
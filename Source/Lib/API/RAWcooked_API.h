@@ -0,0 +1,169 @@
+/*  Copyright (c) MediaArea.net SARL & AV Preservation by reto.ch.
+ *
+ *  Use of this source code is governed by a BSD-style license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//---------------------------------------------------------------------------
+#ifndef RAWcooked_APIH
+#define RAWcooked_APIH
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+// libRAWcooked, frame level decoding of Matroska files created by RAWcooked
+//
+// Usage:
+// - rawcooked_open() maps the file and indexes its tracks and frames
+// - rawcooked_track_count() and rawcooked_track_info_get() describe the tracks
+// - rawcooked_decode_frame() decodes frame N of a track and calls back with
+//   pointers to the decoded planes (no copy), rawcooked_decode_frame_to()
+//   copies the planes one after the other in a buffer of the caller
+// - rawcooked_set_region() restricts decoding to a part of the frame and/or
+//   decimates it, for thumbnails, crops and previews
+// - rawcooked_close() releases everything
+//
+// Video planes have the layout of FFmpeg (planar, RGB 8-bit is packed in 4
+// bytes per pixel), audio is a single plane of interleaved little endian
+// samples.
+// Restoring the original files (DPX, TIFF, WAV...) with their headers is not
+// in this API, it is the job of the rawcooked command line.
+//
+// Functions return 0 on success and a rawcooked_status value on error,
+// rawcooked_error() provides a readable message of the last error.
+// A handle must not be used by several threads at the same time, several
+// handles can be used in parallel.
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+#include <stddef.h>
+#include <stdint.h>
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+#if defined(_WIN32) || defined(_WINDOWS)
+    #if defined(RAWCOOKED_API_EXPORTS)
+        #define RAWCOOKED_API __declspec(dllexport)
+    #elif defined(RAWCOOKED_API_IMPORTS)
+        #define RAWCOOKED_API __declspec(dllimport)
+    #else
+        #define RAWCOOKED_API
+    #endif
+#elif defined(__GNUC__)
+    #define RAWCOOKED_API __attribute__((visibility("default")))
+#else
+    #define RAWCOOKED_API
+#endif
+//---------------------------------------------------------------------------
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//---------------------------------------------------------------------------
+typedef struct rawcooked_file rawcooked_file; // Opaque handle
+
+//---------------------------------------------------------------------------
+typedef enum rawcooked_status
+{
+    RAWCOOKED_OK                = 0,
+    RAWCOOKED_ERROR_ARGUMENT    = 1, // Bad handle, track or frame number
+    RAWCOOKED_ERROR_OPEN        = 2, // File can not be opened
+    RAWCOOKED_ERROR_FORMAT      = 3, // Not a supported Matroska file
+    RAWCOOKED_ERROR_CODEC       = 4, // Codec of the track is not supported
+    RAWCOOKED_ERROR_DECODE      = 5, // Frame can not be decoded
+    RAWCOOKED_ERROR_BUFFER      = 6, // Buffer of the caller is too small
+} rawcooked_status;
+
+//---------------------------------------------------------------------------
+typedef enum rawcooked_track_kind
+{
+    RAWCOOKED_TRACK_UNKNOWN     = 0,
+    RAWCOOKED_TRACK_VIDEO       = 1,
+    RAWCOOKED_TRACK_AUDIO       = 2,
+} rawcooked_track_kind;
+
+//---------------------------------------------------------------------------
+typedef struct rawcooked_track_info
+{
+    rawcooked_track_kind        Kind;
+    const char*                 CodecID;        // Matroska codec ID, e.g. "V_FFV1", valid until rawcooked_close()
+    uint64_t                    FrameCount;     // Count of Matroska blocks
+    uint64_t                    FrameDuration;  // In nanoseconds, 0 if unknown
+    uint32_t                    Width;          // Video only
+    uint32_t                    Height;         // Video only
+    int32_t                     ColorSpace;     // Video only, 0 for YCbCr, 1 for RGB, -1 before the first decoded frame
+    uint32_t                    Channels;       // Audio only, 0 if not in the container
+    uint32_t                    BitDepth;       // Bits per sample, 0 if not in the container and before the first decoded frame
+    double                      SampleRate;     // Audio only, 0 if not in the container
+} rawcooked_track_info;
+
+//---------------------------------------------------------------------------
+typedef struct rawcooked_plane
+{
+    const uint8_t*              Data;
+    size_t                      Size;           // In bytes, from Data to the end of the last line (BytesPerLine * Height if there is no region)
+    size_t                      Width;          // In pixels (video) or in samples (audio)
+    size_t                      Height;         // 1 for audio
+    size_t                      BytesPerLine;
+    size_t                      BytesPerBlock;  // A block is the smallest group of pixels with an integral count of bytes
+    size_t                      PixelsPerBlock;
+} rawcooked_plane;
+
+//---------------------------------------------------------------------------
+// Receives the decoded planes of a frame
+// Plane data belongs to the library and is valid only during the call
+typedef void (*rawcooked_planes_callback)(void* Opaque, const rawcooked_plane* Planes, size_t Planes_Count);
+
+//---------------------------------------------------------------------------
+// Open and close
+
+RAWCOOKED_API int           rawcooked_open(const char* FileName, rawcooked_file** File);
+RAWCOOKED_API void          rawcooked_close(rawcooked_file* File); // NULL is accepted
+RAWCOOKED_API const char*   rawcooked_error(const rawcooked_file* File); // Message of the last error, empty if none
+
+//---------------------------------------------------------------------------
+// Config, before the first decoded frame of a track
+
+RAWCOOKED_API int           rawcooked_set_threads(rawcooked_file* File, size_t Count); // Threads for decoding slices of a frame, 0 or 1 for none
+
+//---------------------------------------------------------------------------
+// Region of interest and proxy, can be changed between frames
+// Width or Height 0 for the whole frame, Decimation 0 or 1 for no decimation
+// Only the slices intersecting the region are decoded if the codec is intra
+// only (FFV1 from RAWcooked), content out of the region is not provided.
+// Decimation keeps the top left pixel of each Decimation x Decimation block,
+// without filtering, chroma planes keep their subsampling.
+// rawcooked_decode_frame() provides the region in the decoded frame (no copy)
+// or a compact copy if decimated, rawcooked_decode_frame_to() always copies
+// compact planes (BytesPerLine is Width * BytesPerBlock).
+
+RAWCOOKED_API int           rawcooked_set_region(rawcooked_file* File, size_t Track, uint32_t X, uint32_t Y, uint32_t Width, uint32_t Height, uint32_t Decimation);
+
+//---------------------------------------------------------------------------
+// Info
+
+RAWCOOKED_API size_t        rawcooked_track_count(const rawcooked_file* File);
+RAWCOOKED_API int           rawcooked_track_info_get(rawcooked_file* File, size_t Track, rawcooked_track_info* Info);
+
+//---------------------------------------------------------------------------
+// Decoding, frames can be requested in any order
+// Sequential requests are the fastest, other requests are decoded from the
+// previous key frame if the codec is not intra only
+
+RAWCOOKED_API int           rawcooked_decode_frame(rawcooked_file* File, size_t Track, uint64_t Frame, rawcooked_planes_callback Callback, void* Opaque);
+RAWCOOKED_API int           rawcooked_decode_frame_to(rawcooked_file* File, size_t Track, uint64_t Frame, uint8_t* Buffer, size_t Buffer_Size, size_t* Size); // Size receives the needed size, also if Buffer is too small or nullptr
+
+#ifdef __cplusplus
+}
+
+//---------------------------------------------------------------------------
+// C++ only, not exported, for the command line
+// Pool of the caller instead of own threads, e.g. shared by several files,
+// before the first decoded frame, the pool must outlive the handle
+
+class ThreadPool;
+int                         rawcooked_set_pool(rawcooked_file* File, ThreadPool* Pool);
+#endif
+
+//---------------------------------------------------------------------------
+#endif
@@ -31,6 +31,7 @@ public:
     // Status
     bool                        IsUnderrun();
     size_t                      BytesUsed();
+    bool                        IsRunMode() { return run_mode != 0; }
 
 private:
     // Helpers
@@ -0,0 +1,221 @@
+/*  Copyright (c) MediaArea.net SARL & AV Preservation by reto.ch.
+ *
+ *  Use of this source code is governed by a BSD-style license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//---------------------------------------------------------------------------
+#include "Lib/CoDec/FFV1/FFV1_Analysis.h"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+namespace
+{
+    struct stream_data
+    {
+        size_t                              Planes_Count = 0;
+        array<ffv1_analysis::plane_histograms, 4> Histograms;
+    };
+
+    mutex                                   Data_Mutex;
+    vector<stream_data>                     Streams;
+    analysis_format                         Format = analysis_format::None;
+    ofstream                                File;
+    uint64_t                                Slices_Count = 0;
+
+    void Ratio(uint64_t Bits, uint64_t Count)
+    {
+        File << (Count ? ((double)Bits / Count) : 0.0);
+    }
+
+    void Seconds(uint64_t Value)
+    {
+        File << Value / 1000000000 << '.' << setfill('0') << setw(6) << (Value % 1000000000) / 1000 << setfill(' ');
+    }
+
+    void Slice_Write(const ffv1_analysis::slice_values& Slice)
+    {
+        if (Format == analysis_format::CSV)
+        {
+            // Histograms are only in JSON, CSV is one line per plane of each slice
+            for (size_t i = 0; i < Slice.Planes_Count; i++)
+            {
+                const auto& Plane = Slice.Planes[i];
+                File << Slice.Stream << ',' << Slice.Frame << ',' << Slice.Slice << ',' << Slice.x << ',' << Slice.y << ',' << Slice.w << ',' << Slice.h << ',' << Slice.Coder << ',' << Slice.Bytes << ',' << Slice.RangeCoder_Bytes << ',';
+                Ratio(Slice.Bytes * 8, (uint64_t)Slice.w * Slice.h);
+                File << ',';
+                Seconds(Slice.Duration);
+                File << ',' << i << ',' << Plane.Samples << ',' << Plane.Bytes << ',';
+                Ratio(Plane.Bytes * 8, Plane.Samples);
+                File << ',' << Plane.Contexts_Used << ',' << Plane.Runs << ',' << Plane.Run_Samples << '\n';
+            }
+            return;
+        }
+
+        File << (Slices_Count ? ",\n" : "\n");
+        File << "    { \"stream\": " << Slice.Stream << ", \"frame\": " << Slice.Frame << ", \"slice\": " << Slice.Slice
+             << ", \"x\": " << Slice.x << ", \"y\": " << Slice.y << ", \"width\": " << Slice.w << ", \"height\": " << Slice.h
+             << ", \"coder\": " << Slice.Coder << ", \"bytes\": " << Slice.Bytes << ", \"range_coder_bytes\": " << Slice.RangeCoder_Bytes
+             << ", \"bits_per_pixel\": ";
+        Ratio(Slice.Bytes * 8, (uint64_t)Slice.w * Slice.h);
+        File << ", \"decode_time\": ";
+        Seconds(Slice.Duration);
+        File << ", \"planes\": [";
+        for (size_t i = 0; i < Slice.Planes_Count; i++)
+        {
+            const auto& Plane = Slice.Planes[i];
+            File << (i ? ", " : " ") << "{ \"samples\": " << Plane.Samples << ", \"bytes\": " << Plane.Bytes << ", \"bits_per_sample\": ";
+            Ratio(Plane.Bytes * 8, Plane.Samples);
+            File << ", \"contexts_used\": " << Plane.Contexts_Used << ", \"runs\": " << Plane.Runs << ", \"run_samples\": " << Plane.Run_Samples << " }";
+        }
+        File << " ] }";
+    }
+}
+
+//---------------------------------------------------------------------------
+bool ffv1_analysis::IsEnabled_ = false;
+
+//***************************************************************************
+// Slice data
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+void ffv1_analysis::slice_data::Plane_Begin(size_t Plane_Source)
+{
+    Plane = Plane_Source;
+    if (Values.Planes_Count <= Plane)
+        Values.Planes_Count = Plane + 1;
+}
+
+//---------------------------------------------------------------------------
+void ffv1_analysis::slice_data::Run_End()
+{
+    auto& Plane_Values = Values.Planes[Plane];
+    Plane_Values.Runs++;
+    Plane_Values.Run_Samples += Run_Length;
+
+    auto Length = Run_Length;
+    Run_Length = 0;
+
+    size_t Bucket = 0;
+    while (Length && Bucket < Run_Lengths_Size - 1)
+    {
+        Length >>= 1;
+        Bucket++;
+    }
+    Histograms[Plane].Run_Lengths[Bucket]++;
+}
+
+//***************************************************************************
+// Analysis
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+bool ffv1_analysis::Enable(analysis_format Format_Source, const string& FileName)
+{
+    File.open(FileName, ios_base::out | ios_base::trunc);
+    if (!File.is_open())
+        return true;
+    File << fixed << setprecision(3);
+    if (Format_Source == analysis_format::CSV)
+        File << "stream,frame,slice,x,y,width,height,coder,bytes,range_coder_bytes,bits_per_pixel,decode_time,plane,samples,plane_bytes,bits_per_sample,contexts_used,runs,run_samples\n";
+    else
+        File << "{\n  \"slices\": [";
+
+    Format = Format_Source;
+    IsEnabled_ = Format != analysis_format::None;
+    return false;
+}
+
+//---------------------------------------------------------------------------
+size_t ffv1_analysis::NewStream()
+{
+    lock_guard<mutex> Lock(Data_Mutex);
+    Streams.emplace_back();
+    return Streams.size() - 1;
+}
+
+//---------------------------------------------------------------------------
+void ffv1_analysis::Add(slice_data& Data)
+{
+    auto& Values = Data.Values;
+    for (size_t i = 0; i < Values.Planes_Count; i++)
+    {
+        auto& Contexts = Data.Histograms[i].Contexts;
+        Values.Planes[i].Contexts_Used = Contexts.size() - count(Contexts.begin(), Contexts.end(), 0);
+    }
+
+    {
+        lock_guard<mutex> Lock(Data_Mutex);
+        Slice_Write(Values);
+        Slices_Count++;
+        if (Values.Stream < Streams.size())
+        {
+            auto& Stream = Streams[Values.Stream];
+            if (Stream.Planes_Count < Values.Planes_Count)
+                Stream.Planes_Count = Values.Planes_Count;
+            for (size_t i = 0; i < Values.Planes_Count; i++)
+            {
+                const auto& Source = Data.Histograms[i];
+                auto& Dest = Stream.Histograms[i];
+                if (Dest.Contexts.size() < Source.Contexts.size())
+                    Dest.Contexts.resize(Source.Contexts.size());
+                for (size_t j = 0; j < Source.Contexts.size(); j++)
+                    Dest.Contexts[j] += Source.Contexts[j];
+                for (size_t j = 0; j < Run_Lengths_Size; j++)
+                    Dest.Run_Lengths[j] += Source.Run_Lengths[j];
+            }
+        }
+    }
+
+    // Reset for the next slice
+    for (auto& Histograms : Data.Histograms)
+    {
+        fill(Histograms.Contexts.begin(), Histograms.Contexts.end(), 0);
+        Histograms.Run_Lengths.fill(0);
+    }
+    Values.Planes_Count = 0;
+    Values.Planes.fill(plane_values());
+    Data.Run_Length = 0;
+}
+
+//---------------------------------------------------------------------------
+bool ffv1_analysis::End()
+{
+    lock_guard<mutex> Lock(Data_Mutex);
+    if (!File.is_open())
+        return true;
+
+    if (Format != analysis_format::CSV)
+    {
+        File << (Slices_Count ? "\n  ],\n" : "],\n");
+        File << "  \"streams\": [";
+        for (size_t s = 0; s < Streams.size(); s++)
+        {
+            const auto& Stream = Streams[s];
+            File << (s ? ",\n" : "\n");
+            File << "    { \"stream\": " << s << ", \"planes\": [";
+            for (size_t i = 0; i < Stream.Planes_Count; i++)
+            {
+                const auto& Histograms = Stream.Histograms[i];
+                File << (i ? "," : "") << "\n      { \"contexts\": [";
+                for (size_t j = 0; j < Histograms.Contexts.size(); j++)
+                    File << (j ? ", " : " ") << Histograms.Contexts[j];
+                File << " ], \"run_lengths\": [";
+                for (size_t j = 0; j < Run_Lengths_Size; j++)
+                    File << (j ? ", " : " ") << Histograms.Run_Lengths[j];
+                File << " ] }";
+            }
+            File << (Stream.Planes_Count ? "\n    ] }" : "] }");
+        }
+        File << (Streams.empty() ? "]\n" : "\n  ]\n");
+        File << "}\n";
+    }
+
+    File.close();
+    return !File.good();
+}
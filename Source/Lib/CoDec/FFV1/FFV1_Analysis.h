@@ -0,0 +1,94 @@
+/*  Copyright (c) MediaArea.net SARL & AV Preservation by reto.ch.
+ *
+ *  Use of this source code is governed by a BSD-style license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//---------------------------------------------------------------------------
+#ifndef FFV1_AnalysisH
+#define FFV1_AnalysisH
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+#include "Lib/Config.h"
+#include <array>
+#include <string>
+#include <vector>
+using namespace std;
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+ENUM_BEGIN(analysis_format)
+    None,
+    JSON,
+    CSV,
+ENUM_END(analysis_format)
+
+//---------------------------------------------------------------------------
+// Per slice and per plane statistics of the decoded FFV1 streams, for choosing slice count, context model and coder type
+// Collected by the slices during decoding, a disabled probe is only a test of a boolean
+// Slice records are written to the file as soon as the slice is decoded, in decoding order, only
+// the histograms per stream are kept in memory
+class ffv1_analysis
+{
+public:
+    static const size_t         Run_Lengths_Size = 33; // Bucket 0 is for runs of 0 sample, bucket n for runs of 2^(n-1) to 2^n-1 samples
+
+    struct plane_values
+    {
+        uint64_t                Samples = 0;
+        uint64_t                Bytes = 0; // Attributed line per line, so precise to a byte per line
+        uint64_t                Contexts_Used = 0; // Count of distinct contexts
+        uint64_t                Runs = 0; // Golomb-Rice run mode only
+        uint64_t                Run_Samples = 0;
+    };
+    struct slice_values
+    {
+        size_t                  Stream = 0;
+        uint64_t                Frame = 0;
+        size_t                  Slice = 0; // Order in the frame
+        uint32_t                x = 0;
+        uint32_t                y = 0;
+        uint32_t                w = 0;
+        uint32_t                h = 0;
+        uint32_t                Coder = 0; // 0 for Golomb-Rice, 1 or 2 for range coder
+        uint64_t                Bytes = 0; // Whole slice, with footer
+        uint64_t                RangeCoder_Bytes = 0; // Range coded part, only the header with Golomb-Rice
+        uint64_t                Duration = 0; // In nanoseconds
+        size_t                  Planes_Count = 0;
+        array<plane_values, 4>  Planes;
+    };
+    struct plane_histograms
+    {
+        vector<uint64_t>        Contexts; // Count of samples per context index
+        array<uint64_t, Run_Lengths_Size> Run_Lengths = {};
+    };
+
+    // Collected by a slice
+    struct slice_data
+    {
+        slice_values            Values;
+        array<plane_histograms, 4> Histograms;
+
+        // Helpers for the slice
+        void                    Plane_Begin(size_t Plane);
+        void                    Run_End(); // Run_Length is the count of samples of the run
+        size_t                  Plane = 0;
+        uint64_t                Run_Length = 0;
+    };
+
+    // Config
+    static bool                 Enable(analysis_format Format, const string& FileName); // Returns true on error
+    static bool                 IsEnabled() { return IsEnabled_; }
+
+    // Actions
+    static size_t               NewStream(); // ID of a new decoded stream
+    static void                 Add(slice_data& Data); // Thread safe, Data histograms are reset
+    static bool                 End(); // Returns true on error, histograms are written and the file is closed
+
+private:
+    static bool                 IsEnabled_;
+};
+
+//---------------------------------------------------------------------------
+#endif
@@ -8,6 +8,8 @@
 #include "Lib/CoDec/FFV1/FFV1_Frame.h"
 #include "Lib/Utils/RawFrame/RawFrame.h"
 #include "Lib/Utils/CRC32/ZenCRC32.h"
+#include "Lib/Utils/Stats/Stats.h"
+#include "Lib/Utils/Stats/Trace.h"
 #ifdef __GNUC__
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wreorder"
@@ -22,10 +24,10 @@
 // Threads
 //***************************************************************************
 
-int Frame_Thread(slice* Slice)
+int Frame_Thread(slice* Slice, size_t Index)
 {
-    Slice->Parse();
-    return 1;
+    trace_scope Trace("slice", "decode", "index", Index);
+    return Slice->Parse() ? 1 : 0; // Error message is in the shared parameters
 }
 
 //***************************************************************************
@@ -67,10 +69,13 @@ static inline uint32_t BigEndian2int24u(const uint8_t* B)
 ffv1_frame::ffv1_frame(ThreadPool* Pool_) :
     // Decoded frame
     RawFrame(NULL),
+    RawFrame_Hash(NULL),
     // Temp
     KeyFrame_IsPresent(false),
     Slices(NULL),
-    Pool(Pool_)
+    Pool(Pool_),
+    Analysis_Stream((size_t)-1),
+    Analysis_Frame(0)
 {
     E.AssignStateTransitions(default_state_transitions);
 }
@@ -97,6 +102,15 @@ void ffv1_frame::SetHeight(uint32_t height)
     P.height = height;
 }
 
+//---------------------------------------------------------------------------
+void ffv1_frame::SetRegion(uint32_t x, uint32_t y, uint32_t w, uint32_t h)
+{
+    P.region_x = x;
+    P.region_y = y;
+    P.region_w = w;
+    P.region_h = h;
+}
+
 //***************************************************************************
 // Before - Global
 //***************************************************************************
@@ -124,7 +138,7 @@ bool ffv1_frame::OutOfBand(const uint8_t* Buffer, size_t Buffer_Size)
 
     // Reserved + configuration_record_crc_parity
 
-    return true;
+    return false;
 }
 
 //---------------------------------------------------------------------------
@@ -163,6 +177,8 @@ bool ffv1_frame::Process(const uint8_t* Buffer, size_t Buffer_Size)
         //delete RawFrame;
         //RawFrame = new raw_frame;
         RawFrame->Create(P.colorspace_type, P.width, P.height, P.bits_per_raw_sample, P.chroma_planes, P.alpha_plane, ((size_t)1 << P.log2_h_chroma_subsample), ((size_t)1 << P.log2_v_chroma_subsample));
+        if (RawFrame_Hash)
+            RawFrame_Hash->Create(P.colorspace_type, P.width, P.height, P.bits_per_raw_sample, P.chroma_planes, P.alpha_plane, ((size_t)1 << P.log2_h_chroma_subsample), ((size_t)1 << P.log2_v_chroma_subsample));
     }
 
     size_t Slices_Size = 0;
@@ -186,7 +202,7 @@ bool ffv1_frame::Process(const uint8_t* Buffer, size_t Buffer_Size)
             slice*& Slice_Content = Slice_Current.Content;
             if (!Slice_Content)
                 Slice_Content = new slice(&P);
-            Slice_Content->Init(Buffer + Slices_BufferPos, Size, keyframe, !Slices_BufferPos, RawFrame);
+            Slice_Content->Init(Buffer + Slices_BufferPos, Size, keyframe, !Slices_BufferPos, RawFrame, RawFrame_Hash);
             Slices_Size++;
         }
         Slices_Size--;
@@ -202,18 +218,59 @@ bool ffv1_frame::Process(const uint8_t* Buffer, size_t Buffer_Size)
         Slice_Content->Init(Buffer, Buffer_Size, keyframe, true, RawFrame);
     }
 
+    if (ffv1_analysis::IsEnabled())
+    {
+        if (Analysis_Stream == (size_t)-1)
+            Analysis_Stream = ffv1_analysis::NewStream();
+        for (size_t i = 0; i <= Slices_Size; i++)
+            Slices[i].Content->Analysis_Init(Analysis_Stream, Analysis_Frame, Slices_Size - i); // Slices are found from the end of the frame
+        Analysis_Frame++;
+    }
+
+    stats::Add(stage::Decode, 0, 1);
+    int Slices_Errors = 0;
     if (Pool)
     {
         std::vector<std::future<int>> Futures;
         for (size_t i = Slices_Size; i <= Slices_Size; i--)
-            Futures.push_back(Pool->submit(Frame_Thread, Slices[i].Content));
+            Futures.push_back(Pool->submit(Frame_Thread, Slices[i].Content, i));
+        stats_scope Stats_Wait(stage::Decode, 0, 0, true);
+        trace_scope Trace("slices wait", "decode", "slices", Slices_Size + 1);
         for (size_t i = Slices_Size; i <= Slices_Size; i--) // TODO: don't wait for the parsing of the frame before peeking the next frame
-            Futures[i].get();
+            Slices_Errors += Futures[i].get();
     }
     else
     {
         for (size_t i = Slices_Size; i <= Slices_Size; i--)
-            Frame_Thread(Slices[i].Content);
+            Slices_Errors += Frame_Thread(Slices[i].Content, i);
+    }
+    if (stats::IsEnabled() && RawFrame)
+        stats::Add(stage::Transform, RawFrame->TotalSize(), 1); // Slices transform their lines in the frame buffer, time is counted per line
+
+    return Slices_Errors != 0;
+}
+
+//---------------------------------------------------------------------------
+bool ffv1_frame::Check(const uint8_t* Buffer, size_t Buffer_Size)
+{
+    if (!HasChecksums())
+        return false; // No checksum
+
+    uint64_t Slices_BufferPos = Buffer_Size;
+    while (Slices_BufferPos)
+    {
+        if (Slices_BufferPos < P.TailSize)
+            return true; //There is a problem
+
+        size_t Size = BigEndian2int24u(Buffer + (size_t)Slices_BufferPos - P.TailSize);
+        Size += P.TailSize;
+
+        if (Size > Slices_BufferPos)
+            return true; //There is a problem
+        Slices_BufferPos -= Size;
+
+        if (ZenCRC32(Buffer + Slices_BufferPos, Size))
+            return P.Error("FFV1-SLICE-slice_crc_parity:1");
     }
 
     return false;
@@ -30,13 +30,20 @@ public:
     // External metadata
     void SetWidth(uint32_t width);
     void SetHeight(uint32_t width);
+    void SetRegion(uint32_t x, uint32_t y, uint32_t w, uint32_t h); // Other slices are not decoded if the stream is intra only, w or h 0 for the whole frame
 
     // Actions
     bool Process(const uint8_t* Buffer, size_t Buffer_Size);
     bool OutOfBand(const uint8_t* Buffer, size_t Buffer_Size);
+    bool Check(const uint8_t* Buffer, size_t Buffer_Size); // Slice checksums only, without decoding, returns true if a checksum is wrong
 
     // Decoded frame
     raw_frame*                  RawFrame;
+    raw_frame*                  RawFrame_Hash; // Same samples with FFmpeg layout, for frame hashes
+
+    // Info
+    bool IsIntraOnly() { return P.ConfigurationRecord_IsPresent && P.intra; }
+    bool HasChecksums() { return P.ConfigurationRecord_IsPresent && P.ec == 1; } // Check() tests something
 
     // Error message
     const char* ErrorMessage();
@@ -50,6 +57,8 @@ private:
     bool                        KeyFrame_IsPresent;
     slice_struct*               Slices;
     ThreadPool*                 Pool;
+    size_t                      Analysis_Stream;
+    uint64_t                    Analysis_Frame;
 
     // Helpers
     void Clear();
@@ -53,6 +53,12 @@ struct parameters
     uint32_t                    width = 0;
     uint32_t                    height = 0;
 
+    // Config, not from the bitstream
+    uint32_t                    region_x = 0;   // Only slices intersecting the region are decoded if the stream is intra only
+    uint32_t                    region_y = 0;
+    uint32_t                    region_w = 0;   // 0 for the whole frame
+    uint32_t                    region_h = 0;
+
     // Specific to Range Coder coder_type
     state_transitions_struct*   RC_state_transitions_custom = nullptr; // From state_transition_delta
     quant_table_sets_rc_struct  RC_ContextSets; // states before starting a slice
@@ -9,6 +9,7 @@
 #include "Lib/Transform/Transform.h"
 #include "Lib/Utils/RawFrame/RawFrame.h"
 #include "Lib/Utils/CRC32/ZenCRC32.h"
+#include "Lib/Utils/Stats/Stats.h"
 #include <algorithm>
 using namespace std;
 //---------------------------------------------------------------------------
@@ -99,7 +100,8 @@ static inline pixel_t get_context_5(pixel_t quant_table[MAX_CONTEXT_INPUTS][MAX_
 //---------------------------------------------------------------------------
 slice::slice(parameters* P_) :
     P(P_),
-    Coder(NULL)
+    Coder(NULL),
+    Analysis(NULL)
 {
 }
 
@@ -107,6 +109,17 @@ slice::slice(parameters* P_) :
 slice::~slice()
 {
     delete Coder;
+    delete Analysis;
+}
+
+//---------------------------------------------------------------------------
+void slice::Analysis_Init(size_t Stream, uint64_t Frame, size_t Index)
+{
+    if (!Analysis)
+        Analysis = new ffv1_analysis::slice_data;
+    Analysis->Values.Stream = Stream;
+    Analysis->Values.Frame = Frame;
+    Analysis->Values.Slice = Index;
 }
 
 //---------------------------------------------------------------------------
@@ -197,9 +210,10 @@ void slice::GOP_Init()
 }
 
 //---------------------------------------------------------------------------
-void slice::Init(const uint8_t* Buffer_, size_t Buffer_Size_, bool keyframe_, bool IsFirstSlice_, raw_frame* RawFrame_)
+void slice::Init(const uint8_t* Buffer_, size_t Buffer_Size_, bool keyframe_, bool IsFirstSlice_, raw_frame* RawFrame_, raw_frame* RawFrame_Hash_)
 {
     RawFrame = RawFrame_;
+    RawFrame_Hash = RawFrame_Hash_;
     Buffer = Buffer_;
     Buffer_Size = Buffer_Size_;
     keyframe = keyframe_;
@@ -209,6 +223,9 @@ void slice::Init(const uint8_t* Buffer_, size_t Buffer_Size_, bool keyframe_, bo
 //---------------------------------------------------------------------------
 bool slice::Parse()
 {
+    stats_scope Stats(stage::Decode, Buffer_Size);
+    auto Analysis_Begin = Analysis ? stats::Now() : 0;
+
     // RangeCoder reset
     E.AssignBuffer(Buffer, Buffer_Size);
     E.AssignStateTransitions(default_state_transitions);
@@ -262,6 +279,11 @@ bool slice::Parse()
             quant_table_set_indexes[i].Index = 0;
     }
 
+    // Region of interest, states are reset at each frame in intra only streams so other slices can be skipped
+    if (P->region_w && P->region_h && P->ConfigurationRecord_IsPresent && P->intra
+     && (x >= P->region_x + P->region_w || P->region_x >= x + w || y >= P->region_y + P->region_h || P->region_y >= y + h))
+        return false;
+
     if (keyframe)
         GOP_Init();
 
@@ -285,10 +307,31 @@ bool slice::Parse()
         default:;
     }
 
+    if (Analysis)
+    {
+        auto& Values = Analysis->Values;
+        Values.x = x;
+        Values.y = y;
+        Values.w = w;
+        Values.h = h;
+        Values.Coder = P->coder_type;
+        Values.RangeCoder_Bytes = Buffer_Offset;
+    }
+
     Buffer_Offset += SliceContent();
     if (Buffer_Offset<Buffer_Size)
         P->Error("FFV1-SLICE-JUNK:1");
 
+    if (Analysis)
+    {
+        auto& Values = Analysis->Values;
+        if (P->coder_type)
+            Values.RangeCoder_Bytes = Buffer_Offset;
+        Values.Bytes = Buffer_Size + P->TailSize;
+        Values.Duration = stats::Now() - Analysis_Begin;
+        ffv1_analysis::Add(*Analysis);
+    }
+
     //SliceFooter
     if (P->ConfigurationRecord_IsPresent)
     {
@@ -343,7 +386,7 @@ void slice::SliceContent_PlaneThenLine()
 {
     pixel_t* SamplesBuffer = new pixel_t[2 * (w + 3)];
     memset(SamplesBuffer, 0, 2 * (w + 3) * sizeof(pixel_t));
-    auto Transform = Transform_Init(RawFrame, pix_style::YUVA, P->bits_per_raw_sample, x, y, w, h);
+    auto Transform = Transform_Init(RawFrame, RawFrame_Hash, pix_style::YUVA, P->bits_per_raw_sample, x, y, w, h);
 
     SliceContent_PlaneThenLine(Transform, SamplesBuffer, 0);
     if (P->chroma_planes)
@@ -376,6 +419,8 @@ void slice::SliceContent_PlaneThenLine(transform_base* Transform, pixel_t* Sampl
     sample[1] = sample[0] + w + 3;
 
     Coder->Plane_Init();
+    if (Analysis)
+        Analysis->Plane_Begin(Analysis->Values.Planes_Count); // Planes are coded one after the other
 
     for (size_t y = 0; y < h; y++)
     {
@@ -387,6 +432,7 @@ void slice::SliceContent_PlaneThenLine(transform_base* Transform, pixel_t* Sampl
         Line(pos, sample);
 
         //Copy the line to the frame buffer
+        stats_scope Stats(stage::Transform);
         Transform->From(sample[1]);
     }
 }
@@ -396,7 +442,7 @@ void slice::SliceContent_LineThenPlane()
 {
     pixel_t* SamplesBuffer = new pixel_t[2 * P->plane_count * (w + 3)];
     memset(SamplesBuffer, 0, 2 * P->plane_count * (w + 3) * sizeof(pixel_t));
-    auto Transform = Transform_Init(RawFrame, pix_style::RGBA, P->bits_per_raw_sample, x, y, w, h);
+    auto Transform = Transform_Init(RawFrame, RawFrame_Hash, pix_style::RGBA, P->bits_per_raw_sample, x, y, w, h);
 
     Coder->Plane_Init();
 
@@ -421,10 +467,13 @@ void slice::SliceContent_LineThenPlane()
             sample[c][1][-1] = sample[c][0][0];
             sample[c][0][w] = sample[c][0][w - 1];
 
+            if (Analysis)
+                Analysis->Plane_Begin(c);
             Line((c + 1) >> 1, sample[c]);
         }
 
         //Copy the line to the frame buffer
+        stats_scope Stats(stage::Transform);
         Transform->From(sample[0][1], sample[1][1], sample[2][1], sample[3][1]);
     }
 
@@ -432,12 +481,102 @@ void slice::SliceContent_LineThenPlane()
     delete[] SamplesBuffer;
 }
 
+//---------------------------------------------------------------------------
+namespace
+{
+    // Policy of Line_Loop() without analysis, compiles to nothing
+    struct line_no_analysis
+    {
+        void Line_Begin(const quant_table_set_struct&) {}
+        void Sample_Begin(pixel_t) {}
+        void Sample_End() {}
+        void Line_End(uint32_t) {}
+    };
+
+    // Policy of Line_Loop() with the collect of the statistics
+    struct line_analysis
+    {
+        line_analysis(ffv1_analysis::slice_data& Data_Source, coder_base* Coder_Source, coder_golombrice* GolombRice_Source) :
+            Data(Data_Source),
+            Plane_Values(Data_Source.Values.Planes[Data_Source.Plane]),
+            Contexts(Data_Source.Histograms[Data_Source.Plane].Contexts),
+            Coder(Coder_Source),
+            GolombRice(GolombRice_Source)
+        {
+        }
+
+        void Line_Begin(const quant_table_set_struct& QuantTableSet)
+        {
+            Bytes_Begin = Coder->BytesUsed();
+            if (Contexts.size() < QuantTableSet.Contexts_Count)
+                Contexts.resize(QuantTableSet.Contexts_Count);
+        }
+
+        void Sample_Begin(pixel_t context_idx)
+        {
+            size_t Context = context_idx >= 0 ? context_idx : -context_idx;
+            if (Context < Contexts.size())
+                Contexts[Context]++;
+            IsRun = GolombRice && (GolombRice->IsRunMode() || !Context);
+        }
+
+        void Sample_End()
+        {
+            // A run is the count of zero deltas before the sample leaving the run mode
+            if (IsRun)
+            {
+                if (GolombRice->IsRunMode())
+                    Data.Run_Length++;
+                else
+                    Data.Run_End();
+            }
+        }
+
+        void Line_End(uint32_t w)
+        {
+            // Run mode does not continue on the next line
+            if (GolombRice && GolombRice->IsRunMode())
+                Data.Run_End();
+
+            Plane_Values.Samples += w;
+            auto Bytes_End = Coder->BytesUsed();
+            if (Bytes_End > Bytes_Begin)
+                Plane_Values.Bytes += Bytes_End - Bytes_Begin;
+        }
+
+        ffv1_analysis::slice_data& Data;
+        ffv1_analysis::plane_values& Plane_Values;
+        vector<uint64_t>&       Contexts;
+        coder_base*             Coder;
+        coder_golombrice*       GolombRice;
+        size_t                  Bytes_Begin = 0;
+        bool                    IsRun = false;
+    };
+}
+
 //---------------------------------------------------------------------------
 void slice::Line(size_t quant_table_set_index, pixel_t *sample[2])
 {
+    if (Analysis)
+    {
+        line_analysis Policy(*Analysis, Coder, P->coder_type ? nullptr : (coder_golombrice*)Coder);
+        return Line_Loop(quant_table_set_index, sample, Policy);
+    }
+
+    line_no_analysis Policy;
+    Line_Loop(quant_table_set_index, sample, Policy);
+}
+
+//---------------------------------------------------------------------------
+template<class line_policy>
+void slice::Line_Loop(size_t quant_table_set_index, pixel_t *sample[2], line_policy& Policy)
+{
+    quant_table_set_struct& QuantTableSet = P->QuantTableSets[quant_table_set_indexes[quant_table_set_index].Index];
+    Policy.Line_Begin(QuantTableSet);
+
     Coder->Line_Init(quant_table_set_index);
 
-    quant_tables_struct& QuantTables = P->QuantTableSets[quant_table_set_indexes[quant_table_set_index].Index].QuantTables;
+    quant_tables_struct& QuantTables = QuantTableSet.QuantTables;
     pixel_t& bits_mask=P->bits_mask;
     bool Is5 = QuantTables[3][127] ? true : false;
     pixel_t* s0c = sample[0];
@@ -447,6 +586,7 @@ void slice::Line(size_t quant_table_set_index, pixel_t *sample[2])
     while (s0c<s0e)
     {
         pixel_t context_idx = Is5 ? get_context_5(QuantTables, s1c, s0c) : get_context_3(QuantTables, s1c, s0c);
+        Policy.Sample_Begin(context_idx);
 
         pixel_t Value = predict(s1c, s0c, P->IsOverflow16bit);
         if (context_idx >= 0)
@@ -455,9 +595,13 @@ void slice::Line(size_t quant_table_set_index, pixel_t *sample[2])
             Value -= Coder->Sample_Delta(-context_idx);
         *s1c = Value & bits_mask;
 
+        Policy.Sample_End();
+
         s0c++;
         s1c++;
     }
+
+    Policy.Line_End(w);
 }
 
 
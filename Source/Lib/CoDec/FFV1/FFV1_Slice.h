@@ -10,6 +10,7 @@
 //---------------------------------------------------------------------------
 
 //---------------------------------------------------------------------------
+#include "Lib/CoDec/FFV1/FFV1_Analysis.h"
 #include "Lib/CoDec/FFV1/FFV1_Parameters.h"
 #include "Lib/CoDec/FFV1/Coder/FFV1_Coder_RangeCoder.h"
 #include "Lib/CoDec/FFV1/Coder/FFV1_Coder_GolombRice.h"
@@ -29,9 +30,12 @@ public:
     ~slice();
 
     // Content
-    void                        Init(const uint8_t* Buffer, size_t Buffer_Size, bool keyframe, bool IsFirstSlice, raw_frame* RawFrame);
+    void                        Init(const uint8_t* Buffer, size_t Buffer_Size, bool keyframe, bool IsFirstSlice, raw_frame* RawFrame, raw_frame* RawFrame_Hash = nullptr);
     bool                        Parse();
 
+    // Analysis (only if enabled)
+    void                        Analysis_Init(size_t Stream, uint64_t Frame, size_t Index);
+
     // Metadata (no impact on decoding)
     uint32_t                    picture_structure;
     uint32_t                    sar_num;
@@ -51,6 +55,7 @@ private:
     parameters*                 P;
     rangecoder                  E;
     raw_frame*                  RawFrame;
+    raw_frame*                  RawFrame_Hash; // Copy of the samples, with FFmpeg layout, if not null
 
     // Cache (useful only for splitiing init from parsing)
     const uint8_t*              Buffer;
@@ -66,9 +71,14 @@ private:
     void                        SliceContent_PlaneThenLine(transform_base* Transform, pixel_t* SamplesBuffer, uint32_t pos);
     void                        SliceContent_LineThenPlane();
     void                        Line(size_t quant_table_set_index, pixel_t *sample[2]);
+    template<class line_policy>
+    void                        Line_Loop(size_t quant_table_set_index, pixel_t *sample[2], line_policy& Policy); // Policy collects the analysis or does nothing
 
     // Coder
     coder_base*                 Coder;
+
+    // Analysis
+    ffv1_analysis::slice_data*  Analysis;
 };
 
 //---------------------------------------------------------------------------
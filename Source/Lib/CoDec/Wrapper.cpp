@@ -12,9 +12,26 @@
 #include "Lib/Uncompressed/WAV/WAV.h"
 #include "Lib/Uncompressed/AIFF/AIFF.h"
 #include "Lib/Uncompressed/HashSum/HashSum.h"
+#include "Lib/Utils/FrameHash/FrameHash_MD5.h"
+#include "Lib/Utils/Interleave/Interleave.h"
 #include "FLAC/stream_decoder.h"
+extern "C"
+{
+#include "private/crc.h"
+}
+#ifdef __GNUC__
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wreorder"
+#endif
+#include "ThreadPool.h"
+#ifdef __GNUC__
+#pragma GCC diagnostic pop
+#endif
+#include <condition_variable>
 #include <cstring>
+#include <deque>
 #include <iostream>
+#include <mutex>
 //---------------------------------------------------------------------------
 
 //---------------------------------------------------------------------------
@@ -72,13 +89,25 @@ public:
     // Config
     void                        SetWidth(uint32_t Width);
     void                        SetHeight(uint32_t Height);
+    void                        SetFrameHash(framehash_md5* NewFrameHash);
+    void                        SetRegion(uint32_t X, uint32_t Y, uint32_t Width, uint32_t Height);
 
     // Actions
     void                        Process(const uint8_t* Data, size_t Size);
     void                        OutOfBand(const uint8_t* Data, size_t Size);
 
+    // Info
+    bool                        IsIntraOnly() { return Ffv1Frame->IsIntraOnly(); }
+    bool                        HasChecksums() { return Ffv1Frame->HasChecksums(); }
+    bool                        Check(const uint8_t* Data, size_t Size) { return Ffv1Frame->Check(Data, Size); }
+    const char*                 ErrorMessage() { return ErrorMessage_; }
+
 private:
     ffv1_frame*                 Ffv1Frame;
+    const char*                 ErrorMessage_ = nullptr;
+    const char*                 ErrorMessage_Get();
+    framehash_md5*              FrameHash = nullptr;
+    raw_frame                   RawFrame_Hash; // Same samples as RawFrame, with the layout of FFmpeg
 };
 
 //---------------------------------------------------------------------------
@@ -105,19 +134,42 @@ void ffv1_wrapper::SetHeight(uint32_t Height)
     Ffv1Frame->SetHeight(Height);
 }
 
+//---------------------------------------------------------------------------
+void ffv1_wrapper::SetFrameHash(framehash_md5* NewFrameHash)
+{
+    FrameHash = NewFrameHash;
+    RawFrame_Hash.Flavor = raw_frame::flavor::FFmpeg;
+}
+
+//---------------------------------------------------------------------------
+void ffv1_wrapper::SetRegion(uint32_t X, uint32_t Y, uint32_t Width, uint32_t Height)
+{
+    Ffv1Frame->SetRegion(X, Y, Width, Height);
+}
+
 //---------------------------------------------------------------------------
 void ffv1_wrapper::Process(const uint8_t* Data, size_t Size)
 {
     Ffv1Frame->RawFrame = RawFrame;
-    Ffv1Frame->Process(Data, Size);
+    Ffv1Frame->RawFrame_Hash = FrameHash ? &RawFrame_Hash : nullptr;
+    ErrorMessage_ = Ffv1Frame->Process(Data, Size) ? ErrorMessage_Get() : nullptr;
     RawFrame->Process();
+    if (FrameHash)
+        FrameHash->To(&RawFrame_Hash);
 }
 
 //---------------------------------------------------------------------------
 void ffv1_wrapper::OutOfBand(const uint8_t* Data, size_t Size)
 {
     Ffv1Frame->RawFrame = RawFrame;
-    Ffv1Frame->OutOfBand(Data, Size);
+    ErrorMessage_ = Ffv1Frame->OutOfBand(Data, Size) ? ErrorMessage_Get() : nullptr;
+}
+
+//---------------------------------------------------------------------------
+const char* ffv1_wrapper::ErrorMessage_Get()
+{
+    auto Message = Ffv1Frame->ErrorMessage();
+    return Message ? Message : "FFV1-FRAME:1"; // Some checks do not provide a message
 }
 
 //---------------------------------------------------------------------------
@@ -127,9 +179,16 @@ public:
     flac_wrapper();
     ~flac_wrapper();
 
+    // Config
+    void                        SetPool(ThreadPool* Pool);
+
     // Actions
-    void                        OutOfBand(const uint8_t* Data, size_t Size) { return Process(Data, Size); }
+    void                        OutOfBand(const uint8_t* Data, size_t Size);
     void                        Process(const uint8_t* Data, size_t Size);
+    void                        Wait();
+
+    // Info
+    bool                        Check(const uint8_t* Data, size_t Size) { return Size < 2 || FLAC__crc16(Data, (uint32_t)Size); } // Frame footer is the CRC-16 of the frame, CRC-16 of the whole frame is 0
 
     // libFLAC related helping functions
     void                        FLAC_Read(uint8_t buffer[], size_t* bytes);
@@ -144,6 +203,28 @@ private:
     size_t                      Size_;
     uint8_t                     channels_ = 0;
     uint8_t                     bits_per_sample_ = 0;
+
+    // Parallel decoding, each Matroska block is a complete FLAC frame so it can be decoded by its own decoder
+    struct job
+    {
+        flac_wrapper*           Decoder;
+        const uint8_t*          Data;
+        size_t                  Size;
+        bool                    IsStarted;
+        bool                    IsDecoded;
+    };
+    job*                        NextJob(); // Mutex_ must be locked
+    void                        DecodeNext();
+    void                        Decode(job* Job);
+    ThreadPool*                 Pool_ = nullptr;
+    buffer                      OutOfBand_; // Needed for initializing the decoders
+    deque<job>                  Jobs_; // In stream order
+    size_t                      Jobs_Max_ = 1; // Bound of decoded frames and decoders in memory
+    vector<flac_wrapper*>       Decoders_;
+    vector<flac_wrapper*>       Decoders_Free_;
+    mutex                       Mutex_;
+    condition_variable          IsIdle_;
+    bool                        IsWriting_ = false;
 };
 
 //---------------------------------------------------------------------------
@@ -191,11 +272,74 @@ flac_wrapper::flac_wrapper()
 //---------------------------------------------------------------------------
 flac_wrapper::~flac_wrapper()
 {
+    Wait();
+    for (auto Decoder : Decoders_)
+    {
+        delete Decoder->RawFrame;
+        delete Decoder;
+    }
     FLAC__stream_decoder_delete(Decoder_);
 }
 
+//---------------------------------------------------------------------------
+void flac_wrapper::SetPool(ThreadPool* Pool)
+{
+    Pool_ = Pool;
+    Jobs_Max_ = Pool ? Pool->size() : 1; // One job per thread of the pool, so -threads is respected
+    if (!Jobs_Max_)
+        Jobs_Max_ = 1;
+}
+
+//---------------------------------------------------------------------------
+void flac_wrapper::OutOfBand(const uint8_t* Data, size_t Size)
+{
+    memory_scope Memory(memory_use::Audio);
+    OutOfBand_.Create(Data, Size);
+    Process(Data, Size);
+}
+
+//---------------------------------------------------------------------------
 void flac_wrapper::Process(const uint8_t* Data, size_t Size)
 {
+    if (Pool_ && OutOfBand_.Size())
+    {
+        {
+            unique_lock<mutex> Lock(Mutex_);
+
+            // Too many frames in flight, this thread decodes pending frames itself (it may be a thread of the pool) or waits for their output
+            while (Jobs_.size() >= Jobs_Max_)
+            {
+                if (auto Job = NextJob())
+                {
+                    Lock.unlock();
+                    Decode(Job);
+                    Lock.lock();
+                }
+                else
+                    IsIdle_.wait(Lock);
+            }
+
+            flac_wrapper* Decoder;
+            if (Decoders_Free_.empty())
+            {
+                Decoder = new flac_wrapper;
+                Decoder->RawFrame = new raw_frame;
+                Decoder->OutOfBand(OutOfBand_.Data(), OutOfBand_.Size());
+                Decoder->SetOutputBitDepth(OutputBitDepth_);
+                Decoder->SetEndianness(Endianness_);
+                Decoders_.push_back(Decoder);
+            }
+            else
+            {
+                Decoder = Decoders_Free_.back();
+                Decoders_Free_.pop_back();
+            }
+            Jobs_.push_back({ Decoder, Data, Size, false, false });
+        }
+        Pool_->submit([this]() { DecodeNext(); }); // One task per job, the job may already be decoded by another thread
+        return;
+    }
+
     Data_ = Data;
     Size_ = Size;
 
@@ -211,6 +355,66 @@ void flac_wrapper::Process(const uint8_t* Data, size_t Size)
     }
 }
 
+//---------------------------------------------------------------------------
+flac_wrapper::job* flac_wrapper::NextJob()
+{
+    for (auto& Job : Jobs_)
+        if (!Job.IsStarted)
+        {
+            Job.IsStarted = true;
+            return &Job; // deque does not move its elements when new ones are added at the end, and a job is removed only after being decoded
+        }
+    return nullptr;
+}
+
+//---------------------------------------------------------------------------
+void flac_wrapper::DecodeNext()
+{
+    job* Job;
+    {
+        lock_guard<mutex> Lock(Mutex_);
+        Job = NextJob();
+    }
+    if (Job)
+        Decode(Job);
+}
+
+//---------------------------------------------------------------------------
+void flac_wrapper::Decode(job* Job)
+{
+    // Decoding, data is read directly from the Matroska buffer
+    Job->Decoder->Process(Job->Data, Job->Size);
+
+    // Output in order, by the first thread finding that the next frame is ready
+    unique_lock<mutex> Lock(Mutex_);
+    Job->IsDecoded = true;
+    if (IsWriting_)
+        return;
+    IsWriting_ = true;
+    auto Jobs_Size = Jobs_.size();
+    while (!Jobs_.empty() && Jobs_.front().IsDecoded)
+    {
+        auto Decoder = Jobs_.front().Decoder;
+        Lock.unlock();
+        const auto& Output = Decoder->RawFrame->Buffer();
+        RawFrame->AssignBufferView(Output.Data(), Output.Size());
+        RawFrame->Process();
+        Lock.lock();
+        Jobs_.pop_front();
+        Decoders_Free_.push_back(Decoder);
+    }
+    IsWriting_ = false;
+    if (Jobs_.empty() || Jobs_.size() < Jobs_Size)
+        IsIdle_.notify_all(); // Wait() or Process() waiting for room
+}
+
+//---------------------------------------------------------------------------
+void flac_wrapper::Wait()
+{
+    unique_lock<mutex> Lock(Mutex_);
+    IsIdle_.wait(Lock, [this] { return Jobs_.empty() && !IsWriting_; });
+}
+
 //---------------------------------------------------------------------------
 void flac_wrapper::FLAC_Read(uint8_t buffer[], size_t* bytes)
 {
@@ -241,101 +445,15 @@ void flac_wrapper::FLAC_Write(const uint32_t* const buffer[], size_t blocksize)
 {
     auto& Buffer = RawFrame->Buffer();
     if (!Buffer.Data())
+    {
+        memory_scope Memory(memory_use::Audio);
         Buffer.Create(16384 / 8 * OutputBitDepth_ * channels_); // 16384 is the max blocksize in spec
+    }
     auto Data = Buffer.DataForModification();
 
     // Converting libFLAC output to WAV style
-    uint8_t channels = channels_;
-    switch (OutputBitDepth_)
-    {
-    case 8:
-        switch (bits_per_sample_)
-        {
-        case 8:
-            switch (Endianness_)
-            {
-            case endianness::BE:
-                for (size_t i = 0; i < blocksize; i++)
-                    for (size_t j = 0; j < channels; j++)
-                    {
-                        *(Data++) = (uint8_t)(buffer[j][i]);
-                    }
-                break;
-            case endianness::LE:
-                for (size_t i = 0; i < blocksize; i++)
-                    for (size_t j = 0; j < channels; j++)
-                    {
-                        *(Data++) = (uint8_t)((buffer[j][i]) + 128);
-                    }
-                break;
-            }
-            break;
-        case 16:
-            switch (Endianness_)
-            {
-            case endianness::BE:
-                for (size_t i = 0; i < blocksize; i++)
-                    for (size_t j = 0; j < channels; j++)
-                    {
-                        *(Data++) = (uint8_t)(buffer[j][i] >> 8);
-                    }
-                break;
-            case endianness::LE:
-                for (size_t i = 0; i < blocksize; i++)
-                    for (size_t j = 0; j < channels; j++)
-                    {
-                        *(Data++) = (uint8_t)((buffer[j][i] >> 8) + 128);
-                    }
-                break;
-            }
-            break;
-        }
-        break;
-    case 16:
-        switch (Endianness_)
-        {
-        case endianness::BE:
-            for (size_t i = 0; i < blocksize; i++)
-                for (size_t j = 0; j < channels; j++)
-                {
-                    *(Data++) = (uint8_t)(buffer[j][i] >> 8);
-                    *(Data++) = (uint8_t)(buffer[j][i]);
-                }
-            break;
-        case endianness::LE:
-            for (size_t i = 0; i < blocksize; i++)
-                for (size_t j = 0; j < channels; j++)
-                {
-                    *(Data++) = (uint8_t)(buffer[j][i]);
-                    *(Data++) = (uint8_t)(buffer[j][i] >> 8);
-                }
-            break;
-        }
-        break;
-    case 24:
-        switch (Endianness_)
-        {
-        case endianness::BE:
-            for (size_t i = 0; i < blocksize; i++)
-                for (size_t j = 0; j < channels; j++)
-                {
-                    *(Data++) = (uint8_t)(buffer[j][i] >> 16);
-                    *(Data++) = (uint8_t)(buffer[j][i] >> 8);
-                    *(Data++) = (uint8_t)(buffer[j][i]);
-                }
-            break;
-        case endianness::LE:
-            for (size_t i = 0; i < blocksize; i++)
-                for (size_t j = 0; j < channels; j++)
-                {
-                    *(Data++) = (uint8_t)(buffer[j][i]);
-                    *(Data++) = (uint8_t)(buffer[j][i] >> 8);
-                    *(Data++) = (uint8_t)(buffer[j][i] >> 16);
-                }
-            break;
-        }
-        break;
-    }
+    if (auto Interleave = Interleave_Get(OutputBitDepth_, bits_per_sample_, Endianness_, channels_))
+        Data = Interleave(Data, buffer, blocksize, channels_);
 
     Buffer.Resize(Data - Buffer.Data());
 
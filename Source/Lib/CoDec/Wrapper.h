@@ -23,6 +23,7 @@
 #include <vector>
 class base_wrapper;
 class frame_writer;
+class framehash_md5;
 using namespace std;
 //---------------------------------------------------------------------------
 
@@ -35,6 +36,13 @@ public:
     // Actions
     virtual void                Process(const uint8_t* Data, size_t Size) = 0;
     inline virtual void         OutOfBand(const uint8_t* /*Data*/, size_t /*Size*/) {};
+    inline virtual void         Wait() {}; // Wait for all frames provided to Process() to be fully handled
+
+    // Info
+    inline virtual bool         IsIntraOnly() { return true; }; // Frames can be decoded independently, so some of them can be skipped
+    inline virtual bool         HasChecksums() { return false; }; // Check() tests something, else frames must be decoded for being checked
+    inline virtual bool         Check(const uint8_t* /*Data*/, size_t /*Size*/) { return false; }; // Checksums of the compressed frame without decoding it, returns true if a checksum is wrong
+    inline virtual const char*  ErrorMessage() { return nullptr; }; // Error of the last call to Process() or OutOfBand(), nullptr if none
 
 public:
     raw_frame*                  RawFrame = nullptr;
@@ -47,6 +55,8 @@ public:
     // Config
     virtual void                SetWidth(uint32_t /*Width*/) {};
     virtual void                SetHeight(uint32_t /*Height*/) {};
+    virtual void                SetFrameHash(framehash_md5* /*FrameHash*/) {}; // Hash of each decoded frame
+    virtual void                SetRegion(uint32_t /*X*/, uint32_t /*Y*/, uint32_t /*Width*/, uint32_t /*Height*/) {}; // Content out of the region may not be decoded, Width or Height 0 for the whole frame
 };
 
 //---------------------------------------------------------------------------
@@ -56,6 +66,10 @@ public:
     // Config
     void                        SetOutputBitDepth(uint8_t BitDepth);
     void                        SetEndianness(endianness Endianness);
+    virtual void                SetPool(ThreadPool* /*Pool*/) {}; // Frames may be decoded out of order, output is still in order
+
+    // Info
+    uint8_t                     OutputBitDepth() const { return OutputBitDepth_; }
 
 protected:
     uint8_t                     OutputBitDepth_ = 0;
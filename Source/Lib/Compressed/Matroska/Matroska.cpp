@@ -7,10 +7,17 @@
 //---------------------------------------------------------------------------
 #include "Lib/Compressed/Matroska/Matroska.h"
 #include "Lib/Utils/FileIO/FileWriter.h"
+#include "Lib/Utils/FileIO/AsyncWriter.h"
+#include "Lib/Utils/FileIO/Durability.h"
 #include "Lib/Utils/FileIO/FileChecker.h"
+#include "Lib/Compressed/RAWcooked/RAWcooked.h"
 #include "Lib/Compressed/RAWcooked/Reversibility.h"
 #include "Lib/Compressed/RAWcooked/Track.h"
 #include "Lib/Uncompressed/HashSum/HashSum.h"
+#include "Lib/Utils/FrameHash/FrameHash_MD5.h"
+#include "Lib/Utils/Hash/StreamHash.h"
+#include "Lib/Utils/Stats/Stats.h"
+#include "Lib/Utils/Stats/Trace.h"
 #ifdef __GNUC__
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wreorder"
@@ -166,6 +173,7 @@ ELEMENT_END()
 ELEMENT_BEGIN(Segment_Tracks_TrackEntry)
 ELEMENT_VOID(       6, Segment_Tracks_TrackEntry_CodecID)
 ELEMENT_VOID(    23A2, Segment_Tracks_TrackEntry_CodecPrivate)
+ELEMENT_VOID(   3E383, Segment_Tracks_TrackEntry_DefaultDuration)
 ELEMENT_CASE(      60, Segment_Tracks_TrackEntry_Video)
 ELEMENT_END()
 
@@ -196,6 +204,7 @@ matroska::~matroska()
     delete Hashes_FromRAWcooked;
     delete Hashes_FromAttachments;
     delete FrameWriter_Template;
+    delete Writer;
 }
 
 //---------------------------------------------------------------------------
@@ -210,6 +219,21 @@ void matroska::Shutdown()
     }
     TrackInfo.clear();
 
+    // Frame hashes
+    if (FrameHash)
+    {
+        if (FrameHash->Finish())
+            FrameMd5_IsError = true;
+        delete FrameHash;
+        FrameHash = nullptr;
+    }
+
+    // Pending writes
+    if (Writer)
+        Writer->Wait();
+    if (Durable)
+        Durable->Finish();
+
     // Hashes
     if ((Actions[Action_Decode] || Actions[Action_Check] || Actions[Action_Conch]) && Hashes_FromRAWcooked)
     {
@@ -319,9 +343,14 @@ void matroska::ParseBuffer()
     Level++;
 
     size_t Buffer_Offset_LowerLimit = 0; // Used for indicating the system that we'll not need anymore memory below this value 
+    size_t ContainerHash_Offset = 0; // Content below this value is already sent to the container hash
+    size_t Window_Size = 0; // Part of the mapped file which may be in memory, for memory statistics
+    memory_scope Memory(memory_use::Container);
 
     while (Buffer_Offset < Buffer.Size())
     {
+        stats_scope Stats(stage::Demux);
+        auto Buffer_Offset_Begin = Buffer_Offset;
         uint64_t Name = Get_EB();
         uint64_t Size = Get_EB();
         if (Size <= Levels[Level - 1].Offset_End - Buffer_Offset)
@@ -344,11 +373,37 @@ void matroska::ParseBuffer()
             }
         }
 
+        Stats.Add(Buffer_Offset - Buffer_Offset_Begin);
+        if (memory::IsEnabled() && Buffer_Offset > Buffer_Offset_LowerLimit)
+        {
+            auto Window_Size_New = (Buffer_Offset < Buffer.Size() ? Buffer_Offset : Buffer.Size()) - Buffer_Offset_LowerLimit;
+            memory::Resize(memory_use::Container, Window_Size, Window_Size_New);
+            Window_Size = Window_Size_New;
+        }
+
         // Check if we can indicate the system that we'll not need anymore memory below this value, without indicating it too much
-        if (Buffer_Offset > Buffer_Offset_LowerLimit + 1024 * 1024 && Buffer_Offset < Buffer.Size()) // TODO: when multi-threaded frame decoding is implemented, we need to check that all thread don't need anymore memory below this value 
+        if (Buffer_Offset > Buffer_Offset_LowerLimit + 1024 * 1024 && Buffer_Offset < Buffer.Size())
         {
+            // Tracks decoded in other threads must not use anymore the memory before it is remapped
+            {
+                stats_scope Stats_Wait(stage::Demux, 0, 0, true);
+                trace_scope Trace("remap wait", "demux");
+                for (const auto& TrackInfo_Current : TrackInfo)
+                    if (TrackInfo_Current)
+                        TrackInfo_Current->Wait();
+                if (ContainerHash)
+                    ContainerHash->Wait();
+            }
+
+            trace_scope Trace("remap", "demux", "offset", Buffer_Offset);
             FileMap->Remap();
             Buffer = *FileMap;
+            if (ContainerHash)
+            {
+                // Hashed in parallel of the parsing of the next chunk, until the next remap
+                ContainerHash->Update(Buffer.Data() + ContainerHash_Offset, Buffer_Offset - ContainerHash_Offset);
+                ContainerHash_Offset = Buffer_Offset;
+            }
             for (const auto& TrackInfo_Current : TrackInfo)
                 if (TrackInfo_Current && TrackInfo_Current->ReversibilityData)
                     TrackInfo_Current->ReversibilityData->SetBaseData(Buffer.Data());
@@ -356,6 +411,15 @@ void matroska::ParseBuffer()
         }
     }
 
+    memory::Resize(memory_use::Container, Window_Size, 0);
+
+    // Container hash, including the content not parsed e.g. after a problem
+    if (ContainerHash)
+    {
+        ContainerHash->Update(Buffer.Data() + ContainerHash_Offset, Buffer.Size() - ContainerHash_Offset);
+        ContainerHash->Wait();
+    }
+
     // Progress indicator
     Buffer_Offset = Buffer.Size();
     if (!Quiet)
@@ -431,7 +495,10 @@ void matroska::Segment_Attachments_AttachedFile_FileData()
         TrackInfo_Pos = (size_t)-1;
         for (const auto& TrackInfo_Current : TrackInfo)
             if (TrackInfo_Current && TrackInfo_Current->ReversibilityData)
+            {
+                TrackInfo_Current->Wait();
                 TrackInfo_Current->ReversibilityData->SetBaseData(Buffer.Data());
+            }
 
         return;
     }
@@ -482,12 +549,9 @@ void matroska::Segment_Attachments_AttachedFile_FileData_RawCookedAttachment_Fil
         return; // Not needed
     if (AttachedFile_FileName.empty())
         return; // File name should come first. TODO: support when file name comes after
-    if (Levels[Level].Offset_End - Buffer_Offset != 17 || Buffer[Buffer_Offset] != 0x80)
-        return; // MD5 support only
-    Buffer_Offset++;
-
-    array<uint8_t, 16> Hash;
-    memcpy(Hash.data(), Buffer.Data() + Buffer_Offset, Hash.size());
+    hash_value Hash;
+    if (FileHash(Hash))
+        return; // Unsupported hash format
     Hashes_FromRAWcooked->FromHashFile(AttachedFile_FileName, Hash);
 }
 
@@ -551,14 +615,11 @@ void matroska::Segment_Attachments_AttachedFile_FileData_RawCookedBlock_FileHash
         return; // Not needed
     if (!RAWcooked_FileNameIsValid)
         return; // File name should come first. TODO: support when file name comes after
-    if (Levels[Level].Offset_End - Buffer_Offset != 17 || Buffer[Buffer_Offset] != 0x80)
-        return; // MD5 support only
-    Buffer_Offset++;
+    hash_value Hash;
+    if (FileHash(Hash))
+        return; // Unsupported hash format
 
     track_info* TrackInfo_Current = TrackInfo[TrackInfo_Pos];
-
-    array<uint8_t, 16> Hash;
-    memcpy(Hash.data(), Buffer.Data() + Buffer_Offset, Hash.size());
     Hashes_FromRAWcooked->FromHashFile(TrackInfo_Current->ReversibilityData->Data(reversibility::element::FileName, TrackInfo_Current->ReversibilityData->Count() - 1), Hash);
 }
 
@@ -613,7 +674,11 @@ void matroska::Segment_Attachments_AttachedFile_FileData_RawCookedTrack()
 
     TrackInfo_Pos++;
     if (TrackInfo_Pos >= TrackInfo.size())
+    {
         TrackInfo.push_back(new track_info(FrameWriter_Template, Actions, Errors, FramesPool));
+        if (!Actions[Action_Decode])
+            TrackInfo.back()->CheckLevel = CheckLevel;
+    }
 }
 
 
@@ -624,14 +689,11 @@ void matroska::Segment_Attachments_AttachedFile_FileData_RawCookedTrack_FileHash
         return; // Not needed
     if (!RAWcooked_FileNameIsValid)
         return; // File name should come first. TODO: support when file name comes after
-    if (Levels[Level].Offset_End - Buffer_Offset != 17 || (Buffer[Buffer_Offset] != 0x00 && Buffer[Buffer_Offset] != 0x80)) // Is expected to be EBML encoded but some older version writes only 0x00
-        return; // MD5 support only
-    Buffer_Offset++;
+    hash_value Hash;
+    if (FileHash(Hash))
+        return; // Unsupported hash format
 
     track_info* TrackInfo_Current = TrackInfo[TrackInfo_Pos];
-
-    array<uint8_t, 16> Hash;
-    memcpy(Hash.data(), Buffer.Data() + Buffer_Offset, Hash.size());
     Hashes_FromRAWcooked->FromHashFile(TrackInfo_Current->ReversibilityData->Data(reversibility::element::FileName), Hash);
 }
 
@@ -684,12 +746,26 @@ void matroska::Segment_Cluster()
         }
     }
 
-    if (!Actions[Action_Decode] && !Actions[Action_Check] && !Actions[Action_Conch]) // No file parsing requested, we stop now
+    if (!Actions[Action_Decode] && !Actions[Action_Check] && !Actions[Action_Conch] && FrameMd5FileName.empty()) // No file parsing requested, we stop now
     {
         Buffer_Offset = Buffer.Size();
         return;
     }
 
+    // Frame hashes, from the first FFV1 track
+    if (!FrameMd5FileName.empty() && !FrameHash)
+    {
+        for (const auto& TrackInfo_Current : TrackInfo)
+            if (TrackInfo_Current && TrackInfo_Current->Format_Get() == format::FFV1)
+            {
+                FrameHash = new framehash_md5(FramesPool);
+                FrameHash->SetFrameDuration(TrackInfo_Current->FrameDuration_Get());
+                FrameHash->Open(FrameMd5FileName); // Error is reported by Finish()
+                TrackInfo_Current->SetFrameHash(FrameHash);
+                break;
+            }
+    }
+
     // Init
     for (const auto& TrackInfo_Current : TrackInfo)
         if (TrackInfo_Current && TrackInfo_Current->Init(Buffer.Data()))
@@ -747,7 +823,11 @@ void matroska::Segment_Tracks_TrackEntry()
 
     TrackInfo_Pos++;
     if (TrackInfo_Pos >= TrackInfo.size())
+    {
         TrackInfo.push_back(new track_info(FrameWriter_Template, Actions, Errors, FramesPool));
+        if (!Actions[Action_Decode])
+            TrackInfo.back()->CheckLevel = CheckLevel;
+    }
 }
 
 //---------------------------------------------------------------------------
@@ -770,6 +850,22 @@ void matroska::Segment_Tracks_TrackEntry_CodecPrivate()
     TrackInfo_Current->OutOfBand(Buffer.Data() + Buffer_Offset, Levels[Level].Offset_End - Buffer_Offset);
 }
 
+//---------------------------------------------------------------------------
+void matroska::Segment_Tracks_TrackEntry_DefaultDuration()
+{
+    uint64_t Data = 0;
+    if (Levels[Level].Offset_End - Buffer_Offset <= 8)
+        while (Buffer_Offset < Levels[Level].Offset_End)
+        {
+            Data <<= 8;
+            Data |= Buffer[Buffer_Offset];
+            Buffer_Offset++;
+        }
+
+    track_info* TrackInfo_Current = TrackInfo[TrackInfo_Pos];
+    TrackInfo_Current->SetFrameDuration(Data);
+}
+
 //---------------------------------------------------------------------------
 void matroska::Segment_Tracks_TrackEntry_Video_PixelWidth()
 {
@@ -831,6 +927,7 @@ void matroska::ProgressIndicator_Show()
     steady_clock::time_point Clock_Previous = Clock_Init;
     uint64_t Buffer_Offset_Previous = 0;
     uint64_t Timestamp_Previous = 0;
+    stats::values Stats_Previous;
 
     // Show progress indicator at a specific frequency
     const chrono::seconds Frequency = chrono::seconds(1);
@@ -887,6 +984,14 @@ void matroska::ProgressIndicator_Show()
                 cerr << ", ";
                 ShowRealTime(RealTime);
             }
+            if (stats::IsEnabled())
+            {
+                auto Stats_Current = stats::Values();
+                auto Bottleneck = stats::Bottleneck(Stats_Current, Stats_Previous);
+                if (Bottleneck != (stage)stage_Max)
+                    cerr << ", bottleneck: " << stats::Name(Bottleneck);
+                Stats_Previous = Stats_Current;
+            }
             cerr << "    "; // Clean up in case there is less content outputted than the previous time
 
             ProgressIndicator_Value = ProgressIndicator_New;
@@ -911,6 +1016,12 @@ void matroska::ProgressIndicator_Show()
     {
         ShowRealTime(RealTime);
     }
+    if (stats::IsEnabled())
+    {
+        auto Bottleneck = stats::Bottleneck(stats::Values(), stats::values());
+        if (Bottleneck != (stage)stage_Max)
+            cerr << ", bottleneck: " << stats::Name(Bottleneck);
+    }
     cerr << "                              \n"; // Clean up in case there is less content outputted than the previous time
 }
 
@@ -929,12 +1040,12 @@ bool track_info::ParseDecodedFrame(input_base_uncompressed* Parser)
         auto Post_Offset = FileSize - Post_Size;
         if (Pre_Size >= FileSize || Post_Size >= FileSize || Pre_Size >= Post_Offset)
             return true; // Overlaps detected
-        buffer Frame_Buffer;
-        Frame_Buffer.Create(FileSize); // TODO: more optimal method without allocation of the full file size and without new/delete
-        Frame_Buffer.CopyLimit(RawFrame->Pre());
-        Frame_Buffer.SetZero(Pre_Size, Post_Offset - Pre_Size);
-        Frame_Buffer.CopyLimit(Post_Offset, RawFrame->Post());
-        ParseResult = FrameParser->Parse(Frame_Buffer);
+        if (Frame_Check.Size() != FileSize)
+            Frame_Check.Create(FileSize); // TODO: more optimal method without allocation of the full file size
+        Frame_Check.CopyLimit(RawFrame->Pre());
+        Frame_Check.SetZero(Pre_Size, Post_Offset - Pre_Size);
+        Frame_Check.CopyLimit(Post_Offset, RawFrame->Post());
+        ParseResult = FrameParser->Parse(Frame_Check);
     }
     else
     {
@@ -943,6 +1054,25 @@ bool track_info::ParseDecodedFrame(input_base_uncompressed* Parser)
     return ParseResult;
 }
 
+//---------------------------------------------------------------------------
+bool matroska::FileHash(hash_value& Hash)
+{
+    if (Buffer_Offset >= Levels[Level].Offset_End)
+        return true;
+    auto Code = Buffer[Buffer_Offset];
+    if (!Code)
+        Code = 0x80; // Is expected to be EBML encoded but some older versions write only 0x00 for MD5
+    if (!(Code & 0x80))
+        return true; // Only 1-byte codes are supported
+    auto Format = RAWcooked_HashFormat(Code & 0x7F);
+    auto Size = hash_base::Size(Format);
+    if (!Size || Levels[Level].Offset_End - Buffer_Offset != 1 + Size)
+        return true;
+
+    Hash = hash_value(Format, Buffer.Data() + Buffer_Offset + 1);
+    return false;
+}
+
 //---------------------------------------------------------------------------
 void matroska::Uncompress(buffer& Output)
 {
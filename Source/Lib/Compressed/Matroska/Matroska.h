@@ -16,6 +16,8 @@
 #include "Lib/CoDec/FFV1/FFV1_Frame.h"
 #include "Lib/Utils/FileIO/Input_Base.h"
 #include "Lib/Utils/FileIO/FileIO.h"
+#include "Lib/Utils/Hash/Hash.h"
+#include <atomic>
 #include <bitset>
 #include <cstdint>
 #include <map>
@@ -34,6 +36,11 @@ namespace matroska_issue
 class matroska;
 class matroska_mapping;
 class ThreadPool;
+class async_writer;
+class durable_writes;
+class framehash_md5;
+class stream_hash;
+class journal;
 class hashes;
 class track_info;
 class frame_writer;
@@ -50,6 +57,14 @@ public:
     bool                        NoOutputCheck = false;
     hashes*                     Hashes_FromRAWcooked = nullptr;
     hashes*                     Hashes_FromAttachments = nullptr;
+    async_writer*               Writer = nullptr; // Write-behind of whole files, nullptr if files are written synchronously
+    durable_writes*             Durable = nullptr; // Flush of written files to stable storage, nullptr if not requested
+    journal*                    Journal = nullptr; // Complete output files, for resuming an interrupted decoding
+    stream_hash*                ContainerHash = nullptr; // Hash of the whole file, computed while it is parsed
+    atomic<size_t>              Complete_Count{ 0 }; // Count of output files already complete, not decoded again
+    check_level                 CheckLevel = check_level::Decode; // Used only if output is not written
+    string                      FrameMd5FileName; // framemd5 of the first FFV1 video track is computed if not empty
+    bool                        FrameMd5_IsError = false;
 
     // Theading relating functions
     void                        ProgressIndicator_Show();
@@ -139,6 +154,7 @@ private:
     MATROSKA_ELEMENT(Segment_Tracks_TrackEntry);
     MATROSKA_ELEMENT(Segment_Tracks_TrackEntry_CodecID);
     MATROSKA_ELEMENT(Segment_Tracks_TrackEntry_CodecPrivate);
+    MATROSKA_ELEMENT(Segment_Tracks_TrackEntry_DefaultDuration);
     MATROSKA_ELEMENT(Segment_Tracks_TrackEntry_Video);
     MATROSKA_ELEMENT(Segment_Tracks_TrackEntry_Video_PixelWidth);
     MATROSKA_ELEMENT(Segment_Tracks_TrackEntry_Video_PixelHeight);
@@ -172,6 +188,7 @@ private:
     };
     reversibility_compat        ReversibilityCompat = Compat_Modern;
     ThreadPool*                 FramesPool = nullptr;
+    framehash_md5*              FrameHash = nullptr;
     frame_writer*               FrameWriter_Template;
     bool                        RAWcooked_FileNameIsValid;
     uint64_t                    Cluster_Timestamp;
@@ -179,6 +196,7 @@ private:
 
     //Utils
     void                        Uncompress(buffer& Buffer);
+    bool                        FileHash(hash_value& Hash); // Hash with its format code from reversibility data, true if not supported
     void                        Segment_Attachments_AttachedFile_FileData_RawCookedxxx_yyy(reversibility::element Element, type Type);
     void                        StoreFromCurrentToEndOfElement(buffer& Output);
     void                        RejectIncompatibleVersions();
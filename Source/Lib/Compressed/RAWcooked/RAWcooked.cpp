@@ -7,6 +7,7 @@
 //---------------------------------------------------------------------------
 #include "Lib/Compressed/RAWcooked/RAWcooked.h"
 #include "Lib/Config.h"
+#include "Lib/Utils/Stats/Stats.h"
 #include "zlib.h"
 #include <algorithm>
 #include <cstring>
@@ -62,8 +63,36 @@ static const uint8_t DocTypeReadVersion = 1;
 enum hashformat
 {
     HashFormat_MD5,
+    HashFormat_XXH3_128,
+    HashFormat_BLAKE3,
+    HashFormat_SHA256,
 };
 
+//---------------------------------------------------------------------------
+uint64_t RAWcooked_HashFormat_Code(hash_format Format)
+{
+    switch (Format)
+    {
+        case hash_format::XXH3_128: return HashFormat_XXH3_128;
+        case hash_format::BLAKE3: return HashFormat_BLAKE3;
+        case hash_format::SHA256: return HashFormat_SHA256;
+        default: return HashFormat_MD5;
+    }
+}
+
+//---------------------------------------------------------------------------
+hash_format RAWcooked_HashFormat(uint64_t Code)
+{
+    switch (Code)
+    {
+        case HashFormat_MD5: return hash_format::MD5;
+        case HashFormat_XXH3_128: return hash_format::XXH3_128;
+        case HashFormat_BLAKE3: return hash_format::BLAKE3;
+        case HashFormat_SHA256: return hash_format::SHA256;
+        default: return hash_format::None;
+    }
+}
+
 //---------------------------------------------------------------------------
 static size_t Size_EB(uint64_t Value)
 {
@@ -331,8 +360,9 @@ void ebml_writer::Set2ndPass()
     reverse(BlockSizes.begin(), BlockSizes.end()); // We'll decrement size for keeping track about where we are
     if (Buffer_Offset > Buffer_MaxSize)
     {
-        delete[] Buffer;
-        Buffer = new uint8_t[Buffer_Offset];
+        memory_scope Memory(memory_use::Reversibility);
+        memory::Free(Buffer);
+        Buffer = memory::Allocate(Buffer_Offset);
         Buffer_MaxSize = Buffer_Offset;
     }
     Buffer_PreviousOffset = 0;
@@ -355,7 +385,7 @@ size_t ebml_writer::GetBufferSize()
 //---------------------------------------------------------------------------
 ebml_writer::~ebml_writer()
 {
-    delete[] Buffer;
+    memory::Free(Buffer);
 }
 
 //---------------------------------------------------------------------------
@@ -427,6 +457,9 @@ rawcooked::~rawcooked()
 //---------------------------------------------------------------------------
 void rawcooked::Parse()
 {
+    stats_scope Stats(stage::Reversibility, 0, 1);
+    memory_scope Memory(memory_use::Reversibility);
+
     // Cross-platform support
     // RAWcooked file format supports setting of the path separator but
     // we currently set all to "/", which is supported by both Windows and Unix based platforms
@@ -506,7 +539,7 @@ void rawcooked::Parse()
         Writer.CompressableData(Data_->IsUsingMask(element::After) ? Name_RawCooked_MaskAdditionAfterData : Name_RawCooked_AfterData, Data_->Compressed(element::After));
         Writer.CompressableData(Name_RawCooked_InData, Data_->Compressed(element::In));
         if (HashValue)
-            Writer.DataWithEncodedPrefix(Name_RawCooked_FileHash, HashFormat_MD5, buffer_view(HashValue->data(), HashValue->size()));
+            Writer.DataWithEncodedPrefix(Name_RawCooked_FileHash, RAWcooked_HashFormat_Code(HashValue->Format), buffer_view(HashValue->Data.data(), HashValue->Size()));
         if (FileSize != (uint64_t)-1)
             Writer.Number(Name_RawCooked_FileSize, FileSize);
         Writer.Block_End();
@@ -11,6 +11,7 @@
 
 //---------------------------------------------------------------------------
 #include "Lib/Compressed/RAWcooked/IntermediateWrite.h"
+#include "Lib/Utils/Hash/Hash.h"
 #include <condition_variable>
 #include <cstdint>
 #include <cstddef>
@@ -35,7 +36,7 @@ public:
     const uint8_t*              InData = nullptr;
     uint64_t                    InData_Size = 0;
 
-    md5*                        HashValue = nullptr;
+    hash_value*                 HashValue = nullptr;
     bool                        IsAttachment = false;
 
     void                        Parse();
@@ -50,5 +51,10 @@ private:
     private_data* const          Data_;
 };
 
+//---------------------------------------------------------------------------
+// Hash format code stored before the file hash in reversibility data
+uint64_t RAWcooked_HashFormat_Code(hash_format Format);
+hash_format RAWcooked_HashFormat(uint64_t Code); // None if unknown
+
 //---------------------------------------------------------------------------
 #endif
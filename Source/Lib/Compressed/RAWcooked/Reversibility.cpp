@@ -47,10 +47,9 @@ using namespace reversibility_issue;
 // Compressed file can holds directory traversal filenames (e.g. ../../evil.sh)
 // Not created by the encoder, but a malevolent person could craft such file
 // https://snyk.io/research/zip-slip-vulnerability
-static void SanitizeFileName(buffer& FileName)
+// IsBegin is false when FileName_Data continues a prefix ending with a path separator
+static void SanitizeFileName(uint8_t* FileName_Data, size_t& FileName_Size, bool IsBegin = true)
 {
-    auto FileName_Size = FileName.Size();
-    auto FileName_Data = FileName.Data();
 
     // Replace illegal characters (on the target platform) by underscore
     // Note: the output is not exactly as the source content and information about the exact source file name is lost, this is a limitation of the target platform impossible to bypass
@@ -68,7 +67,7 @@ static void SanitizeFileName(buffer& FileName)
 #endif
 
     // Trash leading path separator (used for absolute file names) ("///foo/bar" becomes "foo/bar")
-    while (FileName_Size && FileName_Data[0] == PathSeparator)
+    while (IsBegin && FileName_Size && FileName_Data[0] == PathSeparator)
     {
         FileName_Size--;
         memmove(FileName_Data, FileName_Data + 1, FileName_Size);
@@ -93,16 +92,24 @@ static void SanitizeFileName(buffer& FileName)
 }
 
 //---------------------------------------------------------------------------
-static bool Uncompress(const buffer_view& In, buffer& Out)
+static void SanitizeFileName(buffer& FileName)
+{
+    auto FileName_Size = FileName.Size();
+    SanitizeFileName(FileName.Data(), FileName_Size);
+    FileName.Resize(FileName_Size);
+}
+
+//---------------------------------------------------------------------------
+// Out is created only if it is too small, Out_Size receives the size of the content
+// Stream is a zlib stream reused between calls (no allocation), uncompress() is used if it is not provided
+static bool Uncompress(const buffer_view& In, buffer& Out, size_t& Out_Size, z_stream* Stream)
 {
     // Size in EBML style
     auto Data = In.Data();
     auto Size = In.Size();
+    Out_Size = 0;
     if (!Size)
-    {
-        Out.Clear();
         return false;
-    }
     decltype(Size) Offset = 0;
     uint64_t UncompressedSize = Data[0];
     if (!UncompressedSize)
@@ -123,24 +130,66 @@ static bool Uncompress(const buffer_view& In, buffer& Out)
     Offset++;
 
     // Read buffer
+    memory_scope Memory(memory_use::Reversibility);
     if (UncompressedSize)
     {
         // Uncompressed
-        Out.Create(UncompressedSize);
+        if (Out.Size() < UncompressedSize)
+            Out.Create(UncompressedSize);
 
-        uLongf t = (uLongf)UncompressedSize;
-        if (uncompress((Bytef*)Out.Data(), &t, (const Bytef*)Data + Offset, (uLong)(Size - Offset)) < 0 || t != UncompressedSize)
-            return true; // Problem
+        if (Stream)
+        {
+            if (inflateReset(Stream) != Z_OK)
+                return true; // Problem
+            Stream->next_in = (Bytef*)Data + Offset;
+            Stream->avail_in = (uInt)(Size - Offset);
+            Stream->next_out = (Bytef*)Out.Data();
+            Stream->avail_out = (uInt)UncompressedSize;
+            if (inflate(Stream, Z_FINISH) != Z_STREAM_END || Stream->avail_out)
+                return true; // Problem
+        }
+        else
+        {
+            uLongf t = (uLongf)UncompressedSize;
+            if (uncompress((Bytef*)Out.Data(), &t, (const Bytef*)Data + Offset, (uLong)(Size - Offset)) < 0 || t != UncompressedSize)
+                return true; // Problem
+        }
+        Out_Size = (size_t)UncompressedSize;
     }
     else
     {
         // Not compressed
-        Out.Create(Data + Offset, Size - Offset);
+        Out_Size = Size - Offset;
+        if (Out.Size() < Out_Size)
+            Out.Create(Out_Size);
+        memcpy(Out.Data(), Data + Offset, Out_Size);
     }
 
     return false;
 }
 
+//---------------------------------------------------------------------------
+static bool Uncompress(const buffer_view& In, buffer& Out)
+{
+    size_t Out_Size;
+    auto Result = Uncompress(In, Out, Out_Size, nullptr);
+    if (!Out_Size)
+        Out.Clear();
+    else if (Out.Size() != Out_Size)
+        Out.Resize(Out_Size);
+    return Result;
+}
+
+//---------------------------------------------------------------------------
+reversibility::~reversibility()
+{
+    if (Stream_)
+    {
+        inflateEnd(Stream_);
+        delete Stream_;
+    }
+}
+
 //---------------------------------------------------------------------------
 void reversibility::NewFrame()
 {
@@ -244,28 +293,89 @@ buffer reversibility::Data(element Element, size_t Pos) const
     return Data.Data(BaseData_, Pos);
 }
 
+//---------------------------------------------------------------------------
+buffer_view reversibility::View(element Element)
+{
+    const auto ElementS = (size_t)Element;
+    if (ElementS >= element_Max)
+        return buffer_view();
+
+    // zlib state is created once, then reset for each element
+    if (!Stream_)
+    {
+        Stream_ = new z_stream;
+        memset(Stream_, 0, sizeof(z_stream));
+        if (inflateInit(Stream_) != Z_OK)
+        {
+            delete Stream_;
+            Stream_ = nullptr;
+        }
+    }
+
+    auto& Scratch = Scratch_[ElementS];
+    auto Size = Data_[ElementS].Data(BaseData_, Pos_, Scratch, Stream_);
+
+    if (Element == element::FileName)
+        SanitizeFileName_Cached(Scratch.Data(), Size);
+
+    return buffer_view(Scratch.Data(), Size);
+}
+
+//---------------------------------------------------------------------------
+// File names in a sequence share their directory, only the part after the cached directory is sanitized
+void reversibility::SanitizeFileName_Cached(uint8_t* FileName_Data, size_t& FileName_Size)
+{
+    auto Prefix_Size = FileNamePrefix_Size_;
+    if (Prefix_Size
+     && FileName_Size >= Prefix_Size
+     && !(FileName_Size - Prefix_Size == 2 && FileName_Data[Prefix_Size] == '.' && FileName_Data[Prefix_Size + 1] == '.') // Trailing directory traversal also removes the path separator in the prefix
+     && !memcmp(FileName_Data, FileNamePrefix_.Data(), Prefix_Size))
+    {
+        auto Remaining_Size = FileName_Size - Prefix_Size;
+        SanitizeFileName(FileName_Data + Prefix_Size, Remaining_Size, false);
+        FileName_Size = Prefix_Size + Remaining_Size;
+        return;
+    }
+
+    // New directory, it is cached only if sanitization does not modify it
+    FileNamePrefix_Size_ = 0;
+    Prefix_Size = FileName_Size;
+    while (Prefix_Size && FileName_Data[Prefix_Size - 1] != PathSeparator)
+        Prefix_Size--;
+    if (Prefix_Size)
+    {
+        if (FileNamePrefix_.Size() < Prefix_Size)
+        {
+            memory_scope Memory(memory_use::Reversibility);
+            FileNamePrefix_.Create(Prefix_Size);
+        }
+        memcpy(FileNamePrefix_.Data(), FileName_Data, Prefix_Size);
+        auto Prefix_Sanitized_Size = Prefix_Size;
+        SanitizeFileName(FileNamePrefix_.Data(), Prefix_Sanitized_Size);
+        if (Prefix_Sanitized_Size == Prefix_Size && !memcmp(FileNamePrefix_.Data(), FileName_Data, Prefix_Size))
+            FileNamePrefix_Size_ = Prefix_Size;
+    }
+    SanitizeFileName(FileName_Data, FileName_Size);
+}
+
 //---------------------------------------------------------------------------
 void reversibility::SetFileSize(uint64_t Value)
 {
-    FileSize_.SetData(Pos_, Value);
+    filesize Entry;
+    Entry.Value = Value;
+    FileSize_.Set(Pos_, Entry);
 }
 
 //---------------------------------------------------------------------------
 uint64_t reversibility::FileSize() const
 {
-    return FileSize_.Data(Pos_);
+    return FileSize_.Get(Pos_).Value;
 }
 
 //---------------------------------------------------------------------------
-reversibility::data::~data()
+uint64_t reversibility::FileSize(size_t Pos) const
 {
-    // Note about the memory model:
-    // In order to speed up a bit the memory management, we avoid the buffer constructor
-    // so we need to manually call the destructor here.
-    // Check also SetData().
-    //for (size_t i = 0; i < MaxCount_; i++)
-    //    Content_[i].Clear();
-    delete[](uint8_t*)Content_;
+    return FileSize_.Get(Pos).Value;
 }
 
 //---------------------------------------------------------------------------
@@ -277,112 +387,209 @@ void reversibility::data::SetDataMask(const buffer_view& Buffer)
 //---------------------------------------------------------------------------
 void reversibility::data::SetData(size_t Pos, size_t Offset, size_t Size, bool AddMask)
 {
-    if (Pos >= MaxCount_)
-    {
-        // Note about the memory model:
-        // In order to speed up a bit the memory management, we avoid the buffer constructor
-        // and set all to 0 manually.
-        // Check also the destructor.
-        if (!MaxCount_ && !Pos)
-        {
-            MaxCount_ = 1;
-            const auto NewSizeInBytes = sizeof(std::remove_pointer<decltype(Content_)>::type);
-            Content_ = (decltype(Content_))new uint8_t[NewSizeInBytes];
-            memset((uint8_t*)Content_, 0, NewSizeInBytes);
-        }
-        else
-        {
-            auto NewMaxCount = MaxCount_;
-            if (!NewMaxCount)
-                NewMaxCount = 1;
-            while (Pos >= NewMaxCount)
-                NewMaxCount *= 4;
-            auto NewSizeInBytes = NewMaxCount * sizeof(std::remove_pointer<decltype(Content_)>::type);
-            auto NewContent = (decltype(Content_))new uint8_t[NewSizeInBytes];
-            size_t OldSizeInBytes;
-            if (Content_)
-            {
-                OldSizeInBytes = MaxCount_ * sizeof(std::remove_pointer<decltype(Content_)>::type);
-                NewSizeInBytes -= OldSizeInBytes;
-                memcpy((uint8_t*)NewContent, Content_, OldSizeInBytes);
-                delete[](uint8_t*)Content_;
-            }
-            else
-                OldSizeInBytes = 0;
-            memset((uint8_t*)NewContent + OldSizeInBytes, 0, NewSizeInBytes);
-            Content_ = NewContent;
-            MaxCount_ = NewMaxCount;
-        }
-    }
-
-    Content_[Pos].Offset = Offset;
-    Content_[Pos].Size = Size;
-    Content_[Pos].AddMask = AddMask;
+    entry Entry;
+    Entry.Offset = Offset;
+    Entry.Size = Size;
+    Entry.AddMask = AddMask;
+    Content_.Set(Pos, Entry);
 }
 
 //---------------------------------------------------------------------------
 buffer reversibility::data::Data(const uint8_t* BaseData, size_t Pos) const
 {
-    // Uncompress
     buffer Content;
-    if (Pos >= MaxCount_ || !BaseData || Uncompress(buffer_view(BaseData + Content_[Pos].Offset, Content_[Pos].Size), Content))
-        return Content;
+    auto Content_Size = Data(BaseData, Pos, Content, nullptr);
+    if (!Content_Size)
+        Content.Clear();
+    else if (Content.Size() != Content_Size)
+        Content.Resize(Content_Size);
+    return Content;
+}
+
+//---------------------------------------------------------------------------
+size_t reversibility::data::Data(const uint8_t* BaseData, size_t Pos, buffer& Content, z_stream_s* Stream) const
+{
+    // Uncompress
+    if (!BaseData)
+        return 0;
+    auto Entry = Content_.Get(Pos);
+    if (!Entry.Size)
+        return 0;
+    size_t Content_Size;
+    if (Uncompress(buffer_view(BaseData + (size_t)Entry.Offset, (size_t)Entry.Size), Content, Content_Size, Stream))
+        return Content_Size;
 
     // Add mask
-    if (Content_[Pos].AddMask)
+    if (Entry.AddMask)
     {
         auto Mask_Size = Mask_.Size();
         auto Mask_Data = Mask_.Data();
-        auto Content_Size = Content.Size();
         auto Content_Data = Content.Data();
         for (size_t i = 0; i < Content_Size && i < Mask_Size; i++)
             Content_Data[i] += Mask_Data[i];
     }
 
-    return Content;
+    return Content_Size;
 }
 
+//***************************************************************************
+// Compact list
+//***************************************************************************
+
 //---------------------------------------------------------------------------
-reversibility::filesize::~filesize()
+// Unsigned LEB128
+static void Varint_Write(vector<uint8_t>& Stream, uint64_t Value)
 {
-    delete[] Content_;
+    while (Value >= 0x80)
+    {
+        Stream.push_back((uint8_t)(Value | 0x80));
+        Value >>= 7;
+    }
+    Stream.push_back((uint8_t)Value);
 }
 
 //---------------------------------------------------------------------------
-void reversibility::filesize::SetData(size_t Pos, uint64_t Value)
+static uint64_t Varint_Read(const uint8_t*& Stream)
 {
-    if (Pos >= MaxCount_)
+    uint64_t Value = 0;
+    int Shift = 0;
+    uint8_t Byte;
+    do
     {
-        if (!MaxCount_ && !Pos)
-        {
-            MaxCount_ = 1;
-            Content_ = new std::remove_pointer<decltype(Content_)>::type[1];
-            *Content_ = (std::remove_pointer<decltype(Content_)>::type)0;
-        }
-        else
+        Byte = *Stream++;
+        Value |= ((uint64_t)(Byte & 0x7F)) << Shift;
+        Shift += 7;
+    }
+    while (Byte & 0x80);
+    return Value;
+}
+
+//---------------------------------------------------------------------------
+// Signed deltas, small absolute values are stored in small unsigned values
+static uint64_t ZigZag_Encode(uint64_t Delta)
+{
+    return (Delta << 1) ^ (uint64_t)((int64_t)Delta >> 63);
+}
+static uint64_t ZigZag_Decode(uint64_t Value)
+{
+    return (Value >> 1) ^ (uint64_t)-(int64_t)(Value & 1);
+}
+
+//---------------------------------------------------------------------------
+// Element: size and mask flag, then offset relative to the end of the previous element if not empty
+// Elements of a frame are usually close to the same element of the previous frame
+void reversibility::data::entry::Write(vector<uint8_t>& Stream, entry& Previous) const
+{
+    Varint_Write(Stream, (Size << 1) | (AddMask ? 1 : 0));
+    if (!Size && !AddMask)
+        return;
+    Varint_Write(Stream, ZigZag_Encode(Offset - (Previous.Offset + Previous.Size)));
+    Previous = *this;
+}
+
+//---------------------------------------------------------------------------
+void reversibility::data::entry::Read(const uint8_t*& Stream, entry& Previous)
+{
+    auto Value = Varint_Read(Stream);
+    Size = Value >> 1;
+    AddMask = Value & 1;
+    if (!Size && !AddMask)
+    {
+        Offset = 0;
+        return;
+    }
+    Offset = Previous.Offset + Previous.Size + ZigZag_Decode(Varint_Read(Stream));
+    Previous = *this;
+}
+
+//---------------------------------------------------------------------------
+// File size: relative to the previous file size, files of a sequence have usually the same size
+void reversibility::filesize::Write(vector<uint8_t>& Stream, filesize& Previous) const
+{
+    Varint_Write(Stream, ZigZag_Encode(Value - Previous.Value));
+    Previous = *this;
+}
+
+//---------------------------------------------------------------------------
+void reversibility::filesize::Read(const uint8_t*& Stream, filesize& Previous)
+{
+    Value = Previous.Value + ZigZag_Decode(Varint_Read(Stream));
+    Previous = *this;
+}
+
+//---------------------------------------------------------------------------
+static const size_t CompactList_CheckpointStep = 256;
+
+//---------------------------------------------------------------------------
+template<class entry>
+void reversibility::compact_list<entry>::Set(size_t Pos, const entry& Value)
+{
+    if (Last_Pos_ != (size_t)-1 && Pos < Last_Pos_)
+        return; // Only the last entry can be modified
+
+    if (Pos != Last_Pos_)
+    {
+        Commit();
+
+        // Missing entries are empty
+        while (Count_ < Pos)
         {
-            auto OldMaxCount = MaxCount_;
-            if (!MaxCount_)
-                MaxCount_ = 1;
-            while (Pos >= MaxCount_)
-                MaxCount_ *= 4;
-            auto NewContent = new std::remove_pointer<decltype(Content_)>::type[MaxCount_];
-            if (OldMaxCount)
-            {
-                memcpy(NewContent, Content_, OldMaxCount * sizeof(std::remove_pointer<decltype(Content_)>::type));
-                delete[] Content_;
-            }
-            Content_ = NewContent;
+            Last_ = entry();
+            Last_Pos_ = Count_;
+            Commit();
         }
     }
 
-    Content_[Pos] = Value;
+    Last_ = Value;
+    Last_Pos_ = Pos;
 }
 
 //---------------------------------------------------------------------------
-uint64_t reversibility::filesize::Data(size_t Pos) const
+template<class entry>
+void reversibility::compact_list<entry>::Commit()
 {
-    if (Pos >= MaxCount_)
-        return 0;
-    return Content_[Pos];
+    if (Last_Pos_ == (size_t)-1 || Last_Pos_ < Count_)
+        return;
+
+    if (Count_ % CompactList_CheckpointStep == 0)
+    {
+        checkpoint Checkpoint;
+        Checkpoint.Stream_Pos = Stream_.size();
+        Checkpoint.Previous = Previous_;
+        Checkpoints_.push_back(Checkpoint);
+    }
+    Last_.Write(Stream_, Previous_);
+    Count_++;
+}
+
+//---------------------------------------------------------------------------
+template<class entry>
+entry reversibility::compact_list<entry>::Get(size_t Pos) const
+{
+    if (Pos == Last_Pos_)
+        return Last_;
+    if (Pos >= Count_)
+        return entry();
+
+    // Sequential reading from the cursor if it is not farther than the checkpoint
+    if (Cursor_Pos_ > Pos || Pos - Cursor_Pos_ > Pos % CompactList_CheckpointStep)
+    {
+        const auto& Checkpoint = Checkpoints_[Pos / CompactList_CheckpointStep];
+        Cursor_Pos_ = Pos - Pos % CompactList_CheckpointStep;
+        Cursor_Stream_Pos_ = Checkpoint.Stream_Pos;
+        Cursor_Previous_ = Checkpoint.Previous;
+    }
+
+    auto Stream_Begin = Stream_.data();
+    auto Stream = Stream_Begin + Cursor_Stream_Pos_;
+    entry Value;
+    for (;;)
+    {
+        Value.Read(Stream, Cursor_Previous_);
+        if (Cursor_Pos_++ == Pos)
+            break;
+    }
+    Cursor_Stream_Pos_ = Stream - Stream_Begin;
+
+    return Value;
 }
@@ -11,6 +11,8 @@
 
 //---------------------------------------------------------------------------
 #include "Lib/Utils/Buffer/Buffer.h"
+#include <vector>
+struct z_stream_s;
 //---------------------------------------------------------------------------
 
 //---------------------------------------------------------------------------
@@ -25,6 +27,10 @@ public:
         InData,
     ENUM_END(element)
 
+    // Constructor/Destructor
+    reversibility() = default;
+    ~reversibility();
+
     // Actions - Storing
     void                        SetBaseData(const uint8_t* BaseData);
     void                        SetUnique();
@@ -40,6 +46,7 @@ public:
     // Data
     buffer                      Data(element Element) const;
     buffer                      Data(element Element, size_t Pos) const;
+    buffer_view                 View(element Element); // Content at the current position, valid until the next call with the same element, memory is reused between frames
 
     // Info
     bool                        Unique() const;
@@ -48,52 +55,89 @@ public:
     size_t                      RemainingCount() const;
     size_t                      ExtraCount() const;
     uint64_t                    FileSize() const;
+    uint64_t                    FileSize(size_t Pos) const;
 
 private:
-    struct data
+    // Compact list of entries, for multi-million frame content
+    // Entries are stored as variable length deltas from the previous entry, with a checkpoint every 256 entries for random access
+    // The last entry is kept apart until an entry is set at another position, it can be set again
+    template<class entry>
+    class compact_list
     {
-        ~data();
+    public:
+        // Set
+        void                    Set(size_t Pos, const entry& Value);
+
+        // Get
+        entry                   Get(size_t Pos) const;
+
+    private:
+        void                    Commit();
 
+        struct checkpoint
+        {
+            size_t              Stream_Pos;
+            entry               Previous;
+        };
+        vector<uint8_t>         Stream_;
+        vector<checkpoint>      Checkpoints_;
+        size_t                  Count_ = 0;
+        entry                   Previous_;
+        entry                   Last_;
+        size_t                  Last_Pos_ = (size_t)-1;
+
+        // Sequential reading
+        mutable size_t          Cursor_Pos_ = (size_t)-1;
+        mutable size_t          Cursor_Stream_Pos_ = 0;
+        mutable entry           Cursor_Previous_;
+    };
+
+    struct data
+    {
         // Set
         void                    SetDataMask(const buffer_view& Buffer);
         void                    SetData(size_t Pos, size_t Offset, size_t Size, bool AddMask);
 
         // Get
         buffer                  Data(const uint8_t* BaseData, size_t Pos) const;
+        size_t                  Data(const uint8_t* BaseData, size_t Pos, buffer& Content, z_stream_s* Stream) const; // Content is created only if it is too small, returns the size of the content
 
-    private:
-        buffer                  Mask_;
-        struct offset_size
+        struct entry
         {
-            size_t              Offset;
-            size_t              Size;
-            bool                AddMask;
+            uint64_t            Offset = 0;
+            uint64_t            Size = 0;
+            bool                AddMask = false;
+
+            void                Write(vector<uint8_t>& Stream, entry& Previous) const;
+            void                Read(const uint8_t*& Stream, entry& Previous);
         };
-        offset_size*            Content_;
-        size_t                  MaxCount_ = 0;
+
+    private:
+        buffer                  Mask_;
+        compact_list<entry>     Content_;
     };
     data                        Data_[element_Max];
 
     struct filesize
     {
-        ~filesize();
+        uint64_t                Value = 0;
 
-        // Set
-        void                    SetData(size_t Pos, uint64_t Value);
-
-        // Get
-        uint64_t                Data(size_t Pos) const;
-
-    private:
-        uint64_t*               Content_ = nullptr;
-        size_t                  MaxCount_ = 0;
+        void                    Write(vector<uint8_t>& Stream, filesize& Previous) const;
+        void                    Read(const uint8_t*& Stream, filesize& Previous);
     };
-    filesize                    FileSize_;
+    compact_list<filesize>      FileSize_;
 
     size_t                      Pos_ = 0;
     size_t                      Count_ = 0;
     const uint8_t*              BaseData_ = nullptr;
     bool                        Unique_ = false;
+
+    // Decoding of the current frame without allocation in steady state
+    void                        SanitizeFileName_Cached(uint8_t* FileName_Data, size_t& FileName_Size);
+    buffer                      Scratch_[element_Max]; // Size is the capacity
+    buffer                      FileNamePrefix_; // Last directory, not modified by sanitization
+    size_t                      FileNamePrefix_Size_ = 0;
+    z_stream_s*                 Stream_ = nullptr;
 };
 
 #endif
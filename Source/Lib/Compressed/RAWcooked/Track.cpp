@@ -9,12 +9,22 @@
 #include "Lib/CoDec/Wrapper.h"
 #include "Lib/Utils/FileIO/FileWriter.h"
 #include "Lib/Utils/FileIO/FileChecker.h"
+#include "Lib/Utils/FileIO/FileVerifier.h"
 #include "Lib/Compressed/RAWcooked/Reversibility.h"
 #include "Lib/Uncompressed/DPX/DPX.h"
 #include "Lib/Uncompressed/TIFF/TIFF.h"
 #include "Lib/Uncompressed/EXR/EXR.h"
 #include "Lib/Uncompressed/WAV/WAV.h"
 #include "Lib/Uncompressed/AIFF/AIFF.h"
+#include <random>
+#ifdef __GNUC__
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wreorder"
+#endif
+#include "ThreadPool.h"
+#ifdef __GNUC__
+#pragma GCC diagnostic pop
+#endif
 //---------------------------------------------------------------------------
 
 //---------------------------------------------------------------------------
@@ -47,6 +57,7 @@ bool track_info::Init(const uint8_t* BaseData)
         auto Wrapper2 = (video_wrapper*)Wrapper;
         Wrapper2->SetWidth(Width);
         Wrapper2->SetHeight(Height);
+        Wrapper2->SetFrameHash(FrameHash);
         DecodedFrameParser = Parser; // Used for each frame
         break;
     }
@@ -56,6 +67,8 @@ bool track_info::Init(const uint8_t* BaseData)
         auto Parser2 = (input_base_uncompressed_audio*)Parser;
         Wrapper2->SetEndianness(Parser2->Endianness());
         Wrapper2->SetOutputBitDepth(Parser2->BitDepth());
+        if (ReversibilityData->Unique())
+            Wrapper2->SetPool(Pool); // Output data is not changed per frame, frames can be decoded out of order
         delete Parser; // No more used
         break;
     }
@@ -64,6 +77,14 @@ bool track_info::Init(const uint8_t* BaseData)
 
     RawFrame->SetPost(buffer_or_view());
 
+    // Stratified sample, another subset of frames is checked at each run
+    if (CheckLevel == check_level::Sample)
+        Sample_Offset = random_device{}() % CheckLevel_SampleStep;
+
+    // Existing output files, compared with hashes from reversibility data
+    if (!ReversibilityData->Unique() && Wrapper->IsIntraOnly() && !FrameHash)
+        Verifier = FrameWriter->NewVerifier(Pool, ReversibilityData);
+
     if (ReversibilityData->Unique())
     {
         FrameWriter->OutputFileName = ReversibilityData->Data(reversibility::element::FileName);
@@ -80,30 +101,107 @@ bool track_info::Init(const uint8_t* BaseData)
 //---------------------------------------------------------------------------
 bool track_info::Process(const uint8_t* Data, size_t Size)
 {
+    // Audio frames are decoded and written by the pool while demux and video decoding continue
+    // Video frames are kept in this thread, FFV1 slices are already dispatched to the pool
+    if (Pool && Wrapper && FormatKind(Format) == format_kind::audio)
+    {
+        lock_guard<mutex> Lock(Queue_Mutex);
+        Queue.emplace_back(Data, Size);
+        if (!Queue_IsRunning)
+        {
+            Queue_IsRunning = true;
+            Pool->submit([this]() { Queue_Run(); });
+        }
+        return false;
+    }
+
+    ProcessFrame(Data, Size);
+    return false;
+}
+
+//---------------------------------------------------------------------------
+void track_info::Queue_Run()
+{
+    unique_lock<mutex> Lock(Queue_Mutex);
+    while (!Queue.empty())
+    {
+        buffer_view Frame = Queue.front();
+        Lock.unlock();
+        ProcessFrame(Frame.Data(), Frame.Size());
+        Lock.lock();
+        Queue.pop_front();
+    }
+    Queue_IsRunning = false;
+    Queue_IsEmpty.notify_all();
+}
+
+//---------------------------------------------------------------------------
+void track_info::Wait()
+{
+    unique_lock<mutex> Lock(Queue_Mutex);
+    Queue_IsEmpty.wait(Lock, [this] { return !Queue_IsRunning; });
+    Lock.unlock();
+    if (Wrapper)
+        Wrapper->Wait();
+}
+
+//---------------------------------------------------------------------------
+void track_info::ProcessFrame(const uint8_t* Data, size_t Size)
+{
+    buffer_view Frame_Pre, Frame_Post;
     if (!ReversibilityData->Unique())
     {
-        RawFrame->SetPre(ReversibilityData->Data(reversibility::element::BeforeData));
-        RawFrame->SetPost(ReversibilityData->Data(reversibility::element::AfterData));
-        RawFrame->SetIn(ReversibilityData->Data(reversibility::element::InData));
-        FrameWriter->OutputFileName = ReversibilityData->Data(reversibility::element::FileName);
+        Frame_Pre = ReversibilityData->View(reversibility::element::BeforeData);
+        Frame_Post = ReversibilityData->View(reversibility::element::AfterData);
+        auto Frame_FileName = ReversibilityData->View(reversibility::element::FileName);
+        RawFrame->SetPre(buffer_or_view(Frame_Pre));
+        RawFrame->SetPost(buffer_or_view(Frame_Post));
+        RawFrame->SetIn(buffer_or_view(ReversibilityData->View(reversibility::element::InData)));
+        FrameWriter->OutputFileName.assign((const char*)Frame_FileName.Data(), Frame_FileName.Size());
         FormatPath(FrameWriter->OutputFileName);
         if (FrameWriter->OutputFileName.empty() && ReversibilityData->Count())
             Undecodable(reversibility_issue::undecodable::ReversibilityData_FrameCount);
     }
     if (Wrapper)
-        Wrapper->Process(Data, Size);
+    {
+        if (!IsDecoded())
+        {
+            // Only checksums are checked
+            if (Wrapper->Check(Data, Size) && Errors)
+                Errors->Error(IO_FileChecker, error::type::Undecodable, (error::generic::code)filechecker_issue::undecodable::Frame_Checksum, FrameWriter->OutputFileName);
+            if (!ReversibilityData->Unique())
+                FrameWriter->Skip();
+        }
+        else if (ReversibilityData->Unique() || !Wrapper->IsIntraOnly() || FrameHash || !FrameWriter->IsComplete(Verifier, ReversibilityData->Pos()))
+            Wrapper->Process(Data, Size);
+    }
     if (!ReversibilityData->Unique())
     {
         if (Actions[Action_Conch] || Actions[Action_Coherency])
         {
-            RawFrame->SetPre(ReversibilityData->Data(reversibility::element::BeforeData));
-            RawFrame->SetPost(ReversibilityData->Data(reversibility::element::AfterData));
+            RawFrame->SetPre(buffer_or_view(Frame_Pre));
+            RawFrame->SetPost(buffer_or_view(Frame_Post));
             ParseDecodedFrame();
         }
         ReversibilityData->NextFrame();
     }
+}
 
-    return false;
+//---------------------------------------------------------------------------
+bool track_info::IsDecoded()
+{
+    if (FrameHash)
+        return true; // All frames are needed for frame hashes
+
+    switch (CheckLevel)
+    {
+        case check_level::Container:
+            return !Wrapper->HasChecksums(); // Nothing to check without decoding, e.g. FLAC, PCM or FFV1 without slice CRC
+        case check_level::Sample:
+            return ReversibilityData->Unique() || !Wrapper->IsIntraOnly() || ReversibilityData->Pos() % CheckLevel_SampleStep == Sample_Offset;
+        default:
+            return true;
+    }
 }
 
 //---------------------------------------------------------------------------
@@ -214,13 +312,17 @@ input_base_uncompressed* track_info::InitOutput(input_base_uncompressed* Potenti
 //---------------------------------------------------------------------------
 void track_info::End(size_t i)
 {
+    Wait();
+
     if (!Actions[Action_Decode] && !Actions[Action_Check])
     {
         return;
     }
 
     // Write end of the file if the file is unique per track
-    if (ReversibilityData->Unique())
+    if (ReversibilityData->Unique() && CheckLevel == check_level::Container && Wrapper && Wrapper->HasChecksums())
+        FrameWriter->Skip();
+    else if (ReversibilityData->Unique())
     {
         RawFrame->AssignBufferView(nullptr, 0);
         RawFrame->SetPre(buffer_or_view());
@@ -278,6 +380,8 @@ track_info::track_info(const frame_writer& FrameWriter_Source, const bitset<Acti
 //
 track_info::~track_info()
 {
+    Wait();
+    delete Verifier;
     delete FrameWriter;
     delete ReversibilityData;
     delete DecodedFrameParser;
@@ -13,14 +13,20 @@
 #include "Lib/CoDec/FFV1/FFV1_Frame.h"
 #include "Lib/Utils/FileIO/Input_Base.h"
 #include "Lib/Utils/FileIO/FileIO.h"
+#include "Lib/Utils/Buffer/Buffer.h"
 #include <bitset>
+#include <condition_variable>
 #include <cstdint>
+#include <deque>
 #include <map>
+#include <mutex>
 #include <set>
 #include <string>
 #include <vector>
 class base_wrapper;
+class file_verifier;
 class frame_writer;
+class framehash_md5;
 using namespace std;
 //---------------------------------------------------------------------------
 
@@ -87,11 +93,18 @@ public:
     input_base_uncompressed*    InitOutput(input_base_uncompressed* PotentialParser, raw_frame::flavor Flavor);
     bool                        Process(const uint8_t* Data, size_t Size);
     bool                        OutOfBand(const uint8_t* Data, size_t Size);
+    void                        Wait(); // Wait for all queued frames to be processed, data provided to Process() is no more used after this call
     void                        End(size_t i);
 
+    check_level                 CheckLevel = check_level::Decode; // Used only if output is not written
+
     void                        SetFormat(const char* NewFormat) { Format = Format_FromCodecID(NewFormat); }
     void                        SetWidth(uint32_t NewWidth) { Width = NewWidth; }
     void                        SetHeight(uint32_t NewHeight) { Height = NewHeight; }
+    void                        SetFrameDuration(uint64_t NewFrameDuration) { FrameDuration = NewFrameDuration; }
+    void                        SetFrameHash(framehash_md5* NewFrameHash) { FrameHash = NewFrameHash; } // Must be called before Init(), all frames are then decoded
+    format                      Format_Get() { return Format; }
+    uint64_t                    FrameDuration_Get() { return FrameDuration; }
 
 private:
     ThreadPool*                 Pool = nullptr;
@@ -99,9 +112,25 @@ private:
     input_base_uncompressed*    DecodedFrameParser = nullptr;
     base_wrapper*               Wrapper = nullptr;
     raw_frame*                  RawFrame = nullptr;
+    file_verifier*              Verifier = nullptr; // Existing output files matching their hash are not decoded again
+    framehash_md5*              FrameHash = nullptr;
+    size_t                      Sample_Offset = 0; // Frame decoded in each group of frames for check_level::Sample
+    bool                        IsDecoded();
     format                      Format = format::None;
     uint32_t                    Width = 0;
     uint32_t                    Height = 0;
+    uint64_t                    FrameDuration = 0; // In nanoseconds
+
+    // Buffers reused for each frame, frames of a track have usually the same sizes
+    buffer                      Frame_Check; // Content of the frame for conformance checks
+
+    // Queue of frames, processed in order by one thread of the pool at a time
+    deque<buffer_view>          Queue;
+    mutex                       Queue_Mutex;
+    condition_variable          Queue_IsEmpty;
+    bool                        Queue_IsRunning = false;
+    void                        Queue_Run();
+    void                        ProcessFrame(const uint8_t* Data, size_t Size);
 
     void                        ParseBuffer() {}
     void                        BufferOverflow() {}
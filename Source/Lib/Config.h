@@ -33,10 +33,40 @@ enum user_mode
 };
 typedef user_mode(*ask_callback)(user_mode* Mode, const string& FileName, const string& ExtraText, bool Always, bool* ProgressIndicator_IsPaused, condition_variable* ProgressIndicator_IsEnd);
 
+//---------------------------------------------------------------------------
+// Defines when written files are flushed to stable storage
+
+enum class durability : uint8_t
+{
+    None,   // Left to the operating system
+    Batch,  // Group commit of several files in the background
+    File,   // Each file is flushed when it is closed
+};
+
+//---------------------------------------------------------------------------
+// Defines how much of the compressed content is decoded during a check
+
+enum class check_level : uint8_t
+{
+    Container,  // Structure and checksums only, no frame is decoded
+    Decode,     // All frames are decoded
+    Sample,     // Structure and checksums, 1 frame per group of frames is decoded
+};
+static const size_t CheckLevel_SampleStep = 100; // Size of a group of frames for check_level::Sample
+
 
 //---------------------------------------------------------------------------
 // Hash types
 typedef std::array<uint8_t, 16> md5;
+enum class hash_format : uint8_t
+{
+    None,
+    MD5,
+    SHA256,
+    XXH3_128,
+    BLAKE3,
+    Max
+};
 
 //---------------------------------------------------------------------------
 // Platform specific
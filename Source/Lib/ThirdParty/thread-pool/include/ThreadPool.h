@@ -55,6 +55,11 @@ public:
   ThreadPool & operator=(const ThreadPool &) = delete;
   ThreadPool & operator=(ThreadPool &&) = delete;
 
+  // Count of threads of the pool
+  size_t size() const {
+    return m_threads.size();
+  }
+
   // Inits thread pool
   void init() {
     for (size_t i = 0; i < m_threads.size(); ++i) {
@@ -691,6 +691,234 @@ public:
     }
 };
 
+//***************************************************************************
+// FFmpeg
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+// Layout of the FFV1 decoder of FFmpeg (BGR0/BGRA if 8-bit RGB, else planar
+// G, B, R, A or Y, U, V, A with little endian 16-bit values if more than 8 bits)
+class transform_ffmpeg : public transform_base
+{
+public:
+    transform_ffmpeg(raw_frame* RawFrame, size_t x_offset, size_t y_offset, size_t w, size_t) :
+        w(w)
+    {
+        for (size_t p = 0; p < 4; p++)
+        {
+            if (p >= RawFrame->Planes_.size())
+            {
+                FrameBuffer[p] = nullptr;
+                NextLine_Offset[p] = 0;
+                continue;
+            }
+            const auto& Plane = RawFrame->Plane(p);
+            FrameBuffer[p] = Plane->Buffer().Data()
+                + y_offset * Plane->AllBytesPerLine()
+                + x_offset * Plane->BytesPerBlock();
+            NextLine_Offset[p] = Plane->AllBytesPerLine();
+        }
+    }
+
+    inline void Next()
+    {
+        for (size_t p = 0; p < 4; p++)
+            FrameBuffer[p] += NextLine_Offset[p];
+    }
+
+protected:
+    uint8_t*    FrameBuffer[4];
+    size_t      w;
+    size_t      NextLine_Offset[4];
+};
+
+//---------------------------------------------------------------------------
+class transform_jpeg2000rct_ffmpeg_RGBA_8 : public transform_ffmpeg
+{
+public:
+    transform_jpeg2000rct_ffmpeg_RGBA_8(raw_frame* RawFrame, size_t x_offset, size_t y_offset, size_t w, size_t h) :
+        transform_ffmpeg(RawFrame, x_offset, y_offset, w, h) {};
+
+    void From(pixel_t* y, pixel_t* u, pixel_t* v, pixel_t* a)
+    {
+        auto FrameBuffer_Temp = FrameBuffer[0];
+
+        for (size_t x = 0; x < w; x++)
+        {
+            JPEG2000RCT(((pixel_t)1) << 8);
+            *(FrameBuffer_Temp++) = (uint8_t)b;
+            *(FrameBuffer_Temp++) = (uint8_t)g;
+            *(FrameBuffer_Temp++) = (uint8_t)r;
+            *(FrameBuffer_Temp++) = a ? (uint8_t)a[x] : 0;
+        }
+
+        Next();
+    }
+};
+
+//---------------------------------------------------------------------------
+class transform_jpeg2000rct_ffmpeg_RGBA_16 : public transform_ffmpeg
+{
+public:
+    transform_jpeg2000rct_ffmpeg_RGBA_16(raw_frame* RawFrame, size_t Bits, size_t x_offset, size_t y_offset, size_t w, size_t h) :
+        transform_ffmpeg(RawFrame, x_offset, y_offset, w, h),
+        Offset(((pixel_t)1) << Bits)
+    {
+        if (Bits < 16 && RawFrame->Planes_.size() == 3)
+            swap(FrameBuffer[0], FrameBuffer[1]); // Exception indicated in specs, g and b are inverted
+    };
+
+    void From(pixel_t* y, pixel_t* u, pixel_t* v, pixel_t* a)
+    {
+        auto FrameBuffer_Temp_G = (uint16_t*)FrameBuffer[0];
+        auto FrameBuffer_Temp_B = (uint16_t*)FrameBuffer[1];
+        auto FrameBuffer_Temp_R = (uint16_t*)FrameBuffer[2];
+        auto FrameBuffer_Temp_A = (uint16_t*)FrameBuffer[3];
+
+        for (size_t x = 0; x < w; x++)
+        {
+            JPEG2000RCT(Offset);
+            FrameBuffer_Temp_G[x] = htol((uint16_t)g);
+            FrameBuffer_Temp_B[x] = htol((uint16_t)b);
+            FrameBuffer_Temp_R[x] = htol((uint16_t)r);
+            if (FrameBuffer_Temp_A)
+                FrameBuffer_Temp_A[x] = htol((uint16_t)a[x]);
+        }
+
+        Next();
+    }
+
+private:
+    pixel_t     Offset;
+};
+
+//---------------------------------------------------------------------------
+// Planes are provided one after the other, line by line
+class transform_passthrough_ffmpeg_YUVA : public transform_base
+{
+public:
+    transform_passthrough_ffmpeg_YUVA(raw_frame* RawFrame, size_t Bits, size_t x_offset, size_t y_offset, size_t w, size_t h) :
+        Is16(Bits > 8)
+    {
+        const auto& Planes = RawFrame->Planes();
+        if (Planes.empty())
+            return;
+        auto Luma = Planes[0];
+
+        // Chroma subsampling, from the plane sizes
+        size_t h_shift = 0;
+        size_t v_shift = 0;
+        if (Planes.size() >= 3)
+        {
+            while (h_shift < 4 && ((Luma->Width_ + (1 << h_shift) - 1) >> h_shift) > Planes[1]->Width_)
+                h_shift++;
+            while (v_shift < 4 && ((Luma->Height_ + (1 << v_shift) - 1) >> v_shift) > Planes[1]->Height_)
+                v_shift++;
+        }
+
+        for (size_t p = 0; p < Planes.size(); p++)
+        {
+            auto IsChroma = Planes.size() >= 3 && (p == 1 || p == 2);
+            AddPlane(Planes[p], IsChroma ? h_shift : 0, IsChroma ? v_shift : 0, x_offset, y_offset, w, h);
+        }
+
+        // Luma and alpha interleaved
+        if (Planes.size() == 1 && !Is16 && Luma->BytesPerBlock() == 2)
+        {
+            Items[0].Step = 2;
+            Items.push_back(Items[0]);
+            Items[1].FrameBuffer++;
+        }
+    }
+
+    void From(pixel_t* y, pixel_t*, pixel_t*, pixel_t*)
+    {
+        if (Item_Pos >= Items.size())
+            return;
+        auto& Item = Items[Item_Pos];
+
+        if (Is16)
+        {
+            auto FrameBuffer_Temp_16 = (uint16_t*)Item.FrameBuffer;
+            for (size_t x = 0; x < Item.w; x++)
+                FrameBuffer_Temp_16[x] = htol((uint16_t)y[x]);
+        }
+        else
+        {
+            auto FrameBuffer_Temp = Item.FrameBuffer;
+            for (size_t x = 0; x < Item.w; x++)
+            {
+                *FrameBuffer_Temp = (uint8_t)y[x];
+                FrameBuffer_Temp += Item.Step;
+            }
+        }
+
+        Item.FrameBuffer += Item.NextLine_Offset;
+        if (++Line == Item.h)
+        {
+            Item_Pos++;
+            Line = 0;
+        }
+    }
+
+private:
+    struct item
+    {
+        uint8_t*    FrameBuffer;
+        size_t      w;
+        size_t      h;
+        size_t      Step;
+        size_t      NextLine_Offset;
+    };
+    vector<item>    Items;
+    size_t          Item_Pos = 0;
+    size_t          Line = 0;
+    bool            Is16;
+
+    void AddPlane(const raw_frame::plane* Plane, size_t h_shift, size_t v_shift, size_t x_offset, size_t y_offset, size_t w, size_t h)
+    {
+        item Item;
+        Item.w = (w + (1 << h_shift) - 1) >> h_shift;
+        Item.h = (h + (1 << v_shift) - 1) >> v_shift;
+        Item.Step = 1;
+        Item.FrameBuffer = Plane->Buffer().Data()
+            + (y_offset >> v_shift) * Plane->AllBytesPerLine()
+            + (x_offset >> h_shift) * Plane->BytesPerBlock();
+        Item.NextLine_Offset = Plane->AllBytesPerLine();
+        Items.push_back(Item);
+    }
+};
+
+//***************************************************************************
+// Tee
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+// Same samples to 2 frames
+class transform_tee : public transform_base
+{
+public:
+    transform_tee(transform_base* First, transform_base* Second) :
+        First(First),
+        Second(Second) {};
+
+    ~transform_tee()
+    {
+        delete First;
+        delete Second;
+    }
+
+    void From(pixel_t* P1, pixel_t* P2, pixel_t* P3, pixel_t* P4)
+    {
+        First->From(P1, P2, P3, P4);
+        Second->From(P1, P2, P3, P4);
+    }
+
+private:
+    transform_base* First;
+    transform_base* Second;
+};
+
 //***************************************************************************
 // List
 //***************************************************************************
@@ -726,6 +954,10 @@ transform_base* Transform_Init(raw_frame* RawFrame, pix_style PixStyle, size_t B
     switch (PixStyle)
     {
     TRANSFORM_PIX_BEGIN(RGBA)
+        case raw_frame::flavor::FFmpeg:
+            if (Bits <= 8)
+                return new transform_jpeg2000rct_ffmpeg_RGBA_8(RawFrame, x_offset, y_offset, w, h);
+            return new transform_jpeg2000rct_ffmpeg_RGBA_16(RawFrame, Bits, x_offset, y_offset, w, h);
         TRANSFORM_FLAVOR_BEGIN(dpx, DPX)
             TRANSFORM_CASE(jpeg2000rct, dpx, Raw_RGB_8)
             TRANSFORM_CASE(jpeg2000rct, dpx, Raw_RGB_10_FilledA_LE)
@@ -756,6 +988,8 @@ transform_base* Transform_Init(raw_frame* RawFrame, pix_style PixStyle, size_t B
         TRANSFORM_FLAVOR_END()
     TRANSFORM_PIX_END()
     TRANSFORM_PIX_BEGIN(YUVA)
+        case raw_frame::flavor::FFmpeg:
+            return new transform_passthrough_ffmpeg_YUVA(RawFrame, Bits, x_offset, y_offset, w, h);
         TRANSFORM_FLAVOR_BEGIN(dpx, DPX)
             TRANSFORM_CASE(passthrough, dpx, Raw_Y_8)
             TRANSFORM_CASE(passthrough, dpx, Raw_Y_16_LE)
@@ -771,3 +1005,12 @@ transform_base* Transform_Init(raw_frame* RawFrame, pix_style PixStyle, size_t B
         return new transform_null;
     }
 }
+
+//---------------------------------------------------------------------------
+transform_base* Transform_Init(raw_frame* RawFrame, raw_frame* RawFrame_Copy, pix_style PixStyle, size_t Bits, size_t x_offset, size_t y_offset, size_t w, size_t h)
+{
+    auto Transform = Transform_Init(RawFrame, PixStyle, Bits, x_offset, y_offset, w, h);
+    if (!RawFrame_Copy)
+        return Transform;
+    return new transform_tee(Transform, Transform_Init(RawFrame_Copy, PixStyle, Bits, x_offset, y_offset, w, h));
+}
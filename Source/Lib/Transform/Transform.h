@@ -19,6 +19,7 @@ class raw_frame;
 class transform_base
 {
 public:
+    virtual ~transform_base() {}
     virtual void From(pixel_t* P1, pixel_t* P2 = nullptr, pixel_t* P3 = nullptr, pixel_t* P4 = nullptr) = 0;
 };
 
@@ -31,6 +32,7 @@ enum class pix_style
 
 //---------------------------------------------------------------------------
 transform_base* Transform_Init(raw_frame* RawFrame, pix_style PixStyle, size_t Bits, size_t x_offset, size_t y_offset, size_t w, size_t h);
+transform_base* Transform_Init(raw_frame* RawFrame, raw_frame* RawFrame_Copy, pix_style PixStyle, size_t Bits, size_t x_offset, size_t y_offset, size_t w, size_t h); // Same samples also to RawFrame_Copy if not null
 
 //---------------------------------------------------------------------------
 #endif
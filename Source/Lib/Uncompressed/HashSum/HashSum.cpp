@@ -92,9 +92,9 @@ void hashes::ResetHashFile(size_t OldSize)
 }
 
 //---------------------------------------------------------------------------
-void hashes::FromHashFile(string const& FileName, md5 const& MD5)
+void hashes::FromHashFile(string const& FileName, hash_value const& Hash)
 {
-    List_FromHashFiles.emplace_back(FileName, MD5);
+    List_FromHashFiles.emplace_back(FileName, Hash);
 }
 
 //---------------------------------------------------------------------------
@@ -106,12 +106,19 @@ void hashes::Ignore(string const& FileName)
 //---------------------------------------------------------------------------
 void hashes::RemoveEmptyFiles()
 {
-    md5 EmptyMD5 = { 0xd4, 0x1d, 0x8c, 0xd9, 0x8f, 0x00, 0xb2, 0x04, 0xe9, 0x80, 0x09, 0x98, 0xec, 0xf8, 0x42, 0x7e };
+    // Hash of empty content, per format
+    hash_value EmptyHashes[(size_t)hash_format::Max];
+    for (uint8_t i = 1; i < (uint8_t)hash_format::Max; i++)
+    {
+        auto Hash = hash_base::New((hash_format)i);
+        EmptyHashes[i] = Hash->Final();
+        delete Hash;
+    }
 
     auto List_FromHashFiles_Size = List_FromHashFiles.size();
     for (size_t i = 0; i < List_FromHashFiles_Size; i++)
     {
-        if (List_FromHashFiles[i].MD5 == EmptyMD5)
+        if (List_FromHashFiles[i].Hash == EmptyHashes[(size_t)List_FromHashFiles[i].Hash.Format])
         {
             List_FromHashFiles.erase(List_FromHashFiles.begin() + i);
             List_FromHashFiles_Size--;
@@ -120,13 +127,22 @@ void hashes::RemoveEmptyFiles()
 }
 
 //---------------------------------------------------------------------------
-void hashes::FromFile(string const& FileName, md5 const& MD5)
+void hashes::FromFile(string const& FileName, hash_value const& Hash)
+{
+    lock_guard<mutex> Lock(Mutex);
+    if (Format_FromFiles == hash_format::None)
+        Format_FromFiles = Hash.Format;
+    FromFile_Internal(FileName, Hash);
+}
+
+//---------------------------------------------------------------------------
+void hashes::FromFile_Internal(string const& FileName, hash_value const& Hash)
 {
     // Hash files maybe not yet there, we wait if we don't know that files are not all there
     if (!IsSorted)
     {
         if (find(HashFiles.begin(), HashFiles.end(), FileName) == HashFiles.end())
-            List_FromFiles.emplace_back(FileName, MD5);
+            List_FromFiles.emplace_back(FileName, Hash);
         return;
     }
 
@@ -147,8 +163,10 @@ void hashes::FromFile(string const& FileName, md5 const& MD5)
     {
         for (auto File = Files.first; File != Files.second; ++File)
         {
+            if (File->Hash.Format != Hash.Format)
+                continue; // Not comparable, e.g. hash file in MD5 and input files hashed with another format for reversibility data
             File->Flags.set(hashes::value::Flag_IsFound);
-            if (File->MD5 != MD5)
+            if (File->Hash != Hash)
             {
                 if (Errors)
                     Errors->Error(IO_Hashes, WouldBeError ? error::type::Undecodable : error::type::Invalid, CheckFromFiles ? (error::generic::code)hashes_issue::undecodable::FileComparison : (error::generic::code)hashes_issue::invalid::FileHashComparison, FileName);
@@ -158,11 +176,60 @@ void hashes::FromFile(string const& FileName, md5 const& MD5)
 }
 
 //---------------------------------------------------------------------------
-void hashes::NoMoreHashFiles_Internal()
+void hashes::Skip(string const& FileName)
+{
+    lock_guard<mutex> Lock(Mutex);
+
+    if (!IsSorted)
+    {
+        HashFiles.push_back(FileName); // Ignored
+        return;
+    }
+
+    auto& List = CheckFromFiles ? List_FromFiles : List_FromHashFiles;
+    auto Files = equal_range(List.begin(), List.end(), FileName, Hash_FileSearch());
+    for (auto File = Files.first; File != Files.second; ++File)
+        File->Flags.set(hashes::value::Flag_IsFound);
+}
+
+//---------------------------------------------------------------------------
+bool hashes::Find(string const& FileName, hash_value& Hash)
+{
+    lock_guard<mutex> Lock(Mutex);
+
+    if (!IsSorted)
+        return false;
+
+    auto Item = lower_bound(List_FromHashFiles.begin(), List_FromHashFiles.end(), FileName, [](value const& l, string const& r) { return l.Name < r; });
+    if (Item == List_FromHashFiles.end() || Item->Name != FileName)
+        return false;
+    auto Next = Item + 1;
+    if (Next != List_FromHashFiles.end() && Next->Name == FileName)
+        return false; // Several hashes for the same file
+    Hash = Item->Hash;
+    return true;
+}
+
+//---------------------------------------------------------------------------
+hash_format hashes::Format()
 {
+    lock_guard<mutex> Lock(Mutex);
+
+    if (CheckFromFiles)
+        return Format_FromFiles;
+    if (List_FromHashFiles.empty())
+        return hash_format::None;
+    return List_FromHashFiles.front().Hash.Format;
+}
+
+//---------------------------------------------------------------------------
+bool hashes::NoMoreHashFiles()
+{
+    lock_guard<mutex> Lock(Mutex);
+
     // Coherency
     if (IsSorted || (!CheckFromFiles && List_FromHashFiles.empty()))
-        return;
+        return !List_FromHashFiles.empty();
     IsSorted = true;
 
     // Sort and make unique
@@ -173,13 +240,16 @@ void hashes::NoMoreHashFiles_Internal()
     if (!List_FromHashFiles.empty())
     {
         for (auto Value : List_FromFiles)
-            FromFile(Value.Name, Value.MD5);
+            FromFile_Internal(Value.Name, Value.Hash);
     }
+    return !List_FromHashFiles.empty();
 }
 
 //---------------------------------------------------------------------------
 void hashes::Finish()
 {
+    lock_guard<mutex> Lock(Mutex);
+
     // Coherency
     if (!IsSorted || (!CheckFromFiles && List_FromHashFiles.empty()))
         return;
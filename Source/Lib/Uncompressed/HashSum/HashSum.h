@@ -12,6 +12,8 @@
 //---------------------------------------------------------------------------
 #include "Lib/CoDec/FFV1/FFV1_Frame.h"
 #include "Lib/Utils/FileIO/Input_Base.h"
+#include "Lib/Utils/Hash/Hash.h"
+#include <mutex>
 #include <vector>
 //---------------------------------------------------------------------------
 
@@ -32,11 +34,11 @@ public:
     {
         // Constructor / Destructor
         value() {}
-        value(string const& Name_Source, md5 const& MD5_Source) : Name(Name_Source), MD5(MD5_Source) {}
+        value(string const& Name_Source, hash_value const& Hash_Source) : Name(Name_Source), Hash(Hash_Source) {}
 
         // Data
         string                  Name;
-        md5                     MD5;
+        hash_value              Hash;
         enum flags
         {
             Flag_IsFound,
@@ -46,34 +48,39 @@ public:
         std::bitset<Flag_Max>   Flags;
 
         // Operators
-        friend bool operator < (value const& l, value const& r) { return l.Name < r.Name || (l.Name == r.Name && l.MD5 < r.MD5); }
-        friend bool operator == (value const& l, value const& r) { return l.Name == r.Name && l.MD5 == r.MD5; }
+        friend bool operator < (value const& l, value const& r) { return l.Name < r.Name || (l.Name == r.Name && l.Hash < r.Hash); }
+        friend bool operator == (value const& l, value const& r) { return l.Name == r.Name && l.Hash == r.Hash; }
     };
     typedef std::vector<value>  list;
 
     // Actions
     size_t                      NewHashFile(); // Indicate that a new hash file is tentatively parsed
     void                        ResetHashFile(size_t OldSize); // Indicate that the new hash file is buggy, discard its content, use value from NewHashFile()
-    void                        FromHashFile(string const& FileName, md5 const& MD5);
-    void                        FromHashFile(buffer_base const& FileName, md5 const& MD5) { FromHashFile(string((const char*)FileName.Data(), FileName.Size()), MD5); }
+    void                        FromHashFile(string const& FileName, hash_value const& Hash);
+    void                        FromHashFile(buffer_base const& FileName, hash_value const& Hash) { FromHashFile(string((const char*)FileName.Data(), FileName.Size()), Hash); }
     void                        Ignore(string const& FileName);
     void                        RemoveEmptyFiles();
-    bool                        NoMoreHashFiles() { if (!IsSorted) NoMoreHashFiles_Internal(); return !List_FromHashFiles.empty(); } // Return true if Hashes are useful
-    void                        FromFile(string const& FileName, md5 const& MD5);
+    bool                        NoMoreHashFiles(); // Return true if Hashes are useful
+    void                        FromFile(string const& FileName, hash_value const& Hash); // Only compared to values in the same format
+    void                        Skip(string const& FileName); // Content of the file is not checked, e.g. frame is not decoded
     void                        Finish();
 
     // Info
     size_t                      HashFiles_Count() { return HashFiles.size(); }
+    bool                        Find(string const& FileName, hash_value& Hash); // Expected hash of a file, only after NoMoreHashFiles(), false if unknown or ambiguous
+    hash_format                 Format(); // Format of the values FromFile() is compared to, None if there is nothing to compare to
 
 private:
     // Internal
-    void                        NoMoreHashFiles_Internal();
+    void                        FromFile_Internal(string const& FileName, hash_value const& Hash);
 
     // Data
     list                        List_FromHashFiles;
     list                        List_FromFiles;
+    hash_format                 Format_FromFiles = hash_format::None; // Format of the first value from files
     std::vector<string>         HashFiles;
     bool                        IsSorted = false;
+    mutex                       Mutex; // FromFile() may be called from several tracks at the same time
 
     // Errors
     errors*                     Errors = nullptr;
@@ -11,6 +11,7 @@
 
 //---------------------------------------------------------------------------
 #include "Lib/Config.h"
+#include "Lib/Utils/Buffer/Memory.h"
 #include <cstring>
 using namespace std;
 //---------------------------------------------------------------------------
@@ -114,7 +115,7 @@ public:
     {
         if (this == &Buffer)
             return *this;
-        delete[] Data();
+        memory::Free(Data());
         AssignBase(Buffer);
         Buffer.ClearBase();
         return *this;
@@ -122,7 +123,7 @@ public:
 
     ~buffer()
     {
-        delete[] Data();
+        memory::Free(Data());
     }
 
 #ifdef __GNUC__
@@ -144,13 +145,13 @@ public:
 
     void Create(size_t NewSize)
     {
-        delete[] Data();
+        memory::Free(Data());
         if (!NewSize)
         {
             ClearBase();
             return;
         }
-        AssignBase(new uint8_t[NewSize], NewSize);
+        AssignBase(memory::Allocate(NewSize), NewSize);
     }
     void Create(const uint8_t* NewData, size_t NewSize)
     {
@@ -200,7 +201,7 @@ public:
     {
         if (!NewSize)
         {
-            ClearBase();
+            Clear();
             return;
         }
         if (NewSize < Size())
@@ -208,14 +209,16 @@ public:
             AssignBase(Data(), NewSize); // We just change the Size value, no shrink of memory
             return;
         }
-        auto NewBuffer = new uint8_t[NewSize];
-        memcpy(NewBuffer, Data(), Size());
+        auto OldBuffer = Data();
+        auto NewBuffer = memory::Allocate(NewSize);
+        memcpy(NewBuffer, OldBuffer, Size());
         AssignBase(NewBuffer, NewSize);
+        memory::Free(OldBuffer);
     }
 
     void Clear()
     {
-        delete[] Data();
+        memory::Free(Data());
         ClearBase();
     }
 
@@ -314,7 +317,7 @@ public:
     {
         if (!IsOwned_)
             return;
-        delete[] Data();
+        memory::Free(Data());
     }
 
     buffer_or_view& operator = (buffer_or_view&& Buffer)
@@ -341,7 +344,7 @@ public:
     {
         if (!IsOwned_ && Size())
         {
-            auto NewBuffer = new uint8_t[Size()];
+            auto NewBuffer = memory::Allocate(Size());
             memcpy(NewBuffer, Data(), Size());
             AssignKeepSizeBase(NewBuffer);
             IsOwned_ = true;
@@ -356,17 +359,17 @@ public:
     void Create(size_t NewSize)
     {
         if (IsOwned_)
-            delete[] Data();
+            memory::Free(Data());
         else
             IsOwned_ = true;
-        AssignBase(new uint8_t[NewSize], NewSize);
+        AssignBase(memory::Allocate(NewSize), NewSize);
     }
 
     void Assign(const uint8_t* NewData, size_t NewSize)
     {
         if (IsOwned_)
         {
-            delete[] Data();
+            memory::Free(Data());
             IsOwned_ = false;
         }
         AssignBase(NewData, NewSize);
@@ -386,11 +389,11 @@ public:
             return;
         }
         auto OldBuffer = Data();
-        auto NewBuffer = new uint8_t[NewSize];
-        memcpy(NewBuffer, OldBuffer, NewSize);
+        auto NewBuffer = memory::Allocate(NewSize);
+        memcpy(NewBuffer, OldBuffer, Size());
         AssignBase(NewBuffer, NewSize);
         if (IsOwned_)
-            delete[] OldBuffer;
+            memory::Free(OldBuffer);
         else
             IsOwned_ = true;
     }
@@ -399,7 +402,7 @@ public:
     {
         if (IsOwned_)
         {
-            delete[] Data();
+            memory::Free(Data());
             IsOwned_ = false;
         }
         ClearBase();
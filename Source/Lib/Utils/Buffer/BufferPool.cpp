@@ -0,0 +1,119 @@
+/*  Copyright (c) MediaArea.net SARL & AV Preservation by reto.ch.
+ *
+ *  Use of this source code is governed by a BSD-style license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//---------------------------------------------------------------------------
+#include "Lib/Utils/Buffer/BufferPool.h"
+#if defined(__linux__)
+    #include <sys/mman.h>
+    #include <cstdint>
+#endif
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+static const size_t BufferPool_MaxMemory_Default = 384 * 1024 * 1024;
+static const size_t BufferPool_MaxFree_Count = 256; // Small buffers are also recycled, but not too many of them
+static const size_t BufferPool_HugePage_Size = 2 * 1024 * 1024;
+
+//---------------------------------------------------------------------------
+buffer_pool::buffer_pool(size_t MaxMemory_Source, bool HugePages_Source) :
+    MaxMemory_(MaxMemory_Source ? MaxMemory_Source : BufferPool_MaxMemory_Default),
+    HugePages(HugePages_Source)
+{
+    MaxFree = MaxMemory_ / 3; // Same ratio as the previous defaults, 256 MiB in flight and 128 MiB free
+}
+
+//---------------------------------------------------------------------------
+buffer_pool::~buffer_pool()
+{
+}
+
+//---------------------------------------------------------------------------
+buffer buffer_pool::Get(size_t Size)
+{
+    buffer Result;
+    if (!Size)
+        return Result;
+
+    {
+        lock_guard<mutex> Lock(Mutex);
+        auto Bin = Free.find(Size);
+        if (Bin != Free.end() && !Bin->second.empty())
+        {
+            Result = move(Bin->second.back());
+            Bin->second.pop_back();
+            Free_Size -= Size;
+            Free_Count--;
+            return Result;
+        }
+        Allocated_Count_++;
+    }
+
+    memory_scope Memory(memory_use::Queue);
+    Result.Create(Size);
+    HugePages_Advise(Result.Data(), Size);
+    return Result;
+}
+
+//---------------------------------------------------------------------------
+void buffer_pool::Release(buffer& Buffer)
+{
+    auto Size = Buffer.Size();
+    if (!Size)
+        return;
+
+    {
+        lock_guard<mutex> Lock(Mutex);
+        if (Size <= MaxFree)
+        {
+            if (Free_Size + Size > MaxFree || Free_Count >= BufferPool_MaxFree_Count)
+                Evict(Size);
+            if (Free_Size + Size <= MaxFree && Free_Count < BufferPool_MaxFree_Count)
+            {
+                Free[Size].push_back(move(Buffer));
+                Free_Size += Size;
+                Free_Count++;
+                return;
+            }
+        }
+    }
+
+    Buffer.Clear();
+}
+
+//---------------------------------------------------------------------------
+void buffer_pool::HugePages_Advise(uint8_t* Data, size_t Size)
+{
+    #if defined(__linux__) && defined(MADV_HUGEPAGE)
+        // Transparent huge pages for the part of big buffers aligned on huge pages, memory is not yet touched
+        if (HugePages && Size >= BufferPool_HugePage_Size)
+        {
+            auto Begin = ((uintptr_t)Data + BufferPool_HugePage_Size - 1) & ~(uintptr_t)(BufferPool_HugePage_Size - 1);
+            auto End = ((uintptr_t)Data + Size) & ~(uintptr_t)(BufferPool_HugePage_Size - 1);
+            if (End > Begin)
+                madvise((void*)Begin, End - Begin, MADV_HUGEPAGE); // Only a hint, failure is not an issue
+        }
+    #else
+        (void)Data;
+        (void)Size;
+    #endif
+}
+
+//---------------------------------------------------------------------------
+void buffer_pool::Evict(size_t Size)
+{
+    // Buffers of other sizes are no more useful, e.g. after a change of frame size
+    for (auto Bin = Free.begin(); Bin != Free.end() && (Free_Size + Size > MaxFree || Free_Count >= BufferPool_MaxFree_Count); ++Bin)
+    {
+        if (Bin->first == Size)
+            continue;
+        while (!Bin->second.empty() && (Free_Size + Size > MaxFree || Free_Count >= BufferPool_MaxFree_Count))
+        {
+            Bin->second.pop_back();
+            Free_Size -= Bin->first;
+            Free_Count--;
+        }
+    }
+}
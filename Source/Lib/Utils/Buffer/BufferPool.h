@@ -0,0 +1,57 @@
+/*  Copyright (c) MediaArea.net SARL & AV Preservation by reto.ch.
+ *
+ *  Use of this source code is governed by a BSD-style license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//---------------------------------------------------------------------------
+#ifndef BufferPoolH
+#define BufferPoolH
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+#include "Lib/Utils/Buffer/Buffer.h"
+#include <map>
+#include <mutex>
+#include <vector>
+using namespace std;
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+// Buffers recycled between the stages of the decoding pipeline
+// Free buffers are kept by size, frames of a stream have the same size so
+// once the pipeline is full no more memory is allocated
+// The budget is split between the data in flight (see async_writer) and the
+// free buffers kept here
+class buffer_pool
+{
+public:
+    // Constructor / Destructor
+    buffer_pool(size_t MaxMemory_Source = 0, bool HugePages_Source = false); // 0 means default budget
+    ~buffer_pool();
+
+    // Actions
+    buffer                      Get(size_t Size); // Content is not initialized
+    void                        Release(buffer& Buffer); // Buffer is empty after the call
+
+    // Info
+    size_t                      MaxMemory() const { return MaxMemory_; }
+    size_t                      MaxInFlight() const { return MaxMemory_ - MaxFree; } // Budget for data waiting for being written
+    size_t                      Allocated_Count() const { return Allocated_Count_; } // Count of buffers not from the pool, for statistics
+
+private:
+    void                        HugePages_Advise(uint8_t* Data, size_t Size); // Memory must not be touched yet
+    void                        Evict(size_t Size); // Free buffers of other sizes until Size fits in the budget
+
+    size_t                      MaxMemory_;
+    size_t                      MaxFree;
+    bool                        HugePages;
+    map<size_t, vector<buffer>> Free; // By size
+    size_t                      Free_Size = 0;
+    size_t                      Free_Count = 0;
+    size_t                      Allocated_Count_ = 0;
+    mutex                       Mutex;
+};
+
+//---------------------------------------------------------------------------
+#endif
@@ -0,0 +1,168 @@
+/*  Copyright (c) MediaArea.net SARL & AV Preservation by reto.ch.
+ *
+ *  Use of this source code is governed by a BSD-style license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//---------------------------------------------------------------------------
+#include "Lib/Utils/Buffer/Memory.h"
+#include <atomic>
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+namespace
+{
+    // In front of the allocated content, 16 bytes for keeping the alignment of the content
+    struct header
+    {
+        uint64_t                Size;
+        uint8_t                 Use; // memory_use_Max if not counted
+        uint8_t                 Reserved[7];
+    };
+    static_assert(sizeof(header) == 16, "memory header size");
+
+    struct use_counters
+    {
+        atomic<uint64_t>        Live{0};
+        atomic<uint64_t>        Peak{0};
+        atomic<uint64_t>        Allocations{0};
+    };
+
+    use_counters                            Counters[memory_use_Max + 1]; // Last one is the total
+    thread_local memory_use                 Current = memory_use::Other;
+
+    void Increase(use_counters& Counter, uint64_t Size)
+    {
+        auto Live = Counter.Live.fetch_add(Size, memory_order_relaxed) + Size;
+        auto Peak = Counter.Peak.load(memory_order_relaxed);
+        while (Live > Peak && !Counter.Peak.compare_exchange_weak(Peak, Live, memory_order_relaxed))
+            ;
+    }
+
+    void Add(size_t Use, uint64_t Size)
+    {
+        Increase(Counters[Use], Size);
+        Increase(Counters[memory_use_Max], Size);
+    }
+
+    void Remove(size_t Use, uint64_t Size)
+    {
+        Counters[Use].Live.fetch_sub(Size, memory_order_relaxed);
+        Counters[memory_use_Max].Live.fetch_sub(Size, memory_order_relaxed);
+    }
+}
+
+//---------------------------------------------------------------------------
+bool memory::IsEnabled_ = false;
+
+//***************************************************************************
+// Memory
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+void memory::Enable()
+{
+    IsEnabled_ = true;
+}
+
+//---------------------------------------------------------------------------
+uint8_t* memory::Allocate(size_t Size)
+{
+    auto Header = (header*)new uint8_t[sizeof(header) + Size];
+    Header->Size = Size;
+    if (IsEnabled_)
+    {
+        auto Use = (size_t)Current;
+        Header->Use = (uint8_t)Use;
+        Add(Use, Size);
+        Counters[Use].Allocations.fetch_add(1, memory_order_relaxed);
+        Counters[memory_use_Max].Allocations.fetch_add(1, memory_order_relaxed);
+    }
+    else
+        Header->Use = (uint8_t)memory_use_Max; // Not counted, e.g. allocated before the accounting is enabled
+    return (uint8_t*)(Header + 1);
+}
+
+//---------------------------------------------------------------------------
+void memory::Free(const uint8_t* Data)
+{
+    if (!Data)
+        return;
+    auto Header = ((const header*)Data) - 1;
+    if (Header->Use < memory_use_Max)
+        Remove(Header->Use, Header->Size);
+    delete[] (const uint8_t*)Header;
+}
+
+//---------------------------------------------------------------------------
+void memory::Resize(memory_use Use, size_t Previous_Size, size_t New_Size)
+{
+    if (!IsEnabled_)
+        return;
+    if (New_Size > Previous_Size)
+        Add((size_t)Use, New_Size - Previous_Size);
+    else if (New_Size < Previous_Size)
+        Remove((size_t)Use, Previous_Size - New_Size);
+}
+
+//---------------------------------------------------------------------------
+memory::values memory::Values()
+{
+    values Result;
+    for (size_t i = 0; i <= memory_use_Max; i++)
+    {
+        Result[i].Live = Counters[i].Live.load(memory_order_relaxed);
+        Result[i].Peak = Counters[i].Peak.load(memory_order_relaxed);
+        Result[i].Allocations = Counters[i].Allocations.load(memory_order_relaxed);
+    }
+    return Result;
+}
+
+//---------------------------------------------------------------------------
+const char* memory::Name(memory_use Use)
+{
+    switch (Use)
+    {
+        case memory_use::Other: return "other";
+        case memory_use::Frame: return "frame";
+        case memory_use::Reversibility: return "reversibility";
+        case memory_use::Container: return "container";
+        case memory_use::Audio: return "audio";
+        case memory_use::Queue: return "queue";
+        default: return "total";
+    }
+}
+
+//---------------------------------------------------------------------------
+void memory::Json(ostream& Out, const char* Indent)
+{
+    auto Current_Values = Values();
+
+    Out << "{\n";
+    for (size_t i = 0; i <= memory_use_Max; i++)
+    {
+        const auto& Value = Current_Values[i];
+        Out << Indent << "  \"" << Name((memory_use)i) << "\": { \"live\": " << Value.Live << ", \"peak\": " << Value.Peak << ", \"allocations\": " << Value.Allocations << " }";
+        if (i < memory_use_Max)
+            Out << ',';
+        Out << '\n';
+    }
+    Out << Indent << '}';
+}
+
+//***************************************************************************
+// Scope
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+memory_scope::memory_scope(memory_use Use) :
+    Parent(Current)
+{
+    Current = Use;
+}
+
+//---------------------------------------------------------------------------
+memory_scope::~memory_scope()
+{
+    Current = Parent;
+}
@@ -0,0 +1,75 @@
+/*  Copyright (c) MediaArea.net SARL & AV Preservation by reto.ch.
+ *
+ *  Use of this source code is governed by a BSD-style license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//---------------------------------------------------------------------------
+#ifndef MemoryH
+#define MemoryH
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+#include "Lib/Config.h"
+#include <array>
+#include <ostream>
+using namespace std;
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+ENUM_BEGIN(memory_use)
+    Other,                      // Not in one of the other uses
+    Frame,                      // Planes of decoded frames
+    Reversibility,              // Reversibility data
+    Container,                  // Matroska input window and frame copies
+    Audio,                      // FLAC and PCM output buffers
+    Queue,                      // Buffers waiting in the write-behind queue or in the pool for recycling
+ENUM_END(memory_use)
+
+//---------------------------------------------------------------------------
+// Live and peak bytes per use of the memory, for knowing the footprint of a run
+// Owned content of buffers is allocated here, with its size in front of it so the size is known when it is freed
+// The use is the one of the innermost memory_scope of the allocating thread, a disabled probe is only a test of a boolean
+class memory
+{
+public:
+    struct use_values
+    {
+        uint64_t                Live = 0;
+        uint64_t                Peak = 0;
+        uint64_t                Allocations = 0;
+    };
+    typedef array<use_values, memory_use_Max + 1> values; // Last one is the total
+
+    // Config
+    static void                 Enable();
+    static bool                 IsEnabled() { return IsEnabled_; }
+
+    // Actions
+    static uint8_t*             Allocate(size_t Size);
+    static void                 Free(const uint8_t* Data); // Data must come from Allocate(), nullptr is accepted
+    static void                 Resize(memory_use Use, size_t Previous_Size, size_t New_Size); // Memory not allocated here (e.g. mapped file)
+
+    // Info
+    static values               Values();
+    static const char*          Name(memory_use Use);
+    static void                 Json(ostream& Out, const char* Indent = ""); // JSON object without line end after the last brace
+
+private:
+    static bool                 IsEnabled_;
+};
+
+//---------------------------------------------------------------------------
+// Allocations between construction and destruction are for the use (in the current thread)
+class memory_scope
+{
+public:
+    memory_scope(memory_use Use);
+    ~memory_scope();
+
+private:
+    memory_use                  Parent;
+};
+
+//---------------------------------------------------------------------------
+#endif
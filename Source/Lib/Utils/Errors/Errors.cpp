@@ -150,6 +150,7 @@ const char* errors::ErrorMessage()
 //---------------------------------------------------------------------------
 void errors::Error(parser Parser, error::type Type, error::generic::code Code)
 {
+    lock_guard<mutex> Lock(Mutex);
     if (Parser >= Parsers.size())
         Parsers.resize(Parser + 1);
     std::vector<per_parser::info> & Codes = Parsers[Parser].Codes[(size_t)Type];
@@ -175,6 +176,7 @@ void errors::Error(parser Parser, error::type Type, error::generic::code Code)
 //---------------------------------------------------------------------------
 void errors::Error(parser Parser, error::type Type, error::generic::code Code, const string& String)
 {
+    lock_guard<mutex> Lock(Mutex);
     if (Parser >= Parsers.size())
         Parsers.resize(Parser + 1);
     std::vector<per_parser::info> & Codes = Parsers[Parser].Codes[(size_t)Type];
@@ -13,6 +13,7 @@
 #include "Lib/Config.h"
 #include <bitset>
 #include <cstdint>
+#include <mutex>
 #include <string>
 #include <vector>
 using namespace std;
@@ -116,6 +117,7 @@ private:
     };
     std::vector<per_parser>     Parsers;
     string                      ErrorMessageCache;
+    mutex                       Mutex; // Errors may be reported from several threads
     void                        DeleteStrings();
     bool                        HasErrors_Value = false;
     bool                        HasWarnings_Value = false;
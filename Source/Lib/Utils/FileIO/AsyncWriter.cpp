@@ -0,0 +1,542 @@
+/*  Copyright (c) MediaArea.net SARL & AV Preservation by reto.ch.
+ *
+ *  Use of this source code is governed by a BSD-style license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//---------------------------------------------------------------------------
+#include "Lib/Utils/FileIO/AsyncWriter.h"
+#include "Lib/Utils/Stats/Stats.h"
+#include "Lib/Utils/Stats/Trace.h"
+#ifdef __GNUC__
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wreorder"
+#endif
+#include "ThreadPool.h"
+#ifdef __GNUC__
+#pragma GCC diagnostic pop
+#endif
+#include <climits>
+#include <cstring>
+#if defined(__linux__) && defined(__has_include)
+    #if __has_include(<linux/io_uring.h>)
+        #include <linux/io_uring.h>
+        #ifdef IORING_FEAT_RW_CUR_POS // openat and close operations need Linux 5.6+ headers
+            #define ASYNCWRITER_IOURING
+            #include <cerrno>
+            #include <fcntl.h>
+            #include <unistd.h>
+            #include <sys/mman.h>
+            #include <sys/stat.h>
+            #include <sys/syscall.h>
+            #include <sys/uio.h>
+        #endif
+    #endif
+#endif
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+static const size_t AsyncWriter_ThreadCount = 8; // Writes are I/O bound, not related to CPU count
+static const unsigned AsyncWriter_RingEntries = 64;
+
+//***************************************************************************
+// io_uring
+//***************************************************************************
+
+#ifdef ASYNCWRITER_IOURING
+//---------------------------------------------------------------------------
+// Minimal io_uring handling with direct system calls, only 1 thread uses it
+struct async_writer::uring
+{
+    ~uring();
+
+    bool                        Init(unsigned NewEntries);
+    io_uring_sqe*               SQE_Get();
+    void                        SQE_Commit();
+    int                         Enter(unsigned MinComplete);
+    io_uring_cqe*               CQE_Peek();
+    void                        CQE_Seen();
+
+    int                         Fd = -1;
+    unsigned                    Entries = 0;
+
+private:
+    void*                       SQ_Ring = MAP_FAILED;
+    size_t                      SQ_Ring_Size = 0;
+    void*                       CQ_Ring = MAP_FAILED;
+    size_t                      CQ_Ring_Size = 0;
+    io_uring_sqe*               SQEs = (io_uring_sqe*)MAP_FAILED;
+    size_t                      SQEs_Size = 0;
+    unsigned*                   SQ_Tail = nullptr;
+    unsigned*                   SQ_Mask = nullptr;
+    unsigned*                   SQ_Array = nullptr;
+    unsigned*                   CQ_Head = nullptr;
+    unsigned*                   CQ_Tail = nullptr;
+    unsigned*                   CQ_Mask = nullptr;
+    io_uring_cqe*               CQEs = nullptr;
+    unsigned                    ToSubmit = 0;
+};
+
+//---------------------------------------------------------------------------
+async_writer::uring::~uring()
+{
+    if (SQEs != MAP_FAILED)
+        munmap(SQEs, SQEs_Size);
+    if (CQ_Ring != MAP_FAILED && CQ_Ring != SQ_Ring)
+        munmap(CQ_Ring, CQ_Ring_Size);
+    if (SQ_Ring != MAP_FAILED)
+        munmap(SQ_Ring, SQ_Ring_Size);
+    if (Fd >= 0)
+        close(Fd);
+}
+
+//---------------------------------------------------------------------------
+bool async_writer::uring::Init(unsigned NewEntries)
+{
+    io_uring_params Params;
+    memset(&Params, 0, sizeof(Params));
+    Fd = (int)syscall(__NR_io_uring_setup, NewEntries, &Params);
+    if (Fd < 0)
+        return true;
+    if (!(Params.features & IORING_FEAT_RW_CUR_POS))
+        return true; // Kernel is too old for openat and close operations
+    Entries = Params.sq_entries;
+
+    // Mapping
+    SQ_Ring_Size = Params.sq_off.array + Params.sq_entries * sizeof(unsigned);
+    CQ_Ring_Size = Params.cq_off.cqes + Params.cq_entries * sizeof(io_uring_cqe);
+    bool IsSingleMap = Params.features & IORING_FEAT_SINGLE_MMAP;
+    if (IsSingleMap && SQ_Ring_Size < CQ_Ring_Size)
+        SQ_Ring_Size = CQ_Ring_Size;
+    SQ_Ring = mmap(nullptr, SQ_Ring_Size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, Fd, IORING_OFF_SQ_RING);
+    if (SQ_Ring == MAP_FAILED)
+        return true;
+    if (IsSingleMap)
+        CQ_Ring = SQ_Ring;
+    else
+    {
+        CQ_Ring = mmap(nullptr, CQ_Ring_Size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, Fd, IORING_OFF_CQ_RING);
+        if (CQ_Ring == MAP_FAILED)
+            return true;
+    }
+    SQEs_Size = Params.sq_entries * sizeof(io_uring_sqe);
+    SQEs = (io_uring_sqe*)mmap(nullptr, SQEs_Size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, Fd, IORING_OFF_SQES);
+    if (SQEs == MAP_FAILED)
+        return true;
+
+    // Pointers
+    auto SQ = (uint8_t*)SQ_Ring;
+    SQ_Tail = (unsigned*)(SQ + Params.sq_off.tail);
+    SQ_Mask = (unsigned*)(SQ + Params.sq_off.ring_mask);
+    SQ_Array = (unsigned*)(SQ + Params.sq_off.array);
+    auto CQ = (uint8_t*)CQ_Ring;
+    CQ_Head = (unsigned*)(CQ + Params.cq_off.head);
+    CQ_Tail = (unsigned*)(CQ + Params.cq_off.tail);
+    CQ_Mask = (unsigned*)(CQ + Params.cq_off.ring_mask);
+    CQEs = (io_uring_cqe*)(CQ + Params.cq_off.cqes);
+
+    return false;
+}
+
+//---------------------------------------------------------------------------
+// There is never more submissions than entries, each job has at most 1 operation in flight
+io_uring_sqe* async_writer::uring::SQE_Get()
+{
+    auto Index = *SQ_Tail & *SQ_Mask;
+    auto SQE = &SQEs[Index];
+    memset(SQE, 0, sizeof(io_uring_sqe));
+    SQ_Array[Index] = Index;
+    return SQE;
+}
+
+//---------------------------------------------------------------------------
+void async_writer::uring::SQE_Commit()
+{
+    __atomic_store_n(SQ_Tail, *SQ_Tail + 1, __ATOMIC_RELEASE);
+    ToSubmit++;
+}
+
+//---------------------------------------------------------------------------
+int async_writer::uring::Enter(unsigned MinComplete)
+{
+    int Result;
+    do
+        Result = (int)syscall(__NR_io_uring_enter, Fd, ToSubmit, MinComplete, MinComplete ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+    while (Result < 0 && errno == EINTR);
+    if (Result > 0)
+        ToSubmit -= Result;
+    return Result;
+}
+
+//---------------------------------------------------------------------------
+io_uring_cqe* async_writer::uring::CQE_Peek()
+{
+    auto Head = *CQ_Head;
+    if (Head == __atomic_load_n(CQ_Tail, __ATOMIC_ACQUIRE))
+        return nullptr;
+    return &CQEs[Head & *CQ_Mask];
+}
+
+//---------------------------------------------------------------------------
+void async_writer::uring::CQE_Seen()
+{
+    __atomic_store_n(CQ_Head, *CQ_Head + 1, __ATOMIC_RELEASE);
+}
+
+//---------------------------------------------------------------------------
+struct async_writer::uring_job
+{
+    uring_job(job* Job_Source) :
+        Job(Job_Source),
+        FullName(Job_Source->BaseDirectory + Job_Source->FileName)
+    {
+        for (const auto& Buffer : Job->Content)
+            Size += Buffer.Size();
+        if (trace::IsEnabled())
+            Begin = stats::Now();
+    }
+
+    enum step
+    {
+        Step_Open,
+        Step_Write,
+        Step_Sync,
+        Step_Close,
+    };
+
+    job*                        Job;
+    string                      FullName;
+    directory_cache::handle_ptr Directory;
+    size_t                      FileName_Offset = 0;
+    vector<iovec>               IOV;
+    size_t                      Size = 0;
+    size_t                      Written = 0;
+    uint64_t                    Begin = 0; // For the trace
+    int                         Fd = -1;
+    step                        Step = Step_Open;
+    file::return_value          Result = file::OK;
+    bool                        IsRetry = false;
+};
+
+//---------------------------------------------------------------------------
+void async_writer::Ring_Run()
+{
+    size_t Active = 0;
+    vector<job*> Jobs;
+    for (;;)
+    {
+        // New jobs
+        {
+            unique_lock<mutex> Lock(Mutex);
+            if (!Active)
+            {
+                Ring_HasPending.wait(Lock, [this] { return !Ring_Pending.empty() || Ring_IsStopping; });
+                if (Ring_Pending.empty())
+                    return;
+            }
+            while (!Ring_Pending.empty() && Active + Jobs.size() < Ring->Entries)
+            {
+                Jobs.push_back(Ring_Pending.front());
+                Ring_Pending.pop_front();
+            }
+        }
+        for (auto Job : Jobs)
+        {
+            auto RingJob = new uring_job(Job);
+            if (Ring_Open(RingJob))
+            {
+                delete RingJob;
+                Pool->submit([this, Job]() { Job->Error(file::Error_CreateDirectory); Job_Done(Job); });
+                continue;
+            }
+            Active++;
+        }
+        Jobs.clear();
+        if (!Active)
+            continue;
+
+        // Submit, and wait for at least 1 completion
+        Ring->Enter(1);
+
+        // Completions
+        while (auto CQE = Ring->CQE_Peek())
+        {
+            auto RingJob = (uring_job*)(uintptr_t)CQE->user_data;
+            auto Result = CQE->res;
+            Ring->CQE_Seen();
+            if (Ring_Next(RingJob, Result))
+                Active--;
+        }
+    }
+}
+
+//---------------------------------------------------------------------------
+bool async_writer::Ring_Open(uring_job* RingJob)
+{
+    // Directory is resolved (and created if needed) once per run
+    RingJob->Directory = directory_cache::Global().Get(RingJob->FullName, RingJob->FileName_Offset);
+    if (!RingJob->Directory)
+        return true;
+
+    RingJob->Step = uring_job::Step_Open;
+    auto SQE = Ring->SQE_Get();
+    SQE->opcode = IORING_OP_OPENAT;
+    SQE->fd = RingJob->Directory->Fd;
+    SQE->addr = (uint64_t)(uintptr_t)(RingJob->FullName.c_str() + RingJob->FileName_Offset);
+    SQE->len = S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH;
+    SQE->open_flags = O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC;
+    SQE->user_data = (uint64_t)(uintptr_t)RingJob;
+    Ring->SQE_Commit();
+    return false;
+}
+
+//---------------------------------------------------------------------------
+void async_writer::Ring_Write(uring_job* RingJob)
+{
+    // Content not yet written
+    RingJob->IOV.clear();
+    auto Skip = RingJob->Written;
+    for (const auto& Buffer : RingJob->Job->Content)
+    {
+        auto Size = Buffer.Size();
+        if (Skip >= Size)
+        {
+            Skip -= Size;
+            continue;
+        }
+        RingJob->IOV.push_back({ Buffer.Data() + Skip, Size - Skip });
+        Skip = 0;
+    }
+    if (RingJob->IOV.size() > IOV_MAX)
+        RingJob->IOV.resize(IOV_MAX);
+
+    RingJob->Step = uring_job::Step_Write;
+    auto SQE = Ring->SQE_Get();
+    SQE->opcode = IORING_OP_WRITEV;
+    SQE->fd = RingJob->Fd;
+    SQE->addr = (uint64_t)(uintptr_t)RingJob->IOV.data();
+    SQE->len = (uint32_t)RingJob->IOV.size();
+    SQE->off = RingJob->Written;
+    SQE->user_data = (uint64_t)(uintptr_t)RingJob;
+    Ring->SQE_Commit();
+}
+
+//---------------------------------------------------------------------------
+void async_writer::Ring_Sync(uring_job* RingJob)
+{
+    RingJob->Step = uring_job::Step_Sync;
+    auto SQE = Ring->SQE_Get();
+    SQE->opcode = IORING_OP_FSYNC;
+    SQE->fd = RingJob->Fd;
+    SQE->user_data = (uint64_t)(uintptr_t)RingJob;
+    Ring->SQE_Commit();
+}
+
+//---------------------------------------------------------------------------
+void async_writer::Ring_Close(uring_job* RingJob)
+{
+    RingJob->Step = uring_job::Step_Close;
+    auto SQE = Ring->SQE_Get();
+    SQE->opcode = IORING_OP_CLOSE;
+    SQE->fd = RingJob->Fd;
+    SQE->user_data = (uint64_t)(uintptr_t)RingJob;
+    Ring->SQE_Commit();
+}
+
+//---------------------------------------------------------------------------
+// Returns true if the job is finished
+bool async_writer::Ring_Next(uring_job* RingJob, int Result)
+{
+    auto Job = RingJob->Job;
+    switch (RingJob->Step)
+    {
+    case uring_job::Step_Open:
+        if (Result >= 0)
+        {
+            RingJob->Fd = Result;
+            if (RingJob->Size)
+                Ring_Write(RingJob);
+            else if (Job->Sync)
+                Ring_Sync(RingJob);
+            else
+                Ring_Close(RingJob);
+            return false;
+        }
+        if (Result == -ENOENT && !RingJob->IsRetry)
+        {
+            // Cached directory no more exists, try again from scratch
+            RingJob->IsRetry = true;
+            directory_cache::Global().Remove(RingJob->FullName);
+            if (!Ring_Open(RingJob))
+                return false;
+            Job->Error(file::Error_CreateDirectory);
+        }
+        else if (Result == -EEXIST)
+        {
+            // Check of the existing file, it may need user interaction so it is not done here
+            delete RingJob;
+            Pool->submit([this, Job]() { Job->AlreadyExists(); Job_Done(Job); });
+            return true;
+        }
+        else
+            Job->Error(file::Error_FileCreate);
+        break;
+    case uring_job::Step_Write:
+        if (Result <= 0)
+        {
+            RingJob->Result = file::Error_FileWrite;
+            Ring_Close(RingJob);
+            return false;
+        }
+        RingJob->Written += Result;
+        if (RingJob->Written < RingJob->Size)
+            Ring_Write(RingJob); // Partial write
+        else if (Job->Sync)
+            Ring_Sync(RingJob);
+        else
+            Ring_Close(RingJob);
+        return false;
+    case uring_job::Step_Sync:
+        if (Result < 0)
+            RingJob->Result = file::Error_FileWrite;
+        Ring_Close(RingJob);
+        return false;
+    case uring_job::Step_Close:
+        if (Result < 0 && !RingJob->Result)
+            RingJob->Result = file::Error_FileWrite;
+        if (RingJob->Result)
+            Job->Error(RingJob->Result);
+        else
+            Job->Written();
+        break;
+    }
+
+    if (RingJob->Begin)
+        trace::Add_Async("write", "write", (uintptr_t)Job, RingJob->Begin, "bytes", RingJob->Size);
+    delete RingJob;
+    Job_Done(Job);
+    return true;
+}
+#endif // ASYNCWRITER_IOURING
+
+//***************************************************************************
+// Jobs
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+async_writer::async_writer(buffer_pool* Buffers_Source) :
+    MaxInFlight(Buffers_Source->MaxInFlight()),
+    Buffers(Buffers_Source)
+{
+    Pool = new ThreadPool(AsyncWriter_ThreadCount);
+    Pool->init();
+
+    #ifdef ASYNCWRITER_IOURING
+        Ring = new uring;
+        if (Ring->Init(AsyncWriter_RingEntries))
+        {
+            delete Ring;
+            Ring = nullptr;
+        }
+        else
+            Ring_Thread = new thread(&async_writer::Ring_Run, this);
+    #endif
+}
+
+//---------------------------------------------------------------------------
+async_writer::~async_writer()
+{
+    Wait();
+
+    if (Ring_Thread)
+    {
+        {
+            lock_guard<mutex> Lock(Mutex);
+            Ring_IsStopping = true;
+        }
+        Ring_HasPending.notify_one();
+        Ring_Thread->join();
+        delete Ring_Thread;
+    }
+    #ifdef ASYNCWRITER_IOURING
+        delete Ring;
+    #endif
+
+    Pool->shutdown();
+    delete Pool;
+}
+
+//---------------------------------------------------------------------------
+void async_writer::Write(job* Job)
+{
+    size_t Size = 0;
+    for (const auto& Buffer : Job->Content)
+        Size += Buffer.Size();
+
+    {
+        stats_scope Stats_Wait(stage::Write, 0, 0, true);
+        unique_lock<mutex> Lock(Mutex);
+        IsDone.wait(Lock, [&] { return !InFlight || InFlight + Size <= MaxInFlight; });
+        InFlight += Size;
+        InFlight_Count++;
+        if (Ring)
+        {
+            Ring_Pending.push_back(Job);
+            Ring_HasPending.notify_one();
+            return;
+        }
+    }
+
+    Pool->submit([this, Job]() { Job_Run(Job); Job_Done(Job); });
+}
+
+//---------------------------------------------------------------------------
+void async_writer::Wait()
+{
+    unique_lock<mutex> Lock(Mutex);
+    IsDone.wait(Lock, [this] { return !InFlight_Count; });
+}
+
+//---------------------------------------------------------------------------
+void async_writer::Job_Run(job* Job)
+{
+    stats_scope Stats(stage::Write);
+    trace_scope Trace("write", "write");
+    file File;
+    auto Result = File.Open_WriteMode(Job->BaseDirectory, Job->FileName, true);
+    if (Result == file::Error_FileAlreadyExists)
+    {
+        Job->AlreadyExists();
+        return;
+    }
+    if (!Result)
+        Result = File.Write(Job->Content);
+    if (!Result && Job->Sync)
+        Result = File.Sync();
+    if (!Result)
+        Result = File.Close();
+    if (Result)
+        Job->Error(Result);
+    else
+        Job->Written();
+}
+
+//---------------------------------------------------------------------------
+void async_writer::Job_Done(job* Job)
+{
+    size_t Size = 0;
+    for (auto& Buffer : Job->Content)
+    {
+        Size += Buffer.Size();
+        Buffers->Release(Buffer);
+    }
+    {
+        lock_guard<mutex> Lock(Mutex);
+        InFlight -= Size;
+        InFlight_Count--;
+    }
+    IsDone.notify_all();
+    stats::Add(stage::Write, Size, 1);
+
+    delete Job;
+}
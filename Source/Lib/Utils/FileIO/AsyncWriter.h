@@ -0,0 +1,88 @@
+/*  Copyright (c) MediaArea.net SARL & AV Preservation by reto.ch.
+ *
+ *  Use of this source code is governed by a BSD-style license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//---------------------------------------------------------------------------
+#ifndef AsyncWriterH
+#define AsyncWriterH
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+#include "Lib/Utils/FileIO/FileIO.h"
+#include "Lib/Utils/Buffer/BufferPool.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+class ThreadPool;
+using namespace std;
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+// Write-behind of whole files: create, vectored write of the content, close
+// io_uring is used if available, else a dedicated thread pool is used
+class async_writer
+{
+public:
+    // Constructor / Destructor
+    async_writer(buffer_pool* Buffers_Source); // Content of jobs is released to Buffers, size of data in flight is limited by its budget
+    ~async_writer();
+
+    // Job, the file must not exist, else AlreadyExists() is called instead of writing
+    class job
+    {
+    public:
+        virtual ~job() {}
+
+        string                  BaseDirectory;
+        string                  FileName;
+        vector<buffer>          Content;
+        bool                    Sync = false; // Flush content to stable storage before closing
+
+        virtual void            AlreadyExists() = 0; // Called from a writer thread, may block
+        virtual void            Error(file::return_value Result) = 0; // Called from a writer thread
+        virtual void            Written() {} // Called from a writer thread after the file is closed
+    };
+
+    // Actions
+    void                        Write(job* Job); // Takes ownership of the job, waits if too much data is in flight
+    void                        Wait(); // Wait for all jobs to be done
+    buffer                      Buffer_Get(size_t Size) { return Buffers->Get(Size); } // Recycled buffer if available
+
+    // Info
+    bool                        IsRing() { return Ring != nullptr; }
+
+private:
+    // Jobs
+    void                        Job_Run(job* Job);
+    void                        Job_Done(job* Job);
+    size_t                      MaxInFlight;
+    size_t                      InFlight = 0;
+    size_t                      InFlight_Count = 0;
+    buffer_pool*                Buffers;
+    mutex                       Mutex;
+    condition_variable          IsDone;
+    ThreadPool*                 Pool = nullptr;
+
+    // io_uring
+    struct uring;
+    struct uring_job;
+    void                        Ring_Run();
+    bool                        Ring_Open(uring_job* RingJob);
+    void                        Ring_Write(uring_job* RingJob);
+    void                        Ring_Sync(uring_job* RingJob);
+    void                        Ring_Close(uring_job* RingJob);
+    bool                        Ring_Next(uring_job* RingJob, int Result);
+    uring*                      Ring = nullptr;
+    thread*                     Ring_Thread = nullptr;
+    deque<job*>                 Ring_Pending;
+    condition_variable          Ring_HasPending;
+    bool                        Ring_IsStopping = false;
+};
+
+//---------------------------------------------------------------------------
+#endif
@@ -0,0 +1,238 @@
+/*  Copyright (c) MediaArea.net SARL & AV Preservation by reto.ch.
+ *
+ *  Use of this source code is governed by a BSD-style license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//---------------------------------------------------------------------------
+#ifndef _GNU_SOURCE
+    #define _GNU_SOURCE // Needed for syncfs on GNU compiler
+#endif
+#include "Lib/Utils/FileIO/Durability.h"
+#include "Lib/Utils/FileIO/FileIO.h"
+#include "Lib/Utils/FileIO/Journal.h"
+#include <set>
+#if defined(_WIN32) || defined(_WINDOWS)
+    #include "windows.h"
+#else
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+durable_writes::durable_writes(durability Mode_Source, size_t MaxFiles_Source, size_t MaxBytes_Source) :
+    Mode_(Mode_Source),
+    MaxFiles(MaxFiles_Source),
+    MaxBytes(MaxBytes_Source)
+{
+    if (Mode_ == durability::Batch)
+        Thread = new thread(&durable_writes::Run, this);
+}
+
+//---------------------------------------------------------------------------
+durable_writes::~durable_writes()
+{
+    Finish();
+    if (Thread)
+    {
+        {
+            lock_guard<mutex> Lock(Mutex);
+            IsFinishing = true;
+        }
+        Cond.notify_all();
+        Thread->join();
+        delete Thread;
+    }
+}
+
+//---------------------------------------------------------------------------
+size_t durable_writes::Begin()
+{
+    lock_guard<mutex> Lock(Mutex);
+    return ID_Next++;
+}
+
+//---------------------------------------------------------------------------
+void durable_writes::End(size_t ID, const string& FullName, size_t Size, const string& Journal_Name, const hash_value& Journal_Hash)
+{
+    switch (Mode_)
+    {
+        case durability::File:
+            // Content is already flushed, directory entry must be flushed too
+            if (file::SyncDirectory(FullName))
+            {
+                lock_guard<mutex> Lock(Mutex);
+                IsError = true;
+                Closed(ID, string());
+                return;
+            }
+            {
+                lock_guard<mutex> Lock(Mutex);
+                Closed(ID, FullName);
+                LastDurable_ = LastClosed;
+            }
+            Journal_Add({ { FullName, Journal_Name, Size, Journal_Hash } });
+            break;
+        case durability::Batch:
+            {
+                lock_guard<mutex> Lock(Mutex);
+                Closed(ID, FullName);
+                Pending.push_back({ FullName, Journal_Name, Size, Journal_Hash });
+                Pending_Size += Size;
+                if (Pending.size() < MaxFiles && Pending_Size < MaxBytes)
+                    return;
+            }
+            Cond.notify_all();
+            break;
+        default:
+            Cancel(ID);
+    }
+}
+
+//---------------------------------------------------------------------------
+void durable_writes::Cancel(size_t ID)
+{
+    lock_guard<mutex> Lock(Mutex);
+    Closed(ID, string());
+    if (Mode_ == durability::File)
+        LastDurable_ = LastClosed;
+}
+
+//---------------------------------------------------------------------------
+// Must be called with the lock
+void durable_writes::Closed(size_t ID, const string& FullName)
+{
+    ID_Closed[ID] = FullName;
+    for (auto Item = ID_Closed.begin(); Item != ID_Closed.end() && Item->first == ID_Closed_Count; Item = ID_Closed.erase(Item))
+    {
+        if (!Item->second.empty())
+            LastClosed = Item->second;
+        ID_Closed_Count++;
+    }
+}
+
+//---------------------------------------------------------------------------
+void durable_writes::Finish()
+{
+    if (!Thread)
+        return;
+
+    // Group commit of remaining files
+    unique_lock<mutex> Lock(Mutex);
+    if (!Pending.empty())
+    {
+        Pending_Size = MaxBytes; // Force the flush
+        Cond.notify_all();
+    }
+    Cond.wait(Lock, [this] { return Pending.empty() && !IsSyncing; });
+}
+
+//---------------------------------------------------------------------------
+string durable_writes::LastDurable()
+{
+    lock_guard<mutex> Lock(Mutex);
+    return LastDurable_;
+}
+
+//---------------------------------------------------------------------------
+void durable_writes::Run()
+{
+    unique_lock<mutex> Lock(Mutex);
+    for (;;)
+    {
+        Cond.wait(Lock, [this] { return IsFinishing || Pending.size() >= MaxFiles || Pending_Size >= MaxBytes; });
+        if (Pending.empty())
+        {
+            if (IsFinishing)
+                return;
+            Pending_Size = 0;
+            continue;
+        }
+
+        // All files closed before the flush will be durable after it
+        vector<pending> Files;
+        Files.swap(Pending);
+        Pending_Size = 0;
+        auto LastClosed_Current = LastClosed;
+        IsSyncing = true;
+        Lock.unlock();
+
+        auto HasError = Sync(Files);
+        if (!HasError)
+            Journal_Add(Files);
+
+        Lock.lock();
+        IsSyncing = false;
+        if (HasError)
+            IsError = true;
+        else
+            LastDurable_ = LastClosed_Current;
+        Cond.notify_all();
+    }
+}
+
+//---------------------------------------------------------------------------
+bool durable_writes::Sync(const vector<pending>& Files)
+{
+    bool HasError = false;
+    set<string> Directories;
+    for (const auto& File : Files)
+    {
+        auto Separator = File.FullName.find_last_of("/\\");
+        Directories.insert(Separator == string::npos ? string() : File.FullName.substr(0, Separator + 1));
+    }
+
+#if defined(__linux__)
+    // Whole file system of each directory, once per file system (directories are usually all on the same one)
+    set<dev_t> Devices;
+    for (const auto& Directory : Directories)
+    {
+        size_t FileName_Offset;
+        auto Handle = directory_cache::Global().Get(Directory, FileName_Offset);
+        struct stat Stat;
+        if (!Handle || fstat(Handle->Fd, &Stat))
+        {
+            HasError = true;
+            continue;
+        }
+        if (!Devices.insert(Stat.st_dev).second)
+            continue;
+        if (syncfs(Handle->Fd))
+            HasError = true;
+    }
+#else
+    // Each file then each directory is flushed
+    for (const auto& Pending_File : Files)
+    {
+        file File;
+        if (File.Open_WriteMode(string(), Pending_File.FullName) || File.Sync() || File.Close())
+            HasError = true;
+    }
+    for (const auto& Directory : Directories)
+        if (file::SyncDirectory(Directory))
+            HasError = true;
+#endif
+
+    return HasError;
+}
+
+//---------------------------------------------------------------------------
+// Files are durable, they can be listed as complete
+void durable_writes::Journal_Add(const vector<pending>& Files)
+{
+    if (!Journal)
+        return;
+    bool IsAdded = false;
+    for (const auto& File : Files)
+        if (!File.Journal_Name.empty())
+        {
+            Journal->Add(File.Journal_Name, File.Size, File.Journal_Hash);
+            IsAdded = true;
+        }
+    if (IsAdded && Journal->Sync())
+    {
+        lock_guard<mutex> Lock(Mutex);
+        IsError = true;
+    }
+}
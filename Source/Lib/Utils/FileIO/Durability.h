@@ -0,0 +1,83 @@
+/*  Copyright (c) MediaArea.net SARL & AV Preservation by reto.ch.
+ *
+ *  Use of this source code is governed by a BSD-style license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//---------------------------------------------------------------------------
+#ifndef DurabilityH
+#define DurabilityH
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+#include "Lib/Config.h"
+#include "Lib/Utils/Hash/Hash.h"
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+using namespace std;
+class journal;
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+// Tracking of written files until they are on stable storage
+// Files are numbered in the order they are opened, the last durable file is
+// the last one such that all files opened before are durable
+// Journal entries of files are appended only once the files are durable
+class durable_writes
+{
+public:
+    // Constructor / Destructor
+    durable_writes(durability Mode_Source, size_t MaxFiles_Source = 256, size_t MaxBytes_Source = 256 * 1024 * 1024);
+    ~durable_writes();
+
+    // Actions
+    size_t                      Begin(); // Returns the ID of a file being written
+    void                        End(size_t ID, const string& FullName, size_t Size, const string& Journal_Name = string(), const hash_value& Journal_Hash = hash_value()); // The file is written and closed
+    void                        Cancel(size_t ID); // Nothing to flush, e.g. the file was not written
+    void                        Finish(); // Flush all pending files
+    void                        SetJournal(journal* Journal_Source) { Journal = Journal_Source; }
+
+    // Info
+    durability                  Mode() { return Mode_; }
+    bool                        SyncOnClose() { return Mode_ == durability::File; } // Each file must be flushed before closing
+    string                      LastDurable(); // Empty if no file is durable yet
+    bool                        HasErrors() { return IsError; }
+
+private:
+    struct pending
+    {
+        string                  FullName;
+        string                  Journal_Name; // Empty if not in the journal
+        size_t                  Size;
+        hash_value              Journal_Hash;
+    };
+    void                        Closed(size_t ID, const string& FullName);
+    void                        Run();
+    bool                        Sync(const vector<pending>& Files); // Returns true on error
+    void                        Journal_Add(const vector<pending>& Files);
+
+    durability                  Mode_;
+    size_t                      MaxFiles;
+    size_t                      MaxBytes;
+    size_t                      ID_Next = 0;
+    map<size_t, string>         ID_Closed; // Closed files after a gap in IDs
+    size_t                      ID_Closed_Count = 0; // All files with a lower ID are closed
+    string                      LastClosed; // Last file of the contiguous closed files
+    string                      LastDurable_;
+    vector<pending>             Pending;
+    size_t                      Pending_Size = 0;
+    bool                        IsFinishing = false;
+    bool                        IsSyncing = false;
+    bool                        IsError = false;
+    mutex                       Mutex;
+    condition_variable          Cond;
+    thread*                     Thread = nullptr;
+    journal*                    Journal = nullptr;
+};
+
+//---------------------------------------------------------------------------
+#endif
@@ -26,6 +26,7 @@ namespace filechecker_issue {
             "extra frame in compressed file",
             "missing frame in source (extra frames in compressed file)",
             "extra frame in source (missing frames in compressed file)",
+            "checksum of compressed frame is wrong",
         };
 
         namespace undecodable { static_assert(Max == sizeof(MessageText) / sizeof(const char*), IncoherencyMessage); }
@@ -19,12 +19,15 @@
     #define mkdir _mkdir
     #define stat _stat
 #else
+    #include <cerrno>
     #include <dirent.h>
     #include <fcntl.h>
     #include <glob.h>
     #include <unistd.h>
+    #include <climits>
     #include <sys/stat.h>
     #include <sys/mman.h>
+    #include <sys/uio.h>
 #endif
 //---------------------------------------------------------------------------
 
@@ -180,6 +183,88 @@ int filemap::Close()
     return 0;
 }
 
+//---------------------------------------------------------------------------
+// directory_cache
+
+#if !defined(_WIN32) && !defined(_WINDOWS)
+static const size_t DirectoryCache_Max = 256; // Limit of open handles
+
+directory_cache::handle::~handle()
+{
+    close(Fd);
+}
+
+directory_cache& directory_cache::Global()
+{
+    static directory_cache Cache;
+    return Cache;
+}
+
+directory_cache::handle_ptr directory_cache::Get(const string& FullName, size_t& FileName_Offset)
+{
+    auto Separator = FullName.rfind('/');
+    FileName_Offset = Separator == string::npos ? 0 : (Separator + 1);
+
+    lock_guard<mutex> Lock(Mutex);
+    return Get_Directory(Separator == string::npos ? string(".") : FullName.substr(0, Separator));
+}
+
+directory_cache::handle_ptr directory_cache::Get_Directory(string DirectoryName)
+{
+    while (DirectoryName.size() > 1 && DirectoryName.back() == '/')
+        DirectoryName.pop_back();
+    if (DirectoryName.empty())
+        DirectoryName = '/';
+
+    auto Handle = Handles.find(DirectoryName);
+    if (Handle != Handles.end())
+        return Handle->second;
+
+    // Open the directory, create it relative to its parent if it does not exist
+    const int Flags = O_RDONLY | O_DIRECTORY | O_CLOEXEC;
+    int Fd = open(DirectoryName.c_str(), Flags);
+    if (Fd == -1 && errno == ENOENT)
+    {
+        handle_ptr Parent;
+        int Parent_Fd = AT_FDCWD;
+        auto Separator = DirectoryName.rfind('/');
+        if (Separator != string::npos)
+        {
+            Parent = Get_Directory(DirectoryName.substr(0, Separator ? Separator : 1));
+            if (!Parent)
+                return nullptr;
+            Parent_Fd = Parent->Fd;
+        }
+        auto Name = DirectoryName.c_str() + (Separator == string::npos ? 0 : (Separator + 1));
+        if (mkdirat(Parent_Fd, Name, S_IRUSR | S_IWUSR | S_IXUSR | S_IRGRP | S_IXGRP | S_IROTH | S_IXOTH) && errno != EEXIST) // Directory may have been created by another process in the meantime
+            return nullptr;
+        Fd = openat(Parent_Fd, Name, Flags);
+    }
+    if (Fd == -1)
+        return nullptr;
+
+    // Handles still in use stay open until they are released
+    if (Handles.size() >= DirectoryCache_Max)
+        Handles.clear();
+    auto NewHandle = make_shared<handle>(Fd);
+    Handles[DirectoryName] = NewHandle;
+    return NewHandle;
+}
+
+void directory_cache::Remove(const string& FullName)
+{
+    // Parents are removed too, they may be the ones which no more exist
+    lock_guard<mutex> Lock(Mutex);
+    for (auto Handle = Handles.begin(); Handle != Handles.end();)
+    {
+        if (!FullName.compare(0, Handle->first.size(), Handle->first))
+            Handle = Handles.erase(Handle);
+        else
+            ++Handle;
+    }
+}
+#endif //!defined(_WIN32) && !defined(_WINDOWS)
+
 //---------------------------------------------------------------------------
 // file
 
@@ -194,46 +279,50 @@ file::return_value file::Open_WriteMode(const string& BaseDirectory, const strin
     DWORD CreationDisposition = Truncate ? (RejectIfExists ? TRUNCATE_EXISTING : CREATE_ALWAYS) : (RejectIfExists ? CREATE_NEW : OPEN_ALWAYS);
     P = CreateFileA(FullName.c_str(), GENERIC_WRITE, 0, 0, CreationDisposition, FILE_ATTRIBUTE_NORMAL, 0);
     if (P == INVALID_HANDLE_VALUE)
-#else
-    int& P = (int&)Private;
-    const int flags = O_WRONLY | O_CREAT | (RejectIfExists ? O_EXCL : 0) | (Truncate ? O_TRUNC : 0);
-    const mode_t Mode = S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH;
-    P = open(FullName.c_str(), flags, Mode);
-    if (P == -1)
-#endif
     {
-        size_t i = 0;
-        for (;;)
+        if (CreateDirectories(FullName))
         {
-            i = FullName.find_first_of("/\\", i + 1);
-            if (i == (size_t)-1)
-                break;
-            string t = FullName.substr(0, i);
-            if (access(t.c_str(), 0))
-            {
-                #if defined(_WIN32) || defined(_WINDOWS)
-                if (mkdir(t.c_str()))
-                #else
-                if (mkdir(t.c_str(), S_IRUSR | S_IWUSR | S_IXUSR | S_IRGRP | S_IXGRP | S_IROTH | S_IXOTH))
-                #endif
-                {
-                    Private = (void*)-1;
-                    return Error_CreateDirectory;
-                }
-            }
+            Private = (void*)-1;
+            return Error_CreateDirectory;
         }
-#if defined(_WIN32) || defined(_WINDOWS)
         P = CreateFileA(FullName.c_str(), GENERIC_WRITE, 0, 0, CreationDisposition, FILE_ATTRIBUTE_NORMAL, 0);
         if (P == INVALID_HANDLE_VALUE)
+        {
+            Private = (void*)-1;
+            return (access(FullName.c_str(), 0)) ? (RejectIfExists ? Error_FileCreate : Error_FileWrite) : Error_FileAlreadyExists;
+        }
+    }
 #else
-        P = open(FullName.c_str(), flags, Mode);
-        if (P == -1)
-#endif
+    // Directory is resolved once per run, the file is created relative to it
+    int& P = (int&)Private;
+    const int flags = O_WRONLY | O_CREAT | O_CLOEXEC | (RejectIfExists ? O_EXCL : 0) | (Truncate ? O_TRUNC : 0);
+    const mode_t Mode = S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH;
+    auto& Directories = directory_cache::Global();
+    for (int i = 0; i < 2; i++)
+    {
+        size_t FileName_Offset;
+        auto Directory = Directories.Get(FullName, FileName_Offset);
+        if (!Directory)
+        {
+            Private = (void*)-1;
+            return Error_CreateDirectory;
+        }
+        P = openat(Directory->Fd, FullName.c_str() + FileName_Offset, flags, Mode);
+        if (P != -1)
+            break;
+        if (errno == EEXIST)
+        {
+            Private = (void*)-1;
+            return Error_FileAlreadyExists;
+        }
+        if (errno != ENOENT || i)
         {
             Private = (void*)-1;
             return (access(FullName.c_str(), 0)) ? (RejectIfExists ? Error_FileCreate : Error_FileWrite) : Error_FileAlreadyExists;
         }
+        Directories.Remove(FullName); // Cached directory no more exists, try again from scratch
     }
+#endif
 
     OutputFileName = OutputFileName_Source;
     return OK;
@@ -242,6 +331,32 @@ file::return_value file::Open_WriteMode(const string& BaseDirectory, const strin
 //---------------------------------------------------------------------------
 // file
 
+file::return_value file::CreateDirectories(const string& FullName)
+{
+    size_t i = 0;
+    for (;;)
+    {
+        i = FullName.find_first_of("/\\", i + 1);
+        if (i == (size_t)-1)
+            break;
+        string t = FullName.substr(0, i);
+        if (access(t.c_str(), 0))
+        {
+            #if defined(_WIN32) || defined(_WINDOWS)
+            if (mkdir(t.c_str()) && access(t.c_str(), 0)) // Directory may have been created by another thread in the meantime
+            #else
+            if (mkdir(t.c_str(), S_IRUSR | S_IWUSR | S_IXUSR | S_IRGRP | S_IXGRP | S_IROTH | S_IXOTH) && access(t.c_str(), 0)) // Directory may have been created by another thread in the meantime
+            #endif
+                return Error_CreateDirectory;
+        }
+    }
+
+    return OK;
+}
+
+//---------------------------------------------------------------------------
+// file
+
 file::return_value file::Write(const uint8_t* Data, size_t Size)
 {
     // Handle size of 0
@@ -273,7 +388,7 @@ file::return_value file::Write(const uint8_t* Data, size_t Size)
     while (Offset < Size)
     {
         size_t Size_Temp = Size - Offset;
-        BytesWritten = write(P, Data, Size_Temp);
+        BytesWritten = write(P, Data + Offset, Size_Temp);
         if (BytesWritten == 0 || BytesWritten == -1)
             break;
         Offset += (size_t)BytesWritten;
@@ -290,6 +405,49 @@ file::return_value file::Write(const uint8_t* Data, size_t Size)
 //---------------------------------------------------------------------------
 // file
 
+file::return_value file::Write(const vector<buffer>& Buffers)
+{
+#if defined(_WIN32) || defined(_WINDOWS)
+    for (const auto& Buffer : Buffers)
+        if (auto Result = Write(Buffer))
+            return Result;
+#else
+    // Vectored write, resumed after the last written byte in case of partial write
+    int& P = (int&)Private;
+    vector<iovec> IOV;
+    IOV.reserve(Buffers.size());
+    for (const auto& Buffer : Buffers)
+        if (Buffer.Size())
+            IOV.push_back({ Buffer.Data(), Buffer.Size() });
+    auto IOV_Current = IOV.data();
+    auto IOV_End = IOV_Current + IOV.size();
+    while (IOV_Current < IOV_End)
+    {
+        auto IOV_Count = IOV_End - IOV_Current;
+        if (IOV_Count > IOV_MAX)
+            IOV_Count = IOV_MAX;
+        auto BytesWritten = writev(P, IOV_Current, (int)IOV_Count);
+        if (BytesWritten == 0 || BytesWritten == -1)
+            return Error_FileWrite;
+        while (IOV_Current < IOV_End && (size_t)BytesWritten >= IOV_Current->iov_len)
+        {
+            BytesWritten -= IOV_Current->iov_len;
+            IOV_Current++;
+        }
+        if (BytesWritten)
+        {
+            IOV_Current->iov_base = (uint8_t*)IOV_Current->iov_base + BytesWritten;
+            IOV_Current->iov_len -= BytesWritten;
+        }
+    }
+#endif
+
+    return OK;
+}
+
+//---------------------------------------------------------------------------
+// file
+
 file::return_value file::Seek(int64_t Offset, seek_value Method)
 {
     if (Private == (void*)-1)
@@ -349,6 +507,45 @@ file::return_value file::SetEndOfFile()
 //---------------------------------------------------------------------------
 // file
 
+file::return_value file::Sync()
+{
+    if (Private == (void*)-1)
+        return Error_FileWrite;
+
+#if defined(_WIN32) || defined(_WINDOWS)
+    HANDLE& P = (HANDLE&)Private;
+    if (FlushFileBuffers(P) == 0)
+#else
+    int& P = (int&)Private;
+    if (fsync(P))
+#endif
+        return Error_FileWrite;
+
+    return OK;
+}
+
+//---------------------------------------------------------------------------
+// file
+
+file::return_value file::SyncDirectory(const string& FullName)
+{
+#if defined(_WIN32) || defined(_WINDOWS)
+    (void)FullName; // Directory entries are flushed with the file
+#else
+    size_t FileName_Offset;
+    auto Directory = directory_cache::Global().Get(FullName, FileName_Offset);
+    if (!Directory)
+        return Error_FileWrite;
+    if (fsync(Directory->Fd))
+        return Error_FileWrite;
+#endif
+
+    return OK;
+}
+
+//---------------------------------------------------------------------------
+// file
+
 file::return_value file::Close()
 {
     if (Private == (void*)-1)
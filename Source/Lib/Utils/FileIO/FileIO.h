@@ -12,6 +12,10 @@
 //---------------------------------------------------------------------------
 #include "Lib/Utils/Errors/Errors.h"
 #include "Lib/Utils/RawFrame/RawFrame.h"
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
 using namespace std;
 //---------------------------------------------------------------------------
 
@@ -38,6 +42,36 @@ private:
     #endif //defined(_WIN32) || defined(_WINDOWS)
 };
 
+#if !defined(_WIN32) && !defined(_WINDOWS)
+// Cache of open directory handles, each directory is resolved (and created
+// if needed) only once, files are then created relative to their directory
+class directory_cache
+{
+public:
+    class handle
+    {
+    public:
+                                handle(int Fd_Source) : Fd(Fd_Source) {}
+                                ~handle();
+        const int               Fd;
+    };
+    typedef shared_ptr<handle>  handle_ptr;
+
+    // Handle of the directory containing FullName, nullptr if it can not be created
+    // FileName_Offset receives the position of the file name in FullName
+    handle_ptr                  Get(const string& FullName, size_t& FileName_Offset);
+    void                        Remove(const string& FullName); // e.g. directory removed by another process
+
+    // Shared by all files of the process
+    static directory_cache&     Global();
+
+private:
+    handle_ptr                  Get_Directory(string DirectoryName);
+    map<string, handle_ptr>     Handles;
+    mutex                       Mutex;
+};
+#endif //!defined(_WIN32) && !defined(_WINDOWS)
+
 class file
 {
 public:
@@ -58,6 +92,7 @@ public:
     bool                        IsOpen() { return Private == (void*)-1 ? false : true; }
     return_value                Write(const uint8_t* Buffer, size_t Size);
     return_value                Write(const buffer_base& Buffer) { return Write(Buffer.Data(), Buffer.Size()); }
+    return_value                Write(const vector<buffer>& Buffers);
     enum seek_value
     {
         Begin,
@@ -66,8 +101,13 @@ public:
     };
     return_value                Seek(int64_t Offset, seek_value Method = Begin);
     return_value                SetEndOfFile();
+    return_value                Sync(); // Flush content to stable storage
     return_value                Close();
 
+    // Helpers
+    static return_value         CreateDirectories(const string& FullName); // Create all directories of the path, file name excluded
+    static return_value         SyncDirectory(const string& FullName); // Flush the directory entry of the file to stable storage
+
 private:
     void*                       Private = (void*)-1;
     string                      OutputFileName;
@@ -0,0 +1,142 @@
+/*  Copyright (c) MediaArea.net SARL & AV Preservation by reto.ch.
+ *
+ *  Use of this source code is governed by a BSD-style license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//---------------------------------------------------------------------------
+#include "Lib/Utils/FileIO/FileVerifier.h"
+#include "Lib/Utils/FileIO/FileIO.h"
+#include "Lib/Utils/FileIO/FileWriter.h"
+#include "Lib/Compressed/RAWcooked/Reversibility.h"
+#include "Lib/Utils/Stats/Trace.h"
+#ifdef __GNUC__
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wreorder"
+#endif
+#include "ThreadPool.h"
+#ifdef __GNUC__
+#pragma GCC diagnostic pop
+#endif
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+file_verifier::file_verifier(const string& BaseDirectory_Source, ThreadPool* Pool_Source, reversibility* ReversibilityData_Source, frame_writer* FrameWriter_Source, size_t Window_Source) :
+    BaseDirectory(BaseDirectory_Source),
+    Pool(Pool_Source),
+    ReversibilityData(ReversibilityData_Source),
+    FrameWriter(FrameWriter_Source),
+    Window(Window_Source),
+    Count(ReversibilityData_Source->Count())
+{
+}
+
+//---------------------------------------------------------------------------
+file_verifier::~file_verifier()
+{
+    // Jobs in the pool use this object
+    unique_lock<mutex> Lock(Mutex);
+    Cond.wait(Lock, [this] { return !InFlight; });
+}
+
+//---------------------------------------------------------------------------
+void file_verifier::Get(size_t Pos, item& Item)
+{
+    Item.FileName = ReversibilityData->Data(reversibility::element::FileName, Pos);
+    FormatPath(Item.FileName);
+    if (FrameWriter->ExpectedHash(Item.FileName, Item.Hash))
+        Item.State = state::Unknown;
+    else
+        Item.State = state::Different; // Nothing to compare with
+    Item.Size = ReversibilityData->FileSize(Pos);
+    if (Item.Size == (uint64_t)-1)
+        Item.Size = 0;
+}
+
+//---------------------------------------------------------------------------
+bool file_verifier::IsSame(size_t Pos, hash_value& Hash)
+{
+    if (Pos >= Count)
+        return false;
+
+    if (!Pool)
+    {
+        item Item;
+        Get(Pos, Item);
+        if (Item.State == state::Unknown && Verify(Item))
+        {
+            Hash = Item.Hash;
+            return true;
+        }
+        return false;
+    }
+
+    Submit(Pos + Window);
+    unique_lock<mutex> Lock(Mutex);
+
+    // Previous items are no more needed, except if still used by the pool (position skipped by the caller)
+    while (Items_Pos < Pos && Items.front().State != state::Pending)
+    {
+        Items.pop_front();
+        Items_Pos++;
+    }
+    if (Pos < Items_Pos)
+        return false; // Already removed, positions are not increasing
+    auto& Item = Items[Pos - Items_Pos];
+    Cond.wait(Lock, [&Item] { return Item.State == state::Same || Item.State == state::Different; });
+
+    if (Item.State != state::Same)
+        return false;
+    Hash = Item.Hash;
+    return true;
+}
+
+//---------------------------------------------------------------------------
+void file_verifier::Submit(size_t Pos_Max)
+{
+    if (Pos_Max > Count)
+        Pos_Max = Count;
+
+    for (; Submitted < Pos_Max; Submitted++)
+    {
+        item New;
+        Get(Submitted, New); // Without the lock, reversibility data and hashes are read by this thread only
+        lock_guard<mutex> Lock(Mutex);
+        Items.push_back(move(New)); // deque does not move the items being verified
+        auto& Item = Items.back();
+        if (Item.State != state::Unknown)
+            continue;
+        Item.State = state::Pending;
+        InFlight++;
+        Pool->submit([this, &Item]()
+        {
+            auto Result = Verify(Item) ? state::Same : state::Different;
+            {
+                lock_guard<mutex> Lock(Mutex);
+                Item.State = Result;
+                InFlight--;
+            }
+            Cond.notify_all();
+        });
+    }
+}
+
+//---------------------------------------------------------------------------
+bool file_verifier::Verify(const item& Item)
+{
+    trace_scope Trace("verify", "hash", "bytes", Item.Size);
+    filemap File;
+    if (File.Open_ReadMode(BaseDirectory + Item.FileName))
+        return false; // File is not present
+    if (Item.Size && File.Size() != Item.Size)
+        return false;
+
+    auto Hash = hash_base::New(Item.Hash.Format);
+    if (!Hash)
+        return false;
+    Hash->Update(File.Data(), File.Size());
+    auto IsSame = Hash->Final() == Item.Hash;
+    delete Hash;
+
+    return IsSame;
+}
@@ -0,0 +1,75 @@
+/*  Copyright (c) MediaArea.net SARL & AV Preservation by reto.ch.
+ *
+ *  Use of this source code is governed by a BSD-style license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//---------------------------------------------------------------------------
+#ifndef FileVerifierH
+#define FileVerifierH
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+#include "Lib/Config.h"
+#include "Lib/Utils/Hash/Hash.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+class ThreadPool;
+class reversibility;
+class frame_writer;
+using namespace std;
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+// Comparison of existing output files with their expected hash, without
+// decoding them
+// Files are hashed by the pool a few frames ahead of their use, so reading
+// existing files is done in parallel with decoding of the missing ones
+// File names are read from the reversibility data only for these frames
+class file_verifier
+{
+public:
+    // Constructor / Destructor
+    file_verifier(const string& BaseDirectory_Source, ThreadPool* Pool_Source, reversibility* ReversibilityData_Source, frame_writer* FrameWriter_Source, size_t Window_Source = 64);
+    ~file_verifier();
+
+    // Actions
+    bool                        IsSame(size_t Pos, hash_value& Hash); // Returns true if the existing file has the expected hash, positions must be increasing
+
+private:
+    enum class state : uint8_t
+    {
+        Unknown,
+        Pending,
+        Same,
+        Different,
+    };
+    struct item
+    {
+        string                  FileName;
+        hash_value              Hash;
+        uint64_t                Size;
+        state                   State;
+    };
+    void                        Get(size_t Pos, item& Item);
+    void                        Submit(size_t Pos_Max);
+    bool                        Verify(const item& Item);
+
+    string                      BaseDirectory;
+    ThreadPool*                 Pool;
+    reversibility*              ReversibilityData;
+    frame_writer*               FrameWriter;
+    size_t                      Window;
+    size_t                      Count;
+    deque<item>                 Items; // From Items_Pos to Submitted
+    size_t                      Items_Pos = 0;
+    size_t                      Submitted = 0;
+    size_t                      InFlight = 0;
+    mutex                       Mutex;
+    condition_variable          Cond;
+};
+
+//---------------------------------------------------------------------------
+#endif
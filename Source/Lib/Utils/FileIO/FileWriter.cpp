@@ -6,13 +6,16 @@
 
 //---------------------------------------------------------------------------
 #include "Lib/Utils/FileIO/FileWriter.h"
+#include "Lib/Utils/FileIO/AsyncWriter.h"
+#include "Lib/Utils/FileIO/Durability.h"
+#include "Lib/Utils/FileIO/FileVerifier.h"
+#include "Lib/Utils/FileIO/Journal.h"
 #include "Lib/Compressed/Matroska/Matroska.h"
 #include "Lib/Uncompressed/HashSum/HashSum.h"
 #include "Lib/Utils/FileIO/FileChecker.h"
-extern "C"
-{
-#include "md5.h"
-}
+#include "Lib/Utils/Stats/Stats.h"
+#include "Lib/Utils/Stats/Trace.h"
+#include <algorithm>
 //---------------------------------------------------------------------------
 
 //---------------------------------------------------------------------------
@@ -58,16 +61,142 @@ static_assert(error::type_Max == sizeof(ErrorTexts) / sizeof(const char**), Inco
 
 } // filewriter_issue
 
+//---------------------------------------------------------------------------
+bool CheckFile_Compare(size_t& Offset, const filemap& File, const buffer_base& Buffer);
+
+//---------------------------------------------------------------------------
+static void FileWriter_Error(errors* Errors, file::return_value Result, const string& OutputFileName)
+{
+    if (!Errors)
+        return;
+    switch (Result)
+    {
+        case file::Error_CreateDirectory:       Errors->Error(IO_FileWriter, error::type::Undecodable, (error::generic::code)filewriter_issue::undecodable::CreateDirectory, OutputFileName); break;
+        case file::Error_FileCreate:            Errors->Error(IO_FileWriter, error::type::Undecodable, (error::generic::code)filewriter_issue::undecodable::FileCreate, OutputFileName); break;
+        default:                                Errors->Error(IO_FileWriter, error::type::Undecodable, (error::generic::code)filewriter_issue::undecodable::FileWrite, OutputFileName); break;
+    }
+}
+
+//---------------------------------------------------------------------------
+class frame_writer_job : public async_writer::job
+{
+public:
+    ~frame_writer_job();
+
+    bool                        NoOutputCheck;
+    user_mode*                  UserMode;
+    ask_callback                Ask_Callback;
+    matroska*                   M;
+    errors*                     Errors;
+    size_t                      DurableID = (size_t)-1;
+    hash_value                  Hash;
+
+    void                        AlreadyExists();
+    void                        Error(file::return_value Result) { FileWriter_Error(Errors, Result, FileName); }
+    void                        Written();
+};
+
+//---------------------------------------------------------------------------
+frame_writer_job::~frame_writer_job()
+{
+    if (DurableID != (size_t)-1)
+        M->Durable->Cancel(DurableID);
+}
+
+//---------------------------------------------------------------------------
+void frame_writer_job::Written()
+{
+    size_t Size = 0;
+    for (const auto& Buffer : Content)
+        Size += Buffer.Size();
+
+    // Listed in the journal once durable
+    if (DurableID != (size_t)-1)
+    {
+        M->Durable->End(DurableID, BaseDirectory + FileName, Size, M->Journal ? FileName : string(), Hash);
+        DurableID = (size_t)-1;
+    }
+}
+
+//---------------------------------------------------------------------------
+void frame_writer_job::AlreadyExists()
+{
+    if (NoOutputCheck)
+        return;
+
+    // File already exists, we want to check it
+    filemap File_Read;
+    if (File_Read.Open_ReadMode(BaseDirectory + FileName))
+    {
+        if (Errors)
+            Errors->Error(IO_FileChecker, error::type::Undecodable, (error::generic::code)filechecker_issue::undecodable::Frame_Source_Missing, FileName);
+        return;
+    }
+    size_t Offset = 0;
+    bool IsSame = true;
+    for (const auto& Buffer : Content)
+        if (CheckFile_Compare(Offset, File_Read, Buffer))
+        {
+            IsSame = false;
+            break;
+        }
+    if (IsSame && Offset == File_Read.Size())
+    {
+        Written(); // Content may be from a previous run which was not flushed
+        return; // All is OK
+    }
+    File_Read.Close();
+
+    // Files don't match, decide what we should do (overwrite or don't overwrite, log check error or don't log)
+    if (UserMode)
+    {
+        user_mode NewMode = *UserMode;
+        if (*UserMode == Ask && Ask_Callback)
+        {
+            NewMode = Ask_Callback(UserMode, FileName, " and is not same", true, &M->ProgressIndicator_IsPaused, &M->ProgressIndicator_IsEnd);
+        }
+        if (NewMode == AlwaysYes)
+        {
+            file File_Write;
+            file::return_value Result = File_Write.Open_WriteMode(BaseDirectory, FileName, false, true);
+            if (!Result)
+                Result = File_Write.Write(Content);
+            if (!Result && Sync)
+                Result = File_Write.Sync();
+            if (!Result)
+                Result = File_Write.Close();
+            if (Result)
+                Error(Result);
+            else
+                Written();
+            return;
+        }
+    }
+    if (Errors)
+        Errors->Error(IO_FileChecker, error::type::Undecodable, (error::generic::code)filechecker_issue::undecodable::FileComparison, FileName);
+}
+
 //---------------------------------------------------------------------------
 frame_writer::~frame_writer()
 {
-    delete (MD5_CTX*)MD5;
+    Durable_Cancel();
+    for (auto Hasher : Hashers)
+        delete Hasher;
 }
 
 void frame_writer::FrameCall(raw_frame* RawFrame)
 {
+    // Whole files are written in the background if possible
+    if (!Mode[IsNotBegin] && !Mode[IsNotEnd] && !Mode[NoWrite] && M->Writer)
+    {
+        FrameCall_Async(RawFrame);
+        return;
+    }
+
     if (!Mode[IsNotBegin])
     {
+        Durable_Cancel(); // Previous file was not fully written
+
         if (!Mode[NoWrite])
         {
             // Open output file in writing mode only if the file does not exist
@@ -75,16 +204,12 @@ void frame_writer::FrameCall(raw_frame* RawFrame)
             switch (Result)
             {
                 case file::OK:
+                    Durable_Begin();
+                    break;
                 case file::Error_FileAlreadyExists:
                     break;
                 default:
-                    if (Errors)
-                        switch (Result)
-                        {
-                            case file::Error_CreateDirectory:       Errors->Error(IO_FileWriter, error::type::Undecodable, (error::generic::code)filewriter_issue::undecodable::CreateDirectory, OutputFileName); break;
-                            case file::Error_FileCreate:            Errors->Error(IO_FileWriter, error::type::Undecodable, (error::generic::code)filewriter_issue::undecodable::FileCreate, OutputFileName); break;
-                            default:                                Errors->Error(IO_FileWriter, error::type::Undecodable, (error::generic::code)filewriter_issue::undecodable::FileWrite, OutputFileName); break;
-                        }
+                    FileWriter_Error(Errors, Result, OutputFileName);
                     return;
             }
         }
@@ -112,31 +237,8 @@ void frame_writer::FrameCall(raw_frame* RawFrame)
         return; // File is flagged as already with wrong data
 
     // Check hash operation
-    if (M->Hashes || M->Hashes_FromRAWcooked || M->Hashes_FromAttachments)
-    {
-        if (!Mode[IsNotBegin])
-        {
-            if (!MD5)
-                MD5 = new MD5_CTX;
-            MD5_Init((MD5_CTX*)MD5);
-        }
-
-        CheckMD5(RawFrame);
+    HashFrame(RawFrame);
 
-        if (!Mode[IsNotEnd])
-        {
-            md5 MD5_Result;
-            MD5_Final(MD5_Result.data(), (MD5_CTX*)MD5);
-
-            if (M->Hashes)
-                M->Hashes->FromFile(OutputFileName, MD5_Result);
-            if (M->Hashes_FromRAWcooked)
-                M->Hashes_FromRAWcooked->FromFile(OutputFileName, MD5_Result);
-            if (M->Hashes_FromAttachments)
-                M->Hashes_FromAttachments->FromFile(OutputFileName, MD5_Result);
-        }
-    }
-                
     // Check file operation
     bool DataIsCheckedAndOk;
     if (File_Read.IsOpen())
@@ -144,7 +246,15 @@ void frame_writer::FrameCall(raw_frame* RawFrame)
         if (!CheckFile(RawFrame))
         {
             if (Mode[IsNotEnd] || Offset == File_Read.Size())
+            {
+                if (!Mode[IsNotEnd] && M->Journal)
+                {
+                    // Content may be from a previous run which was not flushed
+                    Durable_Begin();
+                    Durable_End();
+                }
                 return; // All is OK
+            }
             DataIsCheckedAndOk = true;
         }
         else
@@ -164,16 +274,11 @@ void frame_writer::FrameCall(raw_frame* RawFrame)
             {
                 if (file::return_value Result = File_Write.Open_WriteMode(BaseDirectory, OutputFileName, false))
                 {
-                    if (Errors)
-                        switch (Result)
-                        {
-                        case file::Error_CreateDirectory:       Errors->Error(IO_FileWriter, error::type::Undecodable, (error::generic::code)filewriter_issue::undecodable::CreateDirectory, OutputFileName); break;
-                        case file::Error_FileCreate:            Errors->Error(IO_FileWriter, error::type::Undecodable, (error::generic::code)filewriter_issue::undecodable::FileCreate, OutputFileName); break;
-                        default:                                Errors->Error(IO_FileWriter, error::type::Undecodable, (error::generic::code)filewriter_issue::undecodable::FileWrite, OutputFileName); break;
-                        }
+                    FileWriter_Error(Errors, Result, OutputFileName);
                     Offset = (size_t)-1;
                     return;
                 }
+                Durable_Begin();
                 if (Offset)
                 {
                     if (File_Write.Seek(Offset))
@@ -230,19 +335,234 @@ void frame_writer::FrameCall(raw_frame* RawFrame)
             }
 
             // Close file
-            if (File_Write.Close())
+            if ((DurableID != (size_t)-1 && M->Durable->SyncOnClose() && File_Write.Sync()) || File_Write.Close())
             {
                 if (Errors)
                     Errors->Error(IO_FileWriter, error::type::Undecodable, (error::generic::code)filewriter_issue::undecodable::FileWrite, OutputFileName);
                 Offset = (size_t)-1;
                 return;
             }
+            Durable_End();
         }
 
         return;
     }
 }
 
+//---------------------------------------------------------------------------
+void frame_writer::FrameCall_Async(raw_frame* RawFrame)
+{
+    HashFrame(RawFrame);
+
+    auto Job = new frame_writer_job;
+    Job->BaseDirectory = BaseDirectory;
+    Job->FileName = OutputFileName;
+    Job->NoOutputCheck = Mode[NoOutputCheck];
+    Job->UserMode = UserMode;
+    Job->Ask_Callback = Ask_Callback;
+    Job->M = M;
+    Job->Errors = Errors;
+    Job->Hash = Hash;
+    if (M->Durable)
+    {
+        Job->DurableID = M->Durable->Begin();
+        Job->Sync = M->Durable->SyncOnClose();
+    }
+
+    // Small parts are copied, planes are handed over and replaced by recycled buffers
+    auto Copy = [&](const buffer_base& Buffer)
+    {
+        if (Buffer.Empty())
+            return;
+        Job->Content.emplace_back(M->Writer->Buffer_Get(Buffer.Size()));
+        memcpy(Job->Content.back().Data(), Buffer.Data(), Buffer.Size());
+    };
+    Copy(RawFrame->Pre());
+    Copy(RawFrame->Buffer());
+    for (const auto& Plane : RawFrame->Planes())
+        if (Plane && !Plane->Buffer().Empty())
+        {
+            auto Buffer = M->Writer->Buffer_Get(Plane->Buffer().Size());
+            Plane->SwapBuffer(Buffer);
+            Job->Content.emplace_back(move(Buffer));
+        }
+    Copy(RawFrame->Post());
+
+    M->Writer->Write(Job);
+}
+
+//---------------------------------------------------------------------------
+void frame_writer::Durable_Begin()
+{
+    if (M->Durable)
+        DurableID = M->Durable->Begin();
+}
+
+//---------------------------------------------------------------------------
+void frame_writer::Durable_End()
+{
+    if (DurableID == (size_t)-1)
+        return;
+    M->Durable->End(DurableID, BaseDirectory + OutputFileName, Offset, M->Journal ? OutputFileName : string(), Hash); // Listed in the journal once durable
+    DurableID = (size_t)-1;
+}
+
+//---------------------------------------------------------------------------
+void frame_writer::Durable_Cancel()
+{
+    if (DurableID == (size_t)-1)
+        return;
+    M->Durable->Cancel(DurableID);
+    DurableID = (size_t)-1;
+}
+
+//---------------------------------------------------------------------------
+void frame_writer::HashFrame(raw_frame* RawFrame)
+{
+    if (M->Hashes || M->Hashes_FromRAWcooked || M->Hashes_FromAttachments || M->Journal)
+    {
+        stats_scope Stats(stage::Hash, RawFrame->TotalSize(), Mode[IsNotEnd] ? 0 : 1);
+        trace_scope Trace("hash", "hash", "bytes", RawFrame->TotalSize());
+        if (!Mode[IsNotBegin])
+            HashFrame_Init();
+
+        for (auto Hasher : Hashers)
+            HashFrame_Update(Hasher, RawFrame);
+
+        if (!Mode[IsNotEnd])
+        {
+            Hash_Values.clear();
+            for (auto Hasher : Hashers)
+                Hash_Values.push_back(Hasher->Final());
+            Hash = Hash_Values.front();
+            Hashes_FromFile();
+        }
+    }
+}
+
+//---------------------------------------------------------------------------
+void frame_writer::HashFrame_Init()
+{
+    // Formats needed by the lists, only once per format
+    vector<hash_format> Formats;
+    for (auto List : { M->Hashes_FromRAWcooked, M->Hashes, M->Hashes_FromAttachments })
+    {
+        if (!List)
+            continue;
+        auto Format = List->Format();
+        if (Format != hash_format::None && find(Formats.begin(), Formats.end(), Format) == Formats.end())
+            Formats.push_back(Format);
+    }
+    if (M->Hashes_FromRAWcooked && M->Hashes_FromRAWcooked->Format() == hash_format::None)
+    {
+        // Format of the reversibility data is known only after its attachment, files attached before it (e.g. hash files) are hashed in all formats
+        for (uint8_t i = 1; i < (uint8_t)hash_format::Max; i++)
+            if (find(Formats.begin(), Formats.end(), (hash_format)i) == Formats.end())
+                Formats.push_back((hash_format)i);
+    }
+    if (Formats.empty())
+        Formats.push_back(hash_format::MD5);
+
+    // Hashers are reused if formats did not change
+    bool IsSame = Formats.size() == Hashers.size();
+    for (size_t i = 0; IsSame && i < Formats.size(); i++)
+        if (Hashers[i]->Format() != Formats[i])
+            IsSame = false;
+    if (IsSame)
+    {
+        for (auto Hasher : Hashers)
+            Hasher->Init();
+        return;
+    }
+    for (auto Hasher : Hashers)
+        delete Hasher;
+    Hashers.clear();
+    for (auto Format : Formats)
+        Hashers.push_back(hash_base::New(Format));
+}
+
+//---------------------------------------------------------------------------
+void frame_writer::Hashes_FromFile()
+{
+    Hashes_FromFile(M->Hashes);
+    Hashes_FromFile(M->Hashes_FromRAWcooked);
+    Hashes_FromFile(M->Hashes_FromAttachments);
+}
+
+//---------------------------------------------------------------------------
+void frame_writer::Hashes_FromFile(hashes* List)
+{
+    if (!List)
+        return;
+
+    auto Format = List->Format();
+    if (Format == hash_format::None && List == M->Hashes_FromRAWcooked)
+    {
+        // Compared later, with the value in the format of the reversibility data
+        for (const auto& Hash_Value : Hash_Values)
+            List->FromFile(OutputFileName, Hash_Value);
+        return;
+    }
+    for (const auto& Hash_Value : Hash_Values)
+        if (Format == hash_format::None || Hash_Value.Format == Format)
+        {
+            List->FromFile(OutputFileName, Hash_Value);
+            return;
+        }
+    List->Skip(OutputFileName); // Not available in the format of the list, e.g. value from the journal
+}
+
+//---------------------------------------------------------------------------
+file_verifier* frame_writer::NewVerifier(ThreadPool* Pool, reversibility* ReversibilityData)
+{
+    if (Mode[NoWrite] || !M->Hashes_FromRAWcooked)
+        return nullptr;
+
+    return new file_verifier(BaseDirectory, Pool, ReversibilityData, this);
+}
+
+//---------------------------------------------------------------------------
+bool frame_writer::ExpectedHash(const string& FileName, hash_value& Hash)
+{
+    if (M->Journal && M->Journal->Contains(FileName))
+        return false; // No need to read the file, the journal is enough
+
+    return M->Hashes_FromRAWcooked && M->Hashes_FromRAWcooked->Find(FileName, Hash);
+}
+
+//---------------------------------------------------------------------------
+bool frame_writer::IsComplete(file_verifier* Verifier, size_t Pos)
+{
+    if (Mode[NoWrite])
+        return false;
+
+    auto IsInJournal = M->Journal && M->Journal->Find(OutputFileName, Hash);
+    if (!IsInJournal && !(Verifier && Verifier->IsSame(Pos, Hash)))
+        return false;
+
+    if (IsInJournal)
+        Skip(); // Content is not read, so it is not reported as checked
+    else
+    {
+        // Hashes are not computed again, the file was read and has the hash from the reversibility data
+        Hash_Values.assign(1, Hash);
+        Hashes_FromFile();
+    }
+    M->Complete_Count++;
+    return true;
+}
+
+//---------------------------------------------------------------------------
+void frame_writer::Skip()
+{
+    if (M->Hashes)
+        M->Hashes->Skip(OutputFileName);
+    if (M->Hashes_FromRAWcooked)
+        M->Hashes_FromRAWcooked->Skip(OutputFileName);
+    if (M->Hashes_FromAttachments)
+        M->Hashes_FromAttachments->Skip(OutputFileName);
+}
+
 //---------------------------------------------------------------------------
 bool WriteFile_Write(size_t& Offset, file& File_Write, const buffer_base& Buffer)
 {
@@ -259,6 +579,8 @@ bool WriteFile_Write(size_t& Offset, file& File_Write, const buffer_base& Buffer
 }
 bool frame_writer::WriteFile(raw_frame* RawFrame)
 {
+    stats_scope Stats(stage::Write, RawFrame->TotalSize(), Mode[IsNotEnd] ? 0 : 1);
+    trace_scope Trace("write", "write", "bytes", RawFrame->TotalSize());
     if (WriteFile_Write(Offset, File_Write, RawFrame->Pre()))
         return true;
     if (WriteFile_Write(Offset, File_Write, RawFrame->Buffer()))
@@ -290,6 +612,8 @@ bool CheckFile_Compare(size_t& Offset, const filemap& File, const buffer_base& B
 }
 bool frame_writer::CheckFile(raw_frame* RawFrame)
 {
+    stats_scope Stats(stage::Write, RawFrame->TotalSize(), Mode[IsNotEnd] ? 0 : 1);
+    trace_scope Trace("check", "write", "bytes", RawFrame->TotalSize());
     size_t Offset_Current = Offset;
 
     if (CheckFile_Compare(Offset_Current, File_Read, RawFrame->Pre()))
@@ -307,26 +631,24 @@ bool frame_writer::CheckFile(raw_frame* RawFrame)
 }
 
 //---------------------------------------------------------------------------
-bool frame_writer::CheckMD5(raw_frame* RawFrame)
+void frame_writer::HashFrame_Update(hash_base* Hasher, raw_frame* RawFrame)
 {
     const auto Pre = RawFrame->Pre();
     if (Pre.Size())
-        MD5_Update((MD5_CTX*)MD5, Pre.Data(), (unsigned long)Pre.Size());
+        Hasher->Update(Pre.Data(), Pre.Size());
     const auto Buffer = RawFrame->Buffer();
     if (Buffer.Size())
-        MD5_Update((MD5_CTX*)MD5, Buffer.Data(), (unsigned long)Buffer.Size());
+        Hasher->Update(Buffer.Data(), Buffer.Size());
     for (const auto& Plane : RawFrame->Planes())
         if (Plane)
         {
             const auto& Buffer = Plane->Buffer();
             if (Buffer.Size())
-                MD5_Update((MD5_CTX*)MD5, Buffer.Data(), (unsigned long)Buffer.Size());
+                Hasher->Update(Buffer.Data(), Buffer.Size());
         }
     const auto Post = RawFrame->Post();
     if (Post.Size())
-        MD5_Update((MD5_CTX*)MD5, Post.Data(), (unsigned long)Post.Size());
-
-    return false;
+        Hasher->Update(Post.Data(), Post.Size());
 }
 
 //---------------------------------------------------------------------------
@@ -12,8 +12,14 @@
 //---------------------------------------------------------------------------
 #include "Lib/Utils/RawFrame/RawFrame.h"
 #include "Lib/Utils/FileIO/FileIO.h"
+#include "Lib/Utils/Hash/Hash.h"
 #include <bitset>
+#include <vector>
 class matroska;
+class hashes;
+class file_verifier;
+class reversibility;
+class ThreadPool;
 using namespace std;
 //---------------------------------------------------------------------------
 
@@ -27,8 +33,7 @@ public:
         UserMode(UserMode_Soure),
         Ask_Callback(Ask_Callback_Source),
         M(M_Source),
-        Errors(Errors_Source),
-        MD5(nullptr)
+        Errors(Errors_Source)
     {
     }
     frame_writer(const frame_writer& Source) :
@@ -39,8 +44,7 @@ public:
         M(Source.M),
         Errors(Source.Errors),
         Offset(Source.Offset),
-        SizeOnDisk(Source.SizeOnDisk),
-        MD5(Source.MD5)
+        SizeOnDisk(Source.SizeOnDisk)
     {
     }
     frame_writer(const frame_writer* Source) :
@@ -62,13 +66,27 @@ public:
     bitset<mode_Max>            Mode;
     string                      OutputFileName;
 
+    // Existing output files
+    file_verifier*              NewVerifier(ThreadPool* Pool, reversibility* ReversibilityData); // nullptr if existing files do not need to be verified
+    bool                        ExpectedHash(const string& FileName, hash_value& Hash); // Hash from reversibility data, false if unknown or if the file is already in the journal
+    bool                        IsComplete(file_verifier* Verifier = nullptr, size_t Pos = 0); // Output file is already complete (from the journal of a previous run or from its hash), frame does not need to be decoded
+    void                        Skip(); // Output file is not checked, frame is not decoded
+
 private:
     // Actions
     void                        FrameCall(raw_frame* RawFrame);
+    void                        FrameCall_Async(raw_frame* RawFrame);
+    void                        HashFrame(raw_frame* RawFrame);
+    void                        HashFrame_Init();
+    void                        HashFrame_Update(hash_base* Hasher, raw_frame* RawFrame);
+    void                        Hashes_FromFile();
+    void                        Hashes_FromFile(hashes* List);
+    void                        Durable_Begin();
+    void                        Durable_End();
+    void                        Durable_Cancel();
 
     bool                        WriteFile(raw_frame* RawFrame);
     bool                        CheckFile(raw_frame* RawFrame);
-    bool                        CheckMD5(raw_frame* RawFrame);
     file                        File_Write;
     filemap                     File_Read;
     string                      BaseDirectory;
@@ -78,7 +96,10 @@ private:
     errors*                     Errors;
     size_t                      Offset;
     size_t                      SizeOnDisk;
-    void*                       MD5;
+    vector<hash_base*>          Hashers; // 1 per format needed by the hash lists, format of reversibility data first
+    vector<hash_value>          Hash_Values; // Same order as Hashers
+    hash_value                  Hash; // 1st value, for the journal
+    size_t                      DurableID = (size_t)-1;
 };
 
 #endif
\ No newline at end of file
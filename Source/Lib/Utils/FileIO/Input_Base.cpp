@@ -9,10 +9,6 @@
 #include "Lib/Uncompressed/HashSum/HashSum.h"
 #include "Lib/Utils/FileIO/Input_Base.h"
 #include "Lib/Compressed/RAWcooked/RAWcooked.h"
-extern "C"
-{
-#include "md5.h"
-}
 #include <cmath>
 //---------------------------------------------------------------------------
 
@@ -56,26 +52,23 @@ void input_base::Hash()
     if (!Actions[Action_Hash] || HashComputed)
         return;
 
-    // MD5    
+    // Hash in the format of reversibility data
+    auto Hash = hash_base::New(HashFormat, HashPool);
+    Hash->Update(Buffer.Data(), Buffer.Size());
+    HashValue = Hash->Final();
+    delete Hash;
+    if (Hashes && FileName && !FileName->empty())
     {
-        MD5_CTX MD5;
-        MD5_Init(&MD5);
+        Hashes->FromFile(*FileName, HashValue);
 
-        size_t Offset = 0;
-        while (Offset < Buffer.Size())
+        // Hash files are in MD5 and are parsed only for conformance checks
+        if (HashFormat != hash_format::MD5 && Actions[Action_Conch])
         {
-            unsigned long Size_Temp;
-            if (Buffer.Size() - Offset >= (unsigned long)-1) // MD5_Update() accepts only unsigned longs
-                Size_Temp = (unsigned long)-1;
-            else
-                Size_Temp = (unsigned long)(Buffer.Size() - Offset);
-            MD5_Update(&MD5, Buffer.Data(), Size_Temp);
-            Offset += Size_Temp;
+            Hash = hash_base::New(hash_format::MD5);
+            Hash->Update(Buffer.Data(), Buffer.Size());
+            Hashes->FromFile(*FileName, Hash->Final());
+            delete Hash;
         }
-
-        MD5_Final(HashValue.data(), &MD5);
-        if (Hashes&& FileName && !FileName->empty())
-            Hashes->FromFile(*FileName, HashValue);
     }
     HashComputed = true;
 }
@@ -12,6 +12,7 @@
 //---------------------------------------------------------------------------
 #include "Lib/Utils/Errors/Errors.h"
 #include "Lib/Utils/FileIO/FileIO.h"
+#include "Lib/Utils/Hash/Hash.h"
 #include <bitset>
 #include <cstdint>
 #include <string>
@@ -19,6 +20,7 @@
 using namespace std;
 class rawcooked;
 class hashes;
+class ThreadPool;
 //---------------------------------------------------------------------------
 
 enum action : uint8_t
@@ -73,6 +75,8 @@ public:
     bitset<Action_Max>          Actions;
     hashes*                     Hashes = nullptr;
     string*                     FileName = nullptr;
+    hash_format                 HashFormat = hash_format::MD5; // Format of the hash in reversibility data
+    ThreadPool*                 HashPool = nullptr; // Threads for hash formats with a parallel mode
 
     // Parse
     bool                        Parse(const buffer_view& Buffer, size_t FileSize = (size_t)-1) { return Parse(nullptr, Buffer, FileSize); }
@@ -135,7 +139,7 @@ protected:
     // Info
     bitset<Info_Max>            Info;
     bool                        HashComputed = false;
-    md5                         HashValue;
+    hash_value                  HashValue;
 };
 
 class uncompressed
@@ -0,0 +1,210 @@
+/*  Copyright (c) MediaArea.net SARL & AV Preservation by reto.ch.
+ *
+ *  Use of this source code is governed by a BSD-style license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//---------------------------------------------------------------------------
+#include "Lib/Utils/FileIO/Journal.h"
+#include <cstdio>
+#include <cstring>
+#include <sys/stat.h>
+#if defined(_WIN32) || defined(_WINDOWS)
+    #define stat _stat
+#endif
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+static const char* Journal_Signature = "RAWcooked journal 2";
+
+//---------------------------------------------------------------------------
+static int Journal_Hex(uint8_t Value)
+{
+    if (Value >= '0' && Value <= '9')
+        return Value - '0';
+    if (Value >= 'a' && Value <= 'f')
+        return Value - 'a' + 10;
+    return -1;
+}
+
+//---------------------------------------------------------------------------
+static bool Journal_Stat(const string& Name, uint64_t& Size, uint64_t& Time)
+{
+    struct stat Stat;
+    if (stat(Name.c_str(), &Stat))
+        return true;
+    Size = (uint64_t)Stat.st_size;
+    #if defined(_WIN32) || defined(_WINDOWS)
+        Time = (uint64_t)Stat.st_mtime * 1000000000;
+    #elif defined(__APPLE__)
+        Time = (uint64_t)Stat.st_mtimespec.tv_sec * 1000000000 + Stat.st_mtimespec.tv_nsec;
+    #else
+        Time = (uint64_t)Stat.st_mtim.tv_sec * 1000000000 + Stat.st_mtim.tv_nsec;
+    #endif
+    return false;
+}
+
+//---------------------------------------------------------------------------
+static size_t Journal_Number(const char* Line, size_t Line_Size, size_t i, uint64_t& Value)
+{
+    Value = 0;
+    for (; i < Line_Size && Line[i] >= '0' && Line[i] <= '9'; i++)
+        Value = Value * 10 + (Line[i] - '0');
+    return i;
+}
+
+//---------------------------------------------------------------------------
+journal::journal(const string& FileName_Source, const string& BaseDirectory_Source, const string& InputName, uint64_t InputSize) :
+    FileName(FileName_Source),
+    BaseDirectory(BaseDirectory_Source)
+{
+    auto Separator = InputName.find_last_of("/\\");
+    Header = string(Journal_Signature) + ' ' + to_string(InputSize) + ' ' + InputName.substr(Separator == string::npos ? 0 : (Separator + 1)) + '\n';
+}
+
+//---------------------------------------------------------------------------
+bool journal::Open()
+{
+    // Previous content
+    size_t ValidSize = 0;
+    {
+        filemap Previous;
+        if (!Previous.Open_ReadMode(FileName) && Previous.Size() >= Header.size() && !memcmp(Previous.Data(), Header.c_str(), Header.size()))
+        {
+            auto Data = (const char*)Previous.Data();
+            auto Size = Previous.Size();
+            size_t Offset = Header.size();
+            ValidSize = Offset;
+            for (;;)
+            {
+                auto End = (const char*)memchr(Data + Offset, '\n', Size - Offset);
+                if (!End)
+                    break; // Last line is incomplete, e.g. interrupted write
+                auto Line = Data + Offset;
+                auto Line_Size = End - Line;
+                Offset = End - Data + 1;
+
+                // "<hash> <size> <time> <name>"
+                entry Entry;
+                auto Hash_End = (const char*)memchr(Line, ' ', Line_Size);
+                if (!Hash_End)
+                    break;
+                auto Hash_Begin = (const char*)memchr(Line, ':', Hash_End - Line);
+                if (Hash_Begin)
+                {
+                    Entry.Hash.Format = hash_base::FromOptionName(string(Line, Hash_Begin - Line).c_str());
+                    Hash_Begin++;
+                }
+                else
+                {
+                    Entry.Hash.Format = hash_format::MD5;
+                    Hash_Begin = Line;
+                }
+                auto Hash_Size = Entry.Hash.Size();
+                if (!Hash_Size || (size_t)(Hash_End - Hash_Begin) != Hash_Size * 2)
+                    break;
+                bool IsValid = true;
+                for (size_t i = 0; i < Hash_Size; i++)
+                {
+                    auto Hi = Journal_Hex(Hash_Begin[i * 2]);
+                    auto Lo = Journal_Hex(Hash_Begin[i * 2 + 1]);
+                    if (Hi < 0 || Lo < 0)
+                        IsValid = false;
+                    Entry.Hash.Data[i] = (uint8_t)((Hi << 4) | Lo);
+                }
+                size_t Size_Begin = Hash_End - Line + 1;
+                size_t i = Journal_Number(Line, Line_Size, Size_Begin, Entry.Size);
+                if (!IsValid || i == Size_Begin || i + 1 >= (size_t)Line_Size || Line[i] != ' ')
+                    break;
+                auto Time_Begin = i + 1;
+                i = Journal_Number(Line, Line_Size, Time_Begin, Entry.Time);
+                if (i == Time_Begin || i + 1 >= (size_t)Line_Size || Line[i] != ' ')
+                    break;
+                Entries[string(Line + i + 1, Line_Size - i - 1)] = Entry;
+                ValidSize = Offset;
+            }
+        }
+    }
+
+    // Continue after valid content, or start from scratch
+    if (File.Open_WriteMode(string(), FileName, false, !ValidSize))
+        return true;
+    if (ValidSize)
+    {
+        if (File.Seek(ValidSize) || File.SetEndOfFile())
+            return true;
+    }
+    else
+    {
+        if (File.Write((const uint8_t*)Header.c_str(), Header.size()))
+            return true;
+    }
+
+    return false;
+}
+
+//---------------------------------------------------------------------------
+bool journal::Find(const string& Name, hash_value& Hash)
+{
+    auto Entry = Entries.find(Name);
+    if (Entry == Entries.end())
+        return false;
+
+    // File must still be there, not modified since (content is not read)
+    uint64_t Size, Time;
+    if (Journal_Stat(BaseDirectory + Name, Size, Time) || Size != Entry->second.Size || Time != Entry->second.Time)
+        return false;
+
+    Hash = Entry->second.Hash;
+    return true;
+}
+
+//---------------------------------------------------------------------------
+void journal::Add(const string& Name, uint64_t Size, const hash_value& Hash)
+{
+    if (Name.find('\n') != string::npos || Hash.Empty())
+        return; // Not supported by the format
+
+    // Modification time of the closed file, for detecting later changes
+    uint64_t Size_OnDisk, Time;
+    if (Journal_Stat(BaseDirectory + Name, Size_OnDisk, Time) || Size_OnDisk != Size)
+        return;
+
+    string Line;
+    Line.reserve(8 + 64 + 1 + 20 + 1 + 20 + 1 + Name.size() + 1);
+    if (Hash.Format != hash_format::MD5) // MD5 without prefix, for compatibility with previous versions
+    {
+        Line += hash_base::OptionName(Hash.Format);
+        Line += ':';
+    }
+    Line += Hash.ToString();
+    Line += ' ';
+    Line += to_string(Size);
+    Line += ' ';
+    Line += to_string(Time);
+    Line += ' ';
+    Line += Name;
+    Line += '\n';
+
+    // 1 write per line, so an interruption leads to at most 1 incomplete line
+    lock_guard<mutex> Lock(Mutex);
+    if (File.IsOpen() && !File.Write((const uint8_t*)Line.c_str(), Line.size()))
+        Added = true;
+}
+
+//---------------------------------------------------------------------------
+bool journal::Sync()
+{
+    lock_guard<mutex> Lock(Mutex);
+    return File.IsOpen() && File.Sync();
+}
+
+//---------------------------------------------------------------------------
+void journal::Remove()
+{
+    lock_guard<mutex> Lock(Mutex);
+    if (!File.IsOpen())
+        return;
+    File.Close();
+    remove(FileName.c_str());
+}
@@ -0,0 +1,65 @@
+/*  Copyright (c) MediaArea.net SARL & AV Preservation by reto.ch.
+ *
+ *  Use of this source code is governed by a BSD-style license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//---------------------------------------------------------------------------
+#ifndef JournalH
+#define JournalH
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+#include "Lib/Config.h"
+#include "Lib/Utils/FileIO/FileIO.h"
+#include "Lib/Utils/Hash/Hash.h"
+#include <map>
+#include <mutex>
+#include <string>
+using namespace std;
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+// Append-only list of the output files which are complete and on stable
+// storage, with their size, modification time and hash, so an interrupted
+// decoding can be resumed without decoding again the frames already written
+// Format: 1 header line identifying the input, then "<hash> <size> <time> <name>"
+// lines with hash as MD5 hexadecimal value or "<format>:<hexadecimal value>"
+// and time in nanoseconds
+// Content of listed files is not read again, so their hash is not a check
+class journal
+{
+public:
+    // Constructor / Destructor
+    journal(const string& FileName_Source, const string& BaseDirectory_Source, const string& InputName, uint64_t InputSize);
+
+    // Actions
+    bool                        Open(); // Returns true on error, previous content is kept only if it is from the same input
+    bool                        Find(const string& FileName, hash_value& Hash); // Returns true if the file is complete on disk (same size and modification time), with its hash
+    bool                        Contains(const string& FileName) { return Entries.find(FileName) != Entries.end(); }
+    void                        Add(const string& FileName, uint64_t Size, const hash_value& Hash); // The file must be durable and closed
+    bool                        Sync(); // Returns true on error, added lines are flushed to stable storage
+    void                        Remove(); // Content is no more needed, e.g. all output files are complete
+
+    // Info
+    size_t                      Entries_Count() { return Entries.size(); }
+    bool                        IsEmpty() { return Entries.empty() && !Added; }
+
+private:
+    struct entry
+    {
+        uint64_t                Size;
+        uint64_t                Time;
+        hash_value              Hash;
+    };
+    string                      FileName;
+    string                      BaseDirectory;
+    string                      Header;
+    map<string, entry>          Entries; // Content of the previous run, read-only after Open()
+    bool                        Added = false;
+    file                        File;
+    mutex                       Mutex;
+};
+
+//---------------------------------------------------------------------------
+#endif
@@ -7,33 +7,206 @@
 //---------------------------------------------------------------------------
 #include "Lib/Utils/FrameHash/FrameHash_MD5.h"
 #include "Lib/Utils/RawFrame/RawFrame.h"
+#include "Lib/Utils/Stats/Trace.h"
+#include <cinttypes>
+#include <cstdio>
 extern "C"
 {
-#include "Lib/ThirdParty/md5/md5.h"
+#include "md5.h"
 }
+#ifdef __GNUC__
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wreorder"
+#endif
+#include "ThreadPool.h"
+#ifdef __GNUC__
+#pragma GCC diagnostic pop
+#endif
 //---------------------------------------------------------------------------
 
 //---------------------------------------------------------------------------
-framehash_md5::framehash_md5()
+framehash_md5::framehash_md5(ThreadPool* Pool_Source, size_t MaxInFlight_Source) :
+    Pool(Pool_Source),
+    MaxInFlight(MaxInFlight_Source)
 {
 }
 
+//---------------------------------------------------------------------------
+framehash_md5::~framehash_md5()
+{
+    // Jobs in the pool use this object
+    unique_lock<mutex> Lock(Mutex);
+    Cond.wait(Lock, [this] { return !InFlight; });
+}
+
+//---------------------------------------------------------------------------
+bool framehash_md5::Open(const string& FileName_Source)
+{
+    FileName = FileName_Source;
+    return File.Open_WriteMode(string(), FileName, false, true) ? true : false;
+}
+
+//---------------------------------------------------------------------------
+void framehash_md5::SetFrameDuration(uint64_t Duration_ns)
+{
+    if (!Duration_ns)
+        return;
+
+    // Integer frame rate (1/n), or NTSC style frame rate (1001/n000)
+    const uint64_t Second = 1000000000;
+    for (uint64_t Num = 1; Num <= 1001; Num += 1000)
+    {
+        auto Den = (Second * Num + Duration_ns / 2) / Duration_ns;
+        auto Expected = Second * Num;
+        auto Actual = Den * Duration_ns;
+        auto Diff = Actual > Expected ? (Actual - Expected) : (Expected - Actual);
+        if (Den && Diff <= Den && (Num == 1 || !(Den % 1000))) // Duration is rounded to the nanosecond
+        {
+            TimeBase_Num = Num;
+            TimeBase_Den = Den;
+            return;
+        }
+    }
+
+    // Exact value
+    auto a = Duration_ns;
+    auto b = Second;
+    while (b)
+    {
+        auto t = a % b;
+        a = b;
+        b = t;
+    }
+    TimeBase_Num = Duration_ns / a;
+    TimeBase_Den = Second / a;
+}
+
+//---------------------------------------------------------------------------
+void framehash_md5::WriteHeader(const raw_frame* RawFrame)
+{
+    string Header;
+    Header += "#format: frame checksums\n";
+    Header += "#version: 2\n";
+    Header += "#hash: MD5\n";
+    Header += "#tb 0: " + to_string(TimeBase_Num) + '/' + to_string(TimeBase_Den) + '\n';
+    Header += "#media_type 0: video\n";
+    Header += "#codec_id 0: rawvideo\n";
+    if (RawFrame && !RawFrame->Planes().empty())
+        Header += "#dimensions 0: " + to_string(RawFrame->Plane(0)->Width_) + 'x' + to_string(RawFrame->Plane(0)->Height_) + '\n';
+    Header += "#sar 0: 1/1\n";
+    Header += "#stream#, dts,        pts, duration,     size, hash\n";
+    if (File.Write((const uint8_t*)Header.c_str(), Header.size()))
+        IsError = true;
+    Header_IsWritten = true;
+}
+
 //---------------------------------------------------------------------------
 void framehash_md5::To(raw_frame* RawFrame)
 {
-    MD5_CTX MD5;
-    MD5_Init(&MD5);
+    if (!File.IsOpen())
+        return;
+    if (!Header_IsWritten)
+        WriteHeader(RawFrame);
 
-    for (size_t p = 0; p < RawFrame->Planes_.size(); p++)
+    // Plane buffers are handed over to the job, the frame gets recycled buffers
+    auto Job = new job;
+    Job->Frame = Frame_Next++;
     {
-        auto& FrameBuffer_Temp = RawFrame->Planes_[p]->Buffer_.Data();
-        for (size_t h = 0; h < RawFrame->Planes_[p]->Height_; h++)
+        unique_lock<mutex> Lock(Mutex);
+        Cond.wait(Lock, [this] { return InFlight < MaxInFlight; });
+        for (const auto& Plane : RawFrame->Planes())
         {
-            MD5_Update(&MD5, FrameBuffer_Temp, (int)RawFrame->Planes_[p]->ValidBytesPerLine());
-            FrameBuffer_Temp += RawFrame->Planes_[p]->AllBytesPerLine();
+            buffer Buffer;
+            for (auto Item = Spare.begin(); Item != Spare.end(); ++Item)
+                if (Item->Size() == Plane->Buffer().Size())
+                {
+                    Buffer = move(*Item);
+                    Spare.erase(Item);
+                    break;
+                }
+            if (!Buffer.Size())
+            {
+                memory_scope Memory(memory_use::Frame);
+                Buffer.Create(Plane->Buffer().Size());
+            }
+            const_cast<raw_frame::plane*>(Plane)->SwapBuffer(Buffer);
+            Job->Planes.push_back(move(Buffer));
+            Job->ValidBytesPerLine.push_back(Plane->ValidBytesPerLine());
+            Job->AllBytesPerLine.push_back(Plane->AllBytesPerLine());
+            Job->Heights.push_back(Plane->Height_);
         }
+        InFlight++;
     }
 
+    if (Pool)
+        Pool->submit([this, Job]() { Hash(Job); });
+    else
+        Hash(Job);
+}
+
+//---------------------------------------------------------------------------
+void framehash_md5::Hash(job* Job)
+{
+    trace_scope Trace("framemd5", "hash");
+    MD5_CTX MD5;
+    MD5_Init(&MD5);
+    size_t Size = 0;
+    for (size_t p = 0; p < Job->Planes.size(); p++)
+    {
+        auto FrameBuffer_Temp = Job->Planes[p].Data();
+        for (size_t h = 0; h < Job->Heights[p]; h++)
+        {
+            MD5_Update(&MD5, FrameBuffer_Temp, (unsigned long)Job->ValidBytesPerLine[p]);
+            FrameBuffer_Temp += Job->AllBytesPerLine[p];
+        }
+        Size += Job->ValidBytesPerLine[p] * Job->Heights[p];
+    }
     unsigned char Digest[16];
     MD5_Final(Digest, &MD5);
+
+    // FFmpeg framemd5 line
+    char Line[128];
+    auto Line_Size = snprintf(Line, sizeof(Line), "0, %10" PRIu64 ", %10" PRIu64 ", %8d, %8" PRIu64 ", ", (uint64_t)Job->Frame, (uint64_t)Job->Frame, 1, (uint64_t)Size);
+    static const char* Hex = "0123456789abcdef";
+    for (auto Value : Digest)
+    {
+        Line[Line_Size++] = Hex[Value >> 4];
+        Line[Line_Size++] = Hex[Value & 0xF];
+    }
+    Line[Line_Size++] = '\n';
+
+    {
+        lock_guard<mutex> Lock(Mutex);
+        for (auto& Buffer : Job->Planes)
+            Spare.push_back(move(Buffer));
+        Lines[Job->Frame] = string(Line, Line_Size);
+
+        // Lines in frame order
+        string ToWrite;
+        for (auto Item = Lines.begin(); Item != Lines.end() && Item->first == Frame_Written; Item = Lines.erase(Item))
+        {
+            ToWrite += Item->second;
+            Frame_Written++;
+        }
+        if (!ToWrite.empty() && File.Write((const uint8_t*)ToWrite.c_str(), ToWrite.size()))
+            IsError = true;
+        InFlight--;
+    }
+    Cond.notify_all();
+    delete Job;
+}
+
+//---------------------------------------------------------------------------
+bool framehash_md5::Finish()
+{
+    if (!File.IsOpen())
+        return true;
+
+    unique_lock<mutex> Lock(Mutex);
+    Cond.wait(Lock, [this] { return !InFlight; });
+    if (!Header_IsWritten)
+        WriteHeader(nullptr);
+    if (File.Close())
+        IsError = true;
+    return IsError;
 }
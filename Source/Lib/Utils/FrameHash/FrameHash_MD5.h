@@ -5,26 +5,70 @@
  */
 
 //---------------------------------------------------------------------------
-#ifndef FrameHash_MD5TH
+#ifndef FrameHash_MD5H
 #define FrameHash_MD5H
 //---------------------------------------------------------------------------
 
 //---------------------------------------------------------------------------
 #include "Lib/Config.h"
+#include "Lib/Utils/Buffer/Buffer.h"
+#include "Lib/Utils/FileIO/FileIO.h"
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+class ThreadPool;
 using namespace std;
 //---------------------------------------------------------------------------
 
 class raw_frame;
 
+//---------------------------------------------------------------------------
+// Per frame MD5 of decoded frames, written in the FFmpeg framemd5 format
+// Frames are hashed by the pool, lines are written in frame order
 class framehash_md5
 {
 public:
-    framehash_md5();
+    // Constructor / Destructor
+    framehash_md5(ThreadPool* Pool_Source = nullptr, size_t MaxInFlight_Source = 8);
+    ~framehash_md5();
+
+    // Config
+    bool                        Open(const string& FileName); // Returns true on error
+    void                        SetFrameDuration(uint64_t Duration_ns); // Time base of the output, from the frame duration
 
-    void To(raw_frame*          RawFrame);
+    // Actions
+    void                        To(raw_frame* RawFrame); // Frames are provided in presentation order, plane buffers are taken over
+    bool                        Finish(); // Returns true on error
 
 private:
-    ;
+    struct job
+    {
+        size_t                  Frame;
+        vector<buffer>          Planes;
+        vector<size_t>          ValidBytesPerLine;
+        vector<size_t>          AllBytesPerLine;
+        vector<size_t>          Heights;
+    };
+    void                        Hash(job* Job);
+    void                        WriteHeader(const raw_frame* RawFrame);
+
+    file                        File;
+    string                      FileName;
+    ThreadPool*                 Pool;
+    size_t                      MaxInFlight;
+    uint64_t                    TimeBase_Num = 1;
+    uint64_t                    TimeBase_Den = 1;
+    bool                        Header_IsWritten = false;
+    bool                        IsError = false;
+    size_t                      Frame_Next = 0; // Next frame provided to To()
+    size_t                      Frame_Written = 0; // Next frame to write to the file
+    map<size_t, string>         Lines; // Lines of frames hashed after a gap
+    vector<buffer>              Spare; // Buffers no more used, recycled for next frames
+    size_t                      InFlight = 0;
+    mutex                       Mutex;
+    condition_variable          Cond;
 };
 
 //---------------------------------------------------------------------------
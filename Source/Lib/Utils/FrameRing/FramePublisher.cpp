@@ -0,0 +1,186 @@
+/*  Copyright (c) MediaArea.net SARL & AV Preservation by reto.ch.
+ *
+ *  Use of this source code is governed by a BSD-style license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//---------------------------------------------------------------------------
+#include "Lib/Utils/FrameRing/FramePublisher.h"
+#include "Lib/API/RAWcooked_API.h"
+#include <algorithm>
+#include <cstring>
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+static const size_t Planes_Max = sizeof(frame_ring_slot::Planes) / sizeof(frame_ring_plane);
+
+//---------------------------------------------------------------------------
+struct slot_size_context
+{
+    size_t                      Slot_Size = 0;
+    bool                        HasError = false;
+};
+
+//***************************************************************************
+// Callbacks
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+void frame_publisher::Slot_Size_Callback(void* Opaque, const rawcooked_plane* Planes, size_t Planes_Count)
+{
+    auto& Context = *(slot_size_context*)Opaque;
+    if (Planes_Count > Planes_Max)
+    {
+        Context.HasError = true;
+        return;
+    }
+    size_t Sizes[Planes_Max];
+    for (size_t i = 0; i < Planes_Count; i++)
+        Sizes[i] = Planes[i].Size;
+    Context.Slot_Size = frame_ring::Slot_Size_Get(Sizes, Planes_Count);
+}
+
+//---------------------------------------------------------------------------
+void frame_publisher::Publish_Callback(void* Opaque, const rawcooked_plane* Planes, size_t Planes_Count)
+{
+    ((frame_publisher*)Opaque)->Publish(Planes, Planes_Count);
+}
+
+//***************************************************************************
+// Actions
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+bool frame_publisher::Open(const string& FileName, rawcooked_file*& File_Out, size_t& Track_Out, rawcooked_track_info& Info)
+{
+    if (auto Result = rawcooked_open(FileName.c_str(), &File_Out))
+    {
+        ErrorMessage_ = FileName + (Result == RAWCOOKED_ERROR_OPEN ? " can not be opened" : " is not a supported Matroska file");
+        return true;
+    }
+    rawcooked_set_threads(File_Out, Threads);
+
+    // First video track
+    auto Tracks_Count = rawcooked_track_count(File_Out);
+    for (Track_Out = 0; Track_Out < Tracks_Count; Track_Out++)
+        if (!rawcooked_track_info_get(File_Out, Track_Out, &Info) && Info.Kind == RAWCOOKED_TRACK_VIDEO)
+            return false;
+    ErrorMessage_ = FileName + " has no video track";
+    rawcooked_close(File_Out);
+    File_Out = nullptr;
+    return true;
+}
+
+//---------------------------------------------------------------------------
+bool frame_publisher::Run(const vector<string>& FileNames)
+{
+    // Slot size for the biggest frame, frames of a track have all the same geometry
+    for (const auto& FileName : FileNames)
+    {
+        size_t Track_Temp;
+        rawcooked_track_info Info;
+        if (Open(FileName, File, Track_Temp, Info))
+            return true;
+        slot_size_context Context;
+        if (Info.FrameCount && rawcooked_decode_frame(File, Track_Temp, 0, Slot_Size_Callback, &Context))
+            ErrorMessage_ = FileName + ", frame 0: " + rawcooked_error(File);
+        else if (Context.HasError)
+            ErrorMessage_ = FileName + ", frame 0: too many planes";
+        rawcooked_close(File);
+        File = nullptr;
+        if (!ErrorMessage_.empty())
+            return true;
+        Slot_Size = max(Slot_Size, Context.Slot_Size);
+    }
+    if (!Slot_Size)
+        return false; // Nothing to publish
+
+    Ring.Stop = Stop;
+    if (Ring.Create(Name, Slot_Count, Slot_Size))
+    {
+        ErrorMessage_ = Ring.ErrorMessage();
+        return true;
+    }
+
+    for (size_t i = 0; i < FileNames.size() && ErrorMessage_.empty() && !IsClosed_ && !IsStopped(); i++)
+    {
+        const auto& FileName = FileNames[i];
+        size_t Track_Temp;
+        rawcooked_track_info Info;
+        if (Open(FileName, File, Track_Temp, Info))
+            break;
+        Input = (uint32_t)i;
+        Track = (uint32_t)Track_Temp;
+
+        for (Frame = 0; Frame < Info.FrameCount && ErrorMessage_.empty() && !IsClosed_ && !IsStopped(); Frame++)
+        {
+            if (rawcooked_decode_frame(File, Track, Frame, Publish_Callback, this))
+                ErrorMessage_ = rawcooked_error(File);
+            if (!ErrorMessage_.empty())
+                ErrorMessage_ = FileName + ", frame " + to_string(Frame) + ": " + ErrorMessage_;
+        }
+        rawcooked_close(File);
+        File = nullptr;
+    }
+    if (IsStopped() && ErrorMessage_.empty())
+        ErrorMessage_ = "interrupted";
+
+    auto HasError = !ErrorMessage_.empty();
+    Ring.End(HasError);
+    Ring.Close();
+    return HasError;
+}
+
+//---------------------------------------------------------------------------
+void frame_publisher::Publish(const rawcooked_plane* Planes, size_t Planes_Count)
+{
+    if (Planes_Count > Planes_Max)
+    {
+        ErrorMessage_ = "too many planes";
+        return;
+    }
+    size_t Sizes[Planes_Max];
+    for (size_t i = 0; i < Planes_Count; i++)
+        Sizes[i] = Planes[i].Size;
+    if (frame_ring::Slot_Size_Get(Sizes, Planes_Count) > Ring.Slot_Size())
+    {
+        ErrorMessage_ = "frame is bigger than the slots of the frame ring";
+        return;
+    }
+
+    auto Slot = Ring.Slot_Get();
+    if (!Slot)
+    {
+        if (!IsStopped())
+            IsClosed_ = true;
+        return;
+    }
+    rawcooked_track_info Info;
+    rawcooked_track_info_get(File, Track, &Info);
+    Slot->Frame = Frame;
+    Slot->Input = Input;
+    Slot->Track = Track;
+    Slot->Kind = Info.Kind;
+    Slot->ColorSpace = Info.ColorSpace;
+    Slot->BitDepth = Info.BitDepth;
+    Slot->Planes_Count = (uint32_t)Planes_Count;
+    size_t Offset = 0;
+    size_t Size = 0;
+    for (size_t i = 0; i < Planes_Count; i++)
+    {
+        const auto& Plane = Planes[i];
+        Offset = frame_ring::Plane_Offset(Offset, Size);
+        Size = Plane.Size;
+        auto& Dest = Slot->Planes[i];
+        Dest.Offset = Offset;
+        Dest.Size = Plane.Size;
+        Dest.BytesPerLine = Plane.BytesPerLine;
+        Dest.Width = (uint32_t)Plane.Width;
+        Dest.Height = (uint32_t)Plane.Height;
+        Dest.BytesPerBlock = (uint32_t)Plane.BytesPerBlock;
+        Dest.PixelsPerBlock = (uint32_t)Plane.PixelsPerBlock;
+        memcpy((uint8_t*)Slot + Offset, Plane.Data, Plane.Size);
+    }
+    Ring.Slot_Publish();
+    Published_++;
+}
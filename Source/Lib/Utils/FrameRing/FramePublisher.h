@@ -0,0 +1,64 @@
+/*  Copyright (c) MediaArea.net SARL & AV Preservation by reto.ch.
+ *
+ *  Use of this source code is governed by a BSD-style license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//---------------------------------------------------------------------------
+#ifndef FramePublisherH
+#define FramePublisherH
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+#include "Lib/Config.h"
+#include "Lib/Utils/FrameRing/FrameRing.h"
+#include <string>
+#include <vector>
+using namespace std;
+struct rawcooked_file;
+struct rawcooked_plane;
+struct rawcooked_track_info;
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+// Decoding of the first video track of Matroska files, frames are published
+// in a frame ring instead of being written to files
+// Slots are sized for the biggest frame of all inputs, the first frame of
+// each input is decoded once more for that
+class frame_publisher
+{
+public:
+    // Config
+    string                      Name;           // Of the shared memory
+    size_t                      Slot_Count = 8;
+    size_t                      Threads = 0;    // For decoding slices of a frame
+    const volatile sig_atomic_t* Stop = nullptr; // Publishing stops if it is not 0, e.g. set by a signal handler
+
+    // Actions, return true on error
+    bool                        Run(const vector<string>& FileNames);
+
+    // Info
+    const string&               ErrorMessage() { return ErrorMessage_; }
+    uint64_t                    Published() { return Published_; }
+    bool                        IsClosed() { return IsClosed_; } // The reader does not want more frames or no more exists
+
+private:
+    bool                        Open(const string& FileName, rawcooked_file*& File, size_t& Track, rawcooked_track_info& Info);
+    static void                 Slot_Size_Callback(void* Opaque, const rawcooked_plane* Planes, size_t Planes_Count);
+    static void                 Publish_Callback(void* Opaque, const rawcooked_plane* Planes, size_t Planes_Count);
+    void                        Publish(const rawcooked_plane* Planes, size_t Planes_Count);
+    bool                        IsStopped() { return Stop && *Stop; }
+
+    frame_ring                  Ring;
+    rawcooked_file*             File = nullptr;
+    size_t                      Slot_Size = 0;
+    uint32_t                    Input = 0;
+    uint32_t                    Track = 0;
+    uint64_t                    Frame = 0;
+    uint64_t                    Published_ = 0;
+    bool                        IsClosed_ = false;
+    string                      ErrorMessage_;
+};
+
+//---------------------------------------------------------------------------
+#endif
@@ -0,0 +1,333 @@
+/*  Copyright (c) MediaArea.net SARL & AV Preservation by reto.ch.
+ *
+ *  Use of this source code is governed by a BSD-style license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//---------------------------------------------------------------------------
+#include "Lib/Utils/FrameRing/FrameRing.h"
+#include <cerrno>
+#include <cstring>
+#if !defined(_WIN32) && !defined(_WINDOWS)
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#else
+#include <chrono>
+#include <thread>
+#endif
+#endif
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+namespace
+{
+    const size_t                Page_Size = 4096;
+    const size_t                Plane_Alignment = 64;
+    const long                  Wait_Timeout = 100; // In milliseconds, for checking the other side and the stop request
+
+    size_t Align(size_t Value, size_t Alignment)
+    {
+        return (Value + Alignment - 1) / Alignment * Alignment;
+    }
+
+    string Shm_Name(const string& Name)
+    {
+        return (Name.empty() || Name[0] != '/') ? ('/' + Name) : Name;
+    }
+
+    // Wait while Event is Value and at most Wait_Timeout, waiters are woken up by Wake() (shared between processes)
+    void Wait(atomic<uint32_t>& Event, uint32_t Value)
+    {
+        #if defined(__linux__)
+            timespec Timeout = { 0, Wait_Timeout * 1000000 };
+            syscall(SYS_futex, (uint32_t*)&Event, FUTEX_WAIT, Value, &Timeout, nullptr, 0);
+        #elif !defined(_WIN32) && !defined(_WINDOWS)
+            auto End = chrono::steady_clock::now() + chrono::milliseconds(Wait_Timeout);
+            while (Event.load(memory_order_acquire) == Value && chrono::steady_clock::now() < End)
+                this_thread::sleep_for(chrono::microseconds(100)); // No portable shared futex, polling
+        #else
+            (void)Event;
+            (void)Value;
+        #endif
+    }
+
+    // False if the process does not exist, true if it exists or is unknown
+    bool IsAlive(const atomic<int32_t>& Pid_Source)
+    {
+        #if !defined(_WIN32) && !defined(_WINDOWS)
+            auto Pid = Pid_Source.load(memory_order_acquire);
+            return Pid <= 0 || !kill((pid_t)Pid, 0) || errno == EPERM;
+        #else
+            (void)Pid_Source;
+            return true;
+        #endif
+    }
+
+    void Wake(atomic<uint32_t>& Event)
+    {
+        Event.fetch_add(1, memory_order_release);
+        #if defined(__linux__)
+            syscall(SYS_futex, (uint32_t*)&Event, FUTEX_WAKE, 1, nullptr, nullptr, 0);
+        #endif
+    }
+}
+
+//***************************************************************************
+// Producer
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+frame_ring::~frame_ring()
+{
+    Close();
+}
+
+//---------------------------------------------------------------------------
+size_t frame_ring::Plane_Offset(size_t Plane_Offset_Previous, size_t Plane_Size_Previous)
+{
+    if (!Plane_Offset_Previous)
+        return Align(sizeof(frame_ring_slot), Plane_Alignment);
+    return Align(Plane_Offset_Previous + Plane_Size_Previous, Plane_Alignment);
+}
+
+//---------------------------------------------------------------------------
+size_t frame_ring::Slot_Size_Get(const size_t* Plane_Sizes, size_t Planes_Count)
+{
+    size_t Offset = 0;
+    size_t Size = 0;
+    for (size_t i = 0; i < Planes_Count; i++)
+    {
+        Offset = Plane_Offset(Offset, Size);
+        Size = Plane_Sizes[i];
+    }
+    return Align(Offset + Size, Page_Size);
+}
+
+//---------------------------------------------------------------------------
+bool frame_ring::Create(const string& Name, size_t Slot_Count, size_t Slot_Size)
+{
+    Close();
+
+    #if defined(_WIN32) || defined(_WINDOWS)
+        (void)Name;
+        (void)Slot_Count;
+        (void)Slot_Size;
+        ErrorMessage_ = "shared memory frame ring is not supported on this platform";
+        return true;
+    #else
+        if (!Slot_Count || Slot_Size < sizeof(frame_ring_slot))
+        {
+            ErrorMessage_ = "invalid frame ring size";
+            return true;
+        }
+        auto Slots_Offset = Align(sizeof(frame_ring_header), Page_Size);
+        Slot_Size = Align(Slot_Size, Page_Size);
+        auto NewSize = Slots_Offset + Slot_Count * Slot_Size;
+
+        auto NewName = Shm_Name(Name);
+        auto Fd = shm_open(NewName.c_str(), O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+        if (Fd == -1)
+        {
+            ErrorMessage_ = "can not create shared memory " + NewName + " (" + strerror(errno) + ')';
+            return true;
+        }
+        if (ftruncate(Fd, (off_t)NewSize))
+        {
+            ErrorMessage_ = "can not size shared memory " + NewName + " (" + strerror(errno) + ')';
+            close(Fd);
+            shm_unlink(NewName.c_str());
+            return true;
+        }
+        auto Data = mmap(nullptr, NewSize, PROT_READ | PROT_WRITE, MAP_SHARED, Fd, 0);
+        close(Fd);
+        if (Data == MAP_FAILED)
+        {
+            ErrorMessage_ = "can not map shared memory " + NewName + " (" + strerror(errno) + ')';
+            shm_unlink(NewName.c_str());
+            return true;
+        }
+
+        // Content is zeroed by ftruncate(), the magic value is written last
+        Header = (frame_ring_header*)Data;
+        Size = NewSize;
+        Name_ = NewName;
+        Header->Version = 1;
+        Header->Slot_Count = (uint32_t)Slot_Count;
+        Header->Slot_Size = Slot_Size;
+        Header->Slots_Offset = Slots_Offset;
+        Header->Write_Pid.store((int32_t)getpid(), memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+        memcpy(Header->Magic, "RAWCRING", 8);
+        return false;
+    #endif
+}
+
+//---------------------------------------------------------------------------
+frame_ring_slot* frame_ring::Slot_Get()
+{
+    if (!Header)
+        return nullptr;
+    auto Write_Count = Header->Write_Count.load(memory_order_relaxed);
+    for (;;)
+    {
+        auto Event = Header->Read_Event.load(memory_order_acquire);
+        if (Header->Read_State.load(memory_order_acquire) & FrameRing_Closed)
+            return nullptr;
+        if (Write_Count - Header->Read_Count.load(memory_order_acquire) < Header->Slot_Count)
+            break;
+        if ((Stop && *Stop) || !IsAlive(Header->Read_Pid))
+            return nullptr;
+        Wait(Header->Read_Event, Event);
+    }
+
+    auto Slot = (frame_ring_slot*)((uint8_t*)Header + Header->Slots_Offset + (Write_Count % Header->Slot_Count) * Header->Slot_Size);
+    memset(Slot, 0, sizeof(frame_ring_slot));
+    Slot->Sequence = Write_Count;
+    return Slot;
+}
+
+//---------------------------------------------------------------------------
+void frame_ring::Slot_Publish()
+{
+    if (!Header)
+        return;
+    Header->Write_Count.fetch_add(1, memory_order_release);
+    Wake(Header->Write_Event);
+}
+
+//---------------------------------------------------------------------------
+void frame_ring::End(bool HasError)
+{
+    if (!Header)
+        return;
+    Header->Write_State.fetch_or((uint32_t)FrameRing_End | (HasError ? (uint32_t)FrameRing_Error : 0u), memory_order_release);
+    Wake(Header->Write_Event);
+
+    // The consumer may still read the last frames
+    auto Write_Count = Header->Write_Count.load(memory_order_relaxed);
+    for (;;)
+    {
+        auto Event = Header->Read_Event.load(memory_order_acquire);
+        if ((Header->Read_State.load(memory_order_acquire) & FrameRing_Closed) || Header->Read_Count.load(memory_order_acquire) >= Write_Count)
+            break;
+        if ((Stop && *Stop) || !IsAlive(Header->Read_Pid))
+            break;
+        Wait(Header->Read_Event, Event);
+    }
+}
+
+//---------------------------------------------------------------------------
+void frame_ring::Close()
+{
+    #if !defined(_WIN32) && !defined(_WINDOWS)
+        if (!Header)
+            return;
+        munmap((void*)Header, Size);
+        shm_unlink(Name_.c_str());
+        Header = nullptr;
+        Size = 0;
+        Name_.clear();
+    #endif
+}
+
+//***************************************************************************
+// Consumer
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+frame_ring_reader::~frame_ring_reader()
+{
+    Close();
+}
+
+//---------------------------------------------------------------------------
+bool frame_ring_reader::Open(const string& Name)
+{
+    Close();
+
+    #if defined(_WIN32) || defined(_WINDOWS)
+        (void)Name;
+        return true;
+    #else
+        auto Fd = shm_open(Shm_Name(Name).c_str(), O_RDWR, 0);
+        if (Fd == -1)
+            return true;
+        struct stat Stat;
+        if (fstat(Fd, &Stat) || (size_t)Stat.st_size < sizeof(frame_ring_header))
+        {
+            close(Fd);
+            return true;
+        }
+        auto Data = mmap(nullptr, (size_t)Stat.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, Fd, 0);
+        close(Fd);
+        if (Data == MAP_FAILED)
+            return true;
+        Header = (frame_ring_header*)Data;
+        Size = (size_t)Stat.st_size;
+        atomic_thread_fence(memory_order_acquire);
+        if (memcmp(Header->Magic, "RAWCRING", 8) || Header->Version != 1 || Header->Slots_Offset + Header->Slot_Count * Header->Slot_Size > Size)
+        {
+            munmap(Data, Size);
+            Header = nullptr;
+            Size = 0;
+            return true;
+        }
+        Header->Read_Pid.store((int32_t)getpid(), memory_order_release);
+        IsBroken = false;
+        return false;
+    #endif
+}
+
+//---------------------------------------------------------------------------
+const frame_ring_slot* frame_ring_reader::Next()
+{
+    if (!Header)
+        return nullptr;
+    auto Read_Count = Header->Read_Count.load(memory_order_relaxed);
+    for (;;)
+    {
+        auto Event = Header->Write_Event.load(memory_order_acquire);
+        if (Read_Count < Header->Write_Count.load(memory_order_acquire))
+            break;
+        if (Header->Write_State.load(memory_order_acquire) & FrameRing_End)
+            return nullptr;
+        if (!IsAlive(Header->Write_Pid))
+        {
+            IsBroken = true;
+            return nullptr;
+        }
+        Wait(Header->Write_Event, Event);
+    }
+
+    return (const frame_ring_slot*)((const uint8_t*)Header + Header->Slots_Offset + (Read_Count % Header->Slot_Count) * Header->Slot_Size);
+}
+
+//---------------------------------------------------------------------------
+void frame_ring_reader::Release()
+{
+    if (!Header)
+        return;
+    Header->Read_Count.fetch_add(1, memory_order_release);
+    Wake(Header->Read_Event);
+}
+
+//---------------------------------------------------------------------------
+void frame_ring_reader::Close()
+{
+    #if !defined(_WIN32) && !defined(_WINDOWS)
+        if (!Header)
+            return;
+        Header->Read_State.fetch_or(FrameRing_Closed, memory_order_release);
+        Wake(Header->Read_Event);
+        munmap((void*)Header, Size);
+        Header = nullptr;
+        Size = 0;
+    #endif
+}
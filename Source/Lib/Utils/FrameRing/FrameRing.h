@@ -0,0 +1,162 @@
+/*  Copyright (c) MediaArea.net SARL & AV Preservation by reto.ch.
+ *
+ *  Use of this source code is governed by a BSD-style license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//---------------------------------------------------------------------------
+#ifndef FrameRingH
+#define FrameRingH
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+#include "Lib/Config.h"
+#include <atomic>
+#include <csignal>
+#include <string>
+using namespace std;
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+// Ring of decoded frames in POSIX shared memory, for another process reading
+// them without copy and without files
+//
+// Protocol, one producer and one consumer, native endianness:
+// - the shared memory starts with frame_ring_header, slots are then at
+//   Slots_Offset + (Sequence % Slot_Count) * Slot_Size
+// - a slot starts with frame_ring_slot, plane content is at the offsets
+//   provided in the slot, relative to the start of the slot
+// - the producer fills the slot Write_Count % Slot_Count when
+//   Write_Count - Read_Count < Slot_Count, then increments Write_Count
+// - the consumer reads the slot Read_Count % Slot_Count when
+//   Read_Count < Write_Count, then increments Read_Count for releasing it
+// - counters are written with release semantic and read with acquire
+//   semantic, the side changing a counter or a state then increments its
+//   event and wakes the waiters of the event (Linux futex, shared)
+// - the producer sets End in Write_State after the last frame (and Error if
+//   decoding failed), the consumer sets Closed in Read_State if it stops
+//   before the end
+// - the producer writes its process ID in Write_Pid, the consumer in Read_Pid
+//   when it opens the ring (0 if unknown), a side waits at most 100 ms at a
+//   time and stops waiting if the process of the other side does not exist
+// The producer removes the name of the shared memory after the consumer has
+// released the last frame or is closed or does not exist, or if it is stopped.
+
+//---------------------------------------------------------------------------
+struct frame_ring_header
+{
+    char                        Magic[8];       // "RAWCRING"
+    uint32_t                    Version;        // 1
+    uint32_t                    Slot_Count;
+    uint64_t                    Slot_Size;      // In bytes, slot header included
+    uint64_t                    Slots_Offset;   // From the start of the shared memory
+    uint8_t                     Reserved[32];
+
+    // Written by the producer
+    atomic<uint64_t>            Write_Count;    // Count of published frames
+    atomic<uint32_t>            Write_Event;    // Futex
+    atomic<uint32_t>            Write_State;    // frame_ring_state flags
+    atomic<int32_t>             Write_Pid;      // Process ID of the producer
+    uint8_t                     Reserved_Write[44];
+
+    // Written by the consumer
+    atomic<uint64_t>            Read_Count;     // Count of released frames
+    atomic<uint32_t>            Read_Event;     // Futex
+    atomic<uint32_t>            Read_State;     // frame_ring_state flags
+    atomic<int32_t>             Read_Pid;       // Process ID of the consumer
+    uint8_t                     Reserved_Read[44];
+};
+static_assert(sizeof(frame_ring_header) == 192, "frame_ring_header size");
+
+enum frame_ring_state : uint32_t
+{
+    FrameRing_End               = 1 << 0,       // Producer, no more frames
+    FrameRing_Error             = 1 << 1,       // Producer, frames are missing
+    FrameRing_Closed            = 1 << 2,       // Consumer, no more reading
+};
+
+//---------------------------------------------------------------------------
+struct frame_ring_plane
+{
+    uint64_t                    Offset;         // Of the content, from the start of the slot
+    uint64_t                    Size;           // In bytes, BytesPerLine * Height
+    uint64_t                    BytesPerLine;   // Stride
+    uint32_t                    Width;          // In pixels (video) or in samples (audio)
+    uint32_t                    Height;
+    uint32_t                    BytesPerBlock;  // A block is the smallest group of pixels with an integral count of bytes
+    uint32_t                    PixelsPerBlock;
+    uint8_t                     Reserved[8];
+};
+static_assert(sizeof(frame_ring_plane) == 48, "frame_ring_plane size");
+
+struct frame_ring_slot
+{
+    uint64_t                    Sequence;       // Count of frames published before this one
+    uint64_t                    Frame;          // Index of the frame in its track
+    uint32_t                    Input;          // Index of the input file
+    uint32_t                    Track;          // Index of the track in the input file
+    uint32_t                    Kind;           // 1 for video, 2 for audio
+    int32_t                     ColorSpace;     // Video, 0 for YCbCr, 1 for RGB
+    uint32_t                    BitDepth;       // Bits per sample
+    uint32_t                    Planes_Count;   // Planes with the layout of FFmpeg
+    uint8_t                     Reserved[24];
+    frame_ring_plane            Planes[4];
+};
+static_assert(sizeof(frame_ring_slot) == 256, "frame_ring_slot size");
+
+//---------------------------------------------------------------------------
+// Producer side
+class frame_ring
+{
+public:
+    ~frame_ring();
+
+    // Config
+    const volatile sig_atomic_t* Stop = nullptr; // Waits stop if it is not 0, e.g. set by a signal handler
+
+    // Actions, return true on error
+    bool                        Create(const string& Name, size_t Slot_Count, size_t Slot_Size);
+    frame_ring_slot*            Slot_Get(); // Waits for a free slot, nullptr if the consumer is closed or no more exists or if stopped
+    void                        Slot_Publish();
+    void                        End(bool HasError = false); // Waits for the consumer to release all frames or to be closed or to no more exist, or to be stopped
+    void                        Close();
+
+    // Info
+    static size_t               Slot_Size_Get(const size_t* Plane_Sizes, size_t Planes_Count); // Slot size for such planes, plane content is aligned
+    static size_t               Plane_Offset(size_t Plane_Offset_Previous, size_t Plane_Size_Previous); // Aligned offset of the next plane, first is Plane_Offset(0, 0)
+    const string&               ErrorMessage() { return ErrorMessage_; }
+    bool                        IsOpen() { return Header != nullptr; }
+    size_t                      Slot_Size() { return Header ? (size_t)Header->Slot_Size : 0; }
+
+private:
+    frame_ring_header*          Header = nullptr;
+    size_t                      Size = 0;
+    string                      Name_;
+    string                      ErrorMessage_;
+};
+
+//---------------------------------------------------------------------------
+// Consumer side
+class frame_ring_reader
+{
+public:
+    ~frame_ring_reader();
+
+    // Actions, Open() returns true on error
+    bool                        Open(const string& Name);
+    const frame_ring_slot*      Next(); // Waits for the next frame, nullptr at the end or if the producer no more exists
+    void                        Release(); // Frame from Next() is no more used
+    void                        Close();
+
+    // Info
+    const uint8_t*              Data(const frame_ring_slot* Slot, size_t Plane) { return (const uint8_t*)Slot + Slot->Planes[Plane].Offset; }
+    bool                        HasError() { return IsBroken || (Header && (Header->Write_State.load(memory_order_acquire) & FrameRing_Error)); }
+
+private:
+    frame_ring_header*          Header = nullptr;
+    size_t                      Size = 0;
+    bool                        IsBroken = false; // Producer no more exists
+};
+
+//---------------------------------------------------------------------------
+#endif
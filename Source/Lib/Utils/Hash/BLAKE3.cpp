@@ -0,0 +1,405 @@
+/*  Copyright (c) MediaArea.net SARL & AV Preservation by reto.ch.
+ *
+ *  Use of this source code is governed by a BSD-style license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//---------------------------------------------------------------------------
+#include "Lib/Utils/Hash/BLAKE3.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+#ifdef __GNUC__
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wreorder"
+#endif
+#include "ThreadPool.h"
+#ifdef __GNUC__
+#pragma GCC diagnostic pop
+#endif
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+static const size_t BLAKE3_BlockLen = 64;
+static const size_t BLAKE3_ChunkLen = 1024;
+static const size_t BLAKE3_SubtreeUnit = 64; // Chunks hashed by a single job in parallel mode
+static const size_t BLAKE3_SubtreeUnits_PerThread = 8; // Minimal count of jobs per thread, else threads are not worth it
+
+enum blake3_flags : uint32_t
+{
+    BLAKE3_ChunkStart = 1 << 0,
+    BLAKE3_ChunkEnd   = 1 << 1,
+    BLAKE3_Parent     = 1 << 2,
+    BLAKE3_Root       = 1 << 3,
+};
+
+static const uint32_t BLAKE3_IV[8] =
+{
+    0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A, 0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19,
+};
+
+static const uint8_t BLAKE3_Permutation[16] =
+{
+    2, 6, 3, 10, 7, 0, 4, 13, 1, 11, 12, 5, 9, 14, 15, 8,
+};
+
+//---------------------------------------------------------------------------
+static inline uint32_t BLAKE3_Rotr(uint32_t Value, int Count)
+{
+    return (Value >> Count) | (Value << (32 - Count));
+}
+
+//---------------------------------------------------------------------------
+static inline void BLAKE3_G(uint32_t* State, size_t a, size_t b, size_t c, size_t d, uint32_t x, uint32_t y)
+{
+    State[a] = State[a] + State[b] + x;
+    State[d] = BLAKE3_Rotr(State[d] ^ State[a], 16);
+    State[c] = State[c] + State[d];
+    State[b] = BLAKE3_Rotr(State[b] ^ State[c], 12);
+    State[a] = State[a] + State[b] + y;
+    State[d] = BLAKE3_Rotr(State[d] ^ State[a], 8);
+    State[c] = State[c] + State[d];
+    State[b] = BLAKE3_Rotr(State[b] ^ State[c], 7);
+}
+
+//---------------------------------------------------------------------------
+static void BLAKE3_Compress(const uint32_t CV[8], const uint32_t Block_Words[16], uint64_t Counter, uint32_t Block_Len, uint32_t Flags, uint32_t Out[16])
+{
+    uint32_t State[16] =
+    {
+        CV[0], CV[1], CV[2], CV[3], CV[4], CV[5], CV[6], CV[7],
+        BLAKE3_IV[0], BLAKE3_IV[1], BLAKE3_IV[2], BLAKE3_IV[3],
+        (uint32_t)Counter, (uint32_t)(Counter >> 32), Block_Len, Flags,
+    };
+    uint32_t M[16];
+    memcpy(M, Block_Words, sizeof(M));
+
+    for (int Round = 0; Round < 7; Round++)
+    {
+        BLAKE3_G(State, 0, 4,  8, 12, M[ 0], M[ 1]);
+        BLAKE3_G(State, 1, 5,  9, 13, M[ 2], M[ 3]);
+        BLAKE3_G(State, 2, 6, 10, 14, M[ 4], M[ 5]);
+        BLAKE3_G(State, 3, 7, 11, 15, M[ 6], M[ 7]);
+        BLAKE3_G(State, 0, 5, 10, 15, M[ 8], M[ 9]);
+        BLAKE3_G(State, 1, 6, 11, 12, M[10], M[11]);
+        BLAKE3_G(State, 2, 7,  8, 13, M[12], M[13]);
+        BLAKE3_G(State, 3, 4,  9, 14, M[14], M[15]);
+
+        if (Round != 6)
+        {
+            uint32_t Permuted[16];
+            for (size_t i = 0; i < 16; i++)
+                Permuted[i] = M[BLAKE3_Permutation[i]];
+            memcpy(M, Permuted, sizeof(M));
+        }
+    }
+
+    for (size_t i = 0; i < 8; i++)
+    {
+        Out[i] = State[i] ^ State[i + 8];
+        Out[i + 8] = State[i + 8] ^ CV[i];
+    }
+}
+
+//---------------------------------------------------------------------------
+static inline void BLAKE3_Words(const uint8_t* Data, uint32_t Words[16])
+{
+    for (size_t i = 0; i < 16; i++)
+        Words[i] = ((uint32_t)Data[i * 4]) | ((uint32_t)Data[i * 4 + 1] << 8) | ((uint32_t)Data[i * 4 + 2] << 16) | ((uint32_t)Data[i * 4 + 3] << 24);
+}
+
+//---------------------------------------------------------------------------
+static blake3_ctx::cv BLAKE3_ParentCV(const blake3_ctx::cv& Left, const blake3_ctx::cv& Right)
+{
+    uint32_t Block_Words[16];
+    memcpy(Block_Words, Left.data(), 32);
+    memcpy(Block_Words + 8, Right.data(), 32);
+    uint32_t Out[16];
+    BLAKE3_Compress(BLAKE3_IV, Block_Words, 0, BLAKE3_BlockLen, BLAKE3_Parent, Out);
+    blake3_ctx::cv CV;
+    memcpy(CV.data(), Out, 32);
+    return CV;
+}
+
+//---------------------------------------------------------------------------
+// Complete chunk, not root
+static blake3_ctx::cv BLAKE3_ChunkCV(const uint8_t* Data, uint64_t Counter)
+{
+    blake3_ctx::cv CV;
+    memcpy(CV.data(), BLAKE3_IV, 32);
+    for (size_t i = 0; i < BLAKE3_ChunkLen / BLAKE3_BlockLen; i++)
+    {
+        uint32_t Flags = 0;
+        if (!i)
+            Flags |= BLAKE3_ChunkStart;
+        if (i == BLAKE3_ChunkLen / BLAKE3_BlockLen - 1)
+            Flags |= BLAKE3_ChunkEnd;
+        uint32_t Block_Words[16];
+        BLAKE3_Words(Data + i * BLAKE3_BlockLen, Block_Words);
+        uint32_t Out[16];
+        BLAKE3_Compress(CV.data(), Block_Words, Counter, BLAKE3_BlockLen, Flags, Out);
+        memcpy(CV.data(), Out, 32);
+    }
+    return CV;
+}
+
+//---------------------------------------------------------------------------
+// Complete subtree of Chunks (power of 2) chunks, not root
+static blake3_ctx::cv BLAKE3_SubtreeCV(const uint8_t* Data, size_t Chunks, uint64_t Counter)
+{
+    if (Chunks == 1)
+        return BLAKE3_ChunkCV(Data, Counter);
+    auto Half = Chunks / 2;
+    return BLAKE3_ParentCV(BLAKE3_SubtreeCV(Data, Half, Counter), BLAKE3_SubtreeCV(Data + Half * BLAKE3_ChunkLen, Half, Counter + Half));
+}
+
+//---------------------------------------------------------------------------
+void blake3_ctx::Init()
+{
+    Chunk_Reset(0);
+    CVs_Size = 0;
+}
+
+//---------------------------------------------------------------------------
+void blake3_ctx::Chunk_Reset(uint64_t Counter)
+{
+    memcpy(Chunk_CV.data(), BLAKE3_IV, 32);
+    Chunk_Counter = Counter;
+    memset(Chunk_Block, 0, sizeof(Chunk_Block));
+    Chunk_Block_Size = 0;
+    Chunk_Blocks_Compressed = 0;
+}
+
+//---------------------------------------------------------------------------
+void blake3_ctx::Chunk_Update(const uint8_t* Data, size_t Size)
+{
+    while (Size)
+    {
+        // Block is compressed only when we know that it is not the last one of the chunk
+        if (Chunk_Block_Size == BLAKE3_BlockLen)
+        {
+            uint32_t Block_Words[16];
+            BLAKE3_Words(Chunk_Block, Block_Words);
+            uint32_t Out[16];
+            BLAKE3_Compress(Chunk_CV.data(), Block_Words, Chunk_Counter, BLAKE3_BlockLen, Chunk_Blocks_Compressed ? 0u : (uint32_t)BLAKE3_ChunkStart, Out);
+            memcpy(Chunk_CV.data(), Out, 32);
+            Chunk_Blocks_Compressed++;
+            memset(Chunk_Block, 0, sizeof(Chunk_Block));
+            Chunk_Block_Size = 0;
+        }
+
+        auto ToCopy = BLAKE3_BlockLen - Chunk_Block_Size;
+        if (ToCopy > Size)
+            ToCopy = Size;
+        memcpy(Chunk_Block + Chunk_Block_Size, Data, ToCopy);
+        Chunk_Block_Size += ToCopy;
+        Data += ToCopy;
+        Size -= ToCopy;
+    }
+}
+
+//---------------------------------------------------------------------------
+void blake3_ctx::Chunk_Output(uint32_t Block_Words[16], uint32_t& Flags)
+{
+    BLAKE3_Words(Chunk_Block, Block_Words);
+    Flags = BLAKE3_ChunkEnd;
+    if (!Chunk_Blocks_Compressed)
+        Flags |= BLAKE3_ChunkStart;
+}
+
+//---------------------------------------------------------------------------
+// Units of a subtree, shared by the calling thread and the jobs of the pool
+// Jobs may start after the end of the hash of the subtree, so they own it too
+struct blake3_units
+{
+    const uint8_t*              Data;
+    size_t                      Unit;
+    size_t                      Count;
+    uint64_t                    Counter;
+    vector<blake3_ctx::cv>      Level;
+    atomic<size_t>              Next{ 0 };
+    size_t                      Done = 0;
+    mutex                       Mutex;
+    condition_variable          IsDone;
+
+    void Run()
+    {
+        size_t Run_Done = 0;
+        for (size_t i; (i = Next++) < Count; Run_Done++)
+            Level[i] = BLAKE3_SubtreeCV(Data + i * Unit * BLAKE3_ChunkLen, Unit, Counter + i * Unit);
+        if (!Run_Done)
+            return;
+        lock_guard<mutex> Lock(Mutex);
+        Done += Run_Done;
+        if (Done == Count)
+            IsDone.notify_all();
+    }
+};
+
+//---------------------------------------------------------------------------
+void blake3_ctx::Subtree(const uint8_t* Data, size_t Chunks, cv Halves[2])
+{
+    // Subtrees of units are hashed in parallel, then merged
+    auto Units = make_shared<blake3_units>();
+    Units->Data = Data;
+    Units->Unit = Chunks / 2 < BLAKE3_SubtreeUnit ? (Chunks / 2) : BLAKE3_SubtreeUnit;
+    Units->Count = Chunks / Units->Unit;
+    Units->Counter = Chunk_Counter;
+    Units->Level.resize(Units->Count);
+    size_t Jobs_Count = Pool ? (Units->Count / BLAKE3_SubtreeUnits_PerThread) : 0;
+    if (Pool && Jobs_Count > Pool->size())
+        Jobs_Count = Pool->size();
+    for (size_t i = 1; i < Jobs_Count; i++)
+        Pool->submit([Units]() { Units->Run(); });
+    Units->Run(); // The calling thread does all the work if the threads of the pool are busy, so a thread of the pool can call this method
+    {
+        unique_lock<mutex> Lock(Units->Mutex);
+        while (Units->Done != Units->Count)
+            Units->IsDone.wait(Lock);
+    }
+
+    auto& Level = Units->Level;
+    auto Count = Units->Count;
+    while (Count > 2)
+    {
+        Count /= 2;
+        for (size_t i = 0; i < Count; i++)
+            Level[i] = BLAKE3_ParentCV(Level[i * 2], Level[i * 2 + 1]);
+    }
+    Halves[0] = Level[0];
+    Halves[1] = Level[1];
+}
+
+//---------------------------------------------------------------------------
+void blake3_ctx::MergeCVs(uint64_t Chunks_Total)
+{
+    // Count of CVs in the stack is the count of 1 bits in the count of chunks
+    size_t Size_AfterMerge = 0;
+    for (auto Value = Chunks_Total; Value; Value &= Value - 1)
+        Size_AfterMerge++;
+    while (CVs_Size > Size_AfterMerge)
+    {
+        CVs[CVs_Size - 2] = BLAKE3_ParentCV(CVs[CVs_Size - 2], CVs[CVs_Size - 1]);
+        CVs_Size--;
+    }
+}
+
+//---------------------------------------------------------------------------
+void blake3_ctx::PushCV(const cv& CV, uint64_t Counter)
+{
+    // Previous CVs are merged only when a new one comes, so we know they are not the root
+    MergeCVs(Counter);
+    CVs[CVs_Size++] = CV;
+}
+
+//---------------------------------------------------------------------------
+void blake3_ctx::Update(const uint8_t* Data, size_t Size)
+{
+    // Previous incomplete chunk
+    auto Chunk_Size = Chunk_Blocks_Compressed * BLAKE3_BlockLen + Chunk_Block_Size;
+    if (Chunk_Size)
+    {
+        auto ToCopy = BLAKE3_ChunkLen - Chunk_Size;
+        if (ToCopy > Size)
+            ToCopy = Size;
+        Chunk_Update(Data, ToCopy);
+        Data += ToCopy;
+        Size -= ToCopy;
+        if (!Size)
+            return;
+
+        // More content after this chunk, so it is not the root
+        uint32_t Block_Words[16];
+        uint32_t Flags;
+        Chunk_Output(Block_Words, Flags);
+        uint32_t Out[16];
+        BLAKE3_Compress(Chunk_CV.data(), Block_Words, Chunk_Counter, (uint32_t)Chunk_Block_Size, Flags, Out);
+        cv CV;
+        memcpy(CV.data(), Out, 32);
+        PushCV(CV, Chunk_Counter);
+        Chunk_Reset(Chunk_Counter + 1);
+    }
+
+    // Biggest subtrees aligned on the count of chunks already hashed, the last chunk is kept for Final()
+    while (Size > BLAKE3_ChunkLen)
+    {
+        size_t Subtree_Size = BLAKE3_ChunkLen;
+        while (Subtree_Size * 2 <= Size && !((Subtree_Size * 2 / BLAKE3_ChunkLen - 1) & Chunk_Counter))
+            Subtree_Size *= 2;
+        auto Subtree_Chunks = Subtree_Size / BLAKE3_ChunkLen;
+        if (Subtree_Chunks == 1)
+            PushCV(BLAKE3_ChunkCV(Data, Chunk_Counter), Chunk_Counter);
+        else
+        {
+            cv Halves[2];
+            Subtree(Data, Subtree_Chunks, Halves);
+            PushCV(Halves[0], Chunk_Counter);
+            PushCV(Halves[1], Chunk_Counter + Subtree_Chunks / 2);
+        }
+        Chunk_Counter += Subtree_Chunks;
+        Data += Subtree_Size;
+        Size -= Subtree_Size;
+    }
+
+    // Remaining content
+    if (Size)
+    {
+        Chunk_Update(Data, Size);
+        MergeCVs(Chunk_Counter);
+    }
+}
+
+//---------------------------------------------------------------------------
+void blake3_ctx::Final(uint8_t Digest[32])
+{
+    // Root node
+    uint32_t CV[8];
+    uint32_t Block_Words[16];
+    uint64_t Counter;
+    uint32_t Block_Len;
+    uint32_t Flags;
+    size_t CVs_Remaining;
+    if (Chunk_Blocks_Compressed || Chunk_Block_Size || !CVs_Size)
+    {
+        memcpy(CV, Chunk_CV.data(), 32);
+        Chunk_Output(Block_Words, Flags);
+        Counter = Chunk_Counter;
+        Block_Len = (uint32_t)Chunk_Block_Size;
+        CVs_Remaining = CVs_Size;
+    }
+    else
+    {
+        CVs_Remaining = CVs_Size - 2;
+        memcpy(CV, BLAKE3_IV, 32);
+        memcpy(Block_Words, CVs[CVs_Remaining].data(), 32);
+        memcpy(Block_Words + 8, CVs[CVs_Remaining + 1].data(), 32);
+        Counter = 0;
+        Block_Len = BLAKE3_BlockLen;
+        Flags = BLAKE3_Parent;
+    }
+    while (CVs_Remaining)
+    {
+        CVs_Remaining--;
+        uint32_t Out[16];
+        BLAKE3_Compress(CV, Block_Words, Counter, Block_Len, Flags, Out);
+        memcpy(Block_Words, CVs[CVs_Remaining].data(), 32);
+        memcpy(Block_Words + 8, Out, 32);
+        memcpy(CV, BLAKE3_IV, 32);
+        Counter = 0;
+        Block_Len = BLAKE3_BlockLen;
+        Flags = BLAKE3_Parent;
+    }
+
+    uint32_t Out[16];
+    BLAKE3_Compress(CV, Block_Words, Counter, Block_Len, Flags | BLAKE3_Root, Out);
+    for (size_t i = 0; i < 8; i++)
+    {
+        Digest[i * 4    ] = (uint8_t)(Out[i]);
+        Digest[i * 4 + 1] = (uint8_t)(Out[i] >> 8);
+        Digest[i * 4 + 2] = (uint8_t)(Out[i] >> 16);
+        Digest[i * 4 + 3] = (uint8_t)(Out[i] >> 24);
+    }
+}
@@ -0,0 +1,59 @@
+/*  Copyright (c) MediaArea.net SARL & AV Preservation by reto.ch.
+ *
+ *  Use of this source code is governed by a BSD-style license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//---------------------------------------------------------------------------
+#ifndef BLAKE3H
+#define BLAKE3H
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+#include "Lib/Config.h"
+#include <array>
+using namespace std;
+class ThreadPool;
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+// BLAKE3, hash mode, 256-bit output
+// Big inputs are split in subtrees of chunks which are hashed in parallel
+// by the threads of the pool, if any, and the calling thread
+class blake3_ctx
+{
+public:
+    // Constructor
+    blake3_ctx(ThreadPool* Pool_Source = nullptr) : Pool(Pool_Source) { Init(); }
+
+    // Actions
+    void                        Init();
+    void                        Update(const uint8_t* Data, size_t Size);
+    void                        Final(uint8_t Digest[32]);
+
+    typedef array<uint32_t, 8>  cv; // Chaining value
+
+private:
+    void                        Chunk_Update(const uint8_t* Data, size_t Size);
+    void                        Chunk_Output(uint32_t Block_Words[16], uint32_t& Flags);
+    void                        Chunk_Reset(uint64_t Counter);
+    void                        Subtree(const uint8_t* Data, size_t Chunks, cv CVs[2]); // CVs of both halves of a subtree of Chunks (power of 2) chunks
+    void                        PushCV(const cv& CV, uint64_t Counter);
+    void                        MergeCVs(uint64_t Chunks_Total);
+
+    // Current chunk
+    cv                          Chunk_CV;
+    uint64_t                    Chunk_Counter;
+    uint8_t                     Chunk_Block[64];
+    size_t                      Chunk_Block_Size;
+    size_t                      Chunk_Blocks_Compressed;
+
+    // Subtrees
+    cv                          CVs[54]; // Enough for 2^64 bytes
+    size_t                      CVs_Size;
+
+    ThreadPool*                 Pool;
+};
+
+//---------------------------------------------------------------------------
+#endif
@@ -0,0 +1,166 @@
+/*  Copyright (c) MediaArea.net SARL & AV Preservation by reto.ch.
+ *
+ *  Use of this source code is governed by a BSD-style license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//---------------------------------------------------------------------------
+#include "Lib/Utils/Hash/Hash.h"
+#include "Lib/Utils/Hash/BLAKE3.h"
+#include "Lib/Utils/Hash/SHA256.h"
+#include "Lib/Utils/Hash/XXH3.h"
+extern "C"
+{
+#include "md5.h"
+}
+//---------------------------------------------------------------------------
+
+//***************************************************************************
+// Hash value
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+hash_value::hash_value(hash_format Format_Source, const uint8_t* Data_Source) :
+    Format(Format_Source)
+{
+    memcpy(Data.data(), Data_Source, Size());
+}
+
+//---------------------------------------------------------------------------
+size_t hash_value::Size() const
+{
+    return hash_base::Size(Format);
+}
+
+//---------------------------------------------------------------------------
+string hash_value::ToString() const
+{
+    static const char* Hex = "0123456789abcdef";
+    string Value;
+    auto Value_Size = Size();
+    Value.reserve(Value_Size * 2);
+    for (size_t i = 0; i < Value_Size; i++)
+    {
+        Value += Hex[Data[i] >> 4];
+        Value += Hex[Data[i] & 0xF];
+    }
+    return Value;
+}
+
+//***************************************************************************
+// Algorithms
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+class hash_md5 : public hash_base
+{
+public:
+    hash_md5() : hash_base(hash_format::MD5) { Init(); }
+
+    void Init() { MD5_Init(&Context); }
+    void Update(const uint8_t* Data, size_t Size)
+    {
+        const auto Step = (size_t)1 << 30; // MD5_Update() size is limited on some platforms
+        for (size_t Offset = 0; Offset < Size; Offset += Step)
+        {
+            auto Step_Size = Size - Offset;
+            if (Step_Size > Step)
+                Step_Size = Step;
+            MD5_Update(&Context, Data + Offset, (unsigned long)Step_Size);
+        }
+    }
+    void Final(uint8_t* Digest) { MD5_Final(Digest, &Context); }
+
+private:
+    MD5_CTX                     Context;
+};
+
+//---------------------------------------------------------------------------
+template<hash_format Format_Source, class ctx>
+class hash_ctx : public hash_base
+{
+public:
+    hash_ctx() : hash_base(Format_Source) {}
+    hash_ctx(ThreadPool* Pool) : hash_base(Format_Source), Context(Pool) {}
+
+    void Init() { Context.Init(); }
+    void Update(const uint8_t* Data, size_t Size) { Context.Update(Data, Size); }
+    void Final(uint8_t* Digest) { Context.Final(Digest); }
+
+private:
+    ctx                         Context;
+};
+
+//***************************************************************************
+// Hash
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+hash_base* hash_base::New(hash_format Format, ThreadPool* Pool)
+{
+    switch (Format)
+    {
+        case hash_format::MD5: return new hash_md5;
+        case hash_format::SHA256: return new hash_ctx<hash_format::SHA256, sha256_ctx>;
+        case hash_format::XXH3_128: return new hash_ctx<hash_format::XXH3_128, xxh3_128_ctx>;
+        case hash_format::BLAKE3: return new hash_ctx<hash_format::BLAKE3, blake3_ctx>(Pool);
+        default: return nullptr;
+    }
+}
+
+//---------------------------------------------------------------------------
+hash_value hash_base::Final()
+{
+    hash_value Value;
+    Value.Format = Format_;
+    Final(Value.Data.data());
+    return Value;
+}
+
+//---------------------------------------------------------------------------
+size_t hash_base::Size(hash_format Format)
+{
+    switch (Format)
+    {
+        case hash_format::MD5: return 16;
+        case hash_format::SHA256: return 32;
+        case hash_format::XXH3_128: return 16;
+        case hash_format::BLAKE3: return 32;
+        default: return 0;
+    }
+}
+
+//---------------------------------------------------------------------------
+const char* hash_base::Name(hash_format Format)
+{
+    switch (Format)
+    {
+        case hash_format::MD5: return "MD5";
+        case hash_format::SHA256: return "SHA-256";
+        case hash_format::XXH3_128: return "XXH3-128";
+        case hash_format::BLAKE3: return "BLAKE3";
+        default: return "";
+    }
+}
+
+//---------------------------------------------------------------------------
+const char* hash_base::OptionName(hash_format Format)
+{
+    switch (Format)
+    {
+        case hash_format::MD5: return "md5";
+        case hash_format::SHA256: return "sha256";
+        case hash_format::XXH3_128: return "xxh3";
+        case hash_format::BLAKE3: return "blake3";
+        default: return "";
+    }
+}
+
+//---------------------------------------------------------------------------
+hash_format hash_base::FromOptionName(const char* Name)
+{
+    for (uint8_t i = 1; i < (uint8_t)hash_format::Max; i++)
+        if (!strcmp(Name, OptionName((hash_format)i)))
+            return (hash_format)i;
+    return hash_format::None;
+}
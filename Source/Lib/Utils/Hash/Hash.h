@@ -0,0 +1,75 @@
+/*  Copyright (c) MediaArea.net SARL & AV Preservation by reto.ch.
+ *
+ *  Use of this source code is governed by a BSD-style license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//---------------------------------------------------------------------------
+#ifndef HashH
+#define HashH
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+#include "Lib/Config.h"
+#include <array>
+#include <cstring>
+#include <string>
+using namespace std;
+class ThreadPool;
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+// Hash value of any format, values are same only if formats are same
+struct hash_value
+{
+    // Constructor / Destructor
+    hash_value() {}
+    hash_value(hash_format Format_Source, const uint8_t* Data_Source);
+    hash_value(const md5& MD5) : hash_value(hash_format::MD5, MD5.data()) {}
+
+    // Data
+    hash_format                 Format = hash_format::None;
+    array<uint8_t, 32>          Data = {}; // Unused bytes are 0
+
+    // Info
+    size_t                      Size() const;
+    bool                        Empty() const { return Format == hash_format::None; }
+    string                      ToString() const; // Lowercase hexadecimal value
+
+    // Operators
+    friend bool operator == (hash_value const& l, hash_value const& r) { return l.Format == r.Format && l.Data == r.Data; }
+    friend bool operator != (hash_value const& l, hash_value const& r) { return !(l == r); }
+    friend bool operator < (hash_value const& l, hash_value const& r) { return l.Format < r.Format || (l.Format == r.Format && l.Data < r.Data); }
+};
+
+//---------------------------------------------------------------------------
+// Interface of hash algorithms
+class hash_base
+{
+public:
+    // Constructor / Destructor
+    static hash_base*           New(hash_format Format, ThreadPool* Pool = nullptr); // nullptr if format is unknown, Pool is used by algorithms with a parallel mode
+    virtual ~hash_base() {}
+
+    // Actions
+    virtual void                Init() = 0;
+    virtual void                Update(const uint8_t* Data, size_t Size) = 0;
+    virtual void                Final(uint8_t* Digest) = 0; // Size(Format()) bytes
+    hash_value                  Final();
+
+    // Info
+    hash_format                 Format() const { return Format_; }
+    static size_t               Size(hash_format Format); // Digest size in bytes
+    static const char*          Name(hash_format Format); // Display name e.g. "SHA-256"
+    static const char*          OptionName(hash_format Format); // Command line name e.g. "sha256"
+    static hash_format          FromOptionName(const char* Name); // None if unknown
+
+protected:
+    hash_base(hash_format Format_Source) : Format_(Format_Source) {}
+
+private:
+    hash_format                 Format_;
+};
+
+//---------------------------------------------------------------------------
+#endif
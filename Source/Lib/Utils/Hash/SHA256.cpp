@@ -0,0 +1,245 @@
+/*  Copyright (c) MediaArea.net SARL & AV Preservation by reto.ch.
+ *
+ *  Use of this source code is governed by a BSD-style license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//---------------------------------------------------------------------------
+#include "Lib/Utils/Hash/SHA256.h"
+#include <cstring>
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+    #define SHA256_SHANI
+    #define SHA256_SHANI_TARGET __attribute__((target("sha,sse4.1")))
+    #include <cpuid.h>
+    #include <immintrin.h>
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    #define SHA256_SHANI
+    #define SHA256_SHANI_TARGET
+    #include <intrin.h>
+    #include <immintrin.h>
+#endif
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+static const uint32_t SHA256_K[64] =
+{
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+//---------------------------------------------------------------------------
+static inline uint32_t SHA256_Rotr(uint32_t Value, int Count)
+{
+    return (Value >> Count) | (Value << (32 - Count));
+}
+
+//---------------------------------------------------------------------------
+void sha256_ctx::Init()
+{
+    State[0] = 0x6a09e667;
+    State[1] = 0xbb67ae85;
+    State[2] = 0x3c6ef372;
+    State[3] = 0xa54ff53a;
+    State[4] = 0x510e527f;
+    State[5] = 0x9b05688c;
+    State[6] = 0x1f83d9ab;
+    State[7] = 0x5be0cd19;
+    Length = 0;
+    Block_Size = 0;
+}
+
+//---------------------------------------------------------------------------
+#ifdef SHA256_SHANI
+static bool SHA256_HasShaNi()
+{
+    unsigned int Regs[4]; // EAX, EBX, ECX, EDX
+#if defined(_MSC_VER)
+    __cpuid((int*)Regs, 0);
+    if (Regs[0] < 7)
+        return false;
+    __cpuid((int*)Regs, 1);
+    auto SSE41 = (Regs[2] >> 19) & 1;
+    __cpuidex((int*)Regs, 7, 0);
+#else
+    if (__get_cpuid_max(0, nullptr) < 7)
+        return false;
+    __cpuid(1, Regs[0], Regs[1], Regs[2], Regs[3]);
+    auto SSE41 = (Regs[2] >> 19) & 1;
+    __cpuid_count(7, 0, Regs[0], Regs[1], Regs[2], Regs[3]);
+#endif
+    return SSE41 && ((Regs[1] >> 29) & 1);
+}
+static const bool SHA256_ShaNi = SHA256_HasShaNi();
+
+//---------------------------------------------------------------------------
+SHA256_SHANI_TARGET static void SHA256_Transform_ShaNi(uint32_t* State, const uint8_t* Data, size_t Blocks)
+{
+    const auto Mask = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+    // ABCD EFGH to ABEF CDGH
+    auto Tmp = _mm_loadu_si128((const __m128i*)&State[0]);
+    auto State1 = _mm_loadu_si128((const __m128i*)&State[4]);
+    Tmp = _mm_shuffle_epi32(Tmp, 0xB1);
+    State1 = _mm_shuffle_epi32(State1, 0x1B);
+    auto State0 = _mm_alignr_epi8(Tmp, State1, 8);
+    State1 = _mm_blend_epi16(State1, Tmp, 0xF0);
+
+    for (; Blocks; Blocks--, Data += 64)
+    {
+        auto State0_Save = State0;
+        auto State1_Save = State1;
+
+        __m128i Msg[4];
+        for (int i = 0; i < 4; i++)
+            Msg[i] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(Data + i * 16)), Mask);
+
+        // 4 rounds per group, message schedule is computed 1 group ahead
+        for (int i = 0; i < 16; i++)
+        {
+            auto Value = _mm_add_epi32(Msg[i & 3], _mm_loadu_si128((const __m128i*)&SHA256_K[i * 4]));
+            State1 = _mm_sha256rnds2_epu32(State1, State0, Value);
+            if (i >= 3 && i < 15)
+            {
+                auto& Next = Msg[(i + 1) & 3];
+                Next = _mm_add_epi32(Next, _mm_alignr_epi8(Msg[i & 3], Msg[(i - 1) & 3], 4));
+                Next = _mm_sha256msg2_epu32(Next, Msg[i & 3]);
+            }
+            Value = _mm_shuffle_epi32(Value, 0x0E);
+            State0 = _mm_sha256rnds2_epu32(State0, State1, Value);
+            if (i >= 1 && i < 13)
+                Msg[(i - 1) & 3] = _mm_sha256msg1_epu32(Msg[(i - 1) & 3], Msg[i & 3]);
+        }
+
+        State0 = _mm_add_epi32(State0, State0_Save);
+        State1 = _mm_add_epi32(State1, State1_Save);
+    }
+
+    // ABEF CDGH to ABCD EFGH
+    Tmp = _mm_shuffle_epi32(State0, 0x1B);
+    State1 = _mm_shuffle_epi32(State1, 0xB1);
+    State0 = _mm_blend_epi16(Tmp, State1, 0xF0);
+    State1 = _mm_alignr_epi8(State1, Tmp, 8);
+    _mm_storeu_si128((__m128i*)&State[0], State0);
+    _mm_storeu_si128((__m128i*)&State[4], State1);
+}
+#endif
+
+//---------------------------------------------------------------------------
+void sha256_ctx::Transform(const uint8_t* Data, size_t Blocks)
+{
+#ifdef SHA256_SHANI
+    if (SHA256_ShaNi)
+    {
+        SHA256_Transform_ShaNi(State, Data, Blocks);
+        return;
+    }
+#endif
+
+    for (; Blocks; Blocks--, Data += 64)
+    {
+        uint32_t W[64];
+        for (int i = 0; i < 16; i++)
+            W[i] = ((uint32_t)Data[i * 4] << 24) | ((uint32_t)Data[i * 4 + 1] << 16) | ((uint32_t)Data[i * 4 + 2] << 8) | ((uint32_t)Data[i * 4 + 3]);
+        for (int i = 16; i < 64; i++)
+        {
+            auto s0 = SHA256_Rotr(W[i - 15], 7) ^ SHA256_Rotr(W[i - 15], 18) ^ (W[i - 15] >> 3);
+            auto s1 = SHA256_Rotr(W[i - 2], 17) ^ SHA256_Rotr(W[i - 2], 19) ^ (W[i - 2] >> 10);
+            W[i] = W[i - 16] + s0 + W[i - 7] + s1;
+        }
+
+        auto a = State[0];
+        auto b = State[1];
+        auto c = State[2];
+        auto d = State[3];
+        auto e = State[4];
+        auto f = State[5];
+        auto g = State[6];
+        auto h = State[7];
+        for (int i = 0; i < 64; i++)
+        {
+            auto S1 = SHA256_Rotr(e, 6) ^ SHA256_Rotr(e, 11) ^ SHA256_Rotr(e, 25);
+            auto ch = (e & f) ^ (~e & g);
+            auto t1 = h + S1 + ch + SHA256_K[i] + W[i];
+            auto S0 = SHA256_Rotr(a, 2) ^ SHA256_Rotr(a, 13) ^ SHA256_Rotr(a, 22);
+            auto maj = (a & b) ^ (a & c) ^ (b & c);
+            auto t2 = S0 + maj;
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + t2;
+        }
+        State[0] += a;
+        State[1] += b;
+        State[2] += c;
+        State[3] += d;
+        State[4] += e;
+        State[5] += f;
+        State[6] += g;
+        State[7] += h;
+    }
+}
+
+//---------------------------------------------------------------------------
+void sha256_ctx::Update(const uint8_t* Data, size_t Size)
+{
+    Length += Size;
+
+    // Previous incomplete block
+    if (Block_Size)
+    {
+        auto ToCopy = 64 - Block_Size;
+        if (ToCopy > Size)
+            ToCopy = Size;
+        memcpy(Block + Block_Size, Data, ToCopy);
+        Block_Size += ToCopy;
+        Data += ToCopy;
+        Size -= ToCopy;
+        if (Block_Size < 64)
+            return;
+        Transform(Block, 1);
+        Block_Size = 0;
+    }
+
+    // Complete blocks, directly from the source
+    auto Blocks = Size / 64;
+    if (Blocks)
+    {
+        Transform(Data, Blocks);
+        Data += Blocks * 64;
+        Size -= Blocks * 64;
+    }
+
+    // Remaining bytes
+    memcpy(Block, Data, Size);
+    Block_Size = Size;
+}
+
+//---------------------------------------------------------------------------
+void sha256_ctx::Final(uint8_t Digest[32])
+{
+    auto Length_Bits = Length * 8;
+    static const uint8_t Padding[64] = { 0x80 };
+    Update(Padding, Block_Size < 56 ? (56 - Block_Size) : (120 - Block_Size));
+    uint8_t Length_BE[8];
+    for (int i = 0; i < 8; i++)
+        Length_BE[i] = (uint8_t)(Length_Bits >> (56 - i * 8));
+    Update(Length_BE, 8);
+
+    for (int i = 0; i < 8; i++)
+    {
+        Digest[i * 4    ] = (uint8_t)(State[i] >> 24);
+        Digest[i * 4 + 1] = (uint8_t)(State[i] >> 16);
+        Digest[i * 4 + 2] = (uint8_t)(State[i] >> 8);
+        Digest[i * 4 + 3] = (uint8_t)(State[i]);
+    }
+}
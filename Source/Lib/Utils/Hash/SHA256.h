@@ -0,0 +1,41 @@
+/*  Copyright (c) MediaArea.net SARL & AV Preservation by reto.ch.
+ *
+ *  Use of this source code is governed by a BSD-style license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//---------------------------------------------------------------------------
+#ifndef SHA256H
+#define SHA256H
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+#include "Lib/Config.h"
+using namespace std;
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+// SHA-256 (FIPS 180-4)
+// SHA extensions of x86 CPUs are used if available
+class sha256_ctx
+{
+public:
+    // Constructor
+    sha256_ctx() { Init(); }
+
+    // Actions
+    void                        Init();
+    void                        Update(const uint8_t* Data, size_t Size);
+    void                        Final(uint8_t Digest[32]);
+
+private:
+    void                        Transform(const uint8_t* Data, size_t Blocks);
+
+    uint32_t                    State[8];
+    uint64_t                    Length;
+    uint8_t                     Block[64];
+    size_t                      Block_Size;
+};
+
+//---------------------------------------------------------------------------
+#endif
@@ -0,0 +1,141 @@
+/*  Copyright (c) MediaArea.net SARL & AV Preservation by reto.ch.
+ *
+ *  Use of this source code is governed by a BSD-style license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//---------------------------------------------------------------------------
+#include "Lib/Utils/Hash/StreamHash.h"
+#include "Lib/Utils/FileIO/FileIO.h"
+#include "Lib/Utils/Stats/Trace.h"
+#include <cstring>
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+stream_hash::stream_hash(hash_format Format_Source) :
+    Hash(hash_base::New(Format_Source))
+{
+    Thread = new thread(&stream_hash::Run, this);
+}
+
+//---------------------------------------------------------------------------
+stream_hash::~stream_hash()
+{
+    {
+        lock_guard<mutex> Lock(Mutex);
+        IsFinishing = true;
+    }
+    Cond.notify_all();
+    Thread->join();
+    delete Thread;
+    delete Hash;
+}
+
+//---------------------------------------------------------------------------
+void stream_hash::Update(const uint8_t* Data, size_t Size)
+{
+    if (!Size)
+        return;
+
+    unique_lock<mutex> Lock(Mutex);
+    Cond.wait(Lock, [this] { return !Chunk_Size; });
+    Chunk_Data = Data;
+    Chunk_Size = Size;
+    Lock.unlock();
+    Cond.notify_all();
+}
+
+//---------------------------------------------------------------------------
+void stream_hash::Wait()
+{
+    unique_lock<mutex> Lock(Mutex);
+    Cond.wait(Lock, [this] { return !Chunk_Size; });
+}
+
+//---------------------------------------------------------------------------
+string stream_hash::Final()
+{
+    Wait();
+
+    return Hash->Final().ToString();
+}
+
+//---------------------------------------------------------------------------
+void stream_hash::Run()
+{
+    unique_lock<mutex> Lock(Mutex);
+    for (;;)
+    {
+        Cond.wait(Lock, [this] { return IsFinishing || Chunk_Size; });
+        if (!Chunk_Size)
+            return;
+        auto Data = Chunk_Data;
+        auto Size = Chunk_Size;
+        Lock.unlock();
+
+        {
+            trace_scope Trace("container hash", "hash", "bytes", Size);
+            Hash->Update(Data, Size);
+        }
+
+        Lock.lock();
+        Chunk_Data = nullptr;
+        Chunk_Size = 0;
+        Cond.notify_all();
+    }
+}
+
+//---------------------------------------------------------------------------
+bool stream_hash::FromSidecar(const string& SidecarName, const string& FileName, string& Hash)
+{
+    filemap Sidecar;
+    if (Sidecar.Open_ReadMode(SidecarName))
+        return false;
+
+    auto Separator = FileName.find_last_of("/\\");
+    auto BaseName = FileName.substr(Separator == string::npos ? 0 : (Separator + 1));
+
+    // "<hash> <name>" or "<hash> *<name>" (binary mode) lines, or a single hash
+    auto Data = (const char*)Sidecar.Data();
+    auto Size = Sidecar.Size();
+    size_t Count = 0;
+    string First;
+    for (size_t Offset = 0; Offset < Size;)
+    {
+        auto End = (const char*)memchr(Data + Offset, '\n', Size - Offset);
+        auto Line_Size = (End ? (size_t)(End - Data) : Size) - Offset;
+        string Line(Data + Offset, Line_Size);
+        Offset += Line_Size + 1;
+        if (!Line.empty() && Line.back() == '\r')
+            Line.pop_back();
+        if (Line.empty() || Line[0] == '#' || Line[0] == ';')
+            continue;
+
+        auto Hash_End = Line.find_first_of(" \t");
+        string Line_Hash = Line.substr(0, Hash_End);
+        for (auto& c : Line_Hash)
+            if (c >= 'A' && c <= 'F')
+                c += 'a' - 'A';
+        if (!Count)
+            First = Line_Hash;
+        Count++;
+        if (Hash_End == string::npos)
+            continue;
+
+        auto Name_Begin = Line.find_first_not_of(" \t*", Hash_End);
+        if (Name_Begin == string::npos)
+            continue;
+        auto Line_Name = Line.substr(Name_Begin);
+        auto Line_Separator = Line_Name.find_last_of("/\\");
+        if (Line_Name.substr(Line_Separator == string::npos ? 0 : (Line_Separator + 1)) == BaseName)
+        {
+            Hash = Line_Hash;
+            return true;
+        }
+    }
+
+    if (Count != 1)
+        return false;
+    Hash = First; // Only 1 hash, whatever the file name
+    return true;
+}
@@ -0,0 +1,56 @@
+/*  Copyright (c) MediaArea.net SARL & AV Preservation by reto.ch.
+ *
+ *  Use of this source code is governed by a BSD-style license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//---------------------------------------------------------------------------
+#ifndef StreamHashH
+#define StreamHashH
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+#include "Lib/Config.h"
+#include "Lib/Utils/Hash/Hash.h"
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+using namespace std;
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+// Hash of a byte stream provided in order, computed by a background thread
+// Only 1 chunk is hashed at a time, the caller keeps it valid until Wait()
+class stream_hash
+{
+public:
+    // Constructor / Destructor
+    stream_hash(hash_format Format_Source);
+    ~stream_hash();
+
+    // Actions
+    void                        Update(const uint8_t* Data, size_t Size); // Waits for the previous chunk
+    void                        Wait(); // Previous chunk is no more used after this call
+    string                      Final(); // Lowercase hexadecimal value of the hash
+
+    // Info
+    hash_format                 Format() { return Hash->Format(); }
+
+    // Sidecar files ("<hash> <file name>" lines, e.g. from md5sum)
+    static bool                 FromSidecar(const string& SidecarName, const string& FileName, string& Hash); // Returns true if a hash for this file is found
+
+private:
+    void                        Run();
+
+    hash_base*                  Hash;
+    const uint8_t*              Chunk_Data = nullptr;
+    size_t                      Chunk_Size = 0;
+    bool                        IsFinishing = false;
+    mutex                       Mutex;
+    condition_variable          Cond;
+    thread*                     Thread;
+};
+
+//---------------------------------------------------------------------------
+#endif
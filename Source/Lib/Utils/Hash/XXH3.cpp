@@ -0,0 +1,426 @@
+/*  Copyright (c) MediaArea.net SARL & AV Preservation by reto.ch.
+ *
+ *  Use of this source code is governed by a BSD-style license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//---------------------------------------------------------------------------
+#include "Lib/Utils/Hash/XXH3.h"
+#include <cstring>
+#if defined(_MSC_VER) && defined(_M_X64)
+    #include <intrin.h>
+#endif
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+static const uint32_t XXH_Prime32_1 = 0x9E3779B1U;
+static const uint32_t XXH_Prime32_2 = 0x85EBCA77U;
+static const uint32_t XXH_Prime32_3 = 0xC2B2AE3DU;
+static const uint64_t XXH_Prime64_1 = 0x9E3779B185EBCA87ULL;
+static const uint64_t XXH_Prime64_2 = 0xC2B2AE3D27D4EB4FULL;
+static const uint64_t XXH_Prime64_3 = 0x165667B19E3779F9ULL;
+static const uint64_t XXH_Prime64_4 = 0x85EBCA77C2B2AE63ULL;
+static const uint64_t XXH_Prime64_5 = 0x27D4EB2F165667C5ULL;
+static const uint64_t XXH_PrimeMx1 = 0x165667919E3779F9ULL;
+static const uint64_t XXH_PrimeMx2 = 0x9FB21C651E98DF25ULL;
+
+static const size_t XXH_StripeLen = 64;
+static const size_t XXH_SecretConsumeRate = 8;
+static const size_t XXH_SecretSize = 192;
+static const size_t XXH_StripesPerBlock = (XXH_SecretSize - XXH_StripeLen) / XXH_SecretConsumeRate;
+static const size_t XXH_BlockLen = XXH_StripeLen * XXH_StripesPerBlock;
+static const size_t XXH_SecretLastAccStart = 7;
+static const size_t XXH_SecretMergeAccsStart = 11;
+static const size_t XXH_MidSizeMax = 240;
+
+static const uint8_t XXH_Secret[XXH_SecretSize] =
+{
+    0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+    0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb, 0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+    0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+    0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+    0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb, 0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+    0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+    0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+    0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31, 0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+    0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+    0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+    0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc, 0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+    0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e,
+};
+
+//---------------------------------------------------------------------------
+struct xxh_128
+{
+    uint64_t                    Low;
+    uint64_t                    High;
+};
+
+//---------------------------------------------------------------------------
+static inline uint32_t XXH_Read32(const uint8_t* Data)
+{
+    return ((uint32_t)Data[0]) | ((uint32_t)Data[1] << 8) | ((uint32_t)Data[2] << 16) | ((uint32_t)Data[3] << 24);
+}
+
+//---------------------------------------------------------------------------
+static inline uint64_t XXH_Read64(const uint8_t* Data)
+{
+    return ((uint64_t)XXH_Read32(Data)) | ((uint64_t)XXH_Read32(Data + 4) << 32);
+}
+
+//---------------------------------------------------------------------------
+static inline uint32_t XXH_Swap32(uint32_t Value)
+{
+    return (Value << 24) | ((Value << 8) & 0x00FF0000) | ((Value >> 8) & 0x0000FF00) | (Value >> 24);
+}
+
+//---------------------------------------------------------------------------
+static inline uint64_t XXH_Swap64(uint64_t Value)
+{
+    return ((uint64_t)XXH_Swap32((uint32_t)Value) << 32) | XXH_Swap32((uint32_t)(Value >> 32));
+}
+
+//---------------------------------------------------------------------------
+static inline uint32_t XXH_Rotl32(uint32_t Value, int Count)
+{
+    return (Value << Count) | (Value >> (32 - Count));
+}
+
+//---------------------------------------------------------------------------
+static inline uint64_t XXH_Rotl64(uint64_t Value, int Count)
+{
+    return (Value << Count) | (Value >> (64 - Count));
+}
+
+//---------------------------------------------------------------------------
+static inline xxh_128 XXH_Mult64To128(uint64_t l, uint64_t r)
+{
+    xxh_128 Result;
+#if defined(__SIZEOF_INT128__)
+    auto Product = (unsigned __int128)l * r;
+    Result.Low = (uint64_t)Product;
+    Result.High = (uint64_t)(Product >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    Result.Low = _umul128(l, r, &Result.High);
+#else
+    auto LoLo = (l & 0xFFFFFFFF) * (r & 0xFFFFFFFF);
+    auto HiLo = (l >> 32) * (r & 0xFFFFFFFF);
+    auto LoHi = (l & 0xFFFFFFFF) * (r >> 32);
+    auto HiHi = (l >> 32) * (r >> 32);
+    auto Cross = (LoLo >> 32) + (HiLo & 0xFFFFFFFF) + LoHi;
+    Result.High = (HiLo >> 32) + (Cross >> 32) + HiHi;
+    Result.Low = (Cross << 32) | (LoLo & 0xFFFFFFFF);
+#endif
+    return Result;
+}
+
+//---------------------------------------------------------------------------
+static inline uint64_t XXH_Mul128Fold64(uint64_t l, uint64_t r)
+{
+    auto Product = XXH_Mult64To128(l, r);
+    return Product.Low ^ Product.High;
+}
+
+//---------------------------------------------------------------------------
+static inline uint64_t XXH64_Avalanche(uint64_t Hash)
+{
+    Hash ^= Hash >> 33;
+    Hash *= XXH_Prime64_2;
+    Hash ^= Hash >> 29;
+    Hash *= XXH_Prime64_3;
+    Hash ^= Hash >> 32;
+    return Hash;
+}
+
+//---------------------------------------------------------------------------
+static inline uint64_t XXH3_Avalanche(uint64_t Hash)
+{
+    Hash ^= Hash >> 37;
+    Hash *= XXH_PrimeMx1;
+    Hash ^= Hash >> 32;
+    return Hash;
+}
+
+//---------------------------------------------------------------------------
+static inline uint64_t XXH3_Mix16B(const uint8_t* Data, const uint8_t* Secret)
+{
+    return XXH_Mul128Fold64(XXH_Read64(Data) ^ XXH_Read64(Secret), XXH_Read64(Data + 8) ^ XXH_Read64(Secret + 8));
+}
+
+//---------------------------------------------------------------------------
+static inline void XXH128_Mix32B(xxh_128& Acc, const uint8_t* Data1, const uint8_t* Data2, const uint8_t* Secret)
+{
+    Acc.Low += XXH3_Mix16B(Data1, Secret);
+    Acc.Low ^= XXH_Read64(Data2) + XXH_Read64(Data2 + 8);
+    Acc.High += XXH3_Mix16B(Data2, Secret + 16);
+    Acc.High ^= XXH_Read64(Data1) + XXH_Read64(Data1 + 8);
+}
+
+//---------------------------------------------------------------------------
+// Short and medium inputs, whole content is available
+static xxh_128 XXH3_128_Small(const uint8_t* Data, size_t Size)
+{
+    xxh_128 Hash;
+    const auto Secret = XXH_Secret;
+
+    if (!Size)
+    {
+        Hash.Low = XXH64_Avalanche(XXH_Read64(Secret + 64) ^ XXH_Read64(Secret + 72));
+        Hash.High = XXH64_Avalanche(XXH_Read64(Secret + 80) ^ XXH_Read64(Secret + 88));
+        return Hash;
+    }
+
+    if (Size <= 3)
+    {
+        auto Combined_Low = ((uint32_t)Data[0] << 16) | ((uint32_t)Data[Size >> 1] << 24) | ((uint32_t)Data[Size - 1]) | ((uint32_t)Size << 8);
+        auto Combined_High = XXH_Rotl32(XXH_Swap32(Combined_Low), 13);
+        uint64_t BitFlip_Low = XXH_Read32(Secret) ^ XXH_Read32(Secret + 4);
+        uint64_t BitFlip_High = XXH_Read32(Secret + 8) ^ XXH_Read32(Secret + 12);
+        Hash.Low = XXH64_Avalanche(Combined_Low ^ BitFlip_Low);
+        Hash.High = XXH64_Avalanche(Combined_High ^ BitFlip_High);
+        return Hash;
+    }
+
+    if (Size <= 8)
+    {
+        auto Input = (uint64_t)XXH_Read32(Data) + ((uint64_t)XXH_Read32(Data + Size - 4) << 32);
+        auto BitFlip = XXH_Read64(Secret + 16) ^ XXH_Read64(Secret + 24);
+        auto Product = XXH_Mult64To128(Input ^ BitFlip, XXH_Prime64_1 + (Size << 2));
+        Product.High += Product.Low << 1;
+        Product.Low ^= Product.High >> 3;
+        Product.Low ^= Product.Low >> 35;
+        Product.Low *= XXH_PrimeMx2;
+        Product.Low ^= Product.Low >> 28;
+        Product.High = XXH3_Avalanche(Product.High);
+        return Product;
+    }
+
+    if (Size <= 16)
+    {
+        auto BitFlip_Low = XXH_Read64(Secret + 32) ^ XXH_Read64(Secret + 40);
+        auto BitFlip_High = XXH_Read64(Secret + 48) ^ XXH_Read64(Secret + 56);
+        auto Input_Low = XXH_Read64(Data);
+        auto Input_High = XXH_Read64(Data + Size - 8);
+        auto Product = XXH_Mult64To128(Input_Low ^ Input_High ^ BitFlip_Low, XXH_Prime64_1);
+        Product.Low += (uint64_t)(Size - 1) << 54;
+        Input_High ^= BitFlip_High;
+        Product.High += Input_High + (uint64_t)(uint32_t)Input_High * (XXH_Prime32_2 - 1);
+        Product.Low ^= XXH_Swap64(Product.High);
+        Hash = XXH_Mult64To128(Product.Low, XXH_Prime64_2);
+        Hash.High += Product.High * XXH_Prime64_2;
+        Hash.Low = XXH3_Avalanche(Hash.Low);
+        Hash.High = XXH3_Avalanche(Hash.High);
+        return Hash;
+    }
+
+    xxh_128 Acc;
+    Acc.Low = Size * XXH_Prime64_1;
+    Acc.High = 0;
+    if (Size <= 128)
+    {
+        if (Size > 32)
+        {
+            if (Size > 64)
+            {
+                if (Size > 96)
+                    XXH128_Mix32B(Acc, Data + 48, Data + Size - 64, Secret + 96);
+                XXH128_Mix32B(Acc, Data + 32, Data + Size - 48, Secret + 64);
+            }
+            XXH128_Mix32B(Acc, Data + 16, Data + Size - 32, Secret + 32);
+        }
+        XXH128_Mix32B(Acc, Data, Data + Size - 16, Secret);
+    }
+    else
+    {
+        for (size_t i = 32; i < 160; i += 32)
+            XXH128_Mix32B(Acc, Data + i - 32, Data + i - 16, Secret + i - 32);
+        Acc.Low = XXH3_Avalanche(Acc.Low);
+        Acc.High = XXH3_Avalanche(Acc.High);
+        for (size_t i = 160; i <= Size; i += 32)
+            XXH128_Mix32B(Acc, Data + i - 32, Data + i - 16, Secret + 3 + i - 160);
+        XXH128_Mix32B(Acc, Data + Size - 16, Data + Size - 32, Secret + 136 - 17 - 16);
+    }
+    Hash.Low = Acc.Low + Acc.High;
+    Hash.High = Acc.Low * XXH_Prime64_1 + Acc.High * XXH_Prime64_4 + Size * XXH_Prime64_2;
+    Hash.Low = XXH3_Avalanche(Hash.Low);
+    Hash.High = (uint64_t)0 - XXH3_Avalanche(Hash.High);
+    return Hash;
+}
+
+//---------------------------------------------------------------------------
+static inline void XXH3_Accumulate512(uint64_t* Acc, const uint8_t* Data, const uint8_t* Secret)
+{
+    for (size_t i = 0; i < 8; i++)
+    {
+        auto Value = XXH_Read64(Data + i * 8);
+        auto Key = Value ^ XXH_Read64(Secret + i * 8);
+        Acc[i ^ 1] += Value;
+        Acc[i] += (uint64_t)(uint32_t)Key * (Key >> 32);
+    }
+}
+
+//---------------------------------------------------------------------------
+static inline void XXH3_Accumulate(uint64_t* Acc, const uint8_t* Data, const uint8_t* Secret, size_t Stripes)
+{
+    for (size_t i = 0; i < Stripes; i++)
+        XXH3_Accumulate512(Acc, Data + i * XXH_StripeLen, Secret + i * XXH_SecretConsumeRate);
+}
+
+//---------------------------------------------------------------------------
+static inline void XXH3_ScrambleAcc(uint64_t* Acc, const uint8_t* Secret)
+{
+    for (size_t i = 0; i < 8; i++)
+    {
+        auto Value = Acc[i];
+        Value ^= Value >> 47;
+        Value ^= XXH_Read64(Secret + i * 8);
+        Value *= XXH_Prime32_1;
+        Acc[i] = Value;
+    }
+}
+
+//---------------------------------------------------------------------------
+static uint64_t XXH3_MergeAccs(const uint64_t* Acc, const uint8_t* Secret, uint64_t Start)
+{
+    auto Result = Start;
+    for (size_t i = 0; i < 4; i++)
+        Result += XXH_Mul128Fold64(Acc[i * 2] ^ XXH_Read64(Secret + i * 16), Acc[i * 2 + 1] ^ XXH_Read64(Secret + i * 16 + 8));
+    return XXH3_Avalanche(Result);
+}
+
+//---------------------------------------------------------------------------
+void xxh3_128_ctx::Init()
+{
+    Acc[0] = XXH_Prime32_3;
+    Acc[1] = XXH_Prime64_1;
+    Acc[2] = XXH_Prime64_2;
+    Acc[3] = XXH_Prime64_3;
+    Acc[4] = XXH_Prime64_4;
+    Acc[5] = XXH_Prime32_2;
+    Acc[6] = XXH_Prime64_5;
+    Acc[7] = XXH_Prime32_1;
+    Buffer_Size = 0;
+    Stripes_Count = 0;
+    Length = 0;
+}
+
+//---------------------------------------------------------------------------
+void xxh3_128_ctx::ConsumeStripes(uint64_t* Acc_Current, size_t& Stripes_Current, const uint8_t* Data, size_t Stripes)
+{
+    auto Stripes_ToEndOfBlock = XXH_StripesPerBlock - Stripes_Current;
+    if (Stripes_ToEndOfBlock <= Stripes)
+    {
+        // End of block, scramble is needed
+        XXH3_Accumulate(Acc_Current, Data, XXH_Secret + Stripes_Current * XXH_SecretConsumeRate, Stripes_ToEndOfBlock);
+        XXH3_ScrambleAcc(Acc_Current, XXH_Secret + XXH_SecretSize - XXH_StripeLen);
+        XXH3_Accumulate(Acc_Current, Data + Stripes_ToEndOfBlock * XXH_StripeLen, XXH_Secret, Stripes - Stripes_ToEndOfBlock);
+        Stripes_Current = Stripes - Stripes_ToEndOfBlock;
+    }
+    else
+    {
+        XXH3_Accumulate(Acc_Current, Data, XXH_Secret + Stripes_Current * XXH_SecretConsumeRate, Stripes);
+        Stripes_Current += Stripes;
+    }
+}
+
+//---------------------------------------------------------------------------
+void xxh3_128_ctx::Update(const uint8_t* Data, size_t Size)
+{
+    Length += Size;
+
+    // Content is kept until we know that there is more data after it, last stripe is handled differently
+    if (Size <= sizeof(Buffer) - Buffer_Size)
+    {
+        memcpy(Buffer + Buffer_Size, Data, Size);
+        Buffer_Size += Size;
+        return;
+    }
+    auto Data_End = Data + Size;
+
+    // Previous incomplete buffer
+    if (Buffer_Size)
+    {
+        auto ToCopy = sizeof(Buffer) - Buffer_Size;
+        memcpy(Buffer + Buffer_Size, Data, ToCopy);
+        Data += ToCopy;
+        ConsumeStripes(Acc, Stripes_Count, Buffer, sizeof(Buffer) / XXH_StripeLen);
+        Buffer_Size = 0;
+    }
+
+    // Complete blocks, directly from the source
+    if ((size_t)(Data_End - Data) > XXH_BlockLen)
+    {
+        // Align on block boundary first
+        if (Stripes_Count)
+        {
+            auto Stripes = XXH_StripesPerBlock - Stripes_Count;
+            if ((size_t)(Data_End - Data) > Stripes * XXH_StripeLen)
+            {
+                ConsumeStripes(Acc, Stripes_Count, Data, Stripes);
+                Data += Stripes * XXH_StripeLen;
+            }
+        }
+        while (!Stripes_Count && (size_t)(Data_End - Data) > XXH_BlockLen)
+        {
+            XXH3_Accumulate(Acc, Data, XXH_Secret, XXH_StripesPerBlock);
+            XXH3_ScrambleAcc(Acc, XXH_Secret + XXH_SecretSize - XXH_StripeLen);
+            Data += XXH_BlockLen;
+        }
+    }
+    if ((size_t)(Data_End - Data) > sizeof(Buffer))
+    {
+        do
+        {
+            ConsumeStripes(Acc, Stripes_Count, Data, sizeof(Buffer) / XXH_StripeLen);
+            Data += sizeof(Buffer);
+        }
+        while ((size_t)(Data_End - Data) > sizeof(Buffer));
+    }
+
+    // Last stripe before the remaining bytes may be needed by Final()
+    if (Data - XXH_StripeLen >= Data_End - Size)
+        memcpy(Buffer + sizeof(Buffer) - XXH_StripeLen, Data - XXH_StripeLen, XXH_StripeLen);
+
+    // Remaining bytes
+    Buffer_Size = Data_End - Data;
+    memcpy(Buffer, Data, Buffer_Size);
+}
+
+//---------------------------------------------------------------------------
+void xxh3_128_ctx::Final(uint8_t Digest[16])
+{
+    xxh_128 Hash;
+    if (Length <= XXH_MidSizeMax)
+        Hash = XXH3_128_Small(Buffer, (size_t)Length);
+    else
+    {
+        // Remaining stripes and last stripe, on a copy of the state
+        uint64_t Acc_Final[8];
+        memcpy(Acc_Final, Acc, sizeof(Acc));
+        uint8_t LastStripe[XXH_StripeLen];
+        const uint8_t* LastStripe_Data;
+        if (Buffer_Size >= XXH_StripeLen)
+        {
+            auto Stripes_Final = Stripes_Count;
+            ConsumeStripes(Acc_Final, Stripes_Final, Buffer, (Buffer_Size - 1) / XXH_StripeLen);
+            LastStripe_Data = Buffer + Buffer_Size - XXH_StripeLen;
+        }
+        else
+        {
+            auto CatchUp = XXH_StripeLen - Buffer_Size;
+            memcpy(LastStripe, Buffer + sizeof(Buffer) - CatchUp, CatchUp);
+            memcpy(LastStripe + CatchUp, Buffer, Buffer_Size);
+            LastStripe_Data = LastStripe;
+        }
+        XXH3_Accumulate512(Acc_Final, LastStripe_Data, XXH_Secret + XXH_SecretSize - XXH_StripeLen - XXH_SecretLastAccStart);
+
+        Hash.Low = XXH3_MergeAccs(Acc_Final, XXH_Secret + XXH_SecretMergeAccsStart, Length * XXH_Prime64_1);
+        Hash.High = XXH3_MergeAccs(Acc_Final, XXH_Secret + XXH_SecretSize - sizeof(Acc) - XXH_SecretMergeAccsStart, ~(Length * XXH_Prime64_2));
+    }
+
+    for (int i = 0; i < 8; i++)
+    {
+        Digest[i] = (uint8_t)(Hash.High >> (56 - i * 8));
+        Digest[8 + i] = (uint8_t)(Hash.Low >> (56 - i * 8));
+    }
+}
@@ -0,0 +1,42 @@
+/*  Copyright (c) MediaArea.net SARL & AV Preservation by reto.ch.
+ *
+ *  Use of this source code is governed by a BSD-style license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//---------------------------------------------------------------------------
+#ifndef XXH3H
+#define XXH3H
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+#include "Lib/Config.h"
+using namespace std;
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+// XXH3 128-bit (xxHash 0.8), default secret and seed 0
+// Digest is the canonical representation (big endian, high part first)
+class xxh3_128_ctx
+{
+public:
+    // Constructor
+    xxh3_128_ctx() { Init(); }
+
+    // Actions
+    void                        Init();
+    void                        Update(const uint8_t* Data, size_t Size);
+    void                        Final(uint8_t Digest[16]);
+
+private:
+    void                        ConsumeStripes(uint64_t* Acc_Current, size_t& Stripes_Current, const uint8_t* Data, size_t Stripes);
+
+    uint64_t                    Acc[8];
+    uint8_t                     Buffer[256];
+    size_t                      Buffer_Size;
+    size_t                      Stripes_Count; // Stripes in the current block
+    uint64_t                    Length;
+};
+
+//---------------------------------------------------------------------------
+#endif
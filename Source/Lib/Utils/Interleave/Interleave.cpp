@@ -0,0 +1,353 @@
+/*  Copyright (c) MediaArea.net SARL & AV Preservation by reto.ch.
+ *
+ *  Use of this source code is governed by a BSD-style license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//---------------------------------------------------------------------------
+#include "Lib/Utils/Interleave/Interleave.h"
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    #define INTERLEAVE_X86
+    #include <immintrin.h>
+    #if defined(__GNUC__)
+        #define TARGET_SSSE3 __attribute__((target("ssse3")))
+        #define TARGET_AVX2 __attribute__((target("avx2")))
+    #else
+        #include <intrin.h>
+        #define TARGET_SSSE3
+        #define TARGET_AVX2
+    #endif
+#endif
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+// Each sample is (Input >> Shift) + Offset, Bytes least significant bytes are kept
+// Shift is used for 16-bit input to 8-bit output, Offset for unsigned 8-bit output
+
+//---------------------------------------------------------------------------
+template<size_t Bytes, bool BE, int Shift, int Offset>
+static inline uint8_t* Interleave_Scalar(uint8_t* Output, const uint32_t* const Input[], size_t Begin, size_t Count, size_t Channels)
+{
+    for (size_t i = Begin; i < Count; i++)
+        for (size_t j = 0; j < Channels; j++)
+        {
+            auto Value = (Input[j][i] >> Shift) + Offset;
+            for (size_t k = 0; k < Bytes; k++)
+                *(Output++) = (uint8_t)(Value >> ((BE ? (Bytes - 1 - k) : k) * 8));
+        }
+    return Output;
+}
+
+//---------------------------------------------------------------------------
+// Channels = 0 means that channel count is known only at run time
+template<size_t Bytes, bool BE, int Shift, int Offset, size_t Channels>
+static uint8_t* Interleave_C(uint8_t* Output, const uint32_t* const Input[], size_t Count, size_t Channels_RunTime)
+{
+    return Interleave_Scalar<Bytes, BE, Shift, Offset>(Output, Input, 0, Count, Channels ? Channels : Channels_RunTime);
+}
+
+#ifdef INTERLEAVE_X86
+//---------------------------------------------------------------------------
+// Byte selection of 4 32-bit values, in output order, rest is set to 0
+template<size_t Bytes, bool BE>
+static void Interleave_Mask(int8_t* Mask)
+{
+    for (size_t i = 0; i < 16; i++)
+        Mask[i] = (int8_t)0x80;
+    for (size_t i = 0; i < 4; i++)
+        for (size_t k = 0; k < Bytes; k++)
+            Mask[i * Bytes + k] = (int8_t)(i * 4 + (BE ? (Bytes - 1 - k) : k));
+}
+
+//---------------------------------------------------------------------------
+TARGET_SSSE3 static inline void Transpose4_SSSE3(const __m128i* V, __m128i* T)
+{
+    auto T0 = _mm_unpacklo_epi32(V[0], V[1]);
+    auto T1 = _mm_unpacklo_epi32(V[2], V[3]);
+    auto T2 = _mm_unpackhi_epi32(V[0], V[1]);
+    auto T3 = _mm_unpackhi_epi32(V[2], V[3]);
+    T[0] = _mm_unpacklo_epi64(T0, T1);
+    T[1] = _mm_unpackhi_epi64(T0, T1);
+    T[2] = _mm_unpacklo_epi64(T2, T3);
+    T[3] = _mm_unpackhi_epi64(T2, T3);
+}
+
+//---------------------------------------------------------------------------
+// 4 samples per channel per loop, each store is 16-byte wide with only 4 * Bytes meaningful bytes
+// so the vector loop stops when there is not enough room after the last meaningful byte
+template<size_t Bytes, bool BE, int Shift, int Offset, size_t Channels>
+TARGET_SSSE3 static uint8_t* Interleave_SSSE3(uint8_t* Output, const uint32_t* const Input[], size_t Count, size_t)
+{
+    alignas(16) int8_t Mask_Bytes[16];
+    Interleave_Mask<Bytes, BE>(Mask_Bytes);
+    const auto Mask = _mm_load_si128((const __m128i*)Mask_Bytes);
+    const auto Add = _mm_set1_epi32(Offset);
+
+    size_t i = 0;
+    for (; i + 4 <= Count && (Count - i - 4) * Channels * Bytes >= 16; i += 4)
+    {
+        __m128i V[8], I[8];
+        for (size_t j = 0; j < Channels; j++)
+        {
+            V[j] = _mm_loadu_si128((const __m128i*)(Input[j] + i));
+            if (Shift)
+                V[j] = _mm_srli_epi32(V[j], Shift);
+            if (Offset)
+                V[j] = _mm_add_epi32(V[j], Add);
+        }
+
+        // Planar to interleaved
+        switch (Channels)
+        {
+        case 1:
+            I[0] = V[0];
+            break;
+        case 2:
+            I[0] = _mm_unpacklo_epi32(V[0], V[1]);
+            I[1] = _mm_unpackhi_epi32(V[0], V[1]);
+            break;
+        case 6:
+        {
+            __m128i T[4];
+            Transpose4_SSSE3(V, T);
+            auto U0 = _mm_unpacklo_epi32(V[4], V[5]);
+            auto U1 = _mm_unpackhi_epi32(V[4], V[5]);
+            I[0] = T[0];
+            I[1] = _mm_unpacklo_epi64(U0, T[1]);
+            I[2] = _mm_unpackhi_epi64(T[1], U0);
+            I[3] = T[2];
+            I[4] = _mm_unpacklo_epi64(U1, T[3]);
+            I[5] = _mm_unpackhi_epi64(T[3], U1);
+            break;
+        }
+        case 8:
+        {
+            __m128i T0[4], T1[4];
+            Transpose4_SSSE3(V, T0);
+            Transpose4_SSSE3(V + 4, T1);
+            for (size_t j = 0; j < 4; j++)
+            {
+                I[j * 2] = T0[j];
+                I[j * 2 + 1] = T1[j];
+            }
+            break;
+        }
+        }
+
+        // 32-bit to output bit depth
+        for (size_t j = 0; j < Channels; j++)
+        {
+            _mm_storeu_si128((__m128i*)Output, _mm_shuffle_epi8(I[j], Mask));
+            Output += 4 * Bytes;
+        }
+    }
+
+    return Interleave_Scalar<Bytes, BE, Shift, Offset>(Output, Input, i, Count, Channels);
+}
+
+//---------------------------------------------------------------------------
+TARGET_AVX2 static inline void Transpose4_AVX2(const __m256i* V, __m256i* T)
+{
+    auto T0 = _mm256_unpacklo_epi32(V[0], V[1]);
+    auto T1 = _mm256_unpacklo_epi32(V[2], V[3]);
+    auto T2 = _mm256_unpackhi_epi32(V[0], V[1]);
+    auto T3 = _mm256_unpackhi_epi32(V[2], V[3]);
+    T[0] = _mm256_unpacklo_epi64(T0, T1);
+    T[1] = _mm256_unpackhi_epi64(T0, T1);
+    T[2] = _mm256_unpacklo_epi64(T2, T3);
+    T[3] = _mm256_unpackhi_epi64(T2, T3);
+}
+
+//---------------------------------------------------------------------------
+// Same as SSSE3 with 8 samples per channel per loop, AVX2 shuffles are per 128-bit lane
+// so the low lane has samples 0-3 and the high lane has samples 4-7
+template<size_t Bytes, bool BE, int Shift, int Offset, size_t Channels>
+TARGET_AVX2 static uint8_t* Interleave_AVX2(uint8_t* Output, const uint32_t* const Input[], size_t Count, size_t)
+{
+    alignas(16) int8_t Mask_Bytes[16];
+    Interleave_Mask<Bytes, BE>(Mask_Bytes);
+    const auto Mask = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*)Mask_Bytes));
+    const auto Add = _mm256_set1_epi32(Offset);
+
+    size_t i = 0;
+    for (; i + 8 <= Count && (Count - i - 8) * Channels * Bytes >= 16; i += 8)
+    {
+        __m256i V[8], I[8];
+        for (size_t j = 0; j < Channels; j++)
+        {
+            V[j] = _mm256_loadu_si256((const __m256i*)(Input[j] + i));
+            if (Shift)
+                V[j] = _mm256_srli_epi32(V[j], Shift);
+            if (Offset)
+                V[j] = _mm256_add_epi32(V[j], Add);
+        }
+
+        // Planar to interleaved
+        switch (Channels)
+        {
+        case 1:
+            I[0] = V[0];
+            break;
+        case 2:
+            I[0] = _mm256_unpacklo_epi32(V[0], V[1]);
+            I[1] = _mm256_unpackhi_epi32(V[0], V[1]);
+            break;
+        case 6:
+        {
+            __m256i T[4];
+            Transpose4_AVX2(V, T);
+            auto U0 = _mm256_unpacklo_epi32(V[4], V[5]);
+            auto U1 = _mm256_unpackhi_epi32(V[4], V[5]);
+            I[0] = T[0];
+            I[1] = _mm256_unpacklo_epi64(U0, T[1]);
+            I[2] = _mm256_unpackhi_epi64(T[1], U0);
+            I[3] = T[2];
+            I[4] = _mm256_unpacklo_epi64(U1, T[3]);
+            I[5] = _mm256_unpackhi_epi64(T[3], U1);
+            break;
+        }
+        case 8:
+        {
+            __m256i T0[4], T1[4];
+            Transpose4_AVX2(V, T0);
+            Transpose4_AVX2(V + 4, T1);
+            for (size_t j = 0; j < 4; j++)
+            {
+                I[j * 2] = T0[j];
+                I[j * 2 + 1] = T1[j];
+            }
+            break;
+        }
+        }
+
+        // 32-bit to output bit depth
+        for (size_t j = 0; j < Channels; j++)
+            I[j] = _mm256_shuffle_epi8(I[j], Mask);
+        for (size_t j = 0; j < Channels; j++)
+        {
+            _mm_storeu_si128((__m128i*)Output, _mm256_castsi256_si128(I[j]));
+            Output += 4 * Bytes;
+        }
+        for (size_t j = 0; j < Channels; j++)
+        {
+            _mm_storeu_si128((__m128i*)Output, _mm256_extracti128_si256(I[j], 1));
+            Output += 4 * Bytes;
+        }
+    }
+
+    return Interleave_Scalar<Bytes, BE, Shift, Offset>(Output, Input, i, Count, Channels);
+}
+
+//---------------------------------------------------------------------------
+enum class cpu_level
+{
+    None,
+    SSSE3,
+    AVX2,
+};
+static cpu_level CPU_Level_Get()
+{
+    #if defined(__GNUC__)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+            return cpu_level::AVX2;
+        if (__builtin_cpu_supports("ssse3"))
+            return cpu_level::SSSE3;
+    #elif defined(_MSC_VER)
+        int Info[4];
+        __cpuid(Info, 0);
+        auto Info_Max = Info[0];
+        __cpuid(Info, 1);
+        bool SSSE3 = Info[2] & (1 << 9);
+        bool OSXSAVE = Info[2] & (1 << 27);
+        bool AVX = Info[2] & (1 << 28);
+        if (Info_Max >= 7 && OSXSAVE && AVX && (_xgetbv(0) & 6) == 6)
+        {
+            __cpuidex(Info, 7, 0);
+            if (Info[1] & (1 << 5))
+                return cpu_level::AVX2;
+        }
+        if (SSSE3)
+            return cpu_level::SSSE3;
+    #endif
+    return cpu_level::None;
+}
+static cpu_level CPU_Level()
+{
+    static const cpu_level Level = CPU_Level_Get();
+    return Level;
+}
+#endif // INTERLEAVE_X86
+
+//---------------------------------------------------------------------------
+#ifdef INTERLEAVE_X86
+#define INTERLEAVE_CASE(_CHANNELS) \
+    case _CHANNELS: \
+        switch (CPU_Level()) \
+        { \
+        case cpu_level::AVX2: return Interleave_AVX2<Bytes, BE, Shift, Offset, _CHANNELS>; \
+        case cpu_level::SSSE3: return Interleave_SSSE3<Bytes, BE, Shift, Offset, _CHANNELS>; \
+        case cpu_level::None: return Interleave_C<Bytes, BE, Shift, Offset, _CHANNELS>; \
+        } \
+        break;
+#else
+#define INTERLEAVE_CASE(_CHANNELS) \
+    case _CHANNELS: return Interleave_C<Bytes, BE, Shift, Offset, _CHANNELS>;
+#endif
+
+template<size_t Bytes, bool BE, int Shift, int Offset>
+static interleave Interleave_Get(size_t Channels)
+{
+    switch (Channels)
+    {
+    INTERLEAVE_CASE(1);
+    INTERLEAVE_CASE(2);
+    INTERLEAVE_CASE(6);
+    INTERLEAVE_CASE(8);
+    default: return Interleave_C<Bytes, BE, Shift, Offset, 0>;
+    }
+    return nullptr;
+}
+
+//---------------------------------------------------------------------------
+interleave Interleave_Get(uint8_t OutputBitDepth, uint8_t InputBitDepth, endianness Endianness, size_t Channels)
+{
+    switch (OutputBitDepth)
+    {
+    case 8:
+        // Byte order does not matter, endianness is signedness
+        switch (InputBitDepth)
+        {
+        case 8:
+            switch (Endianness)
+            {
+            case endianness::BE: return Interleave_Get<1, false, 0, 0>(Channels);
+            case endianness::LE: return Interleave_Get<1, false, 0, 128>(Channels);
+            }
+            break;
+        case 16:
+            switch (Endianness)
+            {
+            case endianness::BE: return Interleave_Get<1, false, 8, 0>(Channels);
+            case endianness::LE: return Interleave_Get<1, false, 8, 128>(Channels);
+            }
+            break;
+        }
+        break;
+    case 16:
+        switch (Endianness)
+        {
+        case endianness::BE: return Interleave_Get<2, true, 0, 0>(Channels);
+        case endianness::LE: return Interleave_Get<2, false, 0, 0>(Channels);
+        }
+        break;
+    case 24:
+        switch (Endianness)
+        {
+        case endianness::BE: return Interleave_Get<3, true, 0, 0>(Channels);
+        case endianness::LE: return Interleave_Get<3, false, 0, 0>(Channels);
+        }
+        break;
+    }
+    return nullptr;
+}
@@ -0,0 +1,28 @@
+/*  Copyright (c) MediaArea.net SARL & AV Preservation by reto.ch.
+ *
+ *  Use of this source code is governed by a BSD-style license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//---------------------------------------------------------------------------
+#ifndef InterleaveH
+#define InterleaveH
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+#include "Lib/Config.h"
+#include <cstddef>
+#include <cstdint>
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+// Conversion of planar 32-bit samples (e.g. libFLAC output) to interleaved
+// 8, 16 or 24-bit samples (e.g. WAV or AIFF content)
+// Returns the end of written data
+typedef uint8_t* (*interleave)(uint8_t* Output, const uint32_t* const Input[], size_t Count, size_t Channels);
+
+// Returns the fastest conversion available on this CPU, nullptr if not supported
+interleave Interleave_Get(uint8_t OutputBitDepth, uint8_t InputBitDepth, endianness Endianness, size_t Channels);
+
+//---------------------------------------------------------------------------
+#endif
@@ -17,6 +17,8 @@ void raw_frame::Create(size_t colorspace_type, size_t width, size_t height, size
 {
     if (!Planes_.empty())
         return; //TODO: manage when it changes
+    ColorSpace = colorspace_type;
+    BitsPerSample = bits_per_raw_sample;
 
     for (const auto& Plane : Planes_)
         delete Plane;
@@ -13,6 +13,7 @@
 #include "Lib/Utils/Buffer/Buffer.h"
 #include "Lib/Config.h"
 #include <cstring>
+#include <utility>
 #include <vector>
 using namespace std;
 //---------------------------------------------------------------------------
@@ -44,6 +45,7 @@ public:
             if (Width_Padding_)
                 Width_Padding_ -= Width_ % Width_Padding_;
 
+            memory_scope Memory(memory_use::Frame);
             Buffer_.Create(AllBytesPerLine() * Height_);
         }
 
@@ -52,6 +54,11 @@ public:
             return Buffer_;
         }
 
+        void SwapBuffer(buffer& Other) // Content is handed over without copy
+        {
+            swap(Buffer_, Other);
+        }
+
         size_t ValidBytesPerLine() const
         {
             return Width_ * BytesPerBlock_ / PixelsPerBlock_;
@@ -141,6 +148,10 @@ public:
     ENUM_END(flavor)
     flavor                       Flavor = flavor::None;
 
+    // Format of the samples, set by Create()
+    size_t                       ColorSpace = (size_t)-1; // colorspace_type of FFV1, 0 for YCbCr and 1 for RGB
+    size_t                       BitsPerSample = 0;
+
     ~raw_frame()
     {
         for (const auto& Plane : Planes_)
@@ -0,0 +1,228 @@
+/*  Copyright (c) MediaArea.net SARL & AV Preservation by reto.ch.
+ *
+ *  Use of this source code is governed by a BSD-style license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//---------------------------------------------------------------------------
+#include "Lib/Utils/Stats/Stats.h"
+#include "Lib/Utils/Buffer/Memory.h"
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <vector>
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+namespace
+{
+    // Only the owner thread writes, other threads read
+    struct thread_counters
+    {
+        atomic<uint64_t>        Bytes[stage_Max];
+        atomic<uint64_t>        Frames[stage_Max];
+        atomic<uint64_t>        Busy[stage_Max];
+        atomic<uint64_t>        Wait[stage_Max];
+        atomic<bool>            IsUsed[stage_Max];
+    };
+
+    void Increment(atomic<uint64_t>& Counter, uint64_t Value)
+    {
+        Counter.store(Counter.load(memory_order_relaxed) + Value, memory_order_relaxed);
+    }
+
+    mutex                                   Threads_Mutex;
+    vector<unique_ptr<thread_counters>>     Threads;
+    thread_local thread_counters*           Local = nullptr;
+    thread_local stats_scope*               Current = nullptr;
+    uint64_t                                Begin = 0;
+
+    thread_counters& Counters()
+    {
+        if (!Local)
+        {
+            Local = new thread_counters();
+            lock_guard<mutex> Lock(Threads_Mutex);
+            Threads.emplace_back(Local);
+        }
+        return *Local;
+    }
+}
+
+//---------------------------------------------------------------------------
+bool stats::IsEnabled_ = false;
+
+//***************************************************************************
+// Stats
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+void stats::Enable()
+{
+    Begin = Now();
+    IsEnabled_ = true;
+}
+
+//---------------------------------------------------------------------------
+void stats::Add(stage Stage, uint64_t Bytes, uint64_t Frames)
+{
+    Add(Stage, Bytes, Frames, 0, 0);
+}
+
+//---------------------------------------------------------------------------
+void stats::Add(stage Stage, uint64_t Bytes, uint64_t Frames, uint64_t Busy, uint64_t Wait)
+{
+    if (!IsEnabled_)
+        return;
+
+    auto& Local_Counters = Counters();
+    auto i = (size_t)Stage;
+    if (Bytes)
+        Increment(Local_Counters.Bytes[i], Bytes);
+    if (Frames)
+        Increment(Local_Counters.Frames[i], Frames);
+    if (Busy)
+        Increment(Local_Counters.Busy[i], Busy);
+    if (Wait)
+        Increment(Local_Counters.Wait[i], Wait);
+    Local_Counters.IsUsed[i].store(true, memory_order_relaxed);
+}
+
+//---------------------------------------------------------------------------
+stats::values stats::Values()
+{
+    values Result;
+    lock_guard<mutex> Lock(Threads_Mutex);
+    for (const auto& Thread : Threads)
+        for (size_t i = 0; i < stage_Max; i++)
+        {
+            if (!Thread->IsUsed[i].load(memory_order_relaxed))
+                continue;
+            auto& Value = Result[i];
+            Value.Bytes += Thread->Bytes[i].load(memory_order_relaxed);
+            Value.Frames += Thread->Frames[i].load(memory_order_relaxed);
+            Value.Busy += Thread->Busy[i].load(memory_order_relaxed);
+            Value.Wait += Thread->Wait[i].load(memory_order_relaxed);
+            Value.Threads++;
+        }
+    return Result;
+}
+
+//---------------------------------------------------------------------------
+stage stats::Bottleneck(const values& Current_Values, const values& Previous_Values)
+{
+    auto Result = (stage)stage_Max;
+    uint64_t Result_Busy = 0;
+    for (size_t i = 0; i < stage_Max; i++)
+    {
+        auto Busy = Current_Values[i].Busy - Previous_Values[i].Busy;
+        if (Busy > Result_Busy)
+        {
+            Result = (stage)i;
+            Result_Busy = Busy;
+        }
+    }
+    return Result;
+}
+
+//---------------------------------------------------------------------------
+const char* stats::Name(stage Stage)
+{
+    switch (Stage)
+    {
+        case stage::Demux: return "demux";
+        case stage::Decode: return "decode";
+        case stage::Transform: return "transform";
+        case stage::Hash: return "hash";
+        case stage::Write: return "write";
+        case stage::Input: return "input";
+        case stage::Reversibility: return "reversibility";
+        default: return "";
+    }
+}
+
+//---------------------------------------------------------------------------
+uint64_t stats::Now()
+{
+    using namespace chrono;
+    return (uint64_t)duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+//---------------------------------------------------------------------------
+void stats::Json(ostream& Out)
+{
+    auto Duration = Now() - Begin;
+    auto Current_Values = Values();
+    auto Bottleneck_Stage = Bottleneck(Current_Values, values());
+
+    auto Seconds = [&](uint64_t Value)
+    {
+        Out << Value / 1000000000 << '.' << setfill('0') << setw(6) << (Value % 1000000000) / 1000 << setfill(' ');
+    };
+
+    Out << "{\n";
+    Out << "  \"duration\": ";
+    Seconds(Duration);
+    Out << ",\n";
+    Out << "  \"bottleneck\": ";
+    if (Bottleneck_Stage == (stage)stage_Max)
+        Out << "null";
+    else
+        Out << '\"' << Name(Bottleneck_Stage) << '\"';
+    Out << ",\n";
+    Out << "  \"stages\": {\n";
+    for (size_t i = 0; i < stage_Max; i++)
+    {
+        const auto& Value = Current_Values[i];
+        Out << "    \"" << Name((stage)i) << "\": { \"bytes\": " << Value.Bytes << ", \"frames\": " << Value.Frames << ", \"busy\": ";
+        Seconds(Value.Busy);
+        Out << ", \"wait\": ";
+        Seconds(Value.Wait);
+        Out << ", \"threads\": " << Value.Threads << " }";
+        if (i + 1 < stage_Max)
+            Out << ',';
+        Out << '\n';
+    }
+    Out << "  }";
+    if (memory::IsEnabled())
+    {
+        Out << ",\n";
+        Out << "  \"memory\": ";
+        memory::Json(Out, "  ");
+    }
+    Out << '\n';
+    Out << "}\n";
+}
+
+//***************************************************************************
+// Scope
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+void stats_scope::Start(stage Stage_Source, uint64_t Bytes_Source, uint64_t Frames_Source, bool IsWait_Source)
+{
+    Parent = Current;
+    Current = this;
+    Nested = 0;
+    Bytes = Bytes_Source;
+    Frames = Frames_Source;
+    Stage = Stage_Source;
+    IsWait = IsWait_Source;
+    IsActive = true;
+    Begin = stats::Now();
+}
+
+//---------------------------------------------------------------------------
+void stats_scope::Stop()
+{
+    auto Duration = stats::Now() - Begin;
+    if (IsWait)
+        stats::Add(Stage, Bytes, Frames, 0, Duration);
+    else
+        stats::Add(Stage, Bytes, Frames, Duration > Nested ? Duration - Nested : 0, 0);
+    if (Parent)
+        Parent->Nested += Duration;
+    Current = Parent;
+}
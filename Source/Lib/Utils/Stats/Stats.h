@@ -0,0 +1,100 @@
+/*  Copyright (c) MediaArea.net SARL & AV Preservation by reto.ch.
+ *
+ *  Use of this source code is governed by a BSD-style license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//---------------------------------------------------------------------------
+#ifndef StatsH
+#define StatsH
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+#include "Lib/Config.h"
+#include <array>
+#include <ostream>
+using namespace std;
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+ENUM_BEGIN(stage)
+    Demux,                      // Container parsing
+    Decode,                     // Slice decoding
+    Transform,                  // Decoded samples to output frame layout
+    Hash,                       // Hashes of output files
+    Write,                      // Output files writing or comparison with existing files
+    Input,                      // Input files parsing (encoding)
+    Reversibility,              // Reversibility data storage (encoding)
+ENUM_END(stage)
+
+//---------------------------------------------------------------------------
+// Per stage performance counters: bytes, frames, busy time and wait time
+// Counters are per thread and merged only when they are read, a disabled probe is only a test of a boolean
+// Busy time of a stage does not include the time of the stages nested in it (e.g. decoding during demux)
+class stats
+{
+public:
+    struct stage_values
+    {
+        uint64_t                Bytes = 0;
+        uint64_t                Frames = 0;
+        uint64_t                Busy = 0; // In nanoseconds
+        uint64_t                Wait = 0; // In nanoseconds
+        size_t                  Threads = 0; // Count of threads having this stage
+    };
+    typedef array<stage_values, stage_Max> values;
+
+    // Config
+    static void                 Enable();
+    static bool                 IsEnabled() { return IsEnabled_; }
+
+    // Actions
+    static void                 Add(stage Stage, uint64_t Bytes, uint64_t Frames = 0);
+    static void                 Add(stage Stage, uint64_t Bytes, uint64_t Frames, uint64_t Busy, uint64_t Wait);
+
+    // Info
+    static values               Values(); // Sum of all threads
+    static stage                Bottleneck(const values& Current, const values& Previous); // Stage with the most busy time between 2 readings, stage_Max if none
+    static const char*          Name(stage Stage);
+    static uint64_t             Now(); // In nanoseconds
+    static void                 Json(ostream& Out);
+
+private:
+    static bool                 IsEnabled_;
+};
+
+//---------------------------------------------------------------------------
+// Time between construction and destruction is busy time (or wait time) of the stage
+class stats_scope
+{
+public:
+    stats_scope(stage Stage, uint64_t Bytes = 0, uint64_t Frames = 0, bool IsWait = false)
+    {
+        if (!stats::IsEnabled())
+            return;
+        Start(Stage, Bytes, Frames, IsWait);
+    }
+    ~stats_scope()
+    {
+        if (IsActive)
+            Stop();
+    }
+
+    void                        Add(uint64_t Bytes_More, uint64_t Frames_More = 0) { if (!IsActive) return; Bytes += Bytes_More; Frames += Frames_More; }
+
+private:
+    void                        Start(stage Stage, uint64_t Bytes, uint64_t Frames, bool IsWait);
+    void                        Stop();
+
+    stats_scope*                Parent;
+    uint64_t                    Begin;
+    uint64_t                    Nested;
+    uint64_t                    Bytes;
+    uint64_t                    Frames;
+    stage                       Stage;
+    bool                        IsWait;
+    bool                        IsActive = false;
+};
+
+//---------------------------------------------------------------------------
+#endif
@@ -0,0 +1,170 @@
+/*  Copyright (c) MediaArea.net SARL & AV Preservation by reto.ch.
+ *
+ *  Use of this source code is governed by a BSD-style license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//---------------------------------------------------------------------------
+#include "Lib/Utils/Stats/Trace.h"
+#include "Lib/Utils/Stats/Stats.h"
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <vector>
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+namespace
+{
+    struct event
+    {
+        const char*             Name;
+        const char*             Category;
+        const char*             Arg_Name;
+        uint64_t                Arg;
+        uint64_t                Begin;
+        uint64_t                End;
+        uint64_t                ID; // Async events only
+        bool                    IsAsync;
+    };
+
+    // Only the owner thread writes, events are read after the end of the processing
+    struct thread_events
+    {
+        vector<event>           Events;
+        size_t                  ID;
+    };
+
+    mutex                                   Threads_Mutex;
+    vector<unique_ptr<thread_events>>       Threads;
+    thread_local thread_events*             Local = nullptr;
+    uint64_t                                Begin = 0;
+    ofstream                                Out;
+
+    thread_events& Events()
+    {
+        if (!Local)
+        {
+            Local = new thread_events();
+            lock_guard<mutex> Lock(Threads_Mutex);
+            Local->ID = Threads.size() + 1;
+            Threads.emplace_back(Local);
+        }
+        return *Local;
+    }
+
+    void Microseconds(ostream& Out, uint64_t Value)
+    {
+        Out << Value / 1000 << '.' << setfill('0') << setw(3) << Value % 1000 << setfill(' ');
+    }
+}
+
+//---------------------------------------------------------------------------
+bool trace::IsEnabled_ = false;
+
+//***************************************************************************
+// Trace
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+bool trace::Enable(const string& FileName)
+{
+    Out.open(FileName, ios_base::out | ios_base::trunc);
+    if (!Out.is_open())
+        return true;
+
+    Begin = stats::Now();
+    Events(); // The thread enabling the trace is the 1st one
+    IsEnabled_ = true;
+    return false;
+}
+
+//---------------------------------------------------------------------------
+void trace::Add(const char* Name, const char* Category, uint64_t Event_Begin, const char* Arg_Name, uint64_t Arg)
+{
+    if (!IsEnabled_)
+        return;
+
+    Events().Events.push_back({ Name, Category, Arg_Name, Arg, Event_Begin, stats::Now(), 0, false });
+}
+
+//---------------------------------------------------------------------------
+void trace::Add_Async(const char* Name, const char* Category, uint64_t ID, uint64_t Event_Begin, const char* Arg_Name, uint64_t Arg)
+{
+    if (!IsEnabled_)
+        return;
+
+    Events().Events.push_back({ Name, Category, Arg_Name, Arg, Event_Begin, stats::Now(), ID, true });
+}
+
+//---------------------------------------------------------------------------
+bool trace::Write()
+{
+    if (!IsEnabled_)
+        return false;
+    IsEnabled_ = false;
+
+    auto Event_Common = [&](const event& Event, const thread_events& Thread, char Phase, uint64_t Time)
+    {
+        Out << "{\"name\":\"" << Event.Name << "\",\"cat\":\"" << Event.Category << "\",\"ph\":\"" << Phase << "\",\"ts\":";
+        Microseconds(Out, Time > Begin ? Time - Begin : 0);
+        Out << ",\"pid\":1,\"tid\":" << Thread.ID;
+    };
+    auto Event_Args = [&](const event& Event)
+    {
+        if (Event.Arg_Name)
+            Out << ",\"args\":{\"" << Event.Arg_Name << "\":" << Event.Arg << '}';
+        Out << '}';
+    };
+
+    Out << "{\"traceEvents\":[\n";
+    auto IsFirst = true;
+    lock_guard<mutex> Lock(Threads_Mutex);
+    for (const auto& Thread : Threads)
+    {
+        if (!IsFirst)
+            Out << ",\n";
+        IsFirst = false;
+        Out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << Thread->ID << ",\"args\":{\"name\":\"" << (Thread->ID == 1 ? "main" : "worker") << "\"}}";
+
+        for (const auto& Event : Thread->Events)
+        {
+            Out << ",\n";
+            if (Event.IsAsync)
+            {
+                // Begin and end may be in different threads, they are linked by the ID
+                Event_Common(Event, *Thread, 'b', Event.Begin);
+                Out << ",\"id\":" << Event.ID;
+                Event_Args(Event);
+                Out << ",\n";
+                Event_Common(Event, *Thread, 'e', Event.End);
+                Out << ",\"id\":" << Event.ID << '}';
+            }
+            else
+            {
+                Event_Common(Event, *Thread, 'X', Event.Begin);
+                Out << ",\"dur\":";
+                Microseconds(Out, Event.End - Event.Begin);
+                Event_Args(Event);
+            }
+        }
+    }
+    Out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    Out.close();
+    return Out.fail();
+}
+
+//***************************************************************************
+// Scope
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+void trace_scope::Start(const char* Name_Source, const char* Category_Source, const char* Arg_Name_Source, uint64_t Arg_Source)
+{
+    Name = Name_Source;
+    Category = Category_Source;
+    Arg_Name = Arg_Name_Source;
+    Arg = Arg_Source;
+    Begin = stats::Now();
+}
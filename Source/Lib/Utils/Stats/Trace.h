@@ -0,0 +1,66 @@
+/*  Copyright (c) MediaArea.net SARL & AV Preservation by reto.ch.
+ *
+ *  Use of this source code is governed by a BSD-style license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//---------------------------------------------------------------------------
+#ifndef TraceH
+#define TraceH
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+#include "Lib/Config.h"
+#include <string>
+using namespace std;
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+// Timeline of tasks in Chrome trace format (chrome://tracing, Perfetto)
+// Events are stored per thread and written only at the end, a disabled probe is only a test of a boolean
+// Names and categories must be string literals (only the pointer is stored)
+class trace
+{
+public:
+    // Config
+    static bool                 Enable(const string& FileName); // Returns true on error
+    static bool                 IsEnabled() { return IsEnabled_; }
+
+    // Actions
+    static void                 Add(const char* Name, const char* Category, uint64_t Begin, const char* Arg_Name = nullptr, uint64_t Arg = 0); // Until now, in the current thread
+    static void                 Add_Async(const char* Name, const char* Category, uint64_t ID, uint64_t Begin, const char* Arg_Name = nullptr, uint64_t Arg = 0); // Until now, not bound to a thread
+    static bool                 Write(); // Must be called when all threads are idle, returns true on error
+
+private:
+    static bool                 IsEnabled_;
+};
+
+//---------------------------------------------------------------------------
+// Time between construction and destruction is an event of the current thread
+class trace_scope
+{
+public:
+    trace_scope(const char* Name_Source, const char* Category_Source, const char* Arg_Name_Source = nullptr, uint64_t Arg_Source = 0)
+    {
+        if (!trace::IsEnabled())
+            return;
+        Start(Name_Source, Category_Source, Arg_Name_Source, Arg_Source);
+    }
+    ~trace_scope()
+    {
+        if (Name)
+            trace::Add(Name, Category, Begin, Arg_Name, Arg);
+    }
+
+private:
+    void                        Start(const char* Name, const char* Category, const char* Arg_Name, uint64_t Arg);
+
+    const char*                 Name = nullptr;
+    const char*                 Category;
+    const char*                 Arg_Name;
+    uint64_t                    Arg;
+    uint64_t                    Begin;
+};
+
+//---------------------------------------------------------------------------
+#endif